@@ -0,0 +1,116 @@
+/*
+ * BeaconSweep.c
+ * Beacon peak finding over one spin in place, see BeaconSweep.h
+ *
+ * Integer math only. The parabola vertex is kept in 1/256ths of a reading, so
+ * the heading of a peak comes out to well under a millisecond of spin.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "BeaconSweep.h"
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static uint16_t SampleAt(const BeaconSweep_t *sweep, int i, uint8_t wraps) {
+    int n = sweep->numSamples;
+
+    if (wraps) return sweep->sample[(i + n) % n];
+    if (i < 0) i = 0;
+    if (i >= n) i = n - 1;
+    return sweep->sample[i];
+}
+
+// fits a parabola through the highest reading of a stretch and its neighbours
+// and adds the vertex to the list, which is kept strongest first
+
+static void AddPeak(BeaconSweep_t *sweep, int top, uint8_t wraps) {
+    int32_t before = SampleAt(sweep, top - 1, wraps);
+    int32_t at = sweep->sample[top];
+    int32_t after = SampleAt(sweep, top + 1, wraps);
+    int32_t curve = before - 2 * at + after; // never positive at a maximum
+    int32_t offset = 0; // in 1/256ths of a reading, -128 to 128
+    int32_t intensity = at;
+
+    if (curve < 0) {
+        offset = (before - after) * 128 / curve;
+        intensity = at - (before - after) * offset / 1024;
+    }
+    int32_t atMs = ((int32_t) top * 256 + offset) * BEACON_SWEEP_SAMPLE_TICKS / 256;
+    if (atMs < 0) atMs += (int32_t) sweep->numSamples * BEACON_SWEEP_SAMPLE_TICKS;
+
+    BeaconPeak_t peak = {atMs, intensity > UINT16_MAX ? UINT16_MAX : intensity};
+    int slot = sweep->numPeaks;
+    while (slot > 0 && sweep->peak[slot - 1].intensity < peak.intensity) {
+        if (slot < BEACON_SWEEP_MAX_PEAKS) sweep->peak[slot] = sweep->peak[slot - 1];
+        slot--;
+    }
+    if (slot < BEACON_SWEEP_MAX_PEAKS) {
+        sweep->peak[slot] = peak;
+        if (sweep->numPeaks < BEACON_SWEEP_MAX_PEAKS) sweep->numPeaks++;
+    }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void BeaconSweep_Start(BeaconSweep_t *sweep) {
+    sweep->numSamples = 0;
+    sweep->numPeaks = 0;
+}
+
+uint8_t BeaconSweep_Add(BeaconSweep_t *sweep, uint16_t reading) {
+    if (sweep->numSamples >= BEACON_SWEEP_MAX_SAMPLES) return FALSE;
+    sweep->sample[sweep->numSamples++] = reading;
+    return TRUE;
+}
+
+uint8_t BeaconSweep_FindPeaks(BeaconSweep_t *sweep, uint16_t threshold, uint8_t wraps) {
+    int n = sweep->numSamples;
+    int start = 0;
+
+    sweep->numPeaks = 0;
+    if (n < 3) return 0;
+
+    if (wraps) { // start just after a reading below threshold, so no stretch is cut in two
+        while (start < n && sweep->sample[start] > threshold) start++;
+        if (start == n) { // above all the way round, nothing to go on but the highest
+            int top = 0;
+            for (int i = 1; i < n; i++) {
+                if (sweep->sample[i] > sweep->sample[top]) top = i;
+            }
+            AddPeak(sweep, top, wraps);
+            return sweep->numPeaks;
+        }
+    }
+
+    int top = -1; // highest reading of the stretch in progress
+    for (int k = 0; k <= n; k++) {
+        int i = (start + k) % n;
+        uint8_t above = k < n && sweep->sample[i] > threshold;
+        if (above) {
+            if (top < 0 || sweep->sample[i] > sweep->sample[top]) top = i;
+        } else if (top >= 0) {
+            AddPeak(sweep, top, wraps);
+            top = -1;
+        }
+    }
+    return sweep->numPeaks;
+}
+
+// back where the sweep started, so a peak that far on round, or the rest of
+// the sweep back
+
+uint16_t BeaconSweep_TurnTo(const BeaconSweep_t *sweep, uint8_t peak, uint8_t *onward) {
+    uint16_t sweepMs = sweep->numSamples * BEACON_SWEEP_SAMPLE_TICKS;
+    uint16_t atMs = sweep->peak[peak].atMs;
+
+    *onward = atMs <= sweepMs / 2;
+    return *onward ? atMs : sweepMs - atMs;
+}
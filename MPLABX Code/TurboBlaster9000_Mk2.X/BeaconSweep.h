@@ -0,0 +1,73 @@
+/*
+ * BeaconSweep.h
+ * Finds where the towers are from one spin in place. AcquireTower reads the
+ * beacon detector every BEACON_SWEEP_SAMPLE_TICKS while it turns, and once the
+ * turn is done the readings are searched for peaks: every stretch of readings
+ * above the beacon threshold is one tower, and the highest reading in it,
+ * refined with a parabola through it and its two neighbours, is where the
+ * tower is. Towers come back strongest first.
+ *
+ * There are no wheel encoders, so headings are in ms of spinning since the
+ * sweep started. The robot turns at a steady rate, a full turn every
+ * TURN_360_TICKS, so that is as good as an angle for turning back to a peak.
+ */
+
+#ifndef BEACON_SWEEP_H
+#define	BEACON_SWEEP_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define BEACON_SWEEP_SAMPLE_TICKS 50 // ms between readings, about 3.6 degrees
+#define BEACON_SWEEP_MAX_SAMPLES 160 // enough for the longest TURN_360_TICKS AutoTune tries
+#define BEACON_SWEEP_MAX_PEAKS 4 // towers remembered from one sweep
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    uint16_t atMs; // heading, as ms of spinning after the first reading
+    uint16_t intensity; // the fitted peak reading
+} BeaconPeak_t;
+
+typedef struct {
+    uint16_t sample[BEACON_SWEEP_MAX_SAMPLES];
+    uint8_t numSamples;
+    uint8_t numPeaks;
+    BeaconPeak_t peak[BEACON_SWEEP_MAX_PEAKS]; // strongest first
+} BeaconSweep_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// forgets the last sweep
+void BeaconSweep_Start(BeaconSweep_t *sweep);
+
+// adds the next reading, returns FALSE once the sweep is full
+uint8_t BeaconSweep_Add(BeaconSweep_t *sweep, uint16_t reading);
+
+/*
+ * Finds the towers in the readings so far, strongest first, and returns how
+ * many there are. A tower is a stretch of readings above threshold. If the
+ * readings cover exactly one full turn, set wraps so a tower straddling the
+ * first and last reading is seen as one
+ */
+uint8_t BeaconSweep_FindPeaks(BeaconSweep_t *sweep, uint16_t threshold, uint8_t wraps);
+
+/*
+ * How long to turn for to face a peak, the robot back where the sweep started.
+ * onward is set TRUE to keep turning the way the sweep went, FALSE to turn
+ * back, whichever is shorter
+ */
+uint16_t BeaconSweep_TurnTo(const BeaconSweep_t *sweep, uint8_t peak, uint8_t *onward);
+
+#endif	/* BEACON_SWEEP_H */
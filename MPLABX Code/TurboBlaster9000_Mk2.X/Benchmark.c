@@ -0,0 +1,198 @@
+/*
+ * Benchmark.c
+ * Checker and HSM dispatch microbenchmarks, see Benchmark.h
+ *
+ * Conditionally compiles a main that runs every case on the robot if the macro
+ * BENCHMARK_TEST is defined, the same way EVENTCHECKER_TEST works in
+ * ProjectEventChecker.c. Host builds always get the cases, host/Bench.c has the
+ * main there.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "BOARD.h"
+#include "Global_Macros.h"
+#include "ProjectEventChecker.h"
+#include "RobotHSM.h"
+#include "RobotContext.h"
+#include "MatchClock.h"
+#include "Benchmark.h"
+#include <stdio.h>
+
+//#define BENCHMARK_TEST
+#if defined(BENCHMARK_TEST) || !defined(__XC32)
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+// AcquireTower gives up, FindNewTower faces a tower and hands it over aimed,
+// which starts SearchForTower in ApproachTower
+#define APPROACH_SETUP {{ES_INIT}, {BUDGET_EXCEEDED, PHASE_ACQUIRE}, {NEW_TOWER, TRUE}}
+
+/*******************************************************************************
+ * PUBLIC VARIABLES                                                            *
+ ******************************************************************************/
+
+const BenchmarkCase_t BenchmarkCases[] = {
+    {"CheckTapeSensors", CheckTapeSensors},
+    {"BeaconDetection", BeaconDetection},
+    {"BumperDetection", BumperDetection},
+    {"EchoEdgeDetection", EchoEdgeDetection},
+    {"CheckTrackWire", CheckTrackWire},
+    // a full turn with nothing over the threshold, the sweep searched and started over
+    {"AcquireTower ES_TIMEOUT", NULL, {{ES_INIT}, {ES_TIMEOUT, SAMPLE_TIMER}, {ES_TIMEOUT, SAMPLE_TIMER}}, {ES_TIMEOUT, TURN_TIMER}},
+    // one beacon reading of the sweep
+    {"AcquireTower SAMPLE_TIMER", NULL, {{ES_INIT}}, {ES_TIMEOUT, SAMPLE_TIMER}},
+    // an event nothing handles, passed up through every level
+    {"AcquireTower TW_DETECT", NULL, {{ES_INIT}}, {TW_DETECT}},
+    // a tower passing by mid sweep, consumed in place
+    {"AcquireTower BEACON_FOUND", NULL, {{ES_INIT}}, {BEACON_FOUND}},
+    // one control step of the approach, the beacon read and the motors steered
+    {"ApproachTower SAMPLE_TIMER", NULL, APPROACH_SETUP, {ES_TIMEOUT, SAMPLE_TIMER}},
+    // the steering follows the beacon reading itself, consumed in place
+    {"ApproachTower BEACON_LOST", NULL, APPROACH_SETUP, {BEACON_LOST}},
+    // into ResolveObstacle, a transition that starts a sub HSM and plans an escape
+    {"ApproachTower TAPE_CHANGE", NULL, APPROACH_SETUP, {TAPE_CHANGE, FL_TAPE_BIT}},
+};
+
+const int BenchmarkNumCases = sizeof (BenchmarkCases) / sizeof (BenchmarkCases[0]);
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// the fewest ticks two back to back reads of the clock ever differ by
+
+static uint32_t ClockOverhead(BenchmarkClock_t clock) {
+    uint32_t best = UINT32_MAX;
+    for (uint16_t i = 0; i < BENCHMARK_REPS; i++) {
+        uint32_t start = clock();
+        uint32_t t = clock() - start;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+// the robot as it is at power on, with no timer running and nothing waiting in
+// any queue, so nothing the last call started can land in the next one
+
+static void ResetRobot(void) {
+    for (uint8_t i = 0; i < NUM_ES_TIMERS; i++) {
+        ES_Timer_StopTimer(i);
+    }
+    RobotContext_Reset(ROBOT);
+    ES_Initialize(); // empties the queues and initializes every service again
+}
+
+// gets the robot to where the case is timed from
+
+static void SetUpCase(const BenchmarkCase_t *c) {
+    ResetRobot();
+    if (c->checker != NULL) { // let it catch up with the sensors, so the timed call finds nothing new
+        c->checker();
+    } else { // get RobotHSM to the state the case is about
+        for (uint8_t i = 0; i < BENCHMARK_MAX_SETUP && c->setup[i].EventType != ES_NO_EVENT; i++) {
+            RunRobotHSM(c->setup[i]);
+        }
+    }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void Benchmark_Run(const BenchmarkCase_t *c, BenchmarkClock_t clock, uint16_t reps, BenchmarkResult_t *result) {
+    uint32_t overhead = ClockOverhead(clock);
+    uint64_t total = 0;
+
+    if (reps == 0) reps = 1;
+    result->min = UINT32_MAX;
+    result->max = 0;
+
+    for (uint16_t i = 0; i < reps; i++) {
+        SetUpCase(c);
+        uint32_t t0 = clock();
+        if (c->checker != NULL) {
+            c->checker();
+        } else {
+            RunRobotHSM(c->event);
+        }
+        uint32_t t = clock() - t0;
+        t = t > overhead ? t - overhead : 0;
+        if (t < result->min) result->min = t;
+        if (t > result->max) result->max = t;
+        total += t;
+    }
+    ResetRobot();
+
+    result->calls = reps;
+    result->mean = total / reps;
+}
+
+void Benchmark_PrintJson(const BenchmarkResult_t *results, const char *clockName, double ticksPerUs) {
+    double nsPerTick = 1000.0 / ticksPerUs;
+
+    printf("{\r\n  \"clock\": \"%s\",\r\n  \"ticks_per_us\": %.3f,\r\n  \"cases\": [\r\n", clockName, ticksPerUs);
+    for (int i = 0; i < BenchmarkNumCases; i++) {
+        const BenchmarkResult_t *r = &results[i];
+        printf("    {\"name\": \"%s\", \"calls\": %lu, \"min_ns\": %.1f, \"mean_ns\": %.1f, \"max_ns\": %.1f}%s\r\n",
+                BenchmarkCases[i].name, (unsigned long) r->calls, r->min * nsPerTick, r->mean * nsPerTick, r->max * nsPerTick, i + 1 < BenchmarkNumCases ? "," : "");
+    }
+    printf("  ]\r\n}\r\n");
+}
+
+#endif /* BENCHMARK_TEST || !__XC32 */
+
+/*******************************************************************************
+ * BENCHMARK_TEST MAIN                                                         *
+ ******************************************************************************/
+
+#ifdef BENCHMARK_TEST
+#include "timers.h"
+#include "AD.h"
+#include "IO_Ports.h"
+#include "Motor_Control.h"
+#include "ProfileClock.h"
+
+// what initHardware in Project_ES_Main.c sets up, so the checkers read real pins
+
+static void InitBenchmarkHardware(void) {
+    ES_Timer_Init();
+    TIMERS_Init();
+    InitMotors();
+
+    AD_Init();
+    AD_AddPins(FL_TAPE_PIN | FR_TAPE_PIN | BL_TAPE_PIN | BR_TAPE_PIN | CL_TAPE_PIN | CR_TAPE_PIN | S_TAPE_PIN);
+    AD_AddPins(BEACON_A_PIN);
+    IO_PortsSetPortInputs(BEACON_PORT, BEACON_D_PIN);
+    AD_AddPins(TW_PIN);
+    IO_PortsSetPortInputs(BUMPER_PORT, FL_BUMP_PIN | FR_BUMP_PIN | BL_BUMP_PIN | BR_BUMP_PIN);
+
+    IO_PortsSetPortOutputs(PING_PORT, TRIG_PIN);
+    IO_PortsClearPortBits(PING_PORT, TRIG_PIN);
+    IO_PortsSetPortInputs(PING_PORT, ECHO_PIN);
+}
+
+void main(void) {
+    static BenchmarkResult_t results[sizeof (BenchmarkCases) / sizeof (BenchmarkCases[0])];
+
+    BOARD_Init();
+    InitBenchmarkHardware();
+    while (!AD_IsNewDataReady()); // let every pin get a first reading
+    if (ES_Initialize() != Success) {
+        printf("Failed Initialization\r\n");
+        for (;;);
+    }
+
+    for (int i = 0; i < BenchmarkNumCases; i++) {
+        Benchmark_Run(&BenchmarkCases[i], ProfileClock_GetTicks, BENCHMARK_REPS, &results[i]);
+    }
+    Benchmark_PrintJson(results, "core timer", PROFILE_TICKS_PER_US);
+    for (;;);
+}
+#endif /* BENCHMARK_TEST */
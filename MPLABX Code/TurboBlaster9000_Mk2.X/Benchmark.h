@@ -0,0 +1,88 @@
+/*
+ * Benchmark.h
+ * Per call cost of the event checkers and of RobotHSM dispatch, so a change
+ * that slows the main loop down shows up as a number before it shows up on the
+ * field.
+ *
+ * Every case is one call, timed on its own many times over: an event checker
+ * on its quiet path (sensors steady, nothing posted), which is what the loop
+ * runs on almost every pass, or RunRobotHSM handling one event in one state.
+ * The HSM cases get to their state by feeding RunRobotHSM events from power
+ * on. Before every call the robot is put back to power on, every timer stopped
+ * and every queue emptied, and the case set up again, so each call does
+ * exactly the same work and nothing an earlier call started gets in its way.
+ * Only the quickest, the slowest and the total of the calls are kept, so a
+ * case costs no more RAM than its result.
+ *
+ * The same cases run on the robot and on the host, only the clock differs: the
+ * core timer on the PIC32, a clock the host tool passes in there, see
+ * host/Bench.c. On the robot, define BENCHMARK_TEST in Benchmark.c and leave
+ * Project_ES_Main.c out of the build, the results come out the serial port as
+ * JSON. host/Bench.c compares two result files.
+ */
+
+#ifndef BENCHMARK_H
+#define	BENCHMARK_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "ES_Framework.h"
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define BENCHMARK_REPS 1000 // timed calls per case, unless told otherwise
+#define BENCHMARK_MAX_SETUP 4 // events it takes RobotHSM to get to a case's state
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+// a free running counter, read before and after every call
+typedef uint32_t(*BenchmarkClock_t)(void);
+
+typedef struct {
+    const char *name;
+    uint8_t(*checker)(void); // NULL for a RobotHSM case
+    ES_Event setup[BENCHMARK_MAX_SETUP]; // from power on, up to the first ES_NO_EVENT
+    ES_Event event; // what RobotHSM is timed handling
+} BenchmarkCase_t;
+
+// clock ticks per call, with the cost of reading the clock taken off
+typedef struct {
+    uint32_t calls;
+    uint32_t min;
+    uint32_t mean;
+    uint32_t max;
+} BenchmarkResult_t;
+
+/*******************************************************************************
+ * PUBLIC VARIABLES                                                            *
+ ******************************************************************************/
+
+extern const BenchmarkCase_t BenchmarkCases[];
+extern const int BenchmarkNumCases;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/*
+ * Times one case reps times. The framework must have been initialized and not
+ * be running, the robot is left at power on with the framework initialized
+ * again
+ */
+void Benchmark_Run(const BenchmarkCase_t *c, BenchmarkClock_t clock, uint16_t reps, BenchmarkResult_t *result);
+
+/*
+ * Prints every result as JSON, times in nanoseconds. clockName says what was
+ * counting, ticksPerUs how fast
+ */
+void Benchmark_PrintJson(const BenchmarkResult_t *results, const char *clockName, double ticksPerUs);
+
+#endif	/* BENCHMARK_H */
@@ -28,6 +28,18 @@
 //uncomment to supress the entry and exit events
 //#define SUPPRESS_EXIT_ENTRY_IN_TATTLE
 
+//define to measure post-to-dispatch latency of every event, see EventProfiler.h
+//#define USE_EVENT_PROFILER
+
+//define to time every pass of ES_Run and print the loop rate, see LoopMonitor.h
+//#define USE_LOOP_MONITOR
+
+//define to send every sensor reading out with the trace for host/Replay, see SensorRecorder.h
+//#define USE_SENSOR_RECORDER
+
+//define to track the robot's pose on the arena map with a particle filter, see Localizer.h
+//#define USE_LOCALIZER
+
 /****************************************************************************/
 // Name/define the events of interest
 // Universal events occupy the lowest entries, followed by user-defined events
@@ -49,7 +61,7 @@ typedef enum {
 
 
     /*USER-PING-EVENTS
-     *Jacob put NUMBEROFEVENTS before these, David fixed that*/
+     *Jacob put NUMBEROFEVENTS before these; David fixed that*/
     ECHO_RISE,
     ECHO_FALL,
     TAPE_CHANGE,
@@ -64,6 +76,8 @@ typedef enum {
     NEW_PING,
     HOLE_FOUND,
     NEW_TOWER,
+    ALIGNED,
+    BUDGET_EXCEEDED,
 
     /* User-defined events end here */
     NUMBEROFEVENTS,
@@ -82,7 +96,6 @@ static const char *EventNames[] = {
 	"ES_TIMERSTOPPED",
 	"BATTERY_CONNECTED",
 	"BATTERY_DISCONNECTED",
-	"these",
 	"ECHO_RISE",
 	"ECHO_FALL",
 	"TAPE_CHANGE",
@@ -97,6 +110,8 @@ static const char *EventNames[] = {
 	"NEW_PING",
 	"HOLE_FOUND",
 	"NEW_TOWER",
+	"ALIGNED",
+	"BUDGET_EXCEEDED",
 	"NUMBEROFEVENTS",
 };
 
@@ -105,11 +120,43 @@ static const char *EventNames[] = {
 
 /****************************************************************************/
 // This are the name of the Event checking function header file.
+#ifdef USE_LOOP_MONITOR
+#define EVENT_CHECK_HEADER "LoopMonitor.h"
+#else
 #define EVENT_CHECK_HEADER "ProjectEventChecker.h"
+#endif
 
 /****************************************************************************/
 // This is the list of event checking functions
-#define EVENT_CHECK_LIST  TemplateCheckBattery, EchoEdgeDetection, BumperDetection, BeaconDetection, CheckTapeSensors
+// LoopMonitorTick has to stay first so it runs once every pass, then SensorRecorder
+// for the same reason, LocalizerTick ahead of the sensor checkers as well, since a
+// checker that posts ends the pass and the filter would miss that tape edge (it
+// reads the tape state CheckTapeSensors kept on the pass before, so it is a pass
+// late but sees every edge), and TraceDrain last so the trace only goes out on passes where nothing
+// else happened
+#ifdef USE_SENSOR_RECORDER
+#define RECORDER_CHECKERS SensorRecorder,
+#else
+#define RECORDER_CHECKERS
+#endif
+
+#ifdef USE_LOCALIZER
+#define LOCALIZER_CHECKERS LocalizerTick,
+#else
+#define LOCALIZER_CHECKERS
+#endif
+
+#ifdef USE_LOOP_MONITOR
+#define PROJECT_CHECKERS  LoopMonitorTick, RECORDER_CHECKERS LOCALIZER_CHECKERS Monitored_TemplateCheckBattery, Monitored_EchoEdgeDetection, Monitored_BumperDetection, Monitored_BeaconDetection, Monitored_CheckTapeSensors, MatchClockCheck
+#else
+#define PROJECT_CHECKERS  RECORDER_CHECKERS LOCALIZER_CHECKERS TemplateCheckBattery, EchoEdgeDetection, BumperDetection, BeaconDetection, CheckTapeSensors, MatchClockCheck
+#endif
+
+#ifdef USE_EVENT_PROFILER
+#define EVENT_CHECK_LIST  PROJECT_CHECKERS, CheckProfilerRequest, TraceDrain
+#else
+#define EVENT_CHECK_LIST  PROJECT_CHECKERS, TraceDrain
+#endif
 
 /****************************************************************************/
 // These are the definitions for the post functions to be executed when the
@@ -169,11 +216,19 @@ static const char *EventNames[] = {
 // services are added in numeric sequence (1,2,3,...) with increasing 
 // priorities
 // the header file with the public fuction prototypes
+#ifdef USE_LOOP_MONITOR
+#define SERV_0_HEADER "LoopMonitor.h"
+#else
 #define SERV_0_HEADER "ES_KeyboardInput.h"
+#endif
 // the name of the Init function
 #define SERV_0_INIT InitKeyboardInput
 // the name of the run function
+#ifdef USE_LOOP_MONITOR
+#define SERV_0_RUN Monitored_RunKeyboardInput
+#else
 #define SERV_0_RUN RunKeyboardInput
+#endif
 // How big should this service's Queue be?
 #define SERV_0_QUEUE_SIZE 9
 
@@ -181,11 +236,19 @@ static const char *EventNames[] = {
 // These are the definitions for Service 1
 #if NUM_SERVICES > 1
 // the header file with the public fuction prototypes
+#ifdef USE_LOOP_MONITOR
+#define SERV_1_HEADER "LoopMonitor.h"
+#else
 #define SERV_1_HEADER "PingSensorFSM.h"
+#endif
 // the name of the Init function
 #define SERV_1_INIT InitPingFSM
 // the name of the run function
+#ifdef USE_LOOP_MONITOR
+#define SERV_1_RUN Monitored_RunPingFSM
+#else
 #define SERV_1_RUN RunPingFSM
+#endif
 // How big should this services Queue be?
 #define SERV_1_QUEUE_SIZE 3
 #endif
@@ -193,11 +256,19 @@ static const char *EventNames[] = {
 // These are the definitions for Service 2
 #if NUM_SERVICES > 2
 // the header file with the public fuction prototypes
+#ifdef USE_LOOP_MONITOR
+#define SERV_2_HEADER "LoopMonitor.h"
+#else
 #define SERV_2_HEADER "RobotHSM.h"
+#endif
 // the name of the Init function
 #define SERV_2_INIT InitRobotHSM
 // the name of the run function
+#ifdef USE_LOOP_MONITOR
+#define SERV_2_RUN Monitored_RunRobotHSM
+#else
 #define SERV_2_RUN RunRobotHSM
+#endif
 // How big should this services Queue be?
 #define SERV_2_QUEUE_SIZE 3
 #endif
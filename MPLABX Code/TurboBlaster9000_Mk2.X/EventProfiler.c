@@ -0,0 +1,147 @@
+/*
+ * EventProfiler.c
+ * Post-to-dispatch latency profiler for the ES framework services, see EventProfiler.h
+ *
+ * The framework's own queues only hold the event type and parameter, so every
+ * service that is profiled gets a small shadow queue of post times next to it.
+ * A post pushes a stamp, and the dispatch of the same event type pops it.
+ * Events that were posted without going through EventProfiler_Post (keyboard
+ * input, ES_PostAll) have no stamp and are only counted as unmatched.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "BOARD.h"
+#include "EventProfiler.h"
+#include "ProfileClock.h"
+#include "RobotContext.h"
+#include "serial.h"
+#include <stdio.h>
+
+#ifdef USE_EVENT_PROFILER
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// returns the histogram bucket for a latency, floor(log2(us)) clamped to the table
+
+static uint8_t BucketFor(uint32_t us) {
+    uint8_t bucket = 0;
+    while ((us >>= 1) != 0 && bucket < EVENT_PROFILER_BUCKETS - 1) {
+        bucket++;
+    }
+    return bucket;
+}
+
+// approximate percentile from the histogram, returned as the upper edge of the
+// bucket that holds it
+
+static uint32_t Percentile(const EventLatencyStats_t *s, uint8_t percent) {
+    uint32_t target = (s->count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < EVENT_PROFILER_BUCKETS; i++) {
+        seen += s->bucket[i];
+        if (seen >= target) {
+            return (i == EVENT_PROFILER_BUCKETS - 1) ? s->maxUs : (2UL << i);
+        }
+    }
+    return s->maxUs;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t EventProfiler_Post(uint8_t Priority, ES_Event ThisEvent) {
+    uint32_t now = ProfileClock_GetTicks(); // stamp before posting so the post itself is counted
+
+    if (ES_PostToService(Priority, ThisEvent) != TRUE) {
+        return FALSE;
+    }
+    if (Priority < NUM_SERVICES) {
+        StampQueue_t *q = &ROBOT->profiler.stampQueues[Priority];
+        if (q->count < EVENT_PROFILER_STAMP_QUEUE_SIZE) { // the framework queue accepted it, so this only fills if events are unmatched
+            PostStamp_t *p = &q->stamp[(q->head + q->count) % EVENT_PROFILER_STAMP_QUEUE_SIZE];
+            p->type = ThisEvent.EventType;
+            p->ticks = now;
+            q->count++;
+        }
+    }
+    return TRUE;
+}
+
+void EventProfiler_Dispatch(uint8_t Priority, ES_Event ThisEvent) {
+    EventProfilerContext_t *ctx = &ROBOT->profiler;
+    uint32_t now = ProfileClock_GetTicks();
+
+    if (ThisEvent.EventType == ES_ENTRY || ThisEvent.EventType == ES_EXIT) return; // recursive calls, never queued
+    if (Priority >= NUM_SERVICES || ThisEvent.EventType >= NUMBEROFEVENTS) return;
+
+    StampQueue_t *q = &ctx->stampQueues[Priority];
+    if (q->count == 0 || q->stamp[q->head].type != ThisEvent.EventType) {
+        ctx->unmatched++; // posted some other way, leave the stamps alone so they stay in sync
+        return;
+    }
+
+    uint32_t us = PROFILE_TICKS_TO_US(now - q->stamp[q->head].ticks);
+    q->head = (q->head + 1) % EVENT_PROFILER_STAMP_QUEUE_SIZE;
+    q->count--;
+
+    EventLatencyStats_t *s = &ctx->stats[ThisEvent.EventType];
+    s->count++;
+    s->totalUs += us;
+    if (us > s->maxUs) s->maxUs = us;
+    uint8_t b = BucketFor(us);
+    if (s->bucket[b] < 0xFFFF) s->bucket[b]++; // saturate instead of wrapping
+}
+
+void EventProfiler_Reset(void) {
+    EventProfilerContext_t *ctx = &ROBOT->profiler;
+    for (int i = 0; i < NUMBEROFEVENTS; i++) {
+        ctx->stats[i].count = 0;
+        ctx->stats[i].totalUs = 0;
+        ctx->stats[i].maxUs = 0;
+        for (int b = 0; b < EVENT_PROFILER_BUCKETS; b++) {
+            ctx->stats[i].bucket[b] = 0;
+        }
+    }
+    ctx->unmatched = 0;
+}
+
+const EventLatencyStats_t *EventProfiler_GetStats(ES_EventTyp_t type) {
+    if (type >= NUMBEROFEVENTS) return NULL;
+    return &ROBOT->profiler.stats[type];
+}
+
+uint32_t EventProfiler_GetUnmatched(void) {
+    return ROBOT->profiler.unmatched;
+}
+
+void EventProfiler_PrintStats(void) {
+    const EventProfilerContext_t *ctx = &ROBOT->profiler;
+    printf("EVENT LATENCY (us)\r\n");
+    printf("%-20s %8s %8s %8s %8s %8s %8s\r\n", "event", "count", "avg", "p50", "p90", "p99", "max");
+    for (int i = 0; i < NUMBEROFEVENTS; i++) {
+        const EventLatencyStats_t *s = &ctx->stats[i];
+        if (s->count == 0) continue;
+        printf("%-20s %8lu %8lu %8lu %8lu %8lu %8lu\r\n", EventNames[i],
+                (unsigned long) s->count, (unsigned long) (s->totalUs / s->count),
+                (unsigned long) Percentile(s, 50), (unsigned long) Percentile(s, 90),
+                (unsigned long) Percentile(s, 99), (unsigned long) s->maxUs);
+    }
+    printf("unmatched: %lu\r\n", (unsigned long) ctx->unmatched);
+}
+
+uint8_t CheckProfilerRequest(void) {
+    if (!IsReceiveEmpty() && GetChar() == EVENT_PROFILER_PRINT_KEY) {
+        EventProfiler_PrintStats();
+    }
+    return FALSE;
+}
+
+#endif /* USE_EVENT_PROFILER */
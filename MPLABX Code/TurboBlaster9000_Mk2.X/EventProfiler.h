@@ -0,0 +1,99 @@
+/*
+ * EventProfiler.h
+ * Measures how long each event waits in a service queue, from the moment it is
+ * posted to the moment the service's Run function starts handling it. Latencies
+ * are kept in a log2 histogram per event type.
+ *
+ * Turn it on with USE_EVENT_PROFILER in ES_Configure.h. When it is off, the post
+ * and dispatch hooks compile down to a plain ES_PostToService and nothing.
+ */
+
+#ifndef EVENT_PROFILER_H
+#define	EVENT_PROFILER_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "ES_Framework.h"
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// bucket i holds latencies from 2^i up to 2^(i+1) microseconds, the last bucket
+// also holds everything slower than that
+#define EVENT_PROFILER_BUCKETS 16
+
+// key to send over serial to get the stats printed
+#define EVENT_PROFILER_PRINT_KEY 'p'
+
+#define EVENT_PROFILER_STAMP_QUEUE_SIZE 10 // at least as big as the biggest service queue
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    uint32_t count; // number of events measured
+    uint32_t totalUs; // sum of all latencies, for the average
+    uint32_t maxUs; // slowest event seen
+    uint16_t bucket[EVENT_PROFILER_BUCKETS];
+} EventLatencyStats_t;
+
+typedef struct {
+    ES_EventTyp_t type; // event type that was posted, used to match on dispatch
+    uint32_t ticks; // ProfileClock reading at the time of the post
+} PostStamp_t;
+
+typedef struct {
+    PostStamp_t stamp[EVENT_PROFILER_STAMP_QUEUE_SIZE];
+    uint8_t head; // index of the oldest stamp
+    uint8_t count; // number of stamps waiting
+} StampQueue_t;
+
+typedef struct {
+    StampQueue_t stampQueues[NUM_SERVICES]; // one per service priority
+    EventLatencyStats_t stats[NUMBEROFEVENTS];
+    uint32_t unmatched;
+} EventProfilerContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+#ifdef USE_EVENT_PROFILER
+
+// posts the event to the service like ES_PostToService, and stamps it with the time
+uint8_t EventProfiler_Post(uint8_t Priority, ES_Event ThisEvent);
+
+// called at the top of a service's Run function, records the time since the post.
+// ES_ENTRY and ES_EXIT are never posted so they are ignored
+void EventProfiler_Dispatch(uint8_t Priority, ES_Event ThisEvent);
+
+// clears all of the collected stats
+void EventProfiler_Reset(void);
+
+// returns the stats for one event type, or NULL if the type is out of range
+const EventLatencyStats_t *EventProfiler_GetStats(ES_EventTyp_t type);
+
+// number of dispatched events that could not be matched to a stamped post
+uint32_t EventProfiler_GetUnmatched(void);
+
+// prints a table of count, average, max and percentile latency for every event seen
+void EventProfiler_PrintStats(void);
+
+/*
+ * Event checker that prints the stats when EVENT_PROFILER_PRINT_KEY arrives over
+ * the serial port. Never posts anything, so it always returns FALSE
+ */
+uint8_t CheckProfilerRequest(void);
+
+#else
+#define EventProfiler_Post(Priority, ThisEvent) ES_PostToService(Priority, ThisEvent)
+#define EventProfiler_Dispatch(Priority, ThisEvent)
+#endif
+
+#endif	/* EVENT_PROFILER_H */
@@ -11,6 +11,13 @@
 #include "Motor_Control.h"
 #include "FindNewTowerSubHSM.h"
 #include "Global_Macros.h"
+#include "StateTimers.h"
+#include "Trace.h"
+#include "BeaconSweep.h"
+#include "TowerPlanner.h"
+#include "MatchClock.h"
+#include "AD.h"
+#include "timers.h"
 
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
@@ -18,6 +25,8 @@
 typedef enum {
     InitPSubState,
     ExitHole,
+    Survey,
+    FaceTower,
     Align,
     Drive,
     Turn,
@@ -29,6 +38,8 @@ typedef enum {
 static const char *StateNames[] = {
 	"InitPSubState",
 	"ExitHole",
+	"Survey",
+	"FaceTower",
 	"Align",
 	"Drive",
 	"Turn",
@@ -45,36 +56,35 @@ static const char *StateNames[] = {
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
 
-static FindNewTowerSubHSMState_t CurrentState = InitPSubState; // first pseudo state
-uint32_t pingData;
-uint32_t myTime;
+// the state lives in a FindNewTowerContext_t passed in by RobotHSM, see FindNewTowerSubHSM.h
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                            *
  ******************************************************************************/
 
-uint8_t InitFindNewTowerSubHSM(void) {
+uint8_t InitFindNewTowerSubHSM(FindNewTowerContext_t *ctx) {
     ES_Event returnEvent;
-    CurrentState = InitPSubState;
-    returnEvent = RunFindNewTowerSubHSM(INIT_EVENT); // run the init event through the subHSM
+    ctx->CurrentState = InitPSubState;
+    returnEvent = RunFindNewTowerSubHSM(ctx, INIT_EVENT); // run the init event through the subHSM
     if (returnEvent.EventType == ES_NO_EVENT) { // if there was no issue, return true
         return TRUE;
     }
     return FALSE;
 }
 
-ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
+ES_Event RunFindNewTowerSubHSM(FindNewTowerContext_t *ctx, ES_Event ThisEvent) {
     uint8_t makeTransition = FALSE; // use to flag transition
     FindNewTowerSubHSMState_t nextState; // the state variable
 
     ES_Tattle(); // trace call stack
 
-    switch (CurrentState) { // determine what to do based on current state
+    switch (ctx->CurrentState) { // determine what to do based on current state
         case InitPSubState: // If current state is initial Pseudo State
             if (ThisEvent.EventType == ES_INIT)// only respond to ES_Init
             {
                 // now put the machine into the actual initial state
-                nextState = ExitHole; // begin by exiting the hole
+                nextState = ctx->wander ? Align : ExitHole; // begin by exiting the hole, unless there is none
+                ctx->wander = FALSE;
                 makeTransition = TRUE;
                 ThisEvent.EventType = ES_NO_EVENT; // consume the init event
             }
@@ -83,17 +93,16 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
         case ExitHole: // will be exiting the hole by briefly backing up before rotating to align
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    ES_Timer_InitTimer(RESET_TIMER, EXIT_TICKS); // how long to back up for
+                    StateTimer_Start(RESET_TIMER, EXIT_TICKS, HSM_LEVEL_SUB, ctx->CurrentState); // how long to back up for
                     SetLeftMotor(-EXIT_SPEED); // the speed at which to back up
                     SetRightMotor(-EXIT_SPEED);
                     break;
 
                 case ES_TIMEOUT: // on timeout event
                     if (RESET_TIMER == ThisEvent.EventParam) { // if its the reset timer which we care about
-                        nextState = Align; // go to the state where we align the bot with the tower
+                        nextState = Survey; // look all the way round for the next tower
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
-                        ES_Timer_StopTimer(RESET_TIMER); // stop the reset timer for now
                     }
 
                 default:
@@ -101,10 +110,102 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
             }
             break;
 
+        case Survey: // spinning once in place beside the tower, noting the beacon all the way round
+            switch (ThisEvent.EventType) {
+                case ES_ENTRY:
+                    BeaconSweep_Start(&ctx->sweep);
+                    BeaconSweep_Add(&ctx->sweep, AD_ReadADPin(BEACON_A_PIN));
+                    StateTimer_Start(SAMPLE_TIMER, BEACON_SWEEP_SAMPLE_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                    StateTimer_Start(TURN_TIMER, TURN_360_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                    SetMotors(ACQUIRE_SPEED, -ACQUIRE_SPEED);
+                    break;
+
+                case ES_TIMEOUT:
+                    if (ThisEvent.EventParam == SAMPLE_TIMER) { // next beacon reading of the sweep
+                        if (ctx->sweep.numSamples < TURN_360_TICKS / BEACON_SWEEP_SAMPLE_TICKS) {
+                            BeaconSweep_Add(&ctx->sweep, AD_ReadADPin(BEACON_A_PIN));
+                            StateTimer_Start(SAMPLE_TIMER, BEACON_SWEEP_SAMPLE_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                        }
+                        ThisEvent.EventType = ES_NO_EVENT;
+                    } else if (ThisEvent.EventParam == TURN_TIMER) { // a full turn is done, pick the next tower
+                        uint8_t wraps = ctx->sweep.numSamples == TURN_360_TICKS / BEACON_SWEEP_SAMPLE_TICKS;
+                        int8_t peak;
+
+                        BeaconSweep_FindPeaks(&ctx->sweep, BEACON_HIGH_THRESH, wraps);
+                        peak = TowerPlanner_Choose(&ctx->plan, &ctx->sweep, MatchClock_ElapsedMs());
+                        if (peak >= 0) {
+                            TRACE3(TR_PLAN, ctx->sweep.numPeaks, ctx->plan.target == TOWER_PLAN_NONE ? -1 : ctx->plan.target,
+                                    ctx->plan.etaMs / 1000);
+                            ctx->alignMs = BeaconSweep_TurnTo(&ctx->sweep, peak, &ctx->alignDir);
+                            nextState = FaceTower;
+                        } else { // nowhere worth going, wander until a beacon shows up
+                            TRACE3(TR_PLAN, ctx->sweep.numPeaks, -1, 0);
+                            nextState = Align;
+                        }
+                        makeTransition = TRUE;
+                        ThisEvent.EventType = ES_NO_EVENT;
+                    }
+                    break;
+
+                case BEACON_FOUND: // the sweep has it already
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
+                case BUMPED: // a front corner caught the tower it just left, back out further and spin again
+                    if (ThisEvent.EventParam & (FL_BUMP_BIT | FR_BUMP_BIT)) {
+                        nextState = ExitHole;
+                        makeTransition = TRUE;
+                    }
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+
+        case FaceTower: // turning back to face the tower picked from the sweep
+            switch (ThisEvent.EventType) {
+                case ES_ENTRY:
+                    StateTimer_Start(TURN_TIMER, ctx->alignMs, HSM_LEVEL_SUB, ctx->CurrentState);
+                    if (ctx->alignDir) {
+                        SetMotors(ACQUIRE_SPEED, -ACQUIRE_SPEED); // on round the way it was spinning
+                    } else {
+                        SetMotors(-ACQUIRE_SPEED, ACQUIRE_SPEED); // back the way it came
+                    }
+                    break;
+
+                case ES_TIMEOUT:
+                    if (ThisEvent.EventParam == TURN_TIMER) { // facing it, SearchForTower can head straight there
+                        ES_Event towerEvent;
+                        towerEvent.EventType = NEW_TOWER;
+                        towerEvent.EventParam = TRUE;
+                        PostRobotHSM(towerEvent);
+                        ThisEvent.EventType = ES_NO_EVENT;
+                    }
+                    break;
+
+                case BEACON_FOUND:
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
+                case BUMPED: // turned into the tower it just left, the sweep was taken too close to it
+                    if (ThisEvent.EventParam & (FL_BUMP_BIT | FR_BUMP_BIT)) {
+                        nextState = ExitHole;
+                        makeTransition = TRUE;
+                    }
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+
         case Align: // now rotating to align with the tower before going in reverse
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    ES_Timer_InitTimer(RESET_TIMER, ALIGN_TICKS);
+                    StateTimer_Start(RESET_TIMER, ALIGN_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
                     SetLeftMotor(ALIGN_SPEED); // speed at which to align with the tower
                     SetRightMotor(-ALIGN_SPEED);
                     break;
@@ -114,7 +215,7 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
                         nextState = Forward;
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
-                        ES_Timer_InitTimer(RESET_TIMER, 900);
+                        ctx->forwardTicks = 900;
                     }
 
                     break;
@@ -128,7 +229,7 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
         case Forward:
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-
+                    StateTimer_Start(RESET_TIMER, ctx->forwardTicks, HSM_LEVEL_SUB, ctx->CurrentState); // armed here so leaving Align/Pivot does not cancel it
                     SetLeftMotor(-50); // the speed at which to back up
                     SetRightMotor(-50);
                     break;
@@ -138,7 +239,6 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
                         nextState = Pivot;
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
-                        ES_Timer_InitTimer(RESET_TIMER, PIVOT_TICKS); // how long to back up for
                     }
             }
             break;
@@ -146,7 +246,7 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
         case Pivot:
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-
+                    StateTimer_Start(RESET_TIMER, PIVOT_TICKS, HSM_LEVEL_SUB, ctx->CurrentState); // how long to pivot for
                     SetLeftMotor(0); // the speed at which to back up
                     SetRightMotor(-100);
                     break;
@@ -156,7 +256,7 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
                         nextState = Forward;
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
-                        ES_Timer_InitTimer(RESET_TIMER, BACK_TICKS); // how long to back up for
+                        ctx->forwardTicks = BACK_TICKS; // how long to back up for
                     }
                     break;
 
@@ -176,13 +276,14 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
                 case ES_ENTRY:
                     SetLeftMotor(-ADJUST_SPEED);
                     SetRightMotor(ADJUST_SPEED); // turn speed
-                    ES_Timer_InitTimer(RESET_TIMER, ADJUST_TICKS);
+                    StateTimer_Start(RESET_TIMER, ADJUST_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
                     break;
 
                 case ES_TIMEOUT:
                     if (ThisEvent.EventParam == RESET_TIMER) {
                         ES_Event towerEvent;
                         towerEvent.EventType = NEW_TOWER;
+                        towerEvent.EventParam = FALSE; // found by wandering, SearchForTower sweeps for it
                         PostRobotHSM(towerEvent);
                     }
                     break;
@@ -192,9 +293,13 @@ ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent) {
 
     if (makeTransition == TRUE) { // making a state transition, send EXIT and ENTRY
         // recursively call the current state with an exit event
-        RunFindNewTowerSubHSM(EXIT_EVENT);
-        CurrentState = nextState;
-        RunFindNewTowerSubHSM(ENTRY_EVENT);
+        RunFindNewTowerSubHSM(ctx, EXIT_EVENT);
+        StateTimer_ExitState(HSM_LEVEL_SUB); // no timer carries over into the next state
+        ctx->CurrentState = nextState;
+        TRACE2(TR_STATE, TRACE_FIND_NEW_TOWER, ctx->CurrentState);
+        StateTimer_EnterState(HSM_LEVEL_SUB, ctx->CurrentState);
+        MatchClock_EnterPhase(PHASE_RELOCATE); // every state of it
+        RunFindNewTowerSubHSM(ctx, ENTRY_EVENT);
     }
 
     ES_Tail(); // trace call stack end
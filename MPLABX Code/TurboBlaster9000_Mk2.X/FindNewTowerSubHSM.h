@@ -9,14 +9,38 @@
  ******************************************************************************/
 
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "BeaconSweep.h"
+#include "TowerPlanner.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// the values the context has when the robot is switched on
+#define FIND_NEW_TOWER_CONTEXT_POWER_ON {.plan = TOWER_PLAN_POWER_ON}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+// everything the machine remembers between events
+typedef struct {
+    uint32_t forwardTicks; // how long Forward drives for, chosen by the state that leads into it
+    uint8_t CurrentState; // a FindNewTowerSubHSMState_t, the enum is in the .c file
+    BeaconSweep_t sweep; // the beacon all the way round from beside the tower just launched at
+    uint16_t alignMs; // how long FaceTower turns for to face the tower picked from the sweep
+    uint8_t alignDir; // TRUE to keep turning the way Survey spins, FALSE to turn back
+    TowerPlan_t plan; // every tower found, kept for the whole match
+    uint8_t wander; // set before Init when the robot is not beside a tower, so it starts in Align
+} FindNewTowerContext_t;
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
 
-uint8_t InitFindNewTowerSubHSM(void);
+uint8_t InitFindNewTowerSubHSM(FindNewTowerContext_t *ctx);
 
-ES_Event RunFindNewTowerSubHSM(ES_Event ThisEvent);
+ES_Event RunFindNewTowerSubHSM(FindNewTowerContext_t *ctx, ES_Event ThisEvent);
 
 #endif /* SUB_NEW_TOWER_H */
 
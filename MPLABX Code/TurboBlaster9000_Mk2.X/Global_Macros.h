@@ -13,46 +13,70 @@
  * macros for directly controlling the state machine 
  ***************************************************/
 
+// the constants wrapped in TUNABLE are plain numbers on the robot. Host builds
+// can run the robot on other values for them, see host/TunableParams.h
+#ifdef __XC32
+#define TUNABLE(name, value) (value)
+#else
+#include "TunableParams.h"
+#endif
+
 // Aquire Tower
-#define TURN_360_TICKS 5000
-#define ACQUIRE_SPEED 75
-#define BEACON_CLOSE_THRESH 0
-#define BEACON_HIGH_THRESH 220
-#define BEACON_LOW_THRESH 200
+#define TURN_360_TICKS TUNABLE(TURN_360_TICKS, 5000)
+#define ACQUIRE_SPEED TUNABLE(ACQUIRE_SPEED, 75)
+#define BEACON_CLOSE_THRESH TUNABLE(BEACON_CLOSE_THRESH, 0)
+#define BEACON_HIGH_THRESH TUNABLE(BEACON_HIGH_THRESH, 220)
+#define BEACON_LOW_THRESH TUNABLE(BEACON_LOW_THRESH, 200)
+#define ALIGN_TOWER_MIN_TICKS 40 // a tower less than this far round is already ahead, no turning back for it
 
 // Approach Tower
-#define APR_SPEED 100
-#define APR_DIFF 40
-#define APR_TIMEOUT 1200
+#define APR_SPEED TUNABLE(APR_SPEED, 100)
+#define APR_DIFF TUNABLE(APR_DIFF, 40) // the hardest the approach steers
+#define APR_GAIN TUNABLE(APR_GAIN, 32) // steering per bearing error, 16 is one motor step per 256th stronger on one side
+#define APR_DITHER TUNABLE(APR_DITHER, 30) // the weave that tells which side the beacon is stronger
+#define APR_CONTROL_TICKS 100
+#define APR_TIMEOUT TUNABLE(APR_TIMEOUT, 1200)
 
 // Align Sensor
-#define ALIGN_SPEED 30
-#define PING_IN_RANGE 4
-#define PING_MAX 15
-#define ALIGN_TIME 2000
-#define LOST_TIMEOUT 4000
+#define ALIGN_SPEED TUNABLE(ALIGN_SPEED, 30)
+#define PING_IN_RANGE TUNABLE(PING_IN_RANGE, 4)
+#define PING_MAX TUNABLE(PING_MAX, 15)
+#define ALIGN_TIME TUNABLE(ALIGN_TIME, 2000)
+#define LOST_TIMEOUT TUNABLE(LOST_TIMEOUT, 4000)
 
 // Traverse Tower
-#define TRAVERSE_SPEED 45
-#define TRAVERSE_CORRECTION 25
-#define TW_HIGH_THRESH 220
+#define TRAVERSE_SPEED TUNABLE(TRAVERSE_SPEED, 65)
+#define TRAVERSE_PASS_TICKS TUNABLE(TRAVERSE_PASS_TICKS, 6900) // ms along a face at TRAVERSE_SPEED before losing the wall means the corner
+#define TRAVERSE_CORRECTION TUNABLE(TRAVERSE_CORRECTION, 25) // the most the wall follower steers by
+#define TRAVERSE_STANDOFF TUNABLE(TRAVERSE_STANDOFF, 1) // echo ms from the tower wall the wall follower holds
+#define TRAVERSE_KP TUNABLE(TRAVERSE_KP, 15) // motor steps per echo ms off the standoff
+#define TRAVERSE_KD TUNABLE(TRAVERSE_KD, 40) // motor steps per echo ms closer or further since the last ping
+#define TRAVERSE_SKIP_SPEED TUNABLE(TRAVERSE_SKIP_SPEED, 70) // along a face already inspected, see TowerMemory.h
+#define TW_HIGH_THRESH TUNABLE(TW_HIGH_THRESH, 220)
+#define HOLE_W_TRACK_WIRE TUNABLE(HOLE_W_TRACK_WIRE, 16) // hole confidence per 256th of each score, fitted with host/HoleFit.c, see HoleEvidence.h
+#define HOLE_W_SIDE_TAPE TUNABLE(HOLE_W_SIDE_TAPE, 2)
+#define HOLE_W_PING TUNABLE(HOLE_W_PING, 2)
+#define HOLE_THRESHOLD TUNABLE(HOLE_THRESHOLD, 5120)
 
 // Drive pass
-#define PASS_TIME 5000
+#define PASS_TIME TUNABLE(PASS_TIME, 5000)
 
 // Turn Around Tower
-#define TURN_TIME 2100
-#define TURN_SPEED 100
+#define TURN_TIME TUNABLE(TURN_TIME, 2100)
+#define TURN_SPEED TUNABLE(TURN_SPEED, 100)
 
 // Align Launcher
-#define ALIGN_LAUNCH_TIME 635
+#define ALIGN_LAUNCH_TIME TUNABLE(ALIGN_LAUNCH_TIME, 635)
 #define CL_TAPE_THRESH 37
 #define CR_TAPE_THRESH 150
-#define C_TAPE_THRESH 350
-#define ALIGN_LAUNCH_FOR_TICKS 600
-#define ALIGN_LAUNCH_BAC_TICKS 500
-#define ALIGN_LAUNCH_SPEED 50
-#define ALIGN_SPEED_DIFF 35
+#define C_TAPE_THRESH TUNABLE(C_TAPE_THRESH, 350)
+#define ALIGN_LAUNCH_FOR_TICKS TUNABLE(ALIGN_LAUNCH_FOR_TICKS, 600)
+#define ALIGN_LAUNCH_BAC_TICKS TUNABLE(ALIGN_LAUNCH_BAC_TICKS, 500)
+#define ALIGN_LAUNCH_SPEED TUNABLE(ALIGN_LAUNCH_SPEED, 50)
+#define ALIGN_SPEED_DIFF TUNABLE(ALIGN_SPEED_DIFF, 35)
+#define ALIGN_KP TUNABLE(ALIGN_KP, 16) // PrecisionAlign steering per 256 counts of CR - CL, up to ALIGN_SPEED_DIFF
+#define ALIGN_CONTROL_TICKS 50
+#define ALIGN_MAX_ATTEMPTS 20 // tries at coming in on the hole, tape seen or not, before it gives up on it
 
 // Launch Ball
 #define FLY_POWER 97
@@ -64,27 +88,44 @@
 #define RESET_SPEED 37
 #define RESET_DIFF 75
 
-// Resolve Obstacle
-#define RESOLVE_TIME 800
-#define RESOLVE_SPEED 75
-#define REVERSE_DIFF 35
-#define FORWARD_DIFF 0
-#define LIGHT_THRESHOLD 700
-#define DARK_THRESHOLD 750
+// Resolve Obstacle, the escapes themselves are a table in ObstacleEscape.c and
+// these are for the situations it has no fitted escape for
+#define RESOLVE_TIME TUNABLE(RESOLVE_TIME, 800)
+#define RESOLVE_SPEED TUNABLE(RESOLVE_SPEED, 75)
+#define REVERSE_DIFF TUNABLE(REVERSE_DIFF, 35)
+#define FORWARD_DIFF TUNABLE(FORWARD_DIFF, 0)
+#define LIGHT_THRESHOLD TUNABLE(LIGHT_THRESHOLD, 700)
+#define DARK_THRESHOLD TUNABLE(DARK_THRESHOLD, 750)
 
 // New Tower
-#define EXIT_SPEED 70
-#define EXIT_TICKS 300
-#define ALIGN_TICKS 1300
+#define EXIT_SPEED TUNABLE(EXIT_SPEED, 70)
+#define EXIT_TICKS TUNABLE(EXIT_TICKS, 300)
+#define ALIGN_TICKS TUNABLE(ALIGN_TICKS, 1300)
 #define REVERSE_TURN_SPEED 95
-#define ADJUST_SPEED 20
-#define ADJUST_TICKS 200
+#define ADJUST_SPEED TUNABLE(ADJUST_SPEED, 20)
+#define ADJUST_TICKS TUNABLE(ADJUST_TICKS, 200)
 #define TURN_TIMEOUT 4000
 
 //encircle
 #define INIT_BACK_TICKS 1000
-#define BACK_TICKS 2300
-#define PIVOT_TICKS 1900
+#define BACK_TICKS TUNABLE(BACK_TICKS, 2300)
+#define PIVOT_TICKS TUNABLE(PIVOT_TICKS, 1900)
+
+// Plan the next tower, see TowerPlanner.h
+#define MATCH_TICKS 120000 // from power on
+#define PLAN_SELF_TICKS (TURN_360_TICKS / 8) // a peak this close to straight ahead after backing out is the tower just left
+#define PLAN_CLEAR_TICKS 1500 // driving off a tower this long before a bump can be another one. Every sooner bump in MonteCarlo was the one it left
+#define PLAN_SAME_TOWER_PCT 30 // a beacon reading this close to one from before is the same tower
+#define PLAN_BEACON_REF_CM 200 // how far away a beacon reads BEACON_HIGH_THRESH
+#define PLAN_APPROACH_CM_PER_S 25
+#define PLAN_SEARCH_TICKS 30000 // bumping into a tower to launching at it
+
+// Time budget of each phase, see MatchClock.h
+#define BUDGET_ACQUIRE_TICKS TUNABLE(BUDGET_ACQUIRE_TICKS, 15000) // three sweeps without a beacon, go and look somewhere else
+#define BUDGET_APPROACH_TICKS TUNABLE(BUDGET_APPROACH_TICKS, 20000)
+#define BUDGET_HOLE_SEARCH_TICKS TUNABLE(BUDGET_HOLE_SEARCH_TICKS, 90000) // the whole visit to a tower, lining up the launcher included. Shorter cut more launches than it saved in MonteCarlo
+#define BUDGET_LAUNCH_TICKS TUNABLE(BUDGET_LAUNCH_TICKS, 60000) // lining up the launcher, the launch itself always finishes
+#define BUDGET_RELOCATE_TICKS TUNABLE(BUDGET_RELOCATE_TICKS, 25000)
 
 /*******************************************************
  * macros for defining pins in motors, sensors and misc
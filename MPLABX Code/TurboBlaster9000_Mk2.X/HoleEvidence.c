@@ -0,0 +1,54 @@
+/*
+ * HoleEvidence.c
+ * Track wire, side tape and ping evidence for the hole, see HoleEvidence.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include <string.h>
+#include "BOARD.h"
+#include "Global_Macros.h"
+#include "HoleEvidence.h"
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// 0 at or below low, HOLE_SCORE_MAX at or above high, a straight line between
+
+static uint16_t Ramp(int32_t reading, int32_t low, int32_t high) {
+    if (reading <= low) return 0;
+    if (reading >= high) return HOLE_SCORE_MAX;
+    return (reading - low) * HOLE_SCORE_MAX / (high - low);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void HoleEvidence_Start(HoleEvidence_t *evidence) {
+    memset(evidence, 0, sizeof (*evidence));
+}
+
+uint8_t HoleEvidence_Add(HoleEvidence_t *evidence, uint16_t trackWire, uint16_t sideTape, uint16_t ping) {
+    uint16_t *score = evidence->score[evidence->numPings % HOLE_EVIDENCE_WINDOW];
+
+    score[HOLE_TRACK_WIRE] = Ramp(trackWire, TW_LOW_THRESH, TW_HIGH_THRESH);
+    score[HOLE_SIDE_TAPE_SCORE] = Ramp(sideTape, HOLE_SIDE_WALL, HOLE_SIDE_TAPE);
+    score[HOLE_PING] = HOLE_SCORE_MAX - Ramp(ping, TRAVERSE_STANDOFF, PING_MAX); // the wall right there
+    if (evidence->numPings < UINT16_MAX) evidence->numPings++;
+
+    for (uint8_t s = 0; s < HOLE_NUM_SCORES; s++) {
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < HOLE_EVIDENCE_WINDOW; i++) {
+            sum += evidence->score[i][s];
+        }
+        evidence->mean[s] = sum / HOLE_EVIDENCE_WINDOW;
+    }
+    evidence->confidence = (int32_t) HOLE_W_TRACK_WIRE * evidence->mean[HOLE_TRACK_WIRE]
+            + (int32_t) HOLE_W_SIDE_TAPE * evidence->mean[HOLE_SIDE_TAPE_SCORE]
+            + (int32_t) HOLE_W_PING * evidence->mean[HOLE_PING];
+    return evidence->numPings >= HOLE_EVIDENCE_WINDOW && evidence->confidence >= HOLE_THRESHOLD;
+}
@@ -0,0 +1,73 @@
+/*
+ * HoleEvidence.h
+ * Decides when Traverse is beside the hole from the track wire, the side tape
+ * sensor and the ping sensor together, instead of needing every one of them
+ * over its own threshold on the same ping.
+ *
+ * On every NEW_PING in Traverse each sensor is turned into a score from 0 (no
+ * sign of the hole) to 256 (as sure as that sensor gets), and each score is
+ * averaged over the last HOLE_EVIDENCE_WINDOW pings, a few cm of wall at
+ * TRAVERSE_SPEED. The confidence is the averages weighted by HOLE_W_TRACK_WIRE,
+ * HOLE_W_SIDE_TAPE and HOLE_W_PING and added up, and the hole is there once it
+ * reaches HOLE_THRESHOLD. One sensor reading low for a ping or two only pulls
+ * the confidence down a little, where it used to throw the hole away.
+ *
+ * The weights and the threshold are a logistic regression over the averages,
+ * fitted by host/HoleFit.c from simulated matches or from samples out of a
+ * recorded run.
+ */
+
+#ifndef HOLE_EVIDENCE_H
+#define	HOLE_EVIDENCE_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define HOLE_EVIDENCE_WINDOW 3 // pings averaged over
+#define HOLE_SCORE_MAX 256
+
+// the side tape sensor reads the wall low and the tape under the hole high,
+// scored from nothing at the first to certain at the second
+#define HOLE_SIDE_WALL 300
+#define HOLE_SIDE_TAPE 700
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef enum {
+    HOLE_TRACK_WIRE,
+    HOLE_SIDE_TAPE_SCORE,
+    HOLE_PING,
+    HOLE_NUM_SCORES,
+} HoleScore_t;
+
+typedef struct {
+    uint16_t score[HOLE_EVIDENCE_WINDOW][HOLE_NUM_SCORES];
+    uint16_t mean[HOLE_NUM_SCORES]; // over the window, 0 to HOLE_SCORE_MAX
+    int32_t confidence; // the weighted sum of the means
+    uint16_t numPings; // since HoleEvidence_Start
+} HoleEvidence_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// forgets everything, for the start of a face
+void HoleEvidence_Start(HoleEvidence_t *evidence);
+
+/*
+ * Adds one ping's readings: the track wire and side tape A/D readings and the
+ * ping sensor's echo ms. Returns TRUE once the confidence has reached
+ * HOLE_THRESHOLD, which needs a full window of pings
+ */
+uint8_t HoleEvidence_Add(HoleEvidence_t *evidence, uint16_t trackWire, uint16_t sideTape, uint16_t ping);
+
+#endif	/* HOLE_EVIDENCE_H */
@@ -0,0 +1,484 @@
+/*
+ * Localizer.c
+ * Particle filter pose on the arena map, see Localizer.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include <string.h>
+#include "ES_Configure.h"
+#include "BOARD.h"
+#include "IO_Ports.h"
+#include "timers.h"
+#include "Global_Macros.h"
+#include "Localizer.h"
+#include "RobotContext.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define ONE 16384 // sines and cosines are out of this
+#define QUARTER_TURN 16384
+#define TURN_PER_RAD 10430 // 65536ths of a turn
+#define WEIGHT_ONE 65535
+#define MAX_STEP_MS 200 // longer gaps are moved as this, the turn math overflows past it
+
+#define TAPE_BITS (FL_TAPE_BIT | FR_TAPE_BIT | BL_TAPE_BIT | BR_TAPE_BIT)
+#define NUM_TAPE_SENSORS 4
+#define NUM_BUMPERS 4
+#define BUMPER_POINTS 3 // each bumper is checked this many places along its half of the edge
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+// sin over a quarter turn in 64 steps
+static const int16_t QuarterSine[65] = {
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801, 3196, 3590, 3981, 4370, 4756,
+    5139, 5520, 5897, 6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765, 9102, 9434,
+    9760, 10080, 10394, 10702, 11003, 11297, 11585, 11866, 12140, 12406, 12665, 12916, 13160,
+    13395, 13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978, 15137, 15286, 15426, 15557,
+    15679, 15791, 15893, 15986, 16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379, 16384,
+};
+
+// where each floor tape sensor and the outer end of each bumper is, in the
+// robot frame in eighths of a mm, x forward and y to the left. The bumpers run
+// in from there to the middle of the edge
+static const int16_t TapeSensorAt[NUM_TAPE_SENSORS][2] = {
+    {LOC_TAPE_SENSOR_X_MM * LOC_UNITS_PER_MM, LOC_TAPE_SENSOR_Y_MM * LOC_UNITS_PER_MM},
+    {LOC_TAPE_SENSOR_X_MM * LOC_UNITS_PER_MM, -LOC_TAPE_SENSOR_Y_MM * LOC_UNITS_PER_MM},
+    {-LOC_TAPE_SENSOR_X_MM * LOC_UNITS_PER_MM, LOC_TAPE_SENSOR_Y_MM * LOC_UNITS_PER_MM},
+    {-LOC_TAPE_SENSOR_X_MM * LOC_UNITS_PER_MM, -LOC_TAPE_SENSOR_Y_MM * LOC_UNITS_PER_MM},
+};
+static const uint8_t TapeSensorBit[NUM_TAPE_SENSORS] = {FL_TAPE_BIT, FR_TAPE_BIT, BL_TAPE_BIT, BR_TAPE_BIT};
+
+static const int16_t BumperAt[NUM_BUMPERS][2] = {
+    {LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM, LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM},
+    {LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM, -LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM},
+    {-LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM, LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM},
+    {-LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM, -LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM},
+};
+static const uint16_t BumperBit[NUM_BUMPERS] = {FL_BUMP_BIT, FR_BUMP_BIT, BL_BUMP_BIT, BR_BUMP_BIT};
+
+#ifdef USE_LOCALIZER
+static const LocMap_t LabMap = LOC_LAB_MAP;
+static const LocPose_t LabStart = LOC_LAB_START;
+#endif
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static int16_t Sin(uint16_t angle) {
+    uint8_t step = angle >> 8; // 256 to a turn
+
+    switch (step >> 6) {
+        case 0: return QuarterSine[step & 63];
+        case 1: return QuarterSine[64 - (step & 63)];
+        case 2: return -QuarterSine[step & 63];
+        default: return -QuarterSine[64 - (step & 63)];
+    }
+}
+
+static int16_t Cos(uint16_t angle) {
+    return Sin(angle + QUARTER_TURN);
+}
+
+static uint32_t Random(LocalizerContext_t *loc) {
+    uint32_t x = loc->rng; // xorshift32
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    loc->rng = x;
+    return x;
+}
+
+// -255 to 255, more often near 0 than out at the ends
+
+static int16_t Noise(LocalizerContext_t *loc) {
+    uint32_t r = Random(loc);
+    return (int16_t) (r & 0xFF) + (int16_t) ((r >> 8) & 0xFF) - 255;
+}
+
+// a wheel's speed in mm/s from its motor power, the way Motor_Control maps
+// power to duty
+
+static int32_t WheelSpeed(int pow) {
+    if (pow == 0) return 0;
+    if (pow > 0) return LOC_WHEEL_MIN_MM_S + pow * (LOC_WHEEL_MAX_MM_S - LOC_WHEEL_MIN_MM_S) / 100;
+    return -LOC_WHEEL_MIN_MM_S + pow * (LOC_WHEEL_MAX_MM_S - LOC_WHEEL_MIN_MM_S) / 100;
+}
+
+// a gain off nominal for each wheel of a guess, up to LOC_WHEEL_MISMATCH_PCT
+
+static void Mismatch(LocalizerContext_t *loc, LocParticle_t *p) {
+    p->leftGain = Noise(loc) * LOC_WHEEL_MISMATCH_PCT / 100;
+    p->rightGain = Noise(loc) * LOC_WHEEL_MISMATCH_PCT / 100;
+}
+
+static int16_t Clamp(int32_t value, int32_t low, int32_t high) {
+    if (value < low) return low;
+    if (value > high) return high;
+    return value;
+}
+
+// anywhere the robot fits on the map, facing any way
+
+static void Scatter(LocalizerContext_t *loc, LocParticle_t *p) {
+    int32_t half = LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM;
+    int32_t w = loc->map.width * LOC_UNITS_PER_MM - 2 * half;
+    int32_t h = loc->map.height * LOC_UNITS_PER_MM - 2 * half;
+
+    p->x = half + Random(loc) % w;
+    p->y = half + Random(loc) % h;
+    p->heading = Random(loc);
+}
+
+// how far a point is outside a tower's square along whichever of its axes it
+// is furthest out, negative inside
+
+static int32_t TowerGap(const LocalizerContext_t *loc, uint8_t t, int32_t x, int32_t y) {
+    int32_t dx = x - loc->map.tower[t].x * LOC_UNITS_PER_MM;
+    int32_t dy = y - loc->map.tower[t].y * LOC_UNITS_PER_MM;
+    int32_t along = (dx * loc->towerCos[t] + dy * loc->towerSin[t]) / ONE;
+    int32_t across = (dy * loc->towerCos[t] - dx * loc->towerSin[t]) / ONE;
+
+    if (along < 0) along = -along;
+    if (across < 0) across = -across;
+    return (along > across ? along : across) - loc->map.towerHalf * LOC_UNITS_PER_MM;
+}
+
+// how far the square chassis reaches out from its center along an axis at
+// this angle to it, from half its side square on to 1.4 times that at 45 degrees
+
+static int32_t Reach(uint16_t angle) {
+    int32_t c = Cos(angle), s = Sin(angle);
+    return LOC_ROBOT_HALF_MM * LOC_UNITS_PER_MM * ((c < 0 ? -c : c) + (s < 0 ? -s : s)) / ONE;
+}
+
+// the tower the chassis would be on top of, near enough, or -1
+
+static int8_t InTower(const LocalizerContext_t *loc, int32_t x, int32_t y, uint16_t heading) {
+    for (uint8_t t = 0; t < loc->map.numTowers; t++) {
+        if (TowerGap(loc, t, x, y) < Reach(heading - loc->map.tower[t].angle)) return t;
+    }
+    return -1;
+}
+
+// a move into a tower with the part of it straight at the face taken out, so
+// what is left runs along the face
+
+static void AlongFace(const LocalizerContext_t *loc, uint8_t t, int32_t x, int32_t y, int32_t *dx, int32_t *dy) {
+    int32_t c = loc->towerCos[t], s = loc->towerSin[t];
+    int32_t fromX = x - loc->map.tower[t].x * LOC_UNITS_PER_MM;
+    int32_t fromY = y - loc->map.tower[t].y * LOC_UNITS_PER_MM;
+    int32_t along = (fromX * c + fromY * s) / ONE;
+    int32_t across = (fromY * c - fromX * s) / ONE;
+    int32_t into;
+
+    if ((along < 0 ? -along : along) < (across < 0 ? -across : across)) { // on a face across the tower's axis
+        int32_t swap = c;
+        c = -s;
+        s = swap;
+    }
+    into = (*dx * c + *dy * s) / ONE;
+    *dx -= into * c / ONE;
+    *dy -= into * s / ONE;
+}
+
+static uint8_t Touching(const LocalizerContext_t *loc, int32_t x, int32_t y) {
+    int32_t reach = LOC_BUMP_REACH_MM * LOC_UNITS_PER_MM;
+
+    if (x < reach || y < reach || x > loc->map.width * LOC_UNITS_PER_MM - reach || y > loc->map.height * LOC_UNITS_PER_MM - reach) {
+        return TRUE;
+    }
+    for (uint8_t t = 0; t < loc->map.numTowers; t++) {
+        if (TowerGap(loc, t, x, y) < reach) return TRUE;
+    }
+    return FALSE;
+}
+
+// whether the beacon detector would trip from a guess: some tower's beacon
+// within the lobe and range, or when sure, well within them and not so close
+// the beacon is over the detector's head. Towers in the way of each other are
+// not worried about
+
+static uint8_t FacingBeacon(const LocalizerContext_t *loc, const LocParticle_t *p, int32_t c, int32_t s, uint8_t sure) {
+    int32_t lobe = sure ? LOC_BEACON_SURE : LOC_BEACON_LOBE;
+    int32_t range = sure ? LOC_BEACON_SURE_MM : LOC_BEACON_RANGE_MM;
+    int32_t near = sure ? LOC_BEACON_NEAR_MM : 0;
+
+    for (uint8_t t = 0; t < loc->map.numTowers; t++) {
+        int32_t dx = loc->map.tower[t].x - p->x / LOC_UNITS_PER_MM;
+        int32_t dy = loc->map.tower[t].y - p->y / LOC_UNITS_PER_MM;
+        int32_t ahead = (dx * c + dy * s) / ONE; // mm
+        int32_t aside = (dy * c - dx * s) / ONE;
+
+        if (aside < 0) aside = -aside;
+        int32_t squared = dx * dx + dy * dy;
+
+        if (ahead > 0 && aside * 256 <= ahead * lobe && squared <= range * range && squared >= near * near) return TRUE;
+    }
+    return FALSE;
+}
+
+// whether anything on the map is at any of the points along a bumper
+
+static uint8_t BumperTouching(const LocalizerContext_t *loc, const LocParticle_t *p, int32_t c, int32_t s, uint8_t k) {
+    for (uint8_t i = 1; i <= BUMPER_POINTS; i++) {
+        int32_t along = BumperAt[k][1] * i / BUMPER_POINTS;
+        int32_t x = p->x + (BumperAt[k][0] * c - along * s) / ONE;
+        int32_t y = p->y + (BumperAt[k][0] * s + along * c) / ONE;
+        if (Touching(loc, x, y)) return TRUE;
+    }
+    return FALSE;
+}
+
+static uint8_t OnTape(const LocalizerContext_t *loc, int32_t x, int32_t y) {
+    int32_t tape = loc->map.tape * LOC_UNITS_PER_MM;
+    return x < tape || y < tape || x > loc->map.width * LOC_UNITS_PER_MM - tape || y > loc->map.height * LOC_UNITS_PER_MM - tape;
+}
+
+// every guess moved ms worth at the powers, each wheel off by its gain and a
+// little more. The wheels take LOC_MOTOR_LAG_MS to catch up with a new power,
+// so they are moved at the average of where the speeds were and where they
+// have got to. Walls and towers stop it the way they stop the robot, sliding
+// along them. A guess already on top of a tower can still get off it
+
+static void Predict(LocalizerContext_t *loc, int leftPow, int rightPow, uint32_t ms) {
+    int32_t left = loc->leftSpeed;
+    int32_t right = loc->rightSpeed;
+    int32_t width = loc->map.width * LOC_UNITS_PER_MM;
+    int32_t height = loc->map.height * LOC_UNITS_PER_MM;
+
+    if (ms > MAX_STEP_MS) ms = MAX_STEP_MS;
+    loc->leftSpeed += (WheelSpeed(leftPow) - loc->leftSpeed) * (int32_t) ms / (LOC_MOTOR_LAG_MS + (int32_t) ms);
+    loc->rightSpeed += (WheelSpeed(rightPow) - loc->rightSpeed) * (int32_t) ms / (LOC_MOTOR_LAG_MS + (int32_t) ms);
+    left = (left + loc->leftSpeed) / 2;
+    right = (right + loc->rightSpeed) / 2;
+    if (left == 0 && right == 0) return; // stopped, nothing moves
+    for (uint16_t i = 0; i < LOC_NUM_PARTICLES; i++) {
+        LocParticle_t *p = &loc->particle[i];
+        int32_t l = left + left * (p->leftGain + Noise(loc) * LOC_WHEEL_NOISE_PCT / 100) / 256;
+        int32_t r = right + right * (p->rightGain + Noise(loc) * LOC_WHEEL_NOISE_PCT / 100) / 256;
+        int32_t turn = (r - l) * (int32_t) ms * TURN_PER_RAD / (1000 * LOC_TRACK_MM);
+        int32_t distance = (l + r) * (int32_t) ms * LOC_UNITS_PER_MM / 2000;
+        int32_t dx, dy, reach;
+        int8_t tower;
+        uint16_t mid;
+
+        turn += Noise(loc) * LOC_HEADING_NOISE / 256;
+        mid = p->heading + turn / 2;
+        dx = distance * Cos(mid) / ONE;
+        dy = distance * Sin(mid) / ONE;
+        p->heading += turn;
+        tower = InTower(loc, p->x + dx, p->y + dy, p->heading);
+        if (tower >= 0 && TowerGap(loc, tower, p->x + dx, p->y + dy) < TowerGap(loc, tower, p->x, p->y)) {
+            AlongFace(loc, tower, p->x, p->y, &dx, &dy);
+            if (TowerGap(loc, tower, p->x + dx, p->y + dy) < TowerGap(loc, tower, p->x, p->y)) continue; // head on
+        }
+        reach = Reach(p->heading);
+        p->x = Clamp(p->x + dx, reach, width - reach);
+        p->y = Clamp(p->y + dy, reach, height - reach);
+    }
+}
+
+// redraws the guesses in proportion to their weights, low variance resampling
+// with the copies made in place over the guesses that were not drawn at all.
+// When even the best guess did not fit a few are scattered anywhere instead,
+// in case they were all wrong. Scattering them every time would leave a
+// steady trickle of guesses in the middle of the field, where nothing is felt
+// and they fit as well as the right ones
+
+static void Resample(LocalizerContext_t *loc, uint32_t total, uint8_t lost) {
+    uint32_t step = total / LOC_NUM_PARTICLES;
+    uint32_t at = Random(loc) % step;
+    uint32_t sum = 0;
+    uint16_t i, free = 0;
+
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        loc->copies[i] = 0;
+        sum += loc->particle[i].weight;
+        while (at < sum && loc->copies[i] < UINT8_MAX) {
+            loc->copies[i]++;
+            at += step;
+        }
+    }
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        while (loc->copies[i] > 1) {
+            while (free < LOC_NUM_PARTICLES && loc->copies[free] != 0) free++;
+            if (free == LOC_NUM_PARTICLES) break;
+            loc->particle[free] = loc->particle[i];
+            loc->particle[free].leftGain += Noise(loc) / 64; // so the copies keep trying gains
+            loc->particle[free].rightGain += Noise(loc) / 64;
+            loc->copies[free] = 1;
+            loc->copies[i]--;
+        }
+    }
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        loc->particle[i].weight = WEIGHT_ONE;
+    }
+    for (i = 0; lost && i < LOC_RANDOM_PARTICLES; i++) {
+        Scatter(loc, &loc->particle[Random(loc) % LOC_NUM_PARTICLES]);
+    }
+}
+
+// every guess weighed against the floor tape, the beacon detector and the
+// bumpers just pressed. A bumper still held from before says nothing new, and
+// weighing it again every update would soon leave only the odd guess that
+// happens to fit
+
+static void Measure(LocalizerContext_t *loc, uint8_t tapeState, uint16_t pressed, uint8_t beacon) {
+    uint8_t onTape = ~tapeState & TAPE_BITS;
+    uint32_t total = 0, small = 0, smallSquares = 0;
+    uint16_t most = 0;
+    uint16_t i;
+
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        LocParticle_t *p = &loc->particle[i];
+        int32_t c = Cos(p->heading), s = Sin(p->heading);
+        uint32_t weight = p->weight;
+        uint8_t k;
+
+        for (k = 0; k < NUM_TAPE_SENSORS; k++) {
+            int32_t x = p->x + (TapeSensorAt[k][0] * c - TapeSensorAt[k][1] * s) / ONE;
+            int32_t y = p->y + (TapeSensorAt[k][0] * s + TapeSensorAt[k][1] * c) / ONE;
+            if (OnTape(loc, x, y) != ((onTape & TapeSensorBit[k]) != 0)) {
+                weight = weight * LOC_TAPE_MISS >> 8;
+            }
+        }
+        if (beacon ? !FacingBeacon(loc, p, c, s, FALSE) : FacingBeacon(loc, p, c, s, TRUE)) {
+            weight = weight * LOC_BEACON_MISS >> 8;
+        }
+        for (k = 0; k < NUM_BUMPERS; k++) {
+            if ((pressed & BumperBit[k]) && !BumperTouching(loc, p, c, s, k)) {
+                weight = weight * LOC_BUMP_MISS >> 8;
+            }
+        }
+        if (InTower(loc, p->x, p->y, p->heading) >= 0) {
+            weight = weight * LOC_BUMP_MISS >> 8; // scattered onto a tower
+        }
+        p->weight = weight;
+        if (weight > most) most = weight;
+    }
+
+    if (most == 0) { // nothing fits what the robot feels, it could be anywhere
+        for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+            Scatter(loc, &loc->particle[i]);
+            loc->particle[i].weight = WEIGHT_ONE;
+        }
+        return;
+    }
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        LocParticle_t *p = &loc->particle[i];
+        p->weight = (uint32_t) p->weight * WEIGHT_ONE / most; // the heaviest back up to WEIGHT_ONE
+        total += p->weight;
+        small += p->weight >> 8;
+        smallSquares += (p->weight >> 8) * (p->weight >> 8);
+    }
+    if (small * small < smallSquares * (LOC_NUM_PARTICLES / 2)) { // fewer than half the guesses count
+        Resample(loc, total, most < WEIGHT_ONE);
+    }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void Localizer_Start(LocalizerContext_t *loc, const LocMap_t *map, const LocPose_t *start, uint32_t seed, uint32_t nowMs) {
+    memset(loc, 0, sizeof (*loc));
+    loc->map = *map;
+    loc->rng = seed | 1;
+    for (uint8_t t = 0; t < map->numTowers; t++) {
+        loc->towerCos[t] = Cos(map->tower[t].angle);
+        loc->towerSin[t] = Sin(map->tower[t].angle);
+    }
+    for (uint16_t i = 0; i < LOC_NUM_PARTICLES; i++) {
+        LocParticle_t *p = &loc->particle[i];
+        if (start == NULL) {
+            Scatter(loc, p);
+        } else {
+            p->x = (start->x + Noise(loc) * (int32_t) start->spread / 255) * LOC_UNITS_PER_MM;
+            p->y = (start->y + Noise(loc) * (int32_t) start->spread / 255) * LOC_UNITS_PER_MM;
+            p->heading = (start->heading + Noise(loc) * (int32_t) start->spread / 4 / 255) * 65536 / 360;
+        }
+        Mismatch(loc, p);
+        p->weight = WEIGHT_ONE;
+    }
+    loc->lastUpdateMs = nowMs;
+    loc->tapeState = TAPE_BITS; // all over the floor
+    loc->bumpers = BumperBit[0] | BumperBit[1] | BumperBit[2] | BumperBit[3];
+    loc->started = TRUE;
+}
+
+uint8_t Localizer_Update(LocalizerContext_t *loc, uint32_t nowMs, int leftPow, int rightPow, uint8_t tapeState, uint16_t bumpers, uint8_t beacon) {
+    uint16_t bumperBits = BumperBit[0] | BumperBit[1] | BumperBit[2] | BumperBit[3];
+
+    tapeState &= TAPE_BITS;
+    bumpers &= bumperBits;
+    if (leftPow == loc->leftPow && rightPow == loc->rightPow && tapeState == loc->tapeState &&
+            bumpers == loc->bumpers && beacon == loc->beacon && nowMs - loc->lastUpdateMs < LOC_UPDATE_MS) {
+        return FALSE;
+    }
+    Predict(loc, loc->leftPow, loc->rightPow, nowMs - loc->lastUpdateMs);
+    Measure(loc, tapeState, loc->bumpers & ~bumpers, beacon);
+    loc->lastUpdateMs = nowMs;
+    loc->leftPow = leftPow;
+    loc->rightPow = rightPow;
+    loc->tapeState = tapeState;
+    loc->bumpers = bumpers;
+    loc->beacon = beacon;
+    return TRUE;
+}
+
+// the heading is averaged as each guess's difference from the heaviest one,
+// which stays right across the wrap from a turn back to 0
+
+void Localizer_GetPose(const LocalizerContext_t *loc, LocPose_t *pose) {
+    const LocParticle_t *best = &loc->particle[0];
+    int32_t sumX = 0, sumY = 0, sumTurn = 0, sumSpread = 0, total = 0;
+    int32_t x, y;
+    uint16_t i;
+
+    for (i = 1; i < LOC_NUM_PARTICLES; i++) {
+        if (loc->particle[i].weight > best->weight) best = &loc->particle[i];
+    }
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        const LocParticle_t *p = &loc->particle[i];
+        int32_t w = (p->weight >> 8) + 1;
+        sumX += w * p->x;
+        sumY += w * p->y;
+        sumTurn += w * (int16_t) (p->heading - best->heading);
+        total += w;
+    }
+    x = sumX / total;
+    y = sumY / total;
+    for (i = 0; i < LOC_NUM_PARTICLES; i++) {
+        const LocParticle_t *p = &loc->particle[i];
+        int32_t dx = p->x - x, dy = p->y - y;
+        sumSpread += ((p->weight >> 8) + 1) * (((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy)) / LOC_UNITS_PER_MM);
+    }
+    pose->x = x / LOC_UNITS_PER_MM;
+    pose->y = y / LOC_UNITS_PER_MM;
+    pose->heading = (int32_t) (int16_t) (best->heading + sumTurn / total) * 360 / 65536;
+    pose->spread = sumSpread / total;
+}
+
+#ifdef USE_LOCALIZER
+
+uint8_t LocalizerTick(void) {
+    LocalizerContext_t *loc = &ROBOT->localizer;
+
+    if (!loc->started) {
+        Localizer_Start(loc, &LabMap, &LabStart, TIMERS_GetTime() + 1, TIMERS_GetTime());
+    }
+    Localizer_Update(loc, TIMERS_GetTime(), ROBOT->motors.leftPow, ROBOT->motors.rightPow,
+            ROBOT->checkers.tapeState, IO_PortsReadPort(BUMPER_PORT), ROBOT->checkers.beaconEvent == BEACON_FOUND);
+    return FALSE;
+}
+
+#endif /* USE_LOCALIZER */
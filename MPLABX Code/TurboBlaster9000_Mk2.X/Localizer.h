@@ -0,0 +1,182 @@
+/*
+ * Localizer.h
+ * Keeps track of where the robot is on a known arena map with a particle
+ * filter, so the state machines can ask for a pose instead of going by how
+ * long they have been driving.
+ *
+ * Each particle is one guess at the pose. There are no wheel encoders, so the
+ * guesses are moved by the motor powers Motor_Control last set, through the
+ * same duty to speed curve the drive has (LOC_WHEEL_MIN_MM_S at the lowest
+ * power, LOC_WHEEL_MAX_MM_S flat out, getting there LOC_MOTOR_LAG_MS late).
+ * Every guess also carries its own guess at how far each motor is off
+ * nominal, up to LOC_WHEEL_MISMATCH_PCT, since one side a few percent slow is
+ * what turns the robot off course the most, and each move is off by up to
+ * LOC_WHEEL_NOISE_PCT more. A guess driven into
+ * a wall or a tower slides along it, or stops if it is head on, as the robot
+ * does. Then every guess is checked against what the robot feels:
+ *  - the four floor tape sensors, against whether each one would be over the
+ *    tape running inside the arena walls from that guess
+ *  - the beacon detector, against whether a tower's beacon would be ahead
+ *    from that guess, within LOC_BEACON_LOBE and LOC_BEACON_RANGE_MM when it
+ *    has tripped, and not well inside them when it has not. Spinning in place
+ *    loses the heading the fastest, and this is what finds it again
+ *  - a bumper pressed, against whether there is a wall or a tower on the map
+ *    right at that bumper
+ *  - being on top of a tower on the map, which only a guess scattered there
+ *    can be
+ * A guess that disagrees loses weight, and once too few guesses carry most of
+ * the weight they are redrawn from the heavy ones, with LOC_RANDOM_PARTICLES
+ * scattered anywhere on the map in case all of them were wrong.
+ *
+ * Everything is integer math: positions in eighths of a mm, headings as a
+ * 16 bit turn, weights out of 65535. LOC_NUM_PARTICLES particles take 10 bytes
+ * each, so the whole filter is under 2.5kB of the PIC32's 16kB. host/Localize.c
+ * checks it against where the simulated robot really was and times it.
+ *
+ * Turn it on with USE_LOCALIZER in ES_Configure.h. LocalizerTick is then an
+ * event checker that updates ROBOT->localizer whenever the motors, the floor
+ * tape, the bumpers or the beacon change, and at least every LOC_UPDATE_MS,
+ * starting from the lab field's LOC_LAB_MAP and LOC_LAB_START. Any state can
+ * read the pose with Localizer_GetPose(&ROBOT->localizer, &pose).
+ */
+
+#ifndef LOCALIZER_H
+#define	LOCALIZER_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "ES_Configure.h"   // USE_LOCALIZER
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define LOC_NUM_PARTICLES 200
+#define LOC_MAX_TOWERS 4
+#define LOC_UNITS_PER_MM 8 // particle positions are in eighths of a mm
+#define LOC_UPDATE_MS 50 // longest between updates while nothing changes
+
+// the robot, Prototype 2's dimensions as ArenaSim models them
+#define LOC_ROBOT_HALF_MM 135 // half the side of the square chassis
+#define LOC_TRACK_MM 230 // between the wheels
+#define LOC_TAPE_SENSOR_X_MM 100 // floor tape sensors, ahead and behind the wheels
+#define LOC_TAPE_SENSOR_Y_MM 90 // and either side of the center line
+
+// the drive, a wheel's speed at power 1 and at 100, power 0 stops it, and
+// about how long it takes to get most of the way to a new speed
+#define LOC_WHEEL_MIN_MM_S 82
+#define LOC_WHEEL_MAX_MM_S 300
+#define LOC_MOTOR_LAG_MS 80
+
+// how far the guesses are spread by each move and how much a disagreeing
+// sensor takes off a guess's weight, in 256ths
+#define LOC_WHEEL_MISMATCH_PCT 10
+#define LOC_WHEEL_NOISE_PCT 15
+#define LOC_HEADING_NOISE 720 // 65536ths of a turn per update, about 4 degrees
+#define LOC_TAPE_MISS 64
+#define LOC_BUMP_MISS 32
+#define LOC_BUMP_REACH_MM 60 // a bumper this close to a wall or tower could be on it
+#define LOC_RANDOM_PARTICLES 2
+
+// the beacon detector's lobe, as 256ths of the tangent of how far off straight
+// ahead it trips, about 23 degrees, and how far away. It is sure to trip within
+// the narrower SURE lobe and range, but not up against the tower
+#define LOC_BEACON_LOBE 108
+#define LOC_BEACON_RANGE_MM 2000
+#define LOC_BEACON_SURE 52
+#define LOC_BEACON_SURE_MM 1500
+#define LOC_BEACON_NEAR_MM 500
+#define LOC_BEACON_MISS 192
+
+// the field as set up in lab, the same one ArenaSim_DefaultConfig builds:
+// 8ft square, 2in tape, three 1ft towers, the robot starting in a corner
+// facing the middle
+#define LOC_LAB_MAP {.width = 2438, .height = 2438, .tape = 50, .towerHalf = 152, .numTowers = 3, \
+        .tower = {{762, 1737, 0}, {1737, 1646, 3129}, {1311, 640, 63450}}}
+#define LOC_LAB_START {.x = 335, .y = 335, .heading = 45, .spread = 50}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    int16_t x, y; // center, in mm
+    uint16_t angle; // rotation of the square, 65536ths of a turn
+} LocTower_t;
+
+// the arena, with its origin in a corner and x and y along the walls
+typedef struct {
+    int16_t width, height; // inside of the walls, in mm
+    int16_t tape; // width of the tape just inside the walls
+    int16_t towerHalf; // half the side of a tower
+    uint8_t numTowers;
+    LocTower_t tower[LOC_MAX_TOWERS];
+} LocMap_t;
+
+// where the robot is, or where it starts out and how sure that is
+typedef struct {
+    int16_t x, y; // mm
+    int16_t heading; // degrees counter clockwise from the x axis, -180 to 179
+    uint16_t spread; // mm, the guesses' average distance from x, y
+} LocPose_t;
+
+typedef struct {
+    int16_t x, y; // eighths of a mm
+    uint16_t heading; // 65536ths of a turn
+    uint16_t weight; // out of 65535
+    int8_t leftGain, rightGain; // how far each motor is off nominal, 256ths
+} LocParticle_t;
+
+typedef struct {
+    LocMap_t map;
+    int16_t towerCos[LOC_MAX_TOWERS], towerSin[LOC_MAX_TOWERS];
+    LocParticle_t particle[LOC_NUM_PARTICLES];
+    uint8_t copies[LOC_NUM_PARTICLES]; // for resampling in place
+    uint32_t rng;
+    uint32_t lastUpdateMs;
+    int8_t leftPow, rightPow; // the powers since the last update
+    int16_t leftSpeed, rightSpeed; // mm/s the wheels had got up to by then
+    uint8_t tapeState; // the floor tape and bumpers at the last update
+    uint16_t bumpers;
+    uint8_t beacon;
+    uint8_t started;
+} LocalizerContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/*
+ * Starts the filter over on a map. With a start pose the guesses are spread
+ * around it by its spread, and by a quarter as many degrees of heading.
+ * With NULL they are spread over the whole map facing every way. The seed
+ * picks the random numbers the guesses are spread with
+ */
+void Localizer_Start(LocalizerContext_t *loc, const LocMap_t *map, const LocPose_t *start, uint32_t seed, uint32_t nowMs);
+
+/*
+ * Moves the guesses by the motor powers in effect since the last update and
+ * checks them against the floor tape, the bumpers and the beacon, if any of
+ * them changed or LOC_UPDATE_MS has gone by. tapeState is the tape checker's
+ * bits, set over the floor, bumpers is BUMPER_PORT as read, clear where
+ * pressed, and beacon is TRUE while the beacon detector has found one.
+ * Returns TRUE if it updated
+ */
+uint8_t Localizer_Update(LocalizerContext_t *loc, uint32_t nowMs, int leftPow, int rightPow, uint8_t tapeState, uint16_t bumpers, uint8_t beacon);
+
+// the weighted average of the guesses
+void Localizer_GetPose(const LocalizerContext_t *loc, LocPose_t *pose);
+
+#ifdef USE_LOCALIZER
+/*
+ * Event checker that keeps ROBOT->localizer up to date, starting it on the lab
+ * field the first time it runs. Never posts anything, so it always returns
+ * FALSE
+ */
+uint8_t LocalizerTick(void);
+#endif
+
+#endif	/* LOCALIZER_H */
@@ -0,0 +1,220 @@
+/*
+ * LoopMonitor.c
+ * ES_Run loop rate and CPU utilization monitor, see LoopMonitor.h
+ *
+ * A pass is the time from one LoopMonitorTick to the next. In that time ES_Run
+ * polls the event checkers, and if one of them found something it runs the
+ * services until their queues are empty. A pass counts as idle when no checker
+ * returned TRUE and no service ran, so busy% is the share of the window spent
+ * in passes that actually did something.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "BOARD.h"
+#include "LoopMonitor.h"
+#include "ProfileClock.h"
+#include "RobotContext.h"
+#include <stdio.h>
+
+#ifdef USE_LOOP_MONITOR
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static const char *SlotNames[NUM_MONITORED] = {
+    "KeyboardInput",
+    "PingFSM",
+    "RobotHSM",
+    "CheckBattery",
+    "EchoEdge",
+    "Bumper",
+    "Beacon",
+    "TapeSensors",
+};
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// adds one timed call to a slot and to the current pass
+
+static void Charge(LoopMonitorSlot_t slot, uint32_t startTicks, uint8_t didWork) {
+    LoopMonitorContext_t *ctx = &ROBOT->loopMonitor;
+    uint32_t us = PROFILE_TICKS_TO_US(ProfileClock_GetTicks() - startTicks);
+    LoopMonitorSlotStats_t *s = &ctx->slotStats[slot];
+
+    s->calls++;
+    s->totalUs += us;
+    if (us > s->maxUs) s->maxUs = us;
+
+    if (didWork) ctx->passDidWork = TRUE;
+    if (us >= ctx->passCulpritUs) {
+        ctx->passCulpritUs = us;
+        ctx->passCulprit = slot;
+    }
+}
+
+static void StartPass(LoopMonitorContext_t *ctx, uint32_t now) {
+    ctx->passStart = now;
+    ctx->passDidWork = FALSE;
+    ctx->passCulprit = NO_CULPRIT;
+    ctx->passCulpritUs = 0;
+}
+
+static void StartWindow(LoopMonitorContext_t *ctx, uint32_t now) {
+    ctx->windowStart = now;
+    ctx->loops = 0;
+    ctx->idleLoops = 0;
+    ctx->busyUs = 0;
+    ctx->worstLoopUs = 0;
+    ctx->worstCulprit = NO_CULPRIT;
+    for (int i = 0; i < NUM_MONITORED; i++) {
+        ctx->slotStats[i].calls = 0;
+        ctx->slotStats[i].totalUs = 0;
+        ctx->slotStats[i].maxUs = 0;
+    }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t LoopMonitorTick(void) {
+    LoopMonitorContext_t *ctx = &ROBOT->loopMonitor;
+    uint32_t now = ProfileClock_GetTicks();
+
+    if (!ctx->started) {
+        ctx->started = TRUE;
+        StartWindow(ctx, now);
+        StartPass(ctx, now);
+        return FALSE;
+    }
+
+    // close out the pass that just finished
+    uint32_t passUs = PROFILE_TICKS_TO_US(now - ctx->passStart);
+    ctx->loops++;
+    if (ctx->passDidWork) {
+        ctx->busyUs += passUs;
+    } else {
+        ctx->idleLoops++;
+    }
+    if (passUs > ctx->worstLoopUs) {
+        ctx->worstLoopUs = passUs;
+        ctx->worstCulprit = ctx->passCulprit;
+    }
+
+#if LOOP_MONITOR_REPORT_MS > 0
+    if (PROFILE_TICKS_TO_US(now - ctx->windowStart) >= LOOP_MONITOR_REPORT_MS * 1000UL) {
+        LoopMonitorReport_t report;
+        LoopMonitor_TakeReport(&report);
+        LoopMonitor_PrintReport(&report);
+        now = ProfileClock_GetTicks(); // don't charge the printing to the next pass
+        ctx->windowStart = now;
+    }
+#endif
+
+    StartPass(ctx, now);
+    return FALSE;
+}
+
+void LoopMonitor_TakeReport(LoopMonitorReport_t *report) {
+    LoopMonitorContext_t *ctx = &ROBOT->loopMonitor;
+    uint32_t now = ProfileClock_GetTicks();
+    uint32_t windowUs = PROFILE_TICKS_TO_US(now - ctx->windowStart);
+
+    report->windowUs = windowUs;
+    report->loops = ctx->loops;
+    report->idleLoops = ctx->idleLoops;
+    report->loopHz = windowUs ? (uint32_t) ((uint64_t) ctx->loops * 1000000 / windowUs) : 0;
+    report->busyPercent = windowUs ? (uint8_t) ((uint64_t) ctx->busyUs * 100 / windowUs) : 0;
+    report->worstLoopUs = ctx->worstLoopUs;
+    report->worstCulprit = ctx->worstCulprit;
+    for (int i = 0; i < NUM_MONITORED; i++) {
+        report->slot[i] = ctx->slotStats[i];
+    }
+
+    StartWindow(ctx, now);
+}
+
+void LoopMonitor_PrintReport(const LoopMonitorReport_t *report) {
+    printf("LOOP: %lu Hz, %u%% busy, %lu/%lu idle, worst pass %lu us (%s)\r\n",
+            (unsigned long) report->loopHz, report->busyPercent,
+            (unsigned long) report->idleLoops, (unsigned long) report->loops,
+            (unsigned long) report->worstLoopUs, LoopMonitor_SlotName(report->worstCulprit));
+    printf("%-14s %8s %8s %8s\r\n", "slot", "calls", "avg", "max");
+    for (int i = 0; i < NUM_MONITORED; i++) {
+        const LoopMonitorSlotStats_t *s = &report->slot[i];
+        if (s->calls == 0) continue;
+        printf("%-14s %8lu %8lu %8lu\r\n", SlotNames[i], (unsigned long) s->calls,
+                (unsigned long) (s->totalUs / s->calls), (unsigned long) s->maxUs);
+    }
+}
+
+const char *LoopMonitor_SlotName(LoopMonitorSlot_t slot) {
+    if (slot >= NUM_MONITORED) return "none";
+    return SlotNames[slot];
+}
+
+ES_Event Monitored_RunKeyboardInput(ES_Event ThisEvent) {
+    uint32_t start = ProfileClock_GetTicks();
+    ES_Event ReturnEvent = RunKeyboardInput(ThisEvent);
+    Charge(MON_KEYBOARD_SERVICE, start, TRUE);
+    return ReturnEvent;
+}
+
+ES_Event Monitored_RunPingFSM(ES_Event ThisEvent) {
+    uint32_t start = ProfileClock_GetTicks();
+    ES_Event ReturnEvent = RunPingFSM(ThisEvent);
+    Charge(MON_PING_SERVICE, start, TRUE);
+    return ReturnEvent;
+}
+
+ES_Event Monitored_RunRobotHSM(ES_Event ThisEvent) {
+    uint32_t start = ProfileClock_GetTicks();
+    ES_Event ReturnEvent = RunRobotHSM(ThisEvent);
+    Charge(MON_ROBOT_SERVICE, start, TRUE);
+    return ReturnEvent;
+}
+
+uint8_t Monitored_TemplateCheckBattery(void) {
+    uint32_t start = ProfileClock_GetTicks();
+    uint8_t returnVal = TemplateCheckBattery();
+    Charge(MON_BATTERY_CHECKER, start, returnVal);
+    return returnVal;
+}
+
+uint8_t Monitored_EchoEdgeDetection(void) {
+    uint32_t start = ProfileClock_GetTicks();
+    uint8_t returnVal = EchoEdgeDetection();
+    Charge(MON_ECHO_CHECKER, start, returnVal);
+    return returnVal;
+}
+
+uint8_t Monitored_BumperDetection(void) {
+    uint32_t start = ProfileClock_GetTicks();
+    uint8_t returnVal = BumperDetection();
+    Charge(MON_BUMPER_CHECKER, start, returnVal);
+    return returnVal;
+}
+
+uint8_t Monitored_BeaconDetection(void) {
+    uint32_t start = ProfileClock_GetTicks();
+    uint8_t returnVal = BeaconDetection();
+    Charge(MON_BEACON_CHECKER, start, returnVal);
+    return returnVal;
+}
+
+uint8_t Monitored_CheckTapeSensors(void) {
+    uint32_t start = ProfileClock_GetTicks();
+    uint8_t returnVal = CheckTapeSensors();
+    Charge(MON_TAPE_CHECKER, start, returnVal);
+    return returnVal;
+}
+
+#endif /* USE_LOOP_MONITOR */
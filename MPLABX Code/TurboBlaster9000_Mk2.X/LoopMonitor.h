@@ -0,0 +1,116 @@
+/*
+ * LoopMonitor.h
+ * Measures how fast the ES_Run main loop goes around and where its time goes.
+ *
+ * ES_Run itself lives in the ECE118 library, so the monitor hooks in through
+ * ES_Configure.h instead: LoopMonitorTick is put first in the event checker list,
+ * so it runs exactly once per pass of the loop, and every service Run function
+ * and event checker is swapped for a wrapper that times it.
+ *
+ * Turn it on with USE_LOOP_MONITOR in ES_Configure.h. Every LOOP_MONITOR_REPORT_MS
+ * it prints the loop rate, how busy the loop was, and the slowest pass along with
+ * the service or checker that took the most time in it.
+ */
+
+#ifndef LOOP_MONITOR_H
+#define	LOOP_MONITOR_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "BOARD.h"
+#include "ProjectEventChecker.h"
+#include "ES_KeyboardInput.h"
+#include "PingSensorFSM.h"
+#include "RobotHSM.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define LOOP_MONITOR_REPORT_MS 5000 // how often the report is printed, 0 to never print
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+// every service and event checker that gets timed, in the order they are reported
+typedef enum {
+    MON_KEYBOARD_SERVICE,
+    MON_PING_SERVICE,
+    MON_ROBOT_SERVICE,
+    MON_BATTERY_CHECKER,
+    MON_ECHO_CHECKER,
+    MON_BUMPER_CHECKER,
+    MON_BEACON_CHECKER,
+    MON_TAPE_CHECKER,
+    NUM_MONITORED,
+    NO_CULPRIT = NUM_MONITORED, // a pass where nothing was timed
+} LoopMonitorSlot_t;
+
+typedef struct {
+    uint32_t calls; // times this service or checker ran in the window
+    uint32_t totalUs; // total time spent in it
+    uint32_t maxUs; // slowest single call
+} LoopMonitorSlotStats_t;
+
+typedef struct {
+    uint32_t windowUs; // length of the window the report covers
+    uint32_t loops; // passes of the main loop
+    uint32_t idleLoops; // passes where no service ran and no checker found an event
+    uint32_t loopHz; // loops per second
+    uint8_t busyPercent; // share of the window spent in passes that did work
+    uint32_t worstLoopUs; // slowest single pass
+    LoopMonitorSlot_t worstCulprit; // biggest contributor to the slowest pass
+    LoopMonitorSlotStats_t slot[NUM_MONITORED];
+} LoopMonitorReport_t;
+
+typedef struct {
+    LoopMonitorSlotStats_t slotStats[NUM_MONITORED];
+    uint32_t windowStart; // ticks when the current window began
+    uint32_t passStart; // ticks when the current pass began
+    uint32_t loops;
+    uint32_t idleLoops;
+    uint32_t busyUs; // time spent in passes that did work
+    uint32_t worstLoopUs;
+    LoopMonitorSlot_t worstCulprit;
+    uint8_t started; // FALSE until the first pass has been started
+
+    // the pass that is running right now
+    uint8_t passDidWork;
+    LoopMonitorSlot_t passCulprit;
+    uint32_t passCulpritUs;
+} LoopMonitorContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/*
+ * Event checker that marks the start of every pass of the main loop. Must be the
+ * first entry of EVENT_CHECK_LIST. Never posts anything, so it always returns FALSE
+ */
+uint8_t LoopMonitorTick(void);
+
+// fills in the report for the window since the last report, then starts a new window
+void LoopMonitor_TakeReport(LoopMonitorReport_t *report);
+
+// prints a report in the same format as the periodic one
+void LoopMonitor_PrintReport(const LoopMonitorReport_t *report);
+
+// returns the printable name of a monitored service or checker
+const char *LoopMonitor_SlotName(LoopMonitorSlot_t slot);
+
+// timed wrappers, selected in ES_Configure.h when USE_LOOP_MONITOR is defined
+ES_Event Monitored_RunKeyboardInput(ES_Event ThisEvent);
+ES_Event Monitored_RunPingFSM(ES_Event ThisEvent);
+ES_Event Monitored_RunRobotHSM(ES_Event ThisEvent);
+uint8_t Monitored_TemplateCheckBattery(void);
+uint8_t Monitored_EchoEdgeDetection(void);
+uint8_t Monitored_BumperDetection(void);
+uint8_t Monitored_BeaconDetection(void);
+uint8_t Monitored_CheckTapeSensors(void);
+
+#endif	/* LOOP_MONITOR_H */
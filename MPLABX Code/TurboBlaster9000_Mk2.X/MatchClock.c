@@ -0,0 +1,139 @@
+/*
+ * MatchClock.c
+ * Match time and the time budget of each phase, see MatchClock.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "BOARD.h"
+#include "Global_Macros.h"
+#include "RobotHSM.h"
+#include "MatchClock.h"
+#include "RobotContext.h"
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// adds the visit in progress, up to nowMs, onto the stats. A visit that took
+// no time is not one: RobotHSM's ES_INIT runs every sub HSM's Init at power on,
+// and each of them enters its first phase on the way through
+
+static void AddVisit(const MatchClockContext_t *clock, uint32_t nowMs, MatchPhaseStats_t *stats) {
+    uint32_t ms = nowMs - clock->phaseStartMs;
+
+    if (ms == 0) return;
+    stats->visits++;
+    stats->totalMs += ms;
+    if (ms > stats->longestMs) stats->longestMs = ms;
+    if (clock->posted) stats->exceeded++;
+}
+
+// the hole search budget runs for the whole time at a tower, see MatchClock.h
+
+static uint8_t AtTowerPhase(uint8_t phase) {
+    return phase == PHASE_HOLE_SEARCH || phase == PHASE_LAUNCH;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void MatchClock_EnterPhase(uint8_t phase) {
+    MatchClockContext_t *clock = &ROBOT->matchClock;
+    uint32_t now = TIMERS_GetTime();
+
+    if (phase == clock->phase || phase >= NUM_MATCH_PHASES) return;
+    if (clock->phase != PHASE_NONE) AddVisit(clock, now, &clock->stats[clock->phase]);
+    clock->phase = phase;
+    clock->phaseStartMs = now;
+    clock->posted = FALSE;
+    if (!AtTowerPhase(phase)) clock->atTower = FALSE;
+}
+
+void MatchClock_StartTower(void) {
+    MatchClockContext_t *clock = &ROBOT->matchClock;
+
+    clock->atTower = TRUE;
+    clock->towerPosted = FALSE;
+    clock->towerStartMs = TIMERS_GetTime();
+}
+
+uint32_t MatchClock_ElapsedMs(void) {
+    return TIMERS_GetTime();
+}
+
+uint32_t MatchClock_RemainingMs(void) {
+    uint32_t now = TIMERS_GetTime();
+    return now < MATCH_TICKS ? MATCH_TICKS - now : 0;
+}
+
+uint8_t MatchClock_Phase(void) {
+    return ROBOT->matchClock.phase;
+}
+
+uint32_t MatchClock_PhaseMs(void) {
+    return TIMERS_GetTime() - ROBOT->matchClock.phaseStartMs;
+}
+
+uint8_t MatchClock_BudgetRunning(uint8_t phase) {
+    const MatchClockContext_t *clock = &ROBOT->matchClock;
+
+    if (phase == PHASE_HOLE_SEARCH) return clock->atTower && AtTowerPhase(clock->phase);
+    return phase == clock->phase;
+}
+
+// the budgets are TUNABLE, so the table is filled in on every call instead of
+// being a static const
+
+uint32_t MatchClock_Budget(uint8_t phase) {
+    const uint32_t budget[NUM_MATCH_PHASES] = {
+        [PHASE_ACQUIRE] = BUDGET_ACQUIRE_TICKS,
+        [PHASE_APPROACH] = BUDGET_APPROACH_TICKS,
+        [PHASE_HOLE_SEARCH] = BUDGET_HOLE_SEARCH_TICKS,
+        [PHASE_LAUNCH] = BUDGET_LAUNCH_TICKS,
+        [PHASE_RELOCATE] = BUDGET_RELOCATE_TICKS,
+    };
+
+    return phase < NUM_MATCH_PHASES ? budget[phase] : 0;
+}
+
+void MatchClock_GetStats(uint8_t phase, MatchPhaseStats_t *stats) {
+    const MatchClockContext_t *clock = &ROBOT->matchClock;
+
+    if (phase >= NUM_MATCH_PHASES) {
+        stats->visits = stats->exceeded = 0;
+        stats->totalMs = stats->longestMs = 0;
+        return;
+    }
+    *stats = clock->stats[phase];
+    if (phase == clock->phase && phase != PHASE_NONE) AddVisit(clock, TIMERS_GetTime(), stats);
+}
+
+uint8_t MatchClockCheck(void) {
+    MatchClockContext_t *clock = &ROBOT->matchClock;
+    uint32_t now = TIMERS_GetTime();
+    uint32_t budget = MatchClock_Budget(clock->phase);
+    ES_Event ThisEvent;
+
+    ThisEvent.EventType = BUDGET_EXCEEDED;
+    if (MatchClock_BudgetRunning(PHASE_HOLE_SEARCH) && !clock->towerPosted &&
+            now - clock->towerStartMs >= MatchClock_Budget(PHASE_HOLE_SEARCH)) {
+        clock->towerPosted = TRUE;
+        clock->stats[PHASE_HOLE_SEARCH].exceeded++;
+        ThisEvent.EventParam = PHASE_HOLE_SEARCH;
+        PostRobotHSM(ThisEvent);
+        return TRUE;
+    }
+    if (clock->phase == PHASE_HOLE_SEARCH || clock->posted || budget == 0 || now - clock->phaseStartMs < budget) {
+        return FALSE;
+    }
+    clock->posted = TRUE;
+    ThisEvent.EventParam = clock->phase;
+    PostRobotHSM(ThisEvent);
+    return TRUE;
+}
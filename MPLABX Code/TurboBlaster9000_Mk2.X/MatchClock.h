@@ -0,0 +1,109 @@
+/*
+ * MatchClock.h
+ * How long the match has been going and how long the robot has spent on what
+ * it is doing now, so no one part of the match can eat the rest of it.
+ *
+ * Every state of the sub HSMs belongs to a phase of going after a tower:
+ * acquiring it, approaching it, searching it for the hole, launching at the
+ * hole, and relocating to the next tower. SearchForTower and SearchForHole
+ * have a StatePhase table next to their StateNames, everything FindNewTower
+ * does is relocating, and each of them tells the clock whenever it changes
+ * state. The time in a phase runs from the first state of it until a state of
+ * another phase, so SearchForHole cycling through AlignSensor, Traverse and
+ * DriveTo is all one hole search.
+ *
+ * Each phase has a budget, from the BUDGET_..._TICKS in Global_Macros.h.
+ * MatchClockCheck is an event checker that posts BUDGET_EXCEEDED to RobotHSM,
+ * with the phase as its param, when a visit to a phase goes over its budget.
+ * The hole search is the exception: SearchForHole goes back and forth between
+ * searching and lining up the launcher every time a hole does not pan out, so
+ * its budget is for the whole time at a tower, from MatchClock_StartTower when
+ * RobotHSM gets there until the robot is doing something other than searching
+ * or launching, and it goes over whichever of the two it is in.
+ * What to give up is up to RobotHSM. A launch that has started always finishes.
+ *
+ * The clock also keeps how many times each phase came up, how long it took
+ * in all and at the longest, and how many times it went over, for picking the
+ * budgets, see host/MonteCarlo.c. Visits that took no time, like the ones the
+ * power on ES_INIT passes through, are left out.
+ */
+
+#ifndef MATCH_CLOCK_H
+#define	MATCH_CLOCK_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef enum {
+    PHASE_NONE, // before RobotHSM is in any state, never over budget
+    PHASE_ACQUIRE,
+    PHASE_APPROACH,
+    PHASE_HOLE_SEARCH,
+    PHASE_LAUNCH,
+    PHASE_RELOCATE,
+    NUM_MATCH_PHASES,
+} MatchPhase_t;
+
+typedef struct {
+    uint16_t visits; // times the phase was entered
+    uint16_t exceeded; // visits that went over budget
+    uint32_t totalMs;
+    uint32_t longestMs; // the longest single visit
+} MatchPhaseStats_t;
+
+typedef struct {
+    uint8_t phase; // a MatchPhase_t
+    uint8_t posted; // BUDGET_EXCEEDED already went out for this visit
+    uint8_t atTower; // the hole search budget is running from towerStartMs
+    uint8_t towerPosted; // and BUDGET_EXCEEDED already went out for it
+    uint32_t phaseStartMs;
+    uint32_t towerStartMs;
+    MatchPhaseStats_t stats[NUM_MATCH_PHASES]; // visits before the current one
+} MatchClockContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// called by a sub HSM when it enters a state, with that state's phase. Starts
+// the phase's budget over if it is a different phase from the one before
+void MatchClock_EnterPhase(uint8_t phase);
+
+// called by RobotHSM when it starts searching a tower for the hole, starts the
+// hole search budget for the visit
+void MatchClock_StartTower(void);
+
+// since power on, and until the match is over at MATCH_TICKS, 0 after
+uint32_t MatchClock_ElapsedMs(void);
+uint32_t MatchClock_RemainingMs(void);
+
+// the phase the robot is in and how long it has been in it
+uint8_t MatchClock_Phase(void);
+uint32_t MatchClock_PhaseMs(void);
+
+// TRUE while the budget of a phase is running, so its BUDGET_EXCEEDED is not
+// stale: the phase is the current one, or for the hole search the robot is
+// still at the tower
+uint8_t MatchClock_BudgetRunning(uint8_t phase);
+
+// the budget of a phase in ms, 0 for none
+uint32_t MatchClock_Budget(uint8_t phase);
+
+// what a phase took so far, counting the visit in progress
+void MatchClock_GetStats(uint8_t phase, MatchPhaseStats_t *stats);
+
+/*
+ * Event checker that posts BUDGET_EXCEEDED to RobotHSM, param the phase, the
+ * first time the current visit to a phase, or to a tower for the hole search,
+ * runs past its budget. Returns TRUE if it posted
+ */
+uint8_t MatchClockCheck(void);
+
+#endif	/* MATCH_CLOCK_H */
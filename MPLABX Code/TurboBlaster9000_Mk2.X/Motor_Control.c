@@ -13,13 +13,11 @@
 #include "Motor_Control.h"
 #include "Global_Macros.h"
 #include "RC_Servo.h"
+#include "Trace.h"
+#include "RobotContext.h"
 
 #define ENABLE_MOTORS
 
-static int rightPow = 0;
-static int leftPow = 0;
-static int flyPow = 0;
-
 // initializes the motors' pins
 
 void InitMotors(void) {
@@ -83,7 +81,10 @@ void SetRightMotor(int pow) {
         IO_PortsClearPortBits(MOTOR_PORT, RIGHT_IN1_PIN);
     }
 
-    rightPow = pow; // set the global variable for returns
+    if (pow != ROBOT->motors.rightPow) {
+        TRACE2(TR_MOTORS, ROBOT->motors.leftPow, pow);
+    }
+    ROBOT->motors.rightPow = pow; // set the global variable for returns
 }
 
 /*
@@ -119,7 +120,10 @@ void SetLeftMotor(int pow) {
         IO_PortsClearPortBits(MOTOR_PORT, LEFT_IN1_PIN);
     }
 
-    leftPow = pow; // set the global variable for returns
+    if (pow != ROBOT->motors.leftPow) {
+        TRACE2(TR_MOTORS, pow, ROBOT->motors.rightPow);
+    }
+    ROBOT->motors.leftPow = pow; // set the global variable for returns
 }
 
 // set the power on both motors, same convention as singles
@@ -132,13 +136,13 @@ void SetMotors(int powL, int powR) {
 // get the left motor's power
 
 int getLeftPow(void) {
-    return leftPow;
+    return ROBOT->motors.leftPow;
 }
 
 // get the right motor's power
 
 int getRightPow(void) {
-    return rightPow;
+    return ROBOT->motors.rightPow;
 }
 
 /* FOR THE LAUNCHER'S FLYWHEEL AND SERVO */
@@ -163,11 +167,14 @@ void setFlyMotor(uint32_t pow) {
         return;
     }
     PWM_SetDutyCycle(FLY_PIN, pow * 10);
-    flyPow = pow;
+    if (pow != ROBOT->motors.flyPow) {
+        TRACE1(TR_FLYWHEEL, pow);
+    }
+    ROBOT->motors.flyPow = pow;
 }
 
 // returns current flywheel power
 
 uint32_t getFlyDuty(void) {
-    return flyPow;
+    return ROBOT->motors.flyPow;
 }
\ No newline at end of file
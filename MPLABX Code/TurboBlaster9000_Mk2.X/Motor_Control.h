@@ -10,6 +10,13 @@
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
 #include "BOARD.h"
 
+// the powers last set, what the getters return
+typedef struct {
+    int rightPow;
+    int leftPow;
+    int flyPow;
+} MotorContext_t;
+
 // DA FUNCTIONS
 
 // initializes the motors' pins
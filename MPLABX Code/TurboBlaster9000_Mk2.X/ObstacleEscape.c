@@ -0,0 +1,123 @@
+/*
+ * ObstacleEscape.c
+ * The escape ResolveObstacle takes from each situation, see ObstacleEscape.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include "BOARD.h"
+#include "IO_Ports.h"
+#include "Global_Macros.h"
+#include "RobotContext.h"
+#include "ObstacleEscape.h"
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static const uint16_t CornerBump[ESCAPE_NUM_CORNERS] = {FL_BUMP_BIT, FR_BUMP_BIT, BL_BUMP_BIT, BR_BUMP_BIT};
+
+// left power, right power and time, by key: no corner or the first corner
+// blocked, for each way the robot was moving. ESCAPE_UNFITTED where the fit
+// did not get into the key often enough
+static const ObstacleEscape_t EscapeTable[ESCAPE_NUM_KEYS] = {
+    // ESCAPE TABLE BEGIN, written by host/EscapeFit.c
+    // EscapeFit -s 1 on 600 situations, 16 of the keys fitted
+    {0, 0, 1}, // clear, stopped
+    {-100, -75, 25}, // FL, stopped
+    {-75, -100, 25}, // FR, stopped
+    {75, 75, 25}, // BL, stopped
+    {75, 75, 25}, // BR, stopped
+    {-75, -75, 30}, // clear, forward
+    {-100, -100, 25}, // FL, forward
+    {-100, -100, 25}, // FR, forward
+    ESCAPE_UNFITTED, // BL, forward, goes by stopped
+    ESCAPE_UNFITTED, // BR, forward, goes by stopped
+    {75, 75, 30}, // clear, backward
+    ESCAPE_UNFITTED, // FL, backward, goes by stopped
+    ESCAPE_UNFITTED, // FR, backward, goes by stopped
+    {100, 100, 25}, // BL, backward
+    {100, 100, 25}, // BR, backward
+    {75, -75, 30}, // clear, spin left
+    {-100, 75, 60}, // FL, spin left
+    {-100, -100, 15}, // FR, spin left
+    {75, 100, 15}, // BL, spin left
+    {-75, 100, 40}, // BR, spin left
+    {-75, 75, 30}, // clear, spin right
+    {-100, -100, 15}, // FL, spin right
+    {75, -100, 60}, // FR, spin right
+    {100, -75, 40}, // BL, spin right
+    {75, 100, 15}, // BR, spin right
+    // ESCAPE TABLE END
+};
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t ObstacleEscape_Situation(uint16_t bumped, uint8_t tapeState, int leftPow, int rightPow) {
+    uint8_t corners = ~tapeState & ESCAPE_CORNER_MASK;
+    uint8_t motion;
+    int along = leftPow + rightPow, turn = rightPow - leftPow;
+
+    for (int i = 0; i < ESCAPE_NUM_CORNERS; i++) {
+        if (bumped & CornerBump[i]) corners |= 1 << i;
+    }
+    if (leftPow == 0 && rightPow == 0) {
+        motion = ESCAPE_STOPPED;
+    } else if (abs(along) > abs(turn)) { // more driving than turning
+        motion = along > 0 ? ESCAPE_FORWARD : ESCAPE_BACKWARD;
+    } else {
+        motion = turn > 0 ? ESCAPE_SPIN_LEFT : ESCAPE_SPIN_RIGHT;
+    }
+    return corners | motion << ESCAPE_NUM_CORNERS;
+}
+
+uint8_t ObstacleEscape_Sense(uint16_t bumped) {
+    bumped |= ~IO_PortsReadPort(BUMPER_PORT); // the bumpers read low when pressed
+    return ObstacleEscape_Situation(bumped, ROBOT->checkers.tapeState, getLeftPow(), getRightPow());
+}
+
+uint8_t ObstacleEscape_Key(uint8_t situation) {
+    uint8_t key = 0; // none blocked
+    uint8_t motion;
+
+    if (situation >= ESCAPE_NUM_SITUATIONS) situation = ESCAPE_CORNERS(situation);
+    for (int i = 0; i < ESCAPE_NUM_CORNERS && key == 0; i++) {
+        if (situation & (1 << i)) key = i + 1;
+    }
+    motion = ESCAPE_MOTION(situation);
+    if ((motion == ESCAPE_FORWARD && (ESCAPE_KEY_CORNERS(key) & (BL_TAPE_BIT | BR_TAPE_BIT))) ||
+            (motion == ESCAPE_BACKWARD && (ESCAPE_KEY_CORNERS(key) & (FL_TAPE_BIT | FR_TAPE_BIT)))) {
+        motion = ESCAPE_STOPPED; // already driving away from it
+    }
+    return key + motion * (ESCAPE_NUM_CORNERS + 1);
+}
+
+ObstacleEscape_t ObstacleEscape_Plan(uint8_t situation) {
+    uint8_t key = ObstacleEscape_Key(situation);
+
+    if (EscapeTable[key].time != 0) return EscapeTable[key];
+    return ObstacleEscape_Resolve(ESCAPE_KEY_CORNERS(key));
+}
+
+ObstacleEscape_t ObstacleEscape_Resolve(uint8_t corners) {
+    ObstacleEscape_t escape = {.time = RESOLVE_TIME / ESCAPE_TIME_UNIT};
+
+    if (corners & (FL_TAPE_BIT | FR_TAPE_BIT)) { // FL and FR resolve both backed away the same
+        escape.left = -RESOLVE_SPEED;
+        escape.right = -(RESOLVE_SPEED - REVERSE_DIFF);
+    } else if (corners & BL_TAPE_BIT) {
+        escape.left = RESOLVE_SPEED;
+        escape.right = RESOLVE_SPEED - FORWARD_DIFF;
+    } else if (corners & BR_TAPE_BIT) {
+        escape.left = RESOLVE_SPEED - FORWARD_DIFF;
+        escape.right = RESOLVE_SPEED;
+    } else { // nothing to get away from
+        escape.time = 1;
+    }
+    return escape;
+}
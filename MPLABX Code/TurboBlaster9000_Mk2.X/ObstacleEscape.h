@@ -0,0 +1,105 @@
+/*
+ * ObstacleEscape.h
+ * Picks how ResolveObstacle gets the robot away from whatever it ran into,
+ * from everything the bumpers and the floor tape say at once and from how the
+ * robot was moving, where it used to go by the first corner it found in the
+ * order FL, FR, BL, BR.
+ *
+ * The situation is which of the four corners are blocked, a bumper pressed or
+ * the floor tape sensor over tape, and whether the motors were stopped,
+ * driving forward or back, or spinning one way or the other. The escape table
+ * is keyed by only as much of it as host/EscapeFit.c could fit: the first
+ * corner blocked in the order FL, FR, BL, BR, or none, and the motion. Two
+ * corners at once hardly ever happen as the robot runs into something, 6 of
+ * the 571 situations the fit got into, too few to fit any of the 55 of them,
+ * so they go by their first corner the way the four resolve states did.
+ * Driving straight away from the only corner blocked never happened at all,
+ * it goes by stopped and its four entries are never looked up. Each key has
+ * its own escape: the two motor powers and how long to hold them. With nothing
+ * blocked any more the escape takes back a little of what the robot was
+ * doing, and stopped there is nothing to get away from, that escape stands
+ * still for a moment and hands straight back.
+ *
+ * The table is fitted by host/EscapeFit.c, which drives the simulated robot
+ * into walls and towers every way it can, tries every escape on each
+ * situation it gets into and keeps the one that is clear of everything the
+ * soonest without running into something else. It writes the table into
+ * ObstacleEscape.c, and checks it against the four resolve states it replaced.
+ * A key it did not get into often enough to fit is written as ESCAPE_UNFITTED,
+ * and takes the escape the four states would have: back away from the corner
+ * when it is at the front, drive forward when it is at the back, with
+ * RESOLVE_SPEED and RESOLVE_TIME.
+ */
+
+#ifndef OBSTACLE_ESCAPE_H
+#define	OBSTACLE_ESCAPE_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define ESCAPE_NUM_CORNERS 4
+#define ESCAPE_CORNER_MASK 0x0F // the corners are the same bits as FL_TAPE_BIT to BR_TAPE_BIT
+#define ESCAPE_CORNERS(situation) ((situation) & ESCAPE_CORNER_MASK)
+#define ESCAPE_MOTION(situation) ((situation) >> ESCAPE_NUM_CORNERS)
+#define ESCAPE_NUM_SITUATIONS ((ESCAPE_CORNER_MASK + 1) * ESCAPE_NUM_MOTIONS)
+#define ESCAPE_NUM_KEYS ((ESCAPE_NUM_CORNERS + 1) * ESCAPE_NUM_MOTIONS) // no corner or the first one, for each motion, see ObstacleEscape_Key
+#define ESCAPE_KEY_CORNERS(key) ((key) % (ESCAPE_NUM_CORNERS + 1) ? 1 << ((key) % (ESCAPE_NUM_CORNERS + 1) - 1) : 0)
+#define ESCAPE_KEY_MOTION(key) ((key) / (ESCAPE_NUM_CORNERS + 1))
+#define ESCAPE_TIME_UNIT 10 // ms per count of an escape's time
+#define ESCAPE_UNFITTED {0, 0, 0} // a table entry with no escape fitted, see ObstacleEscape_Plan
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef enum {
+    ESCAPE_STOPPED,
+    ESCAPE_FORWARD,
+    ESCAPE_BACKWARD,
+    ESCAPE_SPIN_LEFT, // counter clockwise
+    ESCAPE_SPIN_RIGHT,
+    ESCAPE_NUM_MOTIONS,
+} EscapeMotion_t;
+
+typedef struct {
+    int8_t left, right; // motor powers, -100 to 100
+    uint8_t time; // how long to hold them, in ESCAPE_TIME_UNITs
+} ObstacleEscape_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/*
+ * The situation from bumped, a bit set for each bumper pressed (FL_BUMP_BIT
+ * to BR_BUMP_BIT), tapeState, the seven tape bits the tape checker keeps, set
+ * where the sensor is over the floor, and the motor powers last set. Only the
+ * four corner tape sensors block a corner, the launcher and side sensors look
+ * at the tower walls and not at the floor
+ */
+uint8_t ObstacleEscape_Situation(uint16_t bumped, uint8_t tapeState, int leftPow, int rightPow);
+
+// the situation as the bumpers, the tape checker's debounced floor tape state
+// and the motors are now, with the bumpers in bumped counted as pressed too,
+// for a BUMPED whose bumper has already let go
+uint8_t ObstacleEscape_Sense(uint16_t bumped);
+
+// which entry of the escape table a situation goes by: its first corner
+// blocked and its motion, stopped when driving straight away from the corner
+uint8_t ObstacleEscape_Key(uint8_t situation);
+
+// the escape for a situation, the fitted one or for an ESCAPE_UNFITTED entry
+// ObstacleEscape_Resolve of its first corner
+ObstacleEscape_t ObstacleEscape_Plan(uint8_t situation);
+
+// the escape the four resolve states took for some corners blocked
+ObstacleEscape_t ObstacleEscape_Resolve(uint8_t corners);
+
+#endif	/* OBSTACLE_ESCAPE_H */
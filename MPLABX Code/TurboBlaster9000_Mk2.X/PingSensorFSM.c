@@ -20,19 +20,19 @@
 #include "xc.h"
 #include "Timers.h"
 #include "Global_Macros.h"
+#include "EventProfiler.h"
+#include "RobotContext.h"
 
 /*******************************************************************************
  * PRIVATE FUNCTION PROTOTYPES                                                 *
  ******************************************************************************/
 // this function takes in the new deltaT variable obtained from the echo pins high time, 
 // adds that time to the current running history, and returns the new running average
-unsigned int updateHistory(unsigned int deltaT);
+unsigned int updateHistory(PingFSMContext_t *ctx, unsigned int deltaT);
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
 
-static unsigned int timeHistory[5] = {0, 0, 0, 0, 0};
-
 typedef enum {
     InitPState,
     PingHigh,
@@ -51,9 +51,7 @@ static const char *StateNames[] = {
 };
 
 
-static PingFSMState_t CurrentState = InitPState; // <- change enum name to match ENUM
-static uint8_t MyPriority;
-static int echoTime;
+// the state lives in the robot's PingFSMContext_t, see RobotContext.h
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                            *
@@ -62,11 +60,12 @@ static int echoTime;
 
 uint8_t InitPingFSM(uint8_t Priority)
 {
-    MyPriority = Priority;
+    PingFSMContext_t *ctx = &ROBOT->ping;
+    ctx->MyPriority = Priority;
     // put us into the Initial PseudoState
-    CurrentState = InitPState;
+    ctx->CurrentState = InitPState;
     // post the initial transition event
-    if (ES_PostToService(MyPriority, INIT_EVENT) == TRUE) {
+    if (EventProfiler_Post(ctx->MyPriority, INIT_EVENT) == TRUE) {
         return TRUE;
     } else {
         return FALSE;
@@ -75,17 +74,20 @@ uint8_t InitPingFSM(uint8_t Priority)
 
 uint8_t PostPingFSM(ES_Event ThisEvent)
 {
-    return ES_PostToService(MyPriority, ThisEvent);
+    return EventProfiler_Post(ROBOT->ping.MyPriority, ThisEvent); // same as ES_PostToService when profiling is off
 }
 
 ES_Event RunPingFSM(ES_Event ThisEvent)
 {
+    PingFSMContext_t *ctx = &ROBOT->ping;
     uint8_t makeTransition = FALSE; // use to flag transition
     PingFSMState_t nextState; // current state of the FSM
 
+    EventProfiler_Dispatch(ctx->MyPriority, ThisEvent); // time spent waiting in the queue
+
     ES_Tattle(); // trace call stack
 
-    switch (CurrentState) {
+    switch (ctx->CurrentState) {
     case InitPState: // If current state is initial Pseudo State
         if (ThisEvent.EventType == ES_INIT)// only respond to ES_Init
         {
@@ -114,14 +116,14 @@ ES_Event RunPingFSM(ES_Event ThisEvent)
 
     case WaitForEcho: // wait for the echo signal to go high, record time
         if (ThisEvent.EventType == ECHO_RISE) {
-            echoTime = TIMERS_GetTime(); // record the time the rise goes high
+            ctx->echoTime = TIMERS_GetTime(); // record the time the rise goes high
 
             // transition to wait for echo high state
             nextState = EchoHigh;
             makeTransition = TRUE;
             ThisEvent.EventType = ES_NO_EVENT;
         } else if (ThisEvent.EventType == ES_TIMEOUT && ThisEvent.EventParam == PING_WAIT_TIMER) {
-            InitPingFSM(MyPriority); // emergency catch case if the echo pin ever fails
+            InitPingFSM(ctx->MyPriority); // emergency catch case if the echo pin ever fails
             //printf("Echo never high\r\n");
         }
         break;
@@ -129,8 +131,8 @@ ES_Event RunPingFSM(ES_Event ThisEvent)
     case EchoHigh: // wait for the echo signal to go low, find the delta time
         if (ThisEvent.EventType == ECHO_FALL) {
             // calculate and post the deltaT
-            unsigned int deltaT = TIMERS_GetTime() - echoTime; // calculate delta time from recorded time
-            unsigned int returnVal = updateHistory(deltaT);
+            unsigned int deltaT = TIMERS_GetTime() - ctx->echoTime; // calculate delta time from recorded time
+            unsigned int returnVal = updateHistory(ctx, deltaT);
             //printf("%d\r\n", returnVal); // prints the delta time, more logic needed to go here
 
             // transition to wait for ping state
@@ -144,7 +146,7 @@ ES_Event RunPingFSM(ES_Event ThisEvent)
 
             // set the high to 200, could be bigger, but higher numbers unneeded
             int deltaT = 200;
-            unsigned int returnVal = updateHistory(deltaT);
+            unsigned int returnVal = updateHistory(ctx, deltaT);
             //printf("Out of Range: %d\r\n", returnVal);
 
             // transition to wait for ping state
@@ -175,7 +177,7 @@ ES_Event RunPingFSM(ES_Event ThisEvent)
     if (makeTransition == TRUE) { // making a state transition, send EXIT and ENTRY
         // recursively call the current state with an exit event
         RunPingFSM(EXIT_EVENT);
-        CurrentState = nextState;
+        ctx->CurrentState = nextState;
         RunPingFSM(ENTRY_EVENT);
     }
     ES_Tail(); // trace call stack end
@@ -190,20 +192,19 @@ ES_Event RunPingFSM(ES_Event ThisEvent)
 // this function takes in the new deltaT variable obtained from the echo pins high time, 
 // adds that time to the current running history, and returns the new running average
 
-unsigned int updateHistory(unsigned int deltaT)
+unsigned int updateHistory(PingFSMContext_t *ctx, unsigned int deltaT)
 {
-    static unsigned int sum = 0; // running sum
-    sum = sum + deltaT - timeHistory[0]; // update sum amount
-    for (int i = 0; i < 5; i++) {
-        timeHistory[i] = timeHistory[i + 1]; // shift the history
+    ctx->sum = ctx->sum + deltaT - ctx->timeHistory[0]; // update sum amount
+    for (int i = 0; i < 4; i++) {
+        ctx->timeHistory[i] = ctx->timeHistory[i + 1]; // shift the history
     }
-    timeHistory[4] = deltaT; // add the new data point to the history
+    ctx->timeHistory[4] = deltaT; // add the new data point to the history
 
     ES_Event thisEvent;
     //printf("here\r\n");
     thisEvent.EventType = NEW_PING;
-    thisEvent.EventParam = sum/5;
+    thisEvent.EventParam = ctx->sum/5;
     PostRobotHSM(thisEvent);
 
-    return sum / 5; // return the new running average
+    return ctx->sum / 5; // return the new running average
 }
@@ -23,6 +23,14 @@
  * PUBLIC TYPEDEFS                                                             *
  ******************************************************************************/
 
+// everything the machine remembers between events
+typedef struct {
+    unsigned int timeHistory[5]; // the last five echo times, oldest first
+    unsigned int sum; // running sum of timeHistory
+    int echoTime; // when the echo went high
+    uint8_t CurrentState; // a PingFSMState_t, the enum is in the .c file
+    uint8_t MyPriority;
+} PingFSMContext_t;
 
 
 /*******************************************************************************
@@ -0,0 +1,35 @@
+/*
+ * ProfileClock.c
+ * Free running tick counter for the profiling modules, see ProfileClock.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "ProfileClock.h"
+#ifdef __XC32
+#include <xc.h>
+#else
+#include "RobotContext.h" // each simulated robot has its own core timer
+#endif
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint32_t ProfileClock_GetTicks(void) {
+#ifdef __XC32
+    return _CP0_GET_COUNT(); // the core timer never stops and is never reset by the board library
+#else
+    return ROBOT->clockTicks;
+#endif
+}
+
+#ifndef __XC32
+
+void ProfileClock_AdvanceMicros(uint32_t micros) {
+    ROBOT->clockTicks += micros * PROFILE_TICKS_PER_US;
+}
+#endif
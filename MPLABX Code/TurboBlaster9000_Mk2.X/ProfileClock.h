@@ -0,0 +1,40 @@
+/*
+ * ProfileClock.h
+ * Free running high resolution clock used for timing measurements. On the PIC32
+ * it reads the core timer, which counts at half the 80MHz system clock. On a host
+ * build there is no core timer, so the clock is simulated and only moves when the
+ * host advances it.
+ */
+
+#ifndef PROFILE_CLOCK_H
+#define	PROFILE_CLOCK_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define PROFILE_TICKS_PER_US 40 // core timer rate, SYSCLK / 2
+
+// convert a difference of two ProfileClock_GetTicks() readings to microseconds.
+// always subtract raw tick readings first so the counter wrapping does not matter
+#define PROFILE_TICKS_TO_US(ticks) ((uint32_t) (ticks) / PROFILE_TICKS_PER_US)
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// returns the current tick count, wraps roughly every 107 seconds
+uint32_t ProfileClock_GetTicks(void);
+
+#ifndef __XC32
+// host builds only: move the simulated clock forward
+void ProfileClock_AdvanceMicros(uint32_t micros);
+#endif
+
+#endif	/* PROFILE_CLOCK_H */
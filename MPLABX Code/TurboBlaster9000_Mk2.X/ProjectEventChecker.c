@@ -36,6 +36,7 @@
 #include "RobotHSM.h"
 #include <stdio.h>
 #include "Global_Macros.h"
+#include "RobotContext.h"
 
 /*******************************************************************************
  * EVENTCHECKER_TEST SPECIFIC CODE                                                             *
@@ -87,7 +88,7 @@ static ES_Event storedEvent;
  * @author Gabriel H Elkaim, 2013.09.27 09:18
  * @modified Gabriel H Elkaim/Max Dunne, 2016.09.12 20:08 */
 uint8_t TemplateCheckBattery(void) {
-    static ES_EventTyp_t lastEvent = BATTERY_DISCONNECTED;
+    EventCheckerContext_t *ctx = &ROBOT->checkers;
     ES_EventTyp_t curEvent;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
@@ -98,12 +99,12 @@ uint8_t TemplateCheckBattery(void) {
     } else {
         curEvent = BATTERY_DISCONNECTED;
     }
-    if (curEvent != lastEvent) { // check for change from last time
+    if (curEvent != ctx->batteryEvent) { // check for change from last time
 
         thisEvent.EventType = curEvent;
         thisEvent.EventParam = batVoltage;
         returnVal = TRUE;
-        lastEvent = curEvent; // update history
+        ctx->batteryEvent = curEvent; // update history
 #ifndef EVENTCHECKER_TEST           // keep this as is for test harness
         //        PostGenericService(thisEvent);
 #else
@@ -119,7 +120,7 @@ uint8_t TemplateCheckBattery(void) {
  * These events will be used to deal with the ping sensor logic
  */
 uint8_t EchoEdgeDetection(void) {
-    static ES_EventTyp_t lastEvent = ECHO_FALL;
+    EventCheckerContext_t *ctx = &ROBOT->checkers;
     ES_EventTyp_t curEvent;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
@@ -133,12 +134,12 @@ uint8_t EchoEdgeDetection(void) {
     } else { // the bit is low
         curEvent = ECHO_FALL;
     }
-    if (curEvent != lastEvent) { // check for change from last time
+    if (curEvent != ctx->echoEvent) { // check for change from last time
         thisEvent.EventType = curEvent;
         thisEvent.EventParam = echoVal;
         PostPingFSM(thisEvent);
         returnVal = TRUE;
-        lastEvent = curEvent; // update history 
+        ctx->echoEvent = curEvent; // update history 
     }
     return (returnVal);
 }
@@ -151,7 +152,7 @@ uint8_t CheckTapeSensors(void) {
 
 
     ES_Event thisEvent; // the event to post later if there is a change in tape state
-    static uint8_t lastState = 0; // the last recorded state of the tape sensors
+    uint8_t lastState = ROBOT->checkers.tapeState; // the last recorded state of the tape sensors
     uint8_t currState = 0; // the current state of the tape sensors
     uint8_t returnVal = FALSE;
 
@@ -179,7 +180,7 @@ uint8_t CheckTapeSensors(void) {
     if (currState != lastState) {
         thisEvent.EventType = TAPE_CHANGE; // mark tape change event
         thisEvent.EventParam = currState; // set the state as the parameter
-        lastState = currState; // update the history
+        ROBOT->checkers.tapeState = currState; // update the history
 #ifdef BOTT_TAPE_ACTIVE
         PostRobotHSM(thisEvent);
         //printf("Tape change FL %d\r\n", currState);
@@ -199,7 +200,7 @@ uint8_t CheckTapeSensors(void) {
 
 uint8_t CheckTrackWire(void) {
 
-    static ES_EventTyp_t lastEvent = TW_LOST;
+    EventCheckerContext_t *ctx = &ROBOT->checkers;
     ES_EventTyp_t curEvent; // the current event/ state of the track wire (TW)
     uint8_t returnVal = FALSE; // will change to true if there is an event posted
 
@@ -209,12 +210,12 @@ uint8_t CheckTrackWire(void) {
     else if (curTWval < TW_LOW_THRESH) curEvent = TW_LOST; // track wire is not detecting if below lower threshold
     else return returnVal; // if in between, the current event defaults to whatever the last event was, ignore
     /* ENDIF */
-    if (curEvent != lastEvent) {
+    if (curEvent != ctx->trackWireEvent) {
         ES_Event thisEvent;
         thisEvent.EventType = curEvent;
         thisEvent.EventParam = curTWval;
         returnVal = TRUE;
-        lastEvent = curEvent;
+        ctx->trackWireEvent = curEvent;
         //PostRobotHSM(ThisEvent);
     }
     return returnVal;
@@ -225,7 +226,7 @@ uint8_t CheckTrackWire(void) {
  * and post an event if any of the bumpers have been pressed since the last check
  */
 uint8_t BumperDetection(void) {
-    static uint16_t bumperStates = 0; // the state of the four bumpers, each presenting a bit
+    uint16_t bumperStates = ROBOT->checkers.bumperStates; // the state of the four bumpers, each presenting a bit
 
     ES_EventTyp_t curEvent = BUMPED; // will only ever return the bumped event, which is what we care about
     uint8_t returnVal = FALSE; // will change to true if there is an event posted
@@ -251,7 +252,7 @@ uint8_t BumperDetection(void) {
         }
 
 
-        bumperStates = curState;
+        ROBOT->checkers.bumperStates = curState;
     }
     return returnVal;
 }
@@ -260,7 +261,7 @@ uint8_t BumperDetection(void) {
  * Posts a beacon detect or beacon lost event if there is a change in value across the hysteresis thresholds
  */
 uint8_t BeaconDetection(void) {
-    static ES_EventTyp_t lastEvent = BEACON_LOST; // default is not detecting the beacon
+    EventCheckerContext_t *ctx = &ROBOT->checkers;
     ES_EventTyp_t curEvent;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
@@ -272,14 +273,14 @@ uint8_t BeaconDetection(void) {
     } else if (beaconVal < BEACON_LOW_THRESH) { // if the beacon value is below the analog threshold
         curEvent = BEACON_LOST; // beacon low event
     } else {
-        curEvent = lastEvent;
+        curEvent = ctx->beaconEvent;
     }
-    if (curEvent != lastEvent) { // check for change from last time
+    if (curEvent != ctx->beaconEvent) { // check for change from last time
         thisEvent.EventType = curEvent; // if there was a change, pass the new event
         thisEvent.EventParam = beaconVal;
         PostRobotHSM(thisEvent);
         returnVal = TRUE;
-        lastEvent = curEvent; // update history 
+        ctx->beaconEvent = curEvent; // update history 
     }
     return (returnVal);
 }
@@ -28,16 +28,33 @@
 
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
 #include "BOARD.h"
+#include "EventProfiler.h"  // CheckProfilerRequest, when USE_EVENT_PROFILER is on
+#include "Trace.h"          // TraceDrain
+#include "SensorRecorder.h" // SensorRecorder, when USE_SENSOR_RECORDER is on
+#include "Localizer.h"      // LocalizerTick, when USE_LOCALIZER is on
+#include "MatchClock.h"     // MatchClockCheck
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
 
+// what every checker has last seen when the robot is switched on
+#define EVENT_CHECKER_CONTEXT_POWER_ON {.batteryEvent = BATTERY_DISCONNECTED, .echoEvent = ECHO_FALL, \
+        .trackWireEvent = TW_LOST, .beaconEvent = BEACON_LOST}
 
 /*******************************************************************************
  * PUBLIC TYPEDEFS                                                             *
  ******************************************************************************/
 
+// the history each checker compares the new reading against
+typedef struct {
+    ES_EventTyp_t batteryEvent; // last event of TemplateCheckBattery
+    ES_EventTyp_t echoEvent; // last event of EchoEdgeDetection
+    ES_EventTyp_t trackWireEvent; // last event of CheckTrackWire
+    ES_EventTyp_t beaconEvent; // last event of BeaconDetection
+    uint16_t bumperStates; // the state of the four bumpers, each presenting a bit
+    uint8_t tapeState; // the last recorded state of the tape sensors
+} EventCheckerContext_t;
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
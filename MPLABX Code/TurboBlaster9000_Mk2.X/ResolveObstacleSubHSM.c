@@ -10,24 +10,21 @@
 #include "ResolveObstacleSubHSM.h"
 #include "Global_Macros.h"
 #include "Motor_Control.h"
+#include "StateTimers.h"
+#include "Trace.h"
+#include "ObstacleEscape.h"
 
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
  ******************************************************************************/
 typedef enum {
     InitPSubState,
-    FL_Resolve,
-    FR_Resolve,
-    BL_Resolve,
-    BR_Resolve,
+    Escape,
 } ResolveObstacleSubHSMState_t;
 
 static const char *StateNames[] = {
 	"InitPSubState",
-	"FL_Resolve",
-	"FR_Resolve",
-	"BL_Resolve",
-	"BR_Resolve",
+	"Escape",
 };
 
 
@@ -36,7 +33,6 @@ static const char *StateNames[] = {
  ******************************************************************************/
 /* Prototypes for private functions for this machine. They should be functions
    relevant to the behavior of this state machine */
-void handleTape(ES_Event ThisEvent);
 
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
@@ -44,8 +40,7 @@ void handleTape(ES_Event ThisEvent);
 /* You will need MyPriority and the state variable; you may need others as well.
  * The type of state variable should match that of enum in header file. */
 
-static ResolveObstacleSubHSMState_t CurrentState = InitPSubState; // <- change name to match ENUM
-static uint8_t MyPriority;
+// the state lives in a ResolveObstacleContext_t passed in by SearchForTower, see ResolveObstacleSubHSM.h
 
 
 /*******************************************************************************
@@ -53,8 +48,8 @@ static uint8_t MyPriority;
  ******************************************************************************/
 
 /**
- * @Function InitResolveObstacleSubHSM(uint8_t Priority)
- * @param Priority - internal variable to track which event queue to use
+ * @Function InitResolveObstacleSubHSM(ResolveObstacleContext_t *ctx)
+ * @param ctx - the state of this instance of the machine
  * @return TRUE or FALSE
  * @brief This will get called by the framework at the beginning of the code
  *        execution. It will post an ES_INIT event to the appropriate event
@@ -62,11 +57,11 @@ static uint8_t MyPriority;
  *        to rename this to something appropriate.
  *        Returns TRUE if successful, FALSE otherwise
  * @author J. Edward Carryer, 2011.10.23 19:25 */
-uint8_t InitResolveObstacleSubHSM(void) {
+uint8_t InitResolveObstacleSubHSM(ResolveObstacleContext_t *ctx) {
     ES_Event returnEvent;
 
-    CurrentState = InitPSubState;
-    returnEvent = RunResolveObstacleSubHSM(INIT_EVENT);
+    ctx->CurrentState = InitPSubState;
+    returnEvent = RunResolveObstacleSubHSM(ctx, INIT_EVENT);
     if (returnEvent.EventType == ES_NO_EVENT) {
         return TRUE;
     }
@@ -74,7 +69,8 @@ uint8_t InitResolveObstacleSubHSM(void) {
 }
 
 /**
- * @Function RunResolveObstacleSubHSM(ES_Event ThisEvent)
+ * @Function RunResolveObstacleSubHSM(ResolveObstacleContext_t *ctx, ES_Event ThisEvent)
+ * @param ctx - the state of this instance of the machine
  * @param ThisEvent - the event (type and param) to be responded.
  * @return Event - return event (type and param), in general should be ES_NO_EVENT
  * @brief This function is where you implement the whole of the heirarchical state
@@ -88,231 +84,66 @@ uint8_t InitResolveObstacleSubHSM(void) {
  *       not consumed as these need to pass pack to the higher level state machine.
  * @author J. Edward Carryer, 2011.10.23 19:25
  * @author Gabriel H Elkaim, 2011.10.23 19:25 */
-ES_Event RunResolveObstacleSubHSM(ES_Event ThisEvent) {
+ES_Event RunResolveObstacleSubHSM(ResolveObstacleContext_t *ctx, ES_Event ThisEvent) {
     uint8_t makeTransition = FALSE; // use to flag transition
-    ResolveObstacleSubHSMState_t nextState; // <- change type to correct enum
+    ResolveObstacleSubHSMState_t nextState = Escape; // <- change type to correct enum
+    ObstacleEscape_t escape;
+    uint8_t corners;
 
     ES_Tattle(); // trace call stack
 
 
 
-    switch (CurrentState) {
+    switch (ctx->CurrentState) {
         case InitPSubState: // If current state is initial Psedudo State
             if (ThisEvent.EventType == ES_INIT)// only respond to ES_Init
             {
-                // find the current area of conflict
-                if ((AD_ReadADPin(FL_TAPE_PIN) > DARK_THRESHOLD) || ((IO_PortsReadPort(BUMPER_PORT) & FL_BUMP_BIT) == 0)) {
-                    nextState = FL_Resolve;
-                } else if ((AD_ReadADPin(FR_TAPE_PIN) > DARK_THRESHOLD) || ((IO_PortsReadPort(BUMPER_PORT) & FR_BUMP_BIT) == 0)) {
-                    nextState = FR_Resolve;
-                } else if ((AD_ReadADPin(BL_TAPE_PIN) > DARK_THRESHOLD) || ((IO_PortsReadPort(BUMPER_PORT) & BL_BUMP_BIT) == 0)) {
-                    nextState = BL_Resolve;
-                } else if ((AD_ReadADPin(BR_TAPE_PIN) > DARK_THRESHOLD) || ((IO_PortsReadPort(BUMPER_PORT) & BR_BUMP_BIT) == 0)) {
-                    nextState = BR_Resolve;
-                }
-
+                ctx->bumped = 0;
                 makeTransition = TRUE;
                 ThisEvent.EventType = ES_NO_EVENT;
             }
             break;
 
-        case FL_Resolve: // resolve the Front left collision state by backing away and 
-            switch (ThisEvent.EventType) {
-                case ES_ENTRY: // when entering this state do the following
-                    printf("Entered FL Resolve\r\n");
-                    SetLeftMotor(-RESOLVE_SPEED);
-                    SetRightMotor(-(RESOLVE_SPEED-REVERSE_DIFF));
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, RESOLVE_TIME); // if this timer expires without incident, exit resolve
-                    break;
-
-                case BUMPED: // if there was a bumped event while in this state
-
-                    if (AD_ReadADPin(BEACON_A_PIN) > BEACON_CLOSE_THRESH) break;
-                    // identify which bumper was pressed and handle transfer to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_BUMP_BIT) > 0) {
-
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_BUMP_BIT) > 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_BUMP_BIT) > 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_BUMP_BIT) > 0) {
-                        nextState = BR_Resolve;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-
-                case TAPE_CHANGE: // if there was a tape event while in this state
-
-                    // identify which tape sensor was triggered and change to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_TAPE_BIT) == 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_TAPE_BIT) == 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_TAPE_BIT) == 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_TAPE_BIT) == 0) {
-                        nextState = BR_Resolve;
-                    } else {
-                        break;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-            }
-            break;
-
-        case FR_Resolve: // resolve the Front left collision state by backing away and 
-            switch (ThisEvent.EventType) {
-                case ES_ENTRY: // when entering this state do the following
-                    printf("Entered FR Resolve\r\n");
-                    SetLeftMotor(-RESOLVE_SPEED);
-                    SetRightMotor(-(RESOLVE_SPEED-REVERSE_DIFF));
-                    //SetRightMotor(-RESOLVE_SPEED);
-                    //SetLeftMotor(-(RESOLVE_SPEED-REVERSE_DIFF));
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, RESOLVE_TIME);
-                    break;
-
-                case BUMPED: // if there was a bumped event while in this state
-
-                    if (AD_ReadADPin(BEACON_A_PIN) > BEACON_CLOSE_THRESH) break;
-                    // identify which bumper was pressed and handle transfer to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_BUMP_BIT) > 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_BUMP_BIT) > 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_BUMP_BIT) > 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_BUMP_BIT) > 0) {
-                        nextState = BR_Resolve;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-
-                case TAPE_CHANGE: // if there was a tape event while in this state
-
-                    // identify which tape sensor was triggered and change to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_TAPE_BIT) == 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_TAPE_BIT) == 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_TAPE_BIT) == 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_TAPE_BIT) == 0) {
-                        nextState = BR_Resolve;
-                    } else {
-                        break;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-
-            }
-            break;
-
-        case BL_Resolve: // resolve the Front left collision state by backing away and 
-            switch (ThisEvent.EventType) {
-                case ES_ENTRY: // when entering this state do the following
-                    printf("Entered BL Resolve\r\n");
-                    SetRightMotor(RESOLVE_SPEED-FORWARD_DIFF);
-                    SetLeftMotor(RESOLVE_SPEED);
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, RESOLVE_TIME);
-                    break;
-
-                case BUMPED: // if there was a bumped event while in this state
-
-                    if (AD_ReadADPin(BEACON_A_PIN) > BEACON_CLOSE_THRESH) break;
-                    // identify which bumper was pressed and handle transfer to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_BUMP_BIT) > 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_BUMP_BIT) > 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_BUMP_BIT) > 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_BUMP_BIT) > 0) {
-                        nextState = BR_Resolve;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-
-                case TAPE_CHANGE: // if there was a tape event while in this state
-
-                    // identify which tape sensor was triggered and change to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_TAPE_BIT) == 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_TAPE_BIT) == 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_TAPE_BIT) == 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_TAPE_BIT) == 0) {
-                        nextState = BR_Resolve;
-                    } else {
-                        break;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-            }
-            break;
-
-        case BR_Resolve: // resolve the Front left collision state by backing away and 
+        case Escape: // get away from whatever is blocking the corners, the way the escape table says to for this situation
             switch (ThisEvent.EventType) {
                 case ES_ENTRY: // when entering this state do the following
-                    printf("Entered BR Resolve\r\n");
-                    SetLeftMotor(RESOLVE_SPEED-FORWARD_DIFF);
-                    SetRightMotor(RESOLVE_SPEED);
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, RESOLVE_TIME);
+                    ctx->situation = ObstacleEscape_Sense(ctx->bumped);
+                    ctx->bumped = 0;
+                    ctx->blocked = ESCAPE_CORNERS(ctx->situation);
+                    escape = ObstacleEscape_Plan(ctx->situation);
+                    TRACE3(TR_ESCAPE, ctx->situation, escape.left, escape.right);
+                    SetMotors(escape.left, escape.right);
+                    StateTimer_Start(OBSTACLE_TIMER, escape.time * ESCAPE_TIME_UNIT, HSM_LEVEL_SUBSUB, ctx->CurrentState); // if this timer expires without incident, exit resolve
                     break;
 
                 case BUMPED: // if there was a bumped event while in this state
-
                     if (AD_ReadADPin(BEACON_A_PIN) > BEACON_CLOSE_THRESH) break;
-                    // identify which bumper was pressed and handle transfer to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_BUMP_BIT) > 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_BUMP_BIT) > 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_BUMP_BIT) > 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_BUMP_BIT) > 0) {
-                        nextState = BR_Resolve;
-                    }
-                    makeTransition = TRUE; // make the transition to the new state
-                    ThisEvent.EventType = ES_NO_EVENT;
-                    break;
-
+                    ctx->bumped = ThisEvent.EventParam;
+                    // fall through, a bumper is handled the same as the tape
                 case TAPE_CHANGE: // if there was a tape event while in this state
-
-                    // identify which tape sensor was triggered and change to the new state accordingly
-                    if ((ThisEvent.EventParam & FL_TAPE_BIT) == 0) {
-                        nextState = FL_Resolve;
-                    } else if ((ThisEvent.EventParam & FR_TAPE_BIT) == 0) {
-                        nextState = FR_Resolve;
-                    } else if ((ThisEvent.EventParam & BL_TAPE_BIT) == 0) {
-                        nextState = BL_Resolve;
-                    } else if ((ThisEvent.EventParam & BR_TAPE_BIT) == 0) {
-                        nextState = BR_Resolve;
+                    // only a corner that was clear when the escape was last
+                    // picked changes the situation enough to pick again
+                    corners = ESCAPE_CORNERS(ObstacleEscape_Sense(ctx->bumped));
+                    if (corners & ~ctx->blocked) {
+                        makeTransition = TRUE; // make the transition to the new state
                     } else {
-                        break;
+                        ctx->blocked = corners;
+                        ctx->bumped = 0;
                     }
-                    makeTransition = TRUE; // make the transition to the new state
                     ThisEvent.EventType = ES_NO_EVENT;
                     break;
-
             }
             break;
-
-
     }
 
     if (makeTransition == TRUE) { // making a state transition, send EXIT and ENTRY
         // recursively call the current state with an exit event
-        RunResolveObstacleSubHSM(EXIT_EVENT); // <- rename to your own Run function
-        CurrentState = nextState;
-        RunResolveObstacleSubHSM(ENTRY_EVENT); // <- rename to your own Run function
+        RunResolveObstacleSubHSM(ctx, EXIT_EVENT); // <- rename to your own Run function
+        StateTimer_ExitState(HSM_LEVEL_SUBSUB);
+        ctx->CurrentState = nextState;
+        TRACE2(TR_STATE, TRACE_RESOLVE_OBSTACLE, ctx->CurrentState);
+        StateTimer_EnterState(HSM_LEVEL_SUBSUB, ctx->CurrentState);
+        RunResolveObstacleSubHSM(ctx, ENTRY_EVENT); // <- rename to your own Run function
     }
 
     ES_Tail(); // trace call stack end
@@ -36,14 +36,21 @@
  * PUBLIC TYPEDEFS                                                             *
  ******************************************************************************/
 
+// everything the machine remembers between events
+typedef struct {
+    uint8_t CurrentState; // a ResolveObstacleSubHSMState_t, the enum is in the .c file
+    uint8_t situation; // what the escape in progress was picked for, see ObstacleEscape.h
+    uint8_t blocked; // the corners blocked as of the last bumper or tape event
+    uint16_t bumped; // the bumpers the last BUMPED had pressed, for picking the next escape
+} ResolveObstacleContext_t;
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
 
 /**
- * @Function InitResolveObstacleSubHSM(void)
- * @param Priority - internal variable to track which event queue to use
+ * @Function InitResolveObstacleSubHSM(ResolveObstacleContext_t *ctx)
+ * @param ctx - the state of this instance of the machine
  * @return TRUE or FALSE
  * @brief This will get called by the framework at the beginning of the code
  *        execution. It will post an ES_INIT event to the appropriate event
@@ -51,10 +58,11 @@
  *        to rename this to something appropriate.
  *        Returns TRUE if successful, FALSE otherwise
  * @author J. Edward Carryer, 2011.10.23 19:25 */
-uint8_t InitResolveObstacleSubHSM(void);
+uint8_t InitResolveObstacleSubHSM(ResolveObstacleContext_t *ctx);
 
 /**
- * @Function RunResolveObstacleSubHSM(ES_Event ThisEvent)
+ * @Function RunResolveObstacleSubHSM(ResolveObstacleContext_t *ctx, ES_Event ThisEvent)
+ * @param ctx - the state of this instance of the machine
  * @param ThisEvent - the event (type and param) to be responded.
  * @return Event - return event (type and param), in general should be ES_NO_EVENT
  * @brief This function is where you implement the whole of the heirarchical state
@@ -68,7 +76,7 @@ uint8_t InitResolveObstacleSubHSM(void);
  *       not consumed as these need to pass pack to the higher level state machine.
  * @author J. Edward Carryer, 2011.10.23 19:25
  * @author Gabriel H Elkaim, 2011.10.23 19:25 */
-ES_Event RunResolveObstacleSubHSM(ES_Event ThisEvent);
+ES_Event RunResolveObstacleSubHSM(ResolveObstacleContext_t *ctx, ES_Event ThisEvent);
 
 #endif /* SUB_HSM_Template_H */
 
@@ -0,0 +1,37 @@
+/*
+ * RobotContext.c
+ * The robot's state, see RobotContext.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "RobotContext.h"
+
+/*******************************************************************************
+ * PUBLIC VARIABLES                                                            *
+ ******************************************************************************/
+
+#ifdef __XC32
+RobotContext_t Robot = ROBOT_CONTEXT_POWER_ON;
+#else
+__thread RobotContext_t *CurrentRobot = NULL;
+#endif
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void RobotContext_Reset(RobotContext_t *robot) {
+    static const RobotContext_t powerOn = ROBOT_CONTEXT_POWER_ON; // in flash on the PIC32
+    *robot = powerOn;
+}
+
+#ifndef __XC32
+
+void RobotContext_Select(RobotContext_t *robot) {
+    CurrentRobot = robot;
+}
+#endif
@@ -0,0 +1,101 @@
+/*
+ * RobotContext.h
+ * Everything the robot code remembers between calls, in one struct. Every state
+ * machine, the event checkers and the support modules keep their state in a
+ * context struct declared in their own header, and RobotContext_t holds one of
+ * each. Sub HSMs get their context passed to Init and Run by the machine above
+ * them, the services and event checkers that the framework calls find theirs
+ * through ROBOT.
+ *
+ * On the PIC32 there is only ever one robot, so ROBOT is the address of a single
+ * global. The linker places it once, every access is to a fixed address like
+ * the file statics it replaces, and it takes no more RAM than they did.
+ *
+ * Host builds can have any number of robots. ROBOT is then a per thread pointer
+ * to the one being run, set with RobotContext_Select, so many robots can be
+ * stepped from many threads in the same process, see host/HostMatch.h.
+ */
+
+#ifndef ROBOT_CONTEXT_H
+#define	ROBOT_CONTEXT_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "ES_Configure.h"   // USE_EVENT_PROFILER, USE_LOOP_MONITOR, USE_SENSOR_RECORDER and USE_LOCALIZER
+#include "ES_Framework.h"
+#include "BOARD.h"
+#include "RobotHSM.h"
+#include "PingSensorFSM.h"
+#include "ProjectEventChecker.h"
+#include "Motor_Control.h"
+#include "StateTimers.h"
+#include "Trace.h"
+#include "EventProfiler.h"
+#include "LoopMonitor.h"
+#include "SensorRecorder.h"
+#include "Localizer.h"
+#include "MatchClock.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// what the robot holds when it is switched on, anything not listed starts at 0
+#define ROBOT_CONTEXT_POWER_ON {.hsm = ROBOT_HSM_CONTEXT_POWER_ON, .checkers = EVENT_CHECKER_CONTEXT_POWER_ON}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    RobotHSMContext_t hsm; // RobotHSM and all of its sub HSMs
+    PingFSMContext_t ping;
+    EventCheckerContext_t checkers;
+    MotorContext_t motors;
+    StateTimerContext_t stateTimers;
+    TraceContext_t trace;
+    MatchClockContext_t matchClock;
+#ifdef USE_EVENT_PROFILER
+    EventProfilerContext_t profiler;
+#endif
+#ifdef USE_LOOP_MONITOR
+    LoopMonitorContext_t loopMonitor;
+#endif
+#ifdef USE_SENSOR_RECORDER
+    SensorRecorderContext_t recorder;
+#endif
+#ifdef USE_LOCALIZER
+    LocalizerContext_t localizer;
+#endif
+#ifndef __XC32
+    uint32_t clockTicks; // the simulated core timer, see ProfileClock.h
+#endif
+} RobotContext_t;
+
+/*******************************************************************************
+ * PUBLIC VARIABLES                                                            *
+ ******************************************************************************/
+
+#ifdef __XC32
+extern RobotContext_t Robot;
+#define ROBOT (&Robot)
+#else
+extern __thread RobotContext_t *CurrentRobot;
+#define ROBOT (CurrentRobot)
+#endif
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// puts a robot back the way it is at power on
+void RobotContext_Reset(RobotContext_t *robot);
+
+#ifndef __XC32
+// host builds only: makes the robot the one ROBOT points at for the calling thread
+void RobotContext_Select(RobotContext_t *robot);
+#endif
+
+#endif	/* ROBOT_CONTEXT_H */
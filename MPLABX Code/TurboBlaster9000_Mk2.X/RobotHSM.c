@@ -13,6 +13,11 @@
 #include "AD.h"
 #include "Global_Macros.h" // contains all of the macros
 #include "Motor_Control.h"
+#include "StateTimers.h"
+#include "Trace.h"
+#include "EventProfiler.h"
+#include "RobotContext.h"
+#include "MatchClock.h"
 
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
@@ -47,19 +52,19 @@ static const char *StateNames[] = {
 /* You will need MyPriority and the state variable; you may need others as well.
  * The type of state variable should match that of enum in header file. */
 
-static RobotHSMState_t CurrentState = InitPState;
-static uint8_t MyPriority;
+// the state lives in the robot's RobotHSMContext_t, see RobotContext.h
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                            *
  ******************************************************************************/
 
 uint8_t InitRobotHSM(uint8_t Priority) {
-    MyPriority = Priority;
+    RobotHSMContext_t *ctx = &ROBOT->hsm;
+    ctx->MyPriority = Priority;
     // put us into the Initial PseudoState
-    CurrentState = InitPState;
+    ctx->CurrentState = InitPState;
     // post the initial transition event
-    if (ES_PostToService(MyPriority, INIT_EVENT) == TRUE) {
+    if (EventProfiler_Post(ctx->MyPriority, INIT_EVENT) == TRUE) {
         return TRUE;
     } else {
         return FALSE;
@@ -67,22 +72,36 @@ uint8_t InitRobotHSM(uint8_t Priority) {
 }
 
 uint8_t PostRobotHSM(ES_Event ThisEvent) {
-    return ES_PostToService(MyPriority, ThisEvent);
+    StateTimer_Stamp(&ThisEvent); // which arm of the timer a timeout is from
+    return EventProfiler_Post(ROBOT->hsm.MyPriority, ThisEvent); // same as ES_PostToService when profiling is off
 }
 
 ES_Event RunRobotHSM(ES_Event ThisEvent) {
+    RobotHSMContext_t *ctx = &ROBOT->hsm;
     uint8_t makeTransition = FALSE; // use to flag transition
     RobotHSMState_t nextState;
 
+    EventProfiler_Dispatch(ctx->MyPriority, ThisEvent); // time spent waiting in the queue
+
+    if (StateTimer_IsStale(&ThisEvent)) { // timer was cancelled when its state exited, drop the timeout
+        return NO_EVENT;
+    }
+    if (ThisEvent.EventType == BUDGET_EXCEEDED && !MatchClock_BudgetRunning(ThisEvent.EventParam)) { // that phase is over already
+        return NO_EVENT;
+    }
+    if (ThisEvent.EventType != ES_ENTRY && ThisEvent.EventType != ES_EXIT) { // only events that came through the queue
+        TRACE2(TR_EVENT, ThisEvent.EventType, ThisEvent.EventParam);
+    }
+
     ES_Tattle(); // trace call stack
 
-    switch (CurrentState) {
+    switch (ctx->CurrentState) {
         case InitPState: // If current state is initial Pseudo State
             if (ThisEvent.EventType == ES_INIT)// only respond to ES_Init
             {
-                InitSearchForTowerSubHSM(); // initialize the Search for tower subHSM
-                InitSearchForHoleSubHSM(); // initialize the Search for hole subHSM
-                InitFindNewTowerSubHSM();
+                InitSearchForTowerSubHSM(&ctx->searchForTower); // initialize the Search for tower subHSM
+                InitSearchForHoleSubHSM(&ctx->searchForHole); // initialize the Search for hole subHSM
+                InitFindNewTowerSubHSM(&ctx->findNewTower);
 
                 nextState = SearchForTower; // first state is search for tower, need to find tower and then hole
                 makeTransition = TRUE; // transition to the next state
@@ -91,35 +110,54 @@ ES_Event RunRobotHSM(ES_Event ThisEvent) {
             break;
 
         case SearchForTower: // if still searching for tower
-            ThisEvent = RunSearchForTowerSubHSM(ThisEvent); // pass down to lower subhsm first
+            ThisEvent = RunSearchForTowerSubHSM(&ctx->searchForTower, ThisEvent); // pass down to lower subhsm first
             switch (ThisEvent.EventType) {
                 
                 case ES_ENTRY:
-                    InitSearchForTowerSubHSM();
+                    InitSearchForTowerSubHSM(&ctx->searchForTower);
                     break;
 
                 case BUMPED: // if there is a bumped event that gets passed to this level
                     // we can assume that the resolve bump state determined that the robot hit the tower and passed the event back up
                     // transition to search for hole
                     if (AD_ReadADPin(BEACON_A_PIN) > BEACON_CLOSE_THRESH) {// only transition if close
+                        TowerPlan_t *plan = &ctx->findNewTower.plan;
+                        PlanArrival_t arrival = TowerPlanner_Arrive(plan, MatchClock_ElapsedMs());
+                        if (arrival == PLAN_LEFT_BEHIND) { // clipped the tower it set off from, back out and survey again
+                            nextState = FindNewTower;
+                        } else {
+                            TowerMemory_Arrive(&ctx->searchForHole.towers, plan->current, arrival == PLAN_NEW_TOWER);
+                            nextState = SearchForHole;
+                        }
                         makeTransition = TRUE;
-                        nextState = SearchForHole;
                     }
                     ThisEvent.EventType = ES_NO_EVENT; // clear the event
                     SetMotors(0, 0);
                     break;
 
+                case BUDGET_EXCEEDED:
+                    if (ThisEvent.EventParam == PHASE_ACQUIRE) { // no tower to be seen from here, go and look elsewhere
+                        ctx->findNewTower.wander = TRUE;
+                        nextState = FindNewTower;
+                    } else { // stuck on the way in, sweep for the tower again
+                        nextState = SearchForTower;
+                    }
+                    makeTransition = TRUE;
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
                 default:
                     break;
             }
             break;
 
         case SearchForHole: // if searching for a hole within a tower
-            ThisEvent = RunSearchForHoleSubHSM(ThisEvent); // pass it down to a lower level
+            ThisEvent = RunSearchForHoleSubHSM(&ctx->searchForHole, ThisEvent); // pass it down to a lower level
             switch (ThisEvent.EventType) {
 
                 case ES_ENTRY:
-                    InitSearchForHoleSubHSM();
+                    MatchClock_StartTower(); // the hole search budget is for the whole visit
+                    InitSearchForHoleSubHSM(&ctx->searchForHole);
                     break;
                     
                 case TOWER_LOST:
@@ -130,25 +168,40 @@ ES_Event RunRobotHSM(ES_Event ThisEvent) {
                     
 
                 case LAUNCH_COMPLETE: // if the robot has completed a ball launch
+                    TowerPlanner_Launched(&ctx->findNewTower.plan);
                     nextState = FindNewTower;
                     makeTransition = TRUE;
                     ThisEvent.EventType = ES_NO_EVENT; // clear the event
                     break;
 
+                case BUDGET_EXCEEDED: // this hole is taking too long, try another tower
+                    TowerPlanner_GiveUp(&ctx->findNewTower.plan);
+                    nextState = FindNewTower;
+                    makeTransition = TRUE;
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
                 default:
                     break;
             }
             break;
 
         case FindNewTower:
-            ThisEvent = RunFindNewTowerSubHSM(ThisEvent); // pass it down to a lower level
+            ThisEvent = RunFindNewTowerSubHSM(&ctx->findNewTower, ThisEvent); // pass it down to a lower level
             switch (ThisEvent.EventType) {
 
                 case ES_ENTRY:
-                    InitFindNewTowerSubHSM();
+                    InitFindNewTowerSubHSM(&ctx->findNewTower);
                     break;
 
                 case NEW_TOWER:
+                    ctx->searchForTower.aimed = ThisEvent.EventParam; // FindNewTower has it facing the tower already
+                    nextState = SearchForTower;
+                    makeTransition = TRUE;
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
+                case BUDGET_EXCEEDED: // sweep for a tower from wherever it got to
                     nextState = SearchForTower;
                     makeTransition = TRUE;
                     ThisEvent.EventType = ES_NO_EVENT;
@@ -166,7 +219,10 @@ ES_Event RunRobotHSM(ES_Event ThisEvent) {
     if (makeTransition == TRUE) { // making a state transition, send EXIT and ENTRY
         // recursively call the current state with an exit event
         RunRobotHSM(EXIT_EVENT); // post an exit event to itself to be handled
-        CurrentState = nextState;
+        StateTimer_ExitState(HSM_LEVEL_TOP); // cancel any timers armed below the state we are leaving
+        ctx->CurrentState = nextState;
+        TRACE2(TR_STATE, TRACE_ROBOT_HSM, ctx->CurrentState);
+        StateTimer_EnterState(HSM_LEVEL_TOP, ctx->CurrentState);
         RunRobotHSM(ENTRY_EVENT); // post an entry event
     }
 
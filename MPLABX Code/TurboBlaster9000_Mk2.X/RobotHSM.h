@@ -2,6 +2,22 @@
 #define HSM_ROBOT_H
 
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "SearchForTowerSubHSM.h"
+#include "SearchForHoleSubHSM.h"
+#include "FindNewTowerSubHSM.h"
+
+// the values the context has when the robot is switched on
+#define ROBOT_HSM_CONTEXT_POWER_ON {.searchForHole = SEARCH_FOR_HOLE_CONTEXT_POWER_ON, \
+    .findNewTower = FIND_NEW_TOWER_CONTEXT_POWER_ON}
+
+// everything the top level machine and its sub machines remember between events
+typedef struct {
+    uint8_t CurrentState; // a RobotHSMState_t, the enum is in the .c file
+    uint8_t MyPriority;
+    SearchForTowerContext_t searchForTower;
+    SearchForHoleContext_t searchForHole;
+    FindNewTowerContext_t findNewTower;
+} RobotHSMContext_t;
 
 uint8_t InitRobotHSM(uint8_t Priority);
 
@@ -10,4 +26,3 @@ uint8_t PostRobotHSM(ES_Event ThisEvent);
 ES_Event RunRobotHSM(ES_Event ThisEvent);
 
 #endif /* HSM_ROBOT_H */
-
@@ -36,6 +36,11 @@
 #include <stdio.h>
 #include "Global_Macros.h"
 #include "Timers.h"
+#include "StateTimers.h"
+#include "Trace.h"
+#include "TowerMemory.h"
+#include "HoleEvidence.h"
+#include "MatchClock.h"
 
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
@@ -54,6 +59,7 @@ typedef enum {
     RevUpFlywheel,
     Launch,
     Reset,
+    BackOff,
 
 } HoleSubHSMState_t;
 
@@ -71,6 +77,7 @@ static const char *StateNames[] = {
 	"RevUpFlywheel",
 	"Launch",
 	"Reset",
+	"BackOff",
 };
 
 
@@ -81,21 +88,36 @@ static const char *StateNames[] = {
 /* Prototypes for private functions for this machine. They should be functions
    relevant to the behavior of this state machine */
 
+static void FollowWall(SearchForHoleContext_t *ctx, uint32_t pingData, int16_t speed);
+static int16_t LauncherTurn(void);
+static uint8_t SteerLauncher(void);
+
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
 /* You will need MyPriority and the state variable; you may need others as well.
  * The type of state variable should match that of enum in header file. */
 
-static HoleSubHSMState_t CurrentState = InitPSubState; // <- change name to match ENUM
-static uint8_t MyPriority;
-static uint8_t firstPass = TRUE; // if this is the first wall face seen or not
-static uint8_t tapeSeen = FALSE; // whether or not tape has been seen since the last turn
-static uint8_t tapeLost = FALSE;
-static uint8_t towerSeen = FALSE;
-static uint8_t alignDir = 0;
-static uint32_t myTime = 0;
-static uint32_t attempts = 0;
+// the state lives in a SearchForHoleContext_t passed in by RobotHSM, see SearchForHoleSubHSM.h
+
+// which part of the match each state is, for its time budget, see MatchClock.h.
+// Finding the tower wall again after a miss is still the hole search
+static const uint8_t StatePhase[] = {
+    PHASE_NONE, // InitPSubState
+    PHASE_HOLE_SEARCH, // AlignSensor
+    PHASE_HOLE_SEARCH, // Traverse
+    PHASE_LAUNCH, // DrivePass
+    PHASE_HOLE_SEARCH, // TurnIn
+    PHASE_HOLE_SEARCH, // DriveTo
+    PHASE_LAUNCH, // AlignLauncher
+    PHASE_HOLE_SEARCH, // AlignDrive
+    PHASE_LAUNCH, // PrecisionAlign
+    PHASE_LAUNCH, // PrecisionBack
+    PHASE_LAUNCH, // RevUpFlywheel
+    PHASE_LAUNCH, // Launch
+    PHASE_LAUNCH, // Reset
+    PHASE_HOLE_SEARCH, // BackOff
+};
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                            *
@@ -111,11 +133,11 @@ static uint32_t attempts = 0;
  *        to rename this to something appropriate.
  *        Returns TRUE if successful, FALSE otherwise
  * @author J. Edward Carryer, 2011.10.23 19:25 */
-uint8_t InitSearchForHoleSubHSM(void) {
+uint8_t InitSearchForHoleSubHSM(SearchForHoleContext_t *ctx) {
     ES_Event returnEvent;
 
-    CurrentState = InitPSubState;
-    returnEvent = RunSearchForHoleSubHSM(INIT_EVENT);
+    ctx->CurrentState = InitPSubState;
+    returnEvent = RunSearchForHoleSubHSM(ctx, INIT_EVENT);
     if (returnEvent.EventType == ES_NO_EVENT) {
         return TRUE;
     }
@@ -137,13 +159,15 @@ uint8_t InitSearchForHoleSubHSM(void) {
  *       not consumed as these need to pass pack to the higher level state machine.
  * @author J. Edward Carryer, 2011.10.23 19:25
  * @author Gabriel H Elkaim, 2011.10.23 19:25 */
-ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
+ES_Event RunSearchForHoleSubHSM(SearchForHoleContext_t *ctx, ES_Event ThisEvent) {
     uint8_t makeTransition = FALSE; // use to flag transition
     HoleSubHSMState_t nextState; // <- change type to correct enum
     uint32_t pingData;
+    uint8_t skip; // Traverse is driving past a face already inspected
+    int16_t turn; // PrecisionBack's steering toward the hole
     ES_Tattle(); // trace call stack
 
-    switch (CurrentState) {
+    switch (ctx->CurrentState) {
         case InitPSubState: // If current state is initial Psedudo State
             if (ThisEvent.EventType == ES_INIT)// only respond to ES_Init
             {
@@ -157,18 +181,18 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
         case AlignSensor: // in the first state, replace this with correct names
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    myTime = TIMERS_GetTime();
-                    firstPass = TRUE;
+                    ctx->myTime = TIMERS_GetTime();
+                    ctx->firstPass = (TowerMemory_FaceMarks(&ctx->towers) & FACE_HITS) == 0; // back on a face that showed something, look for the hole straight away
                     setServoPos(0);
-                    printf("Aligning Sensor\r\n");
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, ALIGN_TIME);
+                    TRACE0(TR_ALIGNING_SENSOR);
+                    StateTimer_Start(OBSTACLE_TIMER, ALIGN_TIME, HSM_LEVEL_SUB, ctx->CurrentState);
                     SetLeftMotor(ALIGN_SPEED);
                     SetRightMotor(-(ALIGN_SPEED));
                     break;
 
 
                 case NEW_PING:
-                    printf("New Ping %d\r\n", ThisEvent.EventParam);
+                    TRACE1(TR_NEW_PING, ThisEvent.EventParam);
                     if (ThisEvent.EventParam < PING_IN_RANGE - 2) {
                         nextState = Traverse;
                         makeTransition = TRUE;
@@ -193,7 +217,7 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
         case AlignDrive: // ede case where the ping sensor has not found the tower while aligning
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, LOST_TIMEOUT); // if timer is expired, assume total failure
+                    StateTimer_Start(OBSTACLE_TIMER, LOST_TIMEOUT, HSM_LEVEL_SUB, ctx->CurrentState); // if timer is expired, assume total failure
                     SetLeftMotor(0);
                     SetRightMotor(70); // drive forward and to the left
                     break;
@@ -216,7 +240,6 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
                     if (ThisEvent.EventParam == OBSTACLE_TIMER) {
                         SetLeftMotor(0);
                         SetRightMotor(0);
-                        ES_Timer_StopTimer(OBSTACLE_TIMER); // not needed for now
 
                         ES_Event failEvent;
                         failEvent.EventType = TOWER_LOST;
@@ -225,55 +248,115 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
                     }
                     break;
             }
-
+            break;
 
         case Traverse:
 
             switch (ThisEvent.EventType) {
 
                 case ES_ENTRY:
-                    tapeSeen = FALSE;
-                    tapeLost = FALSE;
-                    towerSeen = FALSE;
-                    printf("Traversing\r\n");
+                    ctx->tapeSeen = FALSE;
+                    ctx->tapeLost = FALSE;
+                    ctx->towerSeen = FALSE;
+                    ctx->lastPingError = 0; // it only gets here close to the standoff
+                    HoleEvidence_Start(&ctx->hole);
+                    TRACE0(TR_TRAVERSING);
                     break;
 
                 case NEW_PING:
                     pingData = ThisEvent.EventParam;
-                    printf("New Ping %d\r\n", ThisEvent.EventParam);
+                    TRACE1(TR_NEW_PING, ThisEvent.EventParam);
+                    skip = TowerMemory_ShouldSkip(&ctx->towers);
 
-                    if (pingData < PING_MAX && AD_ReadADPin(TW_PIN) > TW_HIGH_THRESH && AD_ReadADPin(S_TAPE_PIN) > 500 && !firstPass && !tapeLost &&
-                            ((TIMERS_GetTime() - myTime) < 15000)) { // if while traversing the robot meets all of the alignment criteria
-                        nextState = AlignLauncher;
-                        makeTransition = TRUE;
+                    if (pingData < PING_MAX && AD_ReadADPin(TW_PIN) > TW_HIGH_THRESH) {
+                        TowerMemory_Hit(&ctx->towers, FACE_TRACK_WIRE, TIMERS_GetTime() - ctx->myTime);
+                    }
+                    if (pingData < PING_MAX && AD_ReadADPin(S_TAPE_PIN) > 500) {
+                        TowerMemory_Hit(&ctx->towers, FACE_SIDE_TAPE, TIMERS_GetTime() - ctx->myTime);
+                    }
+                    if (TowerMemory_FaceMarks(&ctx->towers) & FACE_HOLE) { // launched from this face on an earlier visit, go for the hole now
+                        ctx->firstPass = FALSE;
+                    }
+                    if (HoleEvidence_Add(&ctx->hole, AD_ReadADPin(TW_PIN), AD_ReadADPin(S_TAPE_PIN), pingData) && !ctx->firstPass && !ctx->tapeLost && !skip &&
+                            ((TIMERS_GetTime() - ctx->myTime) < 15000)) { // if while traversing the robot is sure enough it is beside the hole
+                        TRACE2(TR_HOLE_CONFIDENCE, ctx->hole.confidence, TIMERS_GetTime() - ctx->myTime);
+                        SetLeftMotor(0);
+                        SetRightMotor(0);
+                        ES_Event holeEvent;
+                        holeEvent.EventType = HOLE_FOUND;
+                        holeEvent.EventParam = ctx->hole.confidence;
+                        PostRobotHSM(holeEvent);
                         ThisEvent.EventType = ES_NO_EVENT;
                         break;
                     }
 
                     /*
                     if (AD_ReadADPin(S_TAPE_PIN) < 500) {
-                        towerSeen = TRUE;
+                        ctx->towerSeen = TRUE;
                     }
-                    if (AD_ReadADPin(S_TAPE_PIN) > 550 && towerSeen) {
-                        tapeSeen = TRUE;
+                    if (AD_ReadADPin(S_TAPE_PIN) > 550 && ctx->towerSeen) {
+                        ctx->tapeSeen = TRUE;
                     }
-                    if (AD_ReadADPin(S_TAPE_PIN) < 500 && tapeSeen) {
-                        tapeLost = TRUE;
+                    if (AD_ReadADPin(S_TAPE_PIN) < 500 && ctx->tapeSeen) {
+                        ctx->tapeLost = TRUE;
                     }
                      * */
 
-                    if ((pingData >= PING_MAX) && ((TIMERS_GetTime() - myTime) > 10000)) { // if driving past the tower
+                    if ((pingData >= PING_MAX) && ((TIMERS_GetTime() - ctx->myTime) > (skip ? TRAVERSE_PASS_TICKS * TRAVERSE_SPEED / TRAVERSE_SKIP_SPEED : TRAVERSE_PASS_TICKS))) { // if driving past the tower
                         nextState = TurnIn; // begin to turn in
                         makeTransition = TRUE;
-                    } else if (pingData > PING_IN_RANGE - 1) { // if a little too far from the tower
-                        SetLeftMotor(TRAVERSE_SPEED);
-                        SetRightMotor(TRAVERSE_SPEED + TRAVERSE_CORRECTION); // continue to drive forward but with a bias 
                     } else {
-                        SetLeftMotor(TRAVERSE_SPEED);
-                        SetRightMotor(TRAVERSE_SPEED);
+                        FollowWall(ctx, pingData, skip ? TRAVERSE_SKIP_SPEED : TRAVERSE_SPEED); // hold the standoff from the tower wall
+                    }
+                    ThisEvent.EventType = ES_NO_EVENT;
+
+                    break;
+
+                case HOLE_FOUND:
+                    nextState = AlignLauncher;
+                    makeTransition = TRUE;
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
+                case BUMPED: // steered nose first into the tower, the wall follower cannot back out of that
+                    if (ThisEvent.EventParam & (FL_BUMP_BIT | FR_BUMP_BIT)) {
+                        nextState = BackOff; // turn away and carry on along the same face
+                        makeTransition = TRUE;
+                        ThisEvent.EventType = ES_NO_EVENT;
+                    }
+                    break;
+            }
+            break;
+
+        case BackOff: // turns away from the wall Traverse ran into and carries on along the same face, unlike AlignSensor it never turns hole detection off
+            switch (ThisEvent.EventType) {
+                case ES_ENTRY:
+                    ctx->backOffTime = TIMERS_GetTime();
+                    StateTimer_Start(OBSTACLE_TIMER, ALIGN_TIME, HSM_LEVEL_SUB, ctx->CurrentState);
+                    SetLeftMotor(ALIGN_SPEED);
+                    SetRightMotor(-(ALIGN_SPEED));
+                    break;
+
+                case ES_EXIT:
+                    ctx->myTime += TIMERS_GetTime() - ctx->backOffTime; // the face's time picks up where the bump left it
+                    if (TowerMemory_FaceMarks(&ctx->towers) & FACE_HITS) ctx->firstPass = FALSE; // the face showed something, look for the hole now
+                    break;
+
+                case NEW_PING:
+                    TRACE1(TR_NEW_PING, ThisEvent.EventParam);
+                    if (ThisEvent.EventParam < PING_IN_RANGE - 2) {
+                        nextState = Traverse;
+                        makeTransition = TRUE;
                     }
                     ThisEvent.EventType = ES_NO_EVENT;
+                    break;
 
+                case ES_TIMEOUT:
+                    if (ThisEvent.EventParam == OBSTACLE_TIMER) { // turned all the way without the wall, start the face over
+                        nextState = AlignSensor;
+                        makeTransition = TRUE;
+                        ThisEvent.EventType = ES_NO_EVENT;
+                    }
                     break;
             }
             break;
@@ -282,8 +365,10 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
 
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    printf("Turning\r\n");
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, TURN_TIME); // amount of time to turn
+                    TowerMemory_TurnCorner(&ctx->towers, !ctx->firstPass); // the first face was joined part way along
+                    TRACE3(TR_FACE, ctx->towers.current, ctx->towers.tower[ctx->towers.current].onFace, TowerMemory_FaceMarks(&ctx->towers));
+                    TRACE0(TR_TURNING);
+                    StateTimer_Start(OBSTACLE_TIMER, TURN_TIME, HSM_LEVEL_SUB, ctx->CurrentState); // amount of time to turn
                     SetLeftMotor(1);
                     SetRightMotor(TURN_SPEED); // turn speed
                     break;
@@ -293,7 +378,7 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
                         nextState = DriveTo;
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
-                        firstPass = FALSE;
+                        ctx->firstPass = FALSE;
                     }
                     break;
 
@@ -310,9 +395,9 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
         case DriveTo: // drive for a period of time straight after the turn
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    myTime = TIMERS_GetTime();
-                    printf("Driving to Reacquire\r\n");
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, PASS_TIME);
+                    ctx->myTime = TIMERS_GetTime();
+                    TRACE0(TR_REACQUIRE);
+                    StateTimer_Start(OBSTACLE_TIMER, PASS_TIME, HSM_LEVEL_SUB, ctx->CurrentState);
                     SetLeftMotor(TRAVERSE_SPEED);
                     SetRightMotor(TRAVERSE_SPEED);
                     break;
@@ -321,14 +406,12 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
                         nextState = AlignSensor; // attempt to align again
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
-                        ES_Timer_StopTimer(OBSTACLE_TIMER);
                     }
                     break;
                 case NEW_PING:
                     if (ThisEvent.EventParam < PING_MAX) {
                         nextState = Traverse;
                         makeTransition = TRUE;
-                        ES_Timer_StopTimer(OBSTACLE_TIMER);
                     }
                     ThisEvent.EventType = ES_NO_EVENT;
                     break;
@@ -338,7 +421,7 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
         case DrivePass: // when the hole is found and time to drive pass for brief period of time
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, 250); // timeout for how long to drive pass for
+                    StateTimer_Start(OBSTACLE_TIMER, 250, HSM_LEVEL_SUB, ctx->CurrentState); // timeout for how long to drive pass for
                     SetLeftMotor(15); // drive slowly pass
                     SetRightMotor(15);
                     break;
@@ -355,8 +438,8 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
         case AlignLauncher:
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    attempts = 0;
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, ALIGN_LAUNCH_TIME);
+                    ctx->attempts = 0;
+                    StateTimer_Start(OBSTACLE_TIMER, ALIGN_LAUNCH_TIME, HSM_LEVEL_SUB, ctx->CurrentState);
                     SetLeftMotor(-85);
                     SetRightMotor(60);
                     break;
@@ -370,81 +453,78 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
             }
             break;
 
-        case PrecisionAlign: // fix any issues with the timer based alignment in this state
+        case PrecisionAlign: // servo the launcher onto the hole on the way in to the wall
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    attempts++;
-                    printf("Driving Forward\r\n");
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, ALIGN_LAUNCH_FOR_TICKS * 1.5); // set the timer for when to begin backing up
-                    SetLeftMotor(ALIGN_LAUNCH_SPEED); // set the speed upon entry
-                    SetRightMotor(ALIGN_LAUNCH_SPEED);
-                    break;
-
-                case BUMPED: // turn off certain motors if the bumper is pressed
-                    if ((IO_PortsReadPort(BUMPER_PORT) & (FL_BUMP_BIT | FR_BUMP_BIT)) == 0) {
-                        if ((AD_ReadADPin(CR_TAPE_PIN) > C_TAPE_THRESH) || (AD_ReadADPin(CL_TAPE_PIN) > C_TAPE_THRESH)) {
-                            nextState = RevUpFlywheel;
-                            makeTransition = TRUE;
-                        }
+                    ctx->attempts++;
+                    TRACE0(TR_DRIVING_FORWARD);
+                    StateTimer_Start(OBSTACLE_TIMER, ALIGN_LAUNCH_FOR_TICKS * 1.5, HSM_LEVEL_SUB, ctx->CurrentState); // how long it has to reach the wall
+                    StateTimer_Start(SAMPLE_TIMER, ALIGN_CONTROL_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                    SteerLauncher();
+                    break;
 
-                    } else if ((IO_PortsReadPort(BUMPER_PORT) & FL_BUMP_BIT) == 0) {
-                        SetLeftMotor(0);
-                    } else if ((IO_PortsReadPort(BUMPER_PORT) & FR_BUMP_BIT) == 0) {
-                        SetRightMotor(0);
-                    }
+                case BUMPED: // stop that side's wheel now rather than at the next sample
+                    SteerLauncher();
                     ThisEvent.EventType = ES_NO_EVENT;
                     break;
 
-                case ES_TIMEOUT: // timeout on alignement
-                    if (ThisEvent.EventParam == OBSTACLE_TIMER) {
-                        printf("CR: %d, CL: %d\r\n", AD_ReadADPin(CR_TAPE_PIN), AD_ReadADPin(CL_TAPE_PIN));
-                        if ((AD_ReadADPin(CR_TAPE_PIN) < C_TAPE_THRESH) && (AD_ReadADPin(CL_TAPE_PIN) > C_TAPE_THRESH)) { // shifted left, back up slightly to the left
-                            printf("Left Shifted\r\n");
-                            SetLeftMotor(-ALIGN_LAUNCH_SPEED);
-                            SetRightMotor(-ALIGN_LAUNCH_SPEED + ALIGN_SPEED_DIFF / 2);
-                            attempts = 0;
-                            nextState = PrecisionBack; // buffer state to allow for backing up for a period of time
-                        } else if ((AD_ReadADPin(CR_TAPE_PIN) > C_TAPE_THRESH) && (AD_ReadADPin(CL_TAPE_PIN) < C_TAPE_THRESH)) { // shifted right, back up slightly to the right
-                            printf("Right Shifted\r\n");
-                            SetLeftMotor(-ALIGN_LAUNCH_SPEED + (int) (ALIGN_SPEED_DIFF));
-                            SetRightMotor(-ALIGN_LAUNCH_SPEED);
-                            nextState = PrecisionBack; // buffer state to allow for backing up for a period of time
-                            attempts = 0;
-                        } else if ((AD_ReadADPin(CR_TAPE_PIN) > C_TAPE_THRESH) && (AD_ReadADPin(CL_TAPE_PIN) > C_TAPE_THRESH)) {
-                            printf("Centered\r\n");
-                            SetLeftMotor(-ALIGN_LAUNCH_SPEED);
-                            SetRightMotor(-ALIGN_LAUNCH_SPEED + (int) (ALIGN_SPEED_DIFF));
-                            nextState = PrecisionBack;
-                        } else if (attempts <= 20) {
-                            SetLeftMotor(-ALIGN_LAUNCH_SPEED);
-                            SetRightMotor(-ALIGN_LAUNCH_SPEED + (int) (ALIGN_SPEED_DIFF * 1.2));
-                            nextState = PrecisionBack;
-                        } else {
-                            printf("Off Completely\r\n");
-                            nextState = AlignSensor;
-                        }
-
-                        makeTransition = TRUE;
+                case ES_TIMEOUT:
+                    if (ThisEvent.EventParam == SAMPLE_TIMER) {
                         ThisEvent.EventType = ES_NO_EVENT;
-
+                        if (!SteerLauncher()) { // still on the way in
+                            StateTimer_Start(SAMPLE_TIMER, ALIGN_CONTROL_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                            break;
+                        }
+                        if (AD_ReadADPin(CR_TAPE_PIN) > C_TAPE_THRESH && AD_ReadADPin(CL_TAPE_PIN) > C_TAPE_THRESH) { // flush and both sides over the tape
+                            ES_Event alignedEvent;
+                            alignedEvent.EventType = ALIGNED;
+                            alignedEvent.EventParam = LauncherTurn(); // how far off centre it still was
+                            PostRobotHSM(alignedEvent);
+                            break;
+                        }
+                        // flush but off the hole, back off and come in again
+                    } else if (ThisEvent.EventParam != OBSTACLE_TIMER) { // OBSTACLE_TIMER is never getting flush with the wall
+                        break;
                     }
+                    TRACE2(TR_CENTER_TAPE, AD_ReadADPin(CR_TAPE_PIN), AD_ReadADPin(CL_TAPE_PIN));
+                    if (ctx->attempts < ALIGN_MAX_ATTEMPTS) { // half on the tape or not, every try counts
+                        nextState = PrecisionBack;
+                    } else {
+                        TRACE0(TR_OFF_COMPLETELY);
+                        nextState = AlignSensor;
+                    }
+                    makeTransition = TRUE;
+                    ThisEvent.EventType = ES_NO_EVENT;
                     break;
 
-
+                case ALIGNED:
+                    TRACE2(TR_CENTER_TAPE, AD_ReadADPin(CR_TAPE_PIN), AD_ReadADPin(CL_TAPE_PIN));
+                    TRACE0(TR_CENTERED);
+                    nextState = RevUpFlywheel;
+                    makeTransition = TRUE;
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
             }
             break;
 
-        case PrecisionBack: // go backwards if the tape criteria were not met
+        case PrecisionBack: // back off turned toward whichever side the tape was on
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    printf("backing up\r\n");
-                    ES_Timer_InitTimer(OBSTACLE_TIMER, ALIGN_LAUNCH_BAC_TICKS); // motors were already set in the previous state, so just reset the timer on entry
+                    turn = LauncherTurn();
+                    if (AD_ReadADPin(CR_TAPE_PIN) > C_TAPE_THRESH || AD_ReadADPin(CL_TAPE_PIN) > C_TAPE_THRESH) {
+                        TRACE0(turn > 0 ? TR_RIGHT_SHIFTED : TR_LEFT_SHIFTED);
+                    } else { // no sign of the tape, try further left
+                        turn = -ALIGN_SPEED_DIFF;
+                    }
+                    TRACE0(TR_BACKING_UP);
+                    SetMotors(-ALIGN_LAUNCH_SPEED + (turn > 0 ? turn : 0), -ALIGN_LAUNCH_SPEED - (turn < 0 ? turn : 0)); // backing with the nose swinging toward the tape
+                    StateTimer_Start(OBSTACLE_TIMER, ALIGN_LAUNCH_BAC_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
                     break;
 
                 case ES_TIMEOUT: // on timeout kick it back to the previous state
 
                     if (ThisEvent.EventParam == OBSTACLE_TIMER) {
-                        printf("back up time expired\r\n");
+                        TRACE0(TR_BACK_UP_EXPIRED);
                         nextState = PrecisionAlign;
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT;
@@ -461,11 +541,13 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
                     SetMotors(0, 0);
                     setServoPos(0);
                     setFlyMotor(FLY_POWER); // set flywheel to a reasonable speed
-                    ES_Timer_InitTimer(LAUNCH_TIMER, REV_UP_TIME);
+                    StateTimer_Start(LAUNCH_TIMER, REV_UP_TIME, HSM_LEVEL_SUB, ctx->CurrentState);
+                    break;
+                case BUDGET_EXCEEDED: // lined up on the hole, the ball goes no matter how long that took
+                    ThisEvent.EventType = ES_NO_EVENT;
                     break;
                 case ES_TIMEOUT:
                     if (LAUNCH_TIMER == ThisEvent.EventParam) {
-                        ES_Timer_StopTimer(LAUNCH_TIMER);
                         nextState = Launch;
                         makeTransition = TRUE;
                     }
@@ -475,17 +557,21 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
         case Launch:
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    ES_Timer_InitTimer(LAUNCH_TIMER, LAUNCH_TICKS);
+                    StateTimer_Start(LAUNCH_TIMER, LAUNCH_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
                     setServoPos(1); // deliver a ball to the flywheel
                     break;
 
+                case BUDGET_EXCEEDED:
+                    ThisEvent.EventType = ES_NO_EVENT;
+                    break;
+
                 case ES_TIMEOUT:
                     if (LAUNCH_TIMER == ThisEvent.EventParam) {
-                        ES_Timer_StopTimer(LAUNCH_TIMER);
                         setServoPos(0);
                         setFlyMotor(0);
                         ThisEvent.EventType = ES_NO_EVENT;
 
+                        TowerMemory_Launched(&ctx->towers);
                         // create a new event to post to the top level to indicate that the launch sequence has been completed and is reseting
                         ES_Event launchEvent;
                         launchEvent.EventType = LAUNCH_COMPLETE;
@@ -499,9 +585,13 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
 
     if (makeTransition == TRUE) { // making a state transition, send EXIT and ENTRY
         // recursively call the current state with an exit event
-        RunSearchForHoleSubHSM(EXIT_EVENT); // <- rename to your own Run function
-        CurrentState = nextState;
-        RunSearchForHoleSubHSM(ENTRY_EVENT); // <- rename to your own Run function
+        RunSearchForHoleSubHSM(ctx, EXIT_EVENT); // <- rename to your own Run function
+        StateTimer_ExitState(HSM_LEVEL_SUB); // stops OBSTACLE_TIMER / LAUNCH_TIMER armed by the old state
+        ctx->CurrentState = nextState;
+        TRACE2(TR_STATE, TRACE_SEARCH_FOR_HOLE, ctx->CurrentState);
+        StateTimer_EnterState(HSM_LEVEL_SUB, ctx->CurrentState);
+        MatchClock_EnterPhase(StatePhase[ctx->CurrentState]);
+        RunSearchForHoleSubHSM(ctx, ENTRY_EVENT); // <- rename to your own Run function
     }
 
     ES_Tail(); // trace call stack end
@@ -513,3 +603,65 @@ ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent) {
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
 
+/*
+ * Traverse's wall follower, run on every NEW_PING. The tower is on the left,
+ * pingData is how far away it is in echo ms (the ping sensor's running
+ * average). Steering is proportional to how far off TRAVERSE_STANDOFF that is
+ * plus how fast it is changing since the last ping, limited to
+ * TRAVERSE_CORRECTION, and only ever speeds a wheel up so the robot never goes
+ * slower than speed along the face
+ */
+static void FollowWall(SearchForHoleContext_t *ctx, uint32_t pingData, int16_t speed) {
+    int16_t error = (pingData < PING_MAX ? pingData : PING_MAX) - TRAVERSE_STANDOFF; // nothing there counts as PING_MAX
+    int16_t turn = error * TRAVERSE_KP + (error - ctx->lastPingError) * TRAVERSE_KD; // positive turns in to the tower
+
+    ctx->lastPingError = error;
+    if (turn > TRAVERSE_CORRECTION) {
+        turn = TRAVERSE_CORRECTION;
+    } else if (turn < -TRAVERSE_CORRECTION) {
+        turn = -TRAVERSE_CORRECTION;
+    }
+    if (turn > 0) {
+        SetLeftMotor(speed);
+        SetRightMotor(speed + turn);
+    } else {
+        SetLeftMotor(speed - turn);
+        SetRightMotor(speed);
+    }
+}
+
+/*
+ * Which way PrecisionAlign steers, positive to the right. The centre tape
+ * sensors either side of the launcher read high over the tape under the hole
+ * and low over the wall, so CR - CL says which side the hole is on and, while
+ * a sensor is part way onto the tape, roughly how far. ALIGN_KP per 256
+ * counts, limited to ALIGN_SPEED_DIFF
+ */
+static int16_t LauncherTurn(void) {
+    int32_t turn = ((int32_t) AD_ReadADPin(CR_TAPE_PIN) - (int32_t) AD_ReadADPin(CL_TAPE_PIN)) * ALIGN_KP / 256;
+
+    if (turn > ALIGN_SPEED_DIFF) {
+        turn = ALIGN_SPEED_DIFF;
+    } else if (turn < -ALIGN_SPEED_DIFF) {
+        turn = -ALIGN_SPEED_DIFF;
+    }
+    return turn;
+}
+
+/*
+ * PrecisionAlign's controller, run every ALIGN_CONTROL_TICKS and on every
+ * bump. Creeps in at ALIGN_LAUNCH_SPEED turning toward the hole, and stops a
+ * wheel once the front bumper on its side is on the wall so the other one
+ * squares the robot up. Returns TRUE once both front bumpers are pressed
+ */
+static uint8_t SteerLauncher(void) {
+    uint16_t bumpers = IO_PortsReadPort(BUMPER_PORT); // a pressed bumper reads 0
+    int16_t turn = LauncherTurn();
+    int16_t left = ALIGN_LAUNCH_SPEED + turn / 2;
+    int16_t right = ALIGN_LAUNCH_SPEED - turn / 2;
+
+    if ((bumpers & FL_BUMP_BIT) == 0) left = 0;
+    if ((bumpers & FR_BUMP_BIT) == 0) right = 0;
+    SetMotors(left, right);
+    return (bumpers & (FL_BUMP_BIT | FR_BUMP_BIT)) == 0;
+}
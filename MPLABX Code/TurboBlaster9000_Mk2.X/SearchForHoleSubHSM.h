@@ -26,14 +26,42 @@
  ******************************************************************************/
 
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "TowerMemory.h"
+#include "HoleEvidence.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// the values the context has when the robot is switched on
+#define SEARCH_FOR_HOLE_CONTEXT_POWER_ON {.firstPass = TRUE}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+// everything the machine remembers between events
+typedef struct {
+    uint32_t myTime;
+    uint32_t backOffTime; // when BackOff started turning away, that time is not spent along the face
+    uint32_t attempts;
+    uint8_t CurrentState; // a HoleSubHSMState_t, the enum is in the .c file
+    uint8_t firstPass; // if this is the first wall face seen or not
+    uint8_t tapeSeen; // whether or not tape has been seen since the last turn
+    uint8_t tapeLost;
+    uint8_t towerSeen;
+    int16_t lastPingError; // Traverse's distance off the standoff at the last ping, in echo ms
+    HoleEvidence_t hole; // what Traverse has seen of the hole along this face
+    TowerMemory_t towers; // the faces of this tower, kept through every return to AlignSensor
+} SearchForHoleContext_t;
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
 
-uint8_t InitSearchForHoleSubHSM(void);
+uint8_t InitSearchForHoleSubHSM(SearchForHoleContext_t *ctx);
 
-ES_Event RunSearchForHoleSubHSM(ES_Event ThisEvent);
+ES_Event RunSearchForHoleSubHSM(SearchForHoleContext_t *ctx, ES_Event ThisEvent);
 
 #endif /* SUB_HSM_HOLE_H */
 
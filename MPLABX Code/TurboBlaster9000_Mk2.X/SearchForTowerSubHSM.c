@@ -12,6 +12,11 @@
 #include "SearchForTowerSubHSM.h"
 #include "ResolveObstacleSubHSM.h"
 #include "Global_Macros.h"
+#include "StateTimers.h"
+#include "BeaconSweep.h"
+#include "Trace.h"
+#include "MatchClock.h"
+#include "AD.h"
 
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
@@ -38,43 +43,53 @@ static const char *StateNames[] = {
  * PRIVATE FUNCTION PROTOTYPES                                                 *
  ******************************************************************************/
 
+static uint8_t UpdateApproach(SearchForTowerContext_t *ctx, uint16_t beaconVal);
+static void SteerApproach(const SearchForTowerContext_t *ctx);
+
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
 
-static SearchForTowerSubHSMState_t CurrentState = InitPSubState; // first pseudo state
-static uint8_t MyPriority; // subhsm process priority
-static uint8_t turnDir; // the direction the feedback system is having the robot turn when approaching the tower
-static uint32_t lastBeaconVal; // the last recorded value from the beacon
-static uint8_t reAdjust = 0;
+// the state lives in a SearchForTowerContext_t passed in by RobotHSM, see SearchForTowerSubHSM.h
+
+// which part of the match each state is, for its time budget, see MatchClock.h.
+// Once a sweep has picked a tower, turning to face it is the approach
+static const uint8_t StatePhase[] = {
+    PHASE_NONE, // InitPSubState
+    PHASE_ACQUIRE, // AcquireTower
+    PHASE_APPROACH, // AlignTower
+    PHASE_APPROACH, // ApproachTower
+    PHASE_APPROACH, // ResolveObstacle
+    PHASE_APPROACH, // ReAdjust
+};
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                            *
  ******************************************************************************/
 
-uint8_t InitSearchForTowerSubHSM(void) {
+uint8_t InitSearchForTowerSubHSM(SearchForTowerContext_t *ctx) {
     ES_Event returnEvent;
-    CurrentState = InitPSubState;
-    returnEvent = RunSearchForTowerSubHSM(INIT_EVENT); // run the init event through the subHSM
+    ctx->CurrentState = InitPSubState;
+    returnEvent = RunSearchForTowerSubHSM(ctx, INIT_EVENT); // run the init event through the subHSM
     if (returnEvent.EventType == ES_NO_EVENT) { // if there was no issue, return true
         return TRUE;
     }
     return FALSE;
 }
 
-ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
+ES_Event RunSearchForTowerSubHSM(SearchForTowerContext_t *ctx, ES_Event ThisEvent) {
     uint8_t makeTransition = FALSE; // use to flag transition
     SearchForTowerSubHSMState_t nextState; // the state variable
 
     ES_Tattle(); // trace call stack
 
-    switch (CurrentState) { // determine what to do based on current state
+    switch (ctx->CurrentState) { // determine what to do based on current state
         case InitPSubState: // If current state is initial Pseudo State
             if (ThisEvent.EventType == ES_INIT)// only respond to ES_Init
             {
-                InitResolveObstacleSubHSM(); // only subHSM, used for resolving non-tower obstacles
                 // now put the machine into the actual initial state
-                nextState = AcquireTower; // go to the acquire tower state
+                nextState = ctx->aimed ? ApproachTower : AcquireTower; // sweep for a tower unless one was picked already
+                ctx->aimed = FALSE;
                 makeTransition = TRUE;
                 ThisEvent.EventType = ES_NO_EVENT; // consume the init event
             }
@@ -83,27 +98,46 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
         case AcquireTower: // first state is the Acquire tower state
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    printf("searching for tower tower\r\n");
-                    ES_Timer_InitTimer(TURN_TIMER, TURN_360_TICKS); // initialize the timer used to let the robot do a full 360 rotate
+                    TRACE0(TR_SEARCHING_TOWER);
+                    BeaconSweep_Start(&ctx->sweep); // note the beacon all the way round, then turn back to the strongest tower
+                    BeaconSweep_Add(&ctx->sweep, AD_ReadADPin(BEACON_A_PIN));
+                    StateTimer_Start(SAMPLE_TIMER, BEACON_SWEEP_SAMPLE_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                    StateTimer_Start(TURN_TIMER, TURN_360_TICKS, HSM_LEVEL_SUB, ctx->CurrentState); // initialize the timer used to let the robot do a full 360 rotate
                     SetMotors(ACQUIRE_SPEED, -ACQUIRE_SPEED); // let the robot spin in place
                     break;
 
                 case ES_TIMEOUT: // if there is a timeout event
-                    if (ThisEvent.EventParam == TURN_TIMER) { // if the turn timer expires
-                        ES_Timer_InitTimer(TURN_TIMER, TURN_360_TICKS); // try again for now
+                    if (ThisEvent.EventParam == SAMPLE_TIMER) { // next beacon reading of the sweep
+                        if (ctx->sweep.numSamples < TURN_360_TICKS / BEACON_SWEEP_SAMPLE_TICKS) {
+                            BeaconSweep_Add(&ctx->sweep, AD_ReadADPin(BEACON_A_PIN));
+                            StateTimer_Start(SAMPLE_TIMER, BEACON_SWEEP_SAMPLE_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                        }
+                        ThisEvent.EventType = ES_NO_EVENT; // consume event
+                    } else if (ThisEvent.EventParam == TURN_TIMER) { // a full turn is done
+                        uint8_t wraps = ctx->sweep.numSamples == TURN_360_TICKS / BEACON_SWEEP_SAMPLE_TICKS;
+                        if (BeaconSweep_FindPeaks(&ctx->sweep, BEACON_HIGH_THRESH, wraps) > 0) {
+                            const BeaconPeak_t *best = &ctx->sweep.peak[0];
+                            TRACE3(TR_SWEEP_PEAK, ctx->sweep.numPeaks, best->intensity, best->atMs);
+                            ctx->alignMs = BeaconSweep_TurnTo(&ctx->sweep, 0, &ctx->alignDir);
+                            nextState = ctx->alignMs >= ALIGN_TOWER_MIN_TICKS ? AlignTower : ApproachTower;
+                            makeTransition = TRUE;
+                        } else {
+                            BeaconSweep_Start(&ctx->sweep); // nothing this time round, try again
+                            BeaconSweep_Add(&ctx->sweep, AD_ReadADPin(BEACON_A_PIN));
+                            StateTimer_Start(SAMPLE_TIMER, BEACON_SWEEP_SAMPLE_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                            StateTimer_Start(TURN_TIMER, TURN_360_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                        }
                         ThisEvent.EventType = ES_NO_EVENT; // consume event
                     }
                     break;
 
-                case BEACON_FOUND: // if a beacon is found
-                    printf("acquired\r\n");
-                    nextState = ApproachTower; // go to the acquire tower state
-                    makeTransition = TRUE;
+                case BEACON_FOUND: // a tower, but keep turning to see if there is a stronger one
+                    TRACE0(TR_ACQUIRED);
                     ThisEvent.EventType = ES_NO_EVENT; // consume event
                     break;
 
                 case BUMPED:
-                    printf("Bumped Event while acquiring!!\r\n");
+                    TRACE0(TR_BUMPED_ACQUIRING);
                     if (AD_ReadADPin(BEACON_A_PIN) < BEACON_CLOSE_THRESH) { // if there was a bumped event, and the robot is NOT suffiecently close to a tower, assume it hit an obstacle
                         //printf("collided with non tower object\r\n");
                         //nextState = ResolveObstacle;
@@ -113,60 +147,76 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
                     break;
 
 
-                case ES_EXIT:
-                    // on exit, turn off the turn timer, so that their events no longer clog up the HSM queue
-                    ES_Timer_StopTimer(TURN_TIMER);
-                    break;
-
                 case ES_NO_EVENT:
                 default: // all unhandled events pass the event back up to the next level
                     break;
             }
             break;
 
-        case ApproachTower:
-            
+        case AlignTower: // turning back to face the strongest tower of the sweep
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    printf("approaching\r\n");
-                    ES_Timer_InitTimer(TURN_TIMER, APR_TIMEOUT);
-                    lastBeaconVal = AD_ReadADPin(BEACON_A_PIN);
-                    SetMotors(100, 60); // let the robot drive forward (80 left, 100 right)
-                    turnDir = 1;
-                    break;
-
-                case BEACON_LOST: // if the beacon was lost, transition back to acquire tower subHSM
-                    ES_Timer_InitTimer(TURN_TIMER, APR_TIMEOUT);
-                    if (turnDir) {
-                        SetMotors(APR_SPEED - APR_DIFF, APR_SPEED);
-                        turnDir = 0;
+                    StateTimer_Start(TURN_TIMER, ctx->alignMs, HSM_LEVEL_SUB, ctx->CurrentState);
+                    if (ctx->alignDir) {
+                        SetMotors(ACQUIRE_SPEED, -ACQUIRE_SPEED); // on round the way it was spinning
                     } else {
-                        SetMotors(APR_SPEED, APR_SPEED - APR_DIFF);
-                        turnDir = 1;
+                        SetMotors(-ACQUIRE_SPEED, ACQUIRE_SPEED); // back the way it came
                     }
-                    //nextState = ReAdjust; // go to the acquire tower state
-                    //makeTransition = TRUE;
-                    //ThisEvent.EventType = ES_NO_EVENT; // consume the event
                     break;
 
-                case BEACON_FOUND:
-                    ES_Timer_InitTimer(TURN_TIMER, APR_TIMEOUT);
+                case ES_TIMEOUT:
+                    if (ThisEvent.EventParam == TURN_TIMER) { // facing the tower
+                        nextState = ApproachTower;
+                        makeTransition = TRUE;
+                        ThisEvent.EventType = ES_NO_EVENT; // consume event
+                    }
+                    break;
+
+                case BEACON_FOUND: // expected on the way round
+                    ThisEvent.EventType = ES_NO_EVENT; // consume event
+                    break;
+
+                default: // all unhandled events pass the event back up to the next level
+                    break;
+            }
+            break;
+
+        case ApproachTower:
+            
+            switch (ThisEvent.EventType) {
+                case ES_ENTRY:
+                    TRACE0(TR_APPROACHING);
+                    ctx->lastBeaconVal = AD_ReadADPin(BEACON_A_PIN);
+                    ctx->olderBeaconVal = ctx->lastBeaconVal;
+                    ctx->steer = 0;
+                    ctx->lostMs = 0;
+                    ctx->turnDir = 1;
+                    SteerApproach(ctx);
+                    StateTimer_Start(SAMPLE_TIMER, APR_CONTROL_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
                     break;
 
                 case ES_TIMEOUT:
-                    if (ThisEvent.EventParam == TURN_TIMER) { // if the turn timer expires
-                        ES_Timer_StopTimer(TURN_TIMER);
-                        nextState = AcquireTower; // go to the acquire tower state
-                        makeTransition = TRUE;
+                    if (ThisEvent.EventParam == SAMPLE_TIMER) { // time to steer again
+                        if (UpdateApproach(ctx, AD_ReadADPin(BEACON_A_PIN))) {
+                            SteerApproach(ctx);
+                            StateTimer_Start(SAMPLE_TIMER, APR_CONTROL_TICKS, HSM_LEVEL_SUB, ctx->CurrentState);
+                        } else { // the beacon has been gone too long
+                            nextState = AcquireTower; // go to the acquire tower state
+                            makeTransition = TRUE;
+                        }
                         ThisEvent.EventType = ES_NO_EVENT; // consume the event
                     }
                     break;
 
+                case BEACON_LOST: // the steering follows the beacon reading itself, these add nothing
+                case BEACON_FOUND:
+                    ThisEvent.EventType = ES_NO_EVENT; // consume the event
+                    break;
 
                 case BUMPED:
-                    printf("Bumped Event while approaching!\r\n");
+                    TRACE0(TR_BUMPED_APPROACHING);
                     if (AD_ReadADPin(BEACON_A_PIN) < BEACON_CLOSE_THRESH) { // if there was a bumped event, and the robot is NOT suffiecently close to a tower, assume it hit an obstacle
-                        printf("collided with non tower object\r\n");
+                        TRACE0(TR_NON_TOWER_HIT);
                         nextState = ResolveObstacle;
                         makeTransition = TRUE;
                         ThisEvent.EventType = ES_NO_EVENT; // consume event
@@ -182,10 +232,6 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
                     
                     break;
 
-                case ES_EXIT:
-                    ES_Timer_StopTimer(TURN_TIMER);
-                    break;
-
                 default: // all unhandled states fall into here
                     break;
             }
@@ -193,11 +239,11 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
 
         case ResolveObstacle: // if currently trying to resolve an obstacle
 
-            ThisEvent = RunResolveObstacleSubHSM(ThisEvent); // pass events down to substate first
+            ThisEvent = RunResolveObstacleSubHSM(&ctx->resolveObstacle, ThisEvent); // pass events down to substate first
             switch (ThisEvent.EventType) {
                 case ES_ENTRY:
-                    InitResolveObstacleSubHSM();
-                    printf("resolving\r\n");
+                    InitResolveObstacleSubHSM(&ctx->resolveObstacle);
+                    TRACE0(TR_RESOLVING);
                     break;
                 case ES_TIMEOUT: // if there is a timeout event
                     if (OBSTACLE_TIMER == ThisEvent.EventParam) { // and that event is the obstacle timer, and it was not consumed by the sub state machine
@@ -207,9 +253,8 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
                     }
                     break;
                 case ES_EXIT:
-                    printf("resolved\r\n");
+                    TRACE0(TR_RESOLVED);
                     SetMotors(0, 0); // turn off motors when exiting
-                    ES_Timer_StopTimer(OBSTACLE_TIMER); // now stop the timer until next time to resolve
                     break;
                 default: // all unhandled states fall into here
                     break;
@@ -223,9 +268,13 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
 
     if (makeTransition == TRUE) { // making a state transition, send EXIT and ENTRY
         // recursively call the current state with an exit event
-        RunSearchForTowerSubHSM(EXIT_EVENT);
-        CurrentState = nextState;
-        RunSearchForTowerSubHSM(ENTRY_EVENT);
+        RunSearchForTowerSubHSM(ctx, EXIT_EVENT);
+        StateTimer_ExitState(HSM_LEVEL_SUB); // timers armed in the old state no longer apply
+        ctx->CurrentState = nextState;
+        TRACE2(TR_STATE, TRACE_SEARCH_FOR_TOWER, ctx->CurrentState);
+        StateTimer_EnterState(HSM_LEVEL_SUB, ctx->CurrentState);
+        MatchClock_EnterPhase(StatePhase[ctx->CurrentState]);
+        RunSearchForTowerSubHSM(ctx, ENTRY_EVENT);
     }
 
     ES_Tail(); // trace call stack end
@@ -237,3 +286,56 @@ ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent) {
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
 
+/*
+ * The beacon receiver only says how strong the beacon is, not which side it is
+ * on, so ApproachTower weaves a little on purpose: APR_DITHER to the right for
+ * one control period, to the left for the next. The reading at the end of a
+ * weave to the right, against the two either side of it at the ends of weaves
+ * to the left, says which way the beacon gets stronger. Averaging the two
+ * takes out the reading climbing as the robot closes in. Divided by how
+ * strong the beacon is, that is roughly how far off straight ahead the tower
+ * is, and the steering is proportional to it, smoothed over two periods.
+ *
+ * With the beacon under BEACON_LOW_THRESH it keeps turning hard the way it
+ * was last steering. Returns FALSE once that has gone on for APR_TIMEOUT
+ */
+static uint8_t UpdateApproach(SearchForTowerContext_t *ctx, uint16_t beaconVal) {
+    int32_t edge = ctx->lastBeaconVal; // the reading at the end of the last weave
+    int32_t sides = ((int32_t) ctx->olderBeaconVal + beaconVal) / 2; // and either side of it
+    int32_t level = edge + sides + 1;
+    int32_t gradient = (edge - sides) * 512 / level; // 256 times the fraction stronger at the edge
+    int32_t steer;
+
+    if (ctx->turnDir) { // this weave was to the right, so the one lastBeaconVal ended was to the left
+        gradient = -gradient;
+    }
+    ctx->olderBeaconVal = ctx->lastBeaconVal;
+    ctx->lastBeaconVal = beaconVal;
+    ctx->turnDir = !ctx->turnDir;
+
+    if (beaconVal < BEACON_LOW_THRESH) {
+        ctx->lostMs += APR_CONTROL_TICKS;
+        ctx->steer = ctx->steer < 0 ? -APR_DIFF : APR_DIFF;
+        return ctx->lostMs < APR_TIMEOUT;
+    }
+    ctx->lostMs = 0;
+    steer = (ctx->steer + gradient * APR_GAIN / 16) / 2;
+    if (steer > APR_DIFF) {
+        steer = APR_DIFF;
+    } else if (steer < -APR_DIFF) {
+        steer = -APR_DIFF;
+    }
+    ctx->steer = steer;
+    return TRUE;
+}
+
+// positive steer turns right, the weave is added on top
+static void SteerApproach(const SearchForTowerContext_t *ctx) {
+    int16_t turn = ctx->steer + (ctx->turnDir ? APR_DITHER : -APR_DITHER);
+
+    if (turn > 0) {
+        SetMotors(APR_SPEED, APR_SPEED - turn);
+    } else {
+        SetMotors(APR_SPEED + turn, APR_SPEED);
+    }
+}
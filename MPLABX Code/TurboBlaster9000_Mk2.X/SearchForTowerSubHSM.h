@@ -26,14 +26,35 @@
  ******************************************************************************/
 
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "ResolveObstacleSubHSM.h"
+#include "BeaconSweep.h"
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+// everything the machine remembers between events, its sub machine included
+typedef struct {
+    uint32_t lastBeaconVal; // the last recorded value from the beacon
+    uint8_t CurrentState; // a SearchForTowerSubHSMState_t, the enum is in the .c file
+    uint16_t olderBeaconVal; // the beacon value the control period before lastBeaconVal
+    int16_t steer; // how hard ApproachTower is steering, positive to the right
+    uint16_t lostMs; // how long ApproachTower has been without the beacon
+    uint8_t turnDir; // the way ApproachTower is weaving this control period, TRUE to the right
+    BeaconSweep_t sweep; // the beacon through the last full turn in AcquireTower
+    uint16_t alignMs; // how long AlignTower turns for to face the strongest tower
+    uint8_t alignDir; // TRUE to keep turning the way AcquireTower spins, FALSE to turn back
+    uint8_t aimed; // set before Init when the robot already faces a tower, so it starts in ApproachTower
+    ResolveObstacleContext_t resolveObstacle;
+} SearchForTowerContext_t;
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
 
-uint8_t InitSearchForTowerSubHSM(void);
+uint8_t InitSearchForTowerSubHSM(SearchForTowerContext_t *ctx);
 
-ES_Event RunSearchForTowerSubHSM(ES_Event ThisEvent);
+ES_Event RunSearchForTowerSubHSM(SearchForTowerContext_t *ctx, ES_Event ThisEvent);
 
 #endif /* SUB_HSM_TOWER_H */
 
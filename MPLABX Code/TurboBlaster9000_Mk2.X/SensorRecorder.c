@@ -0,0 +1,67 @@
+/*
+ * SensorRecorder.c
+ * Sensor readings into the trace, see SensorRecorder.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "ES_Configure.h"
+#include "BOARD.h"
+#include "AD.h"
+#include "IO_Ports.h"
+#include "timers.h"
+#include "Global_Macros.h"
+#include "SensorRecorder.h"
+#include "RobotContext.h"
+
+#ifdef USE_SENSOR_RECORDER
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static const SensorRecorderGroup_t Groups[NUM_RECORDED_GROUPS] = SENSOR_RECORDER_GROUPS;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t SensorRecorder(void) {
+    SensorRecorderContext_t *ctx = &ROBOT->recorder;
+    int16_t digital[3];
+
+    digital[0] = IO_PortsReadPort(BUMPER_PORT) & RECORDED_BUMPER_PINS;
+    digital[1] = (IO_PortsReadPort(BEACON_PORT) & BEACON_D_PIN) != 0;
+    digital[2] = (IO_PortsReadPort(PING_PORT) & ECHO_PIN) != 0;
+    if (!ctx->started || digital[0] != ctx->digital[0] || digital[1] != ctx->digital[1] || digital[2] != ctx->digital[2]) {
+        TRACE3(TR_REC_DIGITAL, digital[0], digital[1], digital[2]);
+        ctx->digital[0] = digital[0];
+        ctx->digital[1] = digital[1];
+        ctx->digital[2] = digital[2];
+    }
+
+    if (ctx->started && TIMERS_GetTime() - ctx->lastSampleMs < SENSOR_RECORD_MS) {
+        return FALSE;
+    }
+    ctx->lastSampleMs = TIMERS_GetTime();
+
+    for (uint8_t g = 0; g < NUM_RECORDED_GROUPS; g++) {
+        int16_t *last = ctx->analog[g];
+        int16_t a = AD_ReadADPin(Groups[g].pin[0]);
+        int16_t b = AD_ReadADPin(Groups[g].pin[1]);
+        int16_t c = AD_ReadADPin(Groups[g].pin[2]);
+
+        if (!ctx->started || a != last[0] || b != last[1] || c != last[2]) {
+            TRACE3(Groups[g].id, a, b, c);
+            last[0] = a;
+            last[1] = b;
+            last[2] = c;
+        }
+    }
+    ctx->started = TRUE;
+    return FALSE;
+}
+
+#endif /* USE_SENSOR_RECORDER */
@@ -0,0 +1,79 @@
+/*
+ * SensorRecorder.h
+ * Records what every sensor read during a run into the binary trace, so a run
+ * that went wrong on the field can be played again on the host, see
+ * host/Replay.c.
+ *
+ * SensorRecorder is an event checker that runs on every pass of the main loop.
+ * The digital inputs (the four bumpers, the beacon detector's digital pin and
+ * the ping sensor's echo) go out as a TR_REC_DIGITAL record the pass they
+ * change, so echo pulses keep their length. The analog pins are sampled every
+ * SENSOR_RECORD_MS and go out three to a record, each record only when one of
+ * its pins changed. Together with the TR_STATE, TR_MOTORS and TR_FLYWHEEL
+ * records the robot already logs, the capture holds both the inputs to replay
+ * and the outputs to check the replay against.
+ *
+ * Turn it on with USE_SENSOR_RECORDER in ES_Configure.h and capture the serial
+ * port as usual. At the default rate it adds about 4kB/s to the trace when
+ * every analog pin is moving.
+ */
+
+#ifndef SENSOR_RECORDER_H
+#define	SENSOR_RECORDER_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "Global_Macros.h"
+#include "Trace.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define SENSOR_RECORD_MS 10 // how often the analog pins are sampled
+
+#define NUM_RECORDED_GROUPS 3 // analog records, three pins each
+
+// the analog pins in each analog record, in argument order. Replay reads them
+// from here too, so the two always agree
+#define SENSOR_RECORDER_GROUPS { \
+    {TR_REC_TAPE_FRONT, {FL_TAPE_PIN, FR_TAPE_PIN, BL_TAPE_PIN}}, \
+    {TR_REC_TAPE_BACK, {BR_TAPE_PIN, CL_TAPE_PIN, CR_TAPE_PIN}}, \
+    {TR_REC_ANALOG, {S_TAPE_PIN, BEACON_A_PIN, TW_PIN}}, \
+}
+
+// the TR_REC_DIGITAL args are the bumper pins of BUMPER_PORT as read, and 0 or
+// 1 for BEACON_D_PIN and ECHO_PIN
+#define RECORDED_BUMPER_PINS (FL_BUMP_PIN | FR_BUMP_PIN | BL_BUMP_PIN | BR_BUMP_PIN)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    TraceFormat_t id;
+    unsigned int pin[3];
+} SensorRecorderGroup_t;
+
+typedef struct {
+    int16_t analog[NUM_RECORDED_GROUPS][3]; // last values sent
+    int16_t digital[3];
+    uint32_t lastSampleMs;
+    uint8_t started; // FALSE until everything has been sent once
+} SensorRecorderContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/*
+ * Event checker that sends the sensor readings out with the trace. Put it first
+ * in EVENT_CHECK_LIST (after LoopMonitorTick) so it runs on every pass. Never
+ * posts anything, so it always returns FALSE
+ */
+uint8_t SensorRecorder(void);
+
+#endif	/* SENSOR_RECORDER_H */
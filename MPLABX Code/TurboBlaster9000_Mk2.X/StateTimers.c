@@ -0,0 +1,120 @@
+/*
+ * StateTimers.c
+ * Keeps track of which HSM state armed each ES timer, so that the timers can be
+ * cancelled when that state exits instead of every state having to remember to
+ * stop its own timers on ES_EXIT.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "BOARD.h"
+#include "StateTimers.h"
+#include "RobotContext.h"
+#include <stdio.h>
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define NO_OWNER 0xFF    // level value for timers not armed through this module
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// every timer starts out unowned, so timers armed directly with ES_Timer_InitTimer
+// (like the ping sensor's) are never touched by this module
+
+static void InitOwners(StateTimerContext_t *ctx) {
+    for (int i = 0; i < NUM_ES_TIMERS; i++) {
+        ctx->ownerLevel[i] = NO_OWNER;
+        ctx->armed[i] = FALSE;
+    }
+    ctx->initialized = TRUE;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void StateTimer_Start(uint8_t timer, uint32_t ticks, uint8_t level, uint8_t state) {
+    StateTimerContext_t *ctx = &ROBOT->stateTimers;
+    if (!ctx->initialized) InitOwners(ctx);
+    if (timer >= NUM_ES_TIMERS) return;
+
+    ctx->ownerLevel[timer] = level;
+    ctx->ownerState[timer] = state;
+    ctx->armed[timer] = TRUE;
+    if (++ctx->generation[timer] == 0) ctx->generation[timer] = 1; // 0 is unstamped
+    ES_Timer_InitTimer(timer, ticks);
+}
+
+void StateTimer_Stop(uint8_t timer) {
+    StateTimerContext_t *ctx = &ROBOT->stateTimers;
+    if (!ctx->initialized) InitOwners(ctx);
+    if (timer >= NUM_ES_TIMERS) return;
+
+    ES_Timer_StopTimer(timer);
+    ctx->armed[timer] = FALSE;
+}
+
+void StateTimer_ExitState(uint8_t level) {
+    StateTimerContext_t *ctx = &ROBOT->stateTimers;
+    if (!ctx->initialized) InitOwners(ctx);
+
+    for (int i = 0; i < NUM_ES_TIMERS; i++) {
+        // anything armed at this level or deeper belongs to the state that is exiting
+        if (ctx->armed[i] && ctx->ownerLevel[i] != NO_OWNER && ctx->ownerLevel[i] >= level) {
+            ES_Timer_StopTimer(i);
+            ctx->armed[i] = FALSE;
+        }
+    }
+}
+
+void StateTimer_EnterState(uint8_t level, uint8_t state) {
+    if (level < HSM_NUM_LEVELS) {
+        ROBOT->stateTimers.activeState[level] = state;
+    }
+}
+
+void StateTimer_Stamp(ES_Event *ThisEvent) {
+    uint16_t timer = ThisEvent->EventParam;
+
+    if (ThisEvent->EventType != ES_TIMEOUT || timer >= NUM_ES_TIMERS) return;
+    ThisEvent->EventParam = timer | ROBOT->stateTimers.generation[timer] << STATE_TIMER_GENERATION_SHIFT;
+}
+
+uint8_t StateTimer_IsStale(ES_Event *ThisEvent) {
+    StateTimerContext_t *ctx = &ROBOT->stateTimers;
+    uint8_t timer, generation;
+
+    if (ThisEvent->EventType != ES_TIMEOUT) return FALSE;
+    timer = ThisEvent->EventParam & ((1 << STATE_TIMER_GENERATION_SHIFT) - 1);
+    generation = ThisEvent->EventParam >> STATE_TIMER_GENERATION_SHIFT;
+    ThisEvent->EventParam = timer;
+    if (!ctx->initialized) InitOwners(ctx);
+    if (timer >= NUM_ES_TIMERS || ctx->ownerLevel[timer] == NO_OWNER) return FALSE; // not ours to judge
+
+    if (generation != 0 && generation != ctx->generation[timer]) { // expired before the timer was armed again
+#ifdef STATE_TIMER_DEBUG
+        printf("Old timeout: timer %d generation %d, armed again as %d\r\n", timer, generation,
+                ctx->generation[timer]);
+#endif
+        return TRUE;
+    }
+    if (ctx->armed[timer]) { // the owning state is still active, this is a real expiry
+        ctx->armed[timer] = FALSE;
+        return FALSE;
+    }
+
+#ifdef STATE_TIMER_DEBUG
+    printf("Stray timeout: timer %d armed by level %d state %d, level %d now in state %d\r\n",
+            timer, ctx->ownerLevel[timer], ctx->ownerState[timer], ctx->ownerLevel[timer],
+            ctx->activeState[ctx->ownerLevel[timer]]);
+#endif
+    return TRUE;
+}
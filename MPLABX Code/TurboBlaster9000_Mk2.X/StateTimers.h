@@ -0,0 +1,85 @@
+/*
+ * StateTimers.h
+ * ES timers that belong to the HSM state that armed them. A timer armed through
+ * this module is stopped automatically when its owning state, or any state above
+ * it in the RobotHSM tree, exits. Timeouts from a timer that was already cancelled
+ * are recognized as stale so they never reach an unrelated state.
+ *
+ * A timer can expire with its timeout still in the queue when its state exits,
+ * and the next state can arm the same timer again before that timeout comes
+ * out. Every arm gets a generation number, PostRobotHSM stamps the timeout with
+ * the generation of the arm that expired, and only a timeout from the latest
+ * arm counts, whatever was armed in between.
+ */
+
+#ifndef STATE_TIMERS_H
+#define	STATE_TIMERS_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// uncomment to print every stray timeout, and which state had armed it
+//#define STATE_TIMER_DEBUG
+
+#define NUM_ES_TIMERS 16 // the framework has timers 0 - 15
+
+// a stamped ES_TIMEOUT carries the generation above the timer number
+#define STATE_TIMER_GENERATION_SHIFT 8
+
+// depth of each machine in the RobotHSM tree, used as the owner scope of a timer
+#define HSM_LEVEL_TOP 0     // RobotHSM
+#define HSM_LEVEL_SUB 1     // SearchForTower, SearchForHole, FindNewTower
+#define HSM_LEVEL_SUBSUB 2  // ResolveObstacle
+#define HSM_NUM_LEVELS 3
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    uint8_t ownerLevel[NUM_ES_TIMERS]; // level of the machine that armed the timer
+    uint8_t ownerState[NUM_ES_TIMERS]; // state of that machine when it was armed
+    uint8_t armed[NUM_ES_TIMERS]; // TRUE from arming until the timeout is handled or the state exits
+    uint8_t generation[NUM_ES_TIMERS]; // bumped on every arm, never 0 once armed
+    uint8_t activeState[HSM_NUM_LEVELS]; // current state at each level, for debug reports
+    uint8_t initialized;
+} StateTimerContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// arm an ES timer on behalf of the given state of the machine at the given level.
+// re-arming a timer moves its ownership to the new state
+void StateTimer_Start(uint8_t timer, uint32_t ticks, uint8_t level, uint8_t state);
+
+// cancel a timer early, same as ES_Timer_StopTimer but also drops the ownership
+void StateTimer_Stop(uint8_t timer);
+
+// called by a machine right after its current state has handled ES_EXIT.
+// stops every timer armed by that state or by any of its sub states
+void StateTimer_ExitState(uint8_t level);
+
+// called by a machine right before its new state handles ES_ENTRY
+void StateTimer_EnterState(uint8_t level, uint8_t state);
+
+// called as a timeout is posted: puts the generation of the timer's latest arm
+// into the param, next to the timer number
+void StateTimer_Stamp(ES_Event *ThisEvent);
+
+// returns TRUE if the event is an ES_TIMEOUT from a timer that was cancelled by a
+// state exit after it had already expired, or from an arm older than the latest,
+// meaning the event should be dropped. Takes the stamp back off the param, so
+// the machines see only the timer number. An unstamped timeout is judged by
+// whether the timer is still armed alone
+uint8_t StateTimer_IsStale(ES_Event *ThisEvent);
+
+#endif	/* STATE_TIMERS_H */
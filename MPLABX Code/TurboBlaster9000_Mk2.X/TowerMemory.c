@@ -0,0 +1,106 @@
+/*
+ * TowerMemory.c
+ * Per tower, per face marks for SearchForHole, see TowerMemory.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include <string.h>
+#include "BOARD.h"
+#include "TowerMemory.h"
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static TowerRecord_t *Current(TowerMemory_t *memory) {
+    return &memory->tower[memory->current % TOWER_MEMORY_MAX_TOWERS];
+}
+
+// the face the track wire was found on, TOWER_FACES if none
+
+static uint8_t WireFace(const TowerRecord_t *tower) {
+    for (uint8_t i = 0; i < TOWER_FACES; i++) {
+        if (tower->face[i].marks & FACE_TRACK_WIRE) return i;
+    }
+    return TOWER_FACES;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void TowerMemory_Arrive(TowerMemory_t *memory, uint8_t tower, uint8_t fresh) {
+    TowerRecord_t *record;
+
+    memory->current = tower < TOWER_PLAN_MAX_TOWERS ? tower : TOWER_PLAN_MAX_TOWERS;
+    record = Current(memory);
+    if (fresh) {
+        memset(record, 0, sizeof (TowerRecord_t));
+    } else if (WireFace(record) == TOWER_FACES) { // nothing to line the faces up by
+        memset(record->face, 0, sizeof (record->face));
+    }
+    record->onFace = 0;
+    record->placed = WireFace(record) == TOWER_FACES; // numbered from here, or waiting for the track wire
+    record->corners = 0;
+    if (record->visits < UINT8_MAX) record->visits++;
+}
+
+void TowerMemory_Hit(TowerMemory_t *memory, uint8_t mark, uint16_t atMs) {
+    TowerRecord_t *tower = Current(memory);
+    TowerFace_t *face;
+
+    if (mark == FACE_TRACK_WIRE) {
+        if (WireFace(tower) < TOWER_FACES) tower->onFace = WireFace(tower); // back on the face it was found on
+        tower->placed = TRUE;
+    }
+    if (!tower->placed) {
+        return;
+    }
+    face = &tower->face[tower->onFace];
+    if ((face->marks & mark) == 0) {
+        if (mark == FACE_TRACK_WIRE) face->trackWireAtMs = atMs;
+        if (mark == FACE_SIDE_TAPE) face->sideTapeAtMs = atMs;
+    }
+    face->marks |= mark;
+}
+
+void TowerMemory_TurnCorner(TowerMemory_t *memory, uint8_t inspected) {
+    TowerRecord_t *tower = Current(memory);
+
+    if (inspected && tower->placed) tower->face[tower->onFace].marks |= FACE_INSPECTED;
+    tower->onFace = (tower->onFace + 1) % TOWER_FACES;
+    if (tower->corners < UINT8_MAX) tower->corners++;
+}
+
+void TowerMemory_Launched(TowerMemory_t *memory) {
+    TowerRecord_t *tower = Current(memory);
+
+    if (tower->placed) tower->face[tower->onFace].marks |= FACE_HOLE;
+    if (tower->launches < UINT8_MAX) tower->launches++;
+}
+
+uint8_t TowerMemory_FaceMarks(const TowerMemory_t *memory) {
+    const TowerRecord_t *tower = &memory->tower[memory->current % TOWER_MEMORY_MAX_TOWERS];
+    return tower->placed ? tower->face[tower->onFace].marks : 0;
+}
+
+// skipping only while some other face has shown something, so a tower with
+// nothing found on any face yet still gets every face inspected lap after lap
+
+uint8_t TowerMemory_ShouldSkip(const TowerMemory_t *memory) {
+    const TowerRecord_t *tower = &memory->tower[memory->current % TOWER_MEMORY_MAX_TOWERS];
+    uint8_t marks = tower->face[tower->onFace].marks;
+
+    if (!tower->placed || (marks & FACE_INSPECTED) == 0 || (marks & FACE_HITS) != 0) {
+        return FALSE;
+    }
+    for (uint8_t i = 0; i < TOWER_FACES; i++) {
+        if (tower->face[i].marks & FACE_HITS) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
@@ -0,0 +1,100 @@
+/*
+ * TowerMemory.h
+ * What the robot has found out about each tower it has been to, so
+ * SearchForHole does not drive every face of a tower with the same care
+ * lap after lap.
+ *
+ * Every face is marked when the track wire or the side tape reads high on
+ * it, when it has been driven end to end with the hole checks on, and when
+ * a ball was launched from it. A face driven end to end with nothing on it
+ * is not worth inspecting again while another face of the tower has shown
+ * something, so Traverse drives past it at TRAVERSE_SKIP_SPEED.
+ *
+ * The faces are numbered from the one the robot first bumped into, counting
+ * a face on at every corner it turns. The towers go by the numbers
+ * TowerPlanner gives them, so a tower it recognizes gets its own record back,
+ * marks and all. Only the face with the hole that scores has the track wire,
+ * so that is how the robot tells where it is when it comes back: the faces
+ * are not placed until the track wire reads high, nothing is marked and no
+ * face is skipped until then, and from there the numbering picks up where the
+ * last visit left it. A face it launched from before is searched for the hole
+ * straight away. A tower where the track wire was never found has no face to
+ * go by, so its marks start over. How often each tower was visited and
+ * launched at is kept whatever happens.
+ */
+
+#ifndef TOWER_MEMORY_H
+#define	TOWER_MEMORY_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "TowerPlanner.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define TOWER_MEMORY_MAX_TOWERS (TOWER_PLAN_MAX_TOWERS + 1) // one for each tower on the plan, the last for any that did not fit on it
+#define TOWER_FACES 4
+
+// what is known about a face, a bit each
+#define FACE_INSPECTED 0x01 // driven end to end with the hole checks on
+#define FACE_TRACK_WIRE 0x02
+#define FACE_SIDE_TAPE 0x04
+#define FACE_HOLE 0x08 // a ball was launched from it
+#define FACE_HITS (FACE_TRACK_WIRE | FACE_SIDE_TAPE | FACE_HOLE)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    uint8_t marks;
+    uint16_t trackWireAtMs; // first hit, ms after the robot started along the face
+    uint16_t sideTapeAtMs;
+} TowerFace_t;
+
+typedef struct {
+    TowerFace_t face[TOWER_FACES]; // kept from visit to visit
+    uint8_t onFace; // the face the robot is on
+    uint8_t placed; // onFace is the face it is numbered, not just a count from where it arrived
+    uint8_t corners; // turned this visit
+    uint8_t visits;
+    uint8_t launches;
+} TowerRecord_t;
+
+typedef struct {
+    TowerRecord_t tower[TOWER_MEMORY_MAX_TOWERS];
+    uint8_t current; // the tower being searched, or the last one
+} TowerMemory_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// the robot has just bumped into the tower TowerPlanner numbered tower,
+// TOWER_PLAN_NONE for one that did not fit on the plan, on a face it cannot
+// name. Set fresh if it has not been there before
+void TowerMemory_Arrive(TowerMemory_t *memory, uint8_t tower, uint8_t fresh);
+
+// the sensor behind mark read high atMs along the face the robot is on. The
+// track wire places the faces
+void TowerMemory_Hit(TowerMemory_t *memory, uint8_t mark, uint16_t atMs);
+
+// the robot turned a corner on to the next face. Set inspected if the face it
+// left was driven end to end with the hole checks on
+void TowerMemory_TurnCorner(TowerMemory_t *memory, uint8_t inspected);
+
+// a ball was launched from the face the robot is on
+void TowerMemory_Launched(TowerMemory_t *memory);
+
+// the marks on the face the robot is on
+uint8_t TowerMemory_FaceMarks(const TowerMemory_t *memory);
+
+// TRUE if the face the robot is on is not worth inspecting again
+uint8_t TowerMemory_ShouldSkip(const TowerMemory_t *memory);
+
+#endif	/* TOWER_MEMORY_H */
@@ -0,0 +1,139 @@
+/*
+ * TowerPlanner.c
+ * The towers found so far and the pick of the next one, see TowerPlanner.h
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include <string.h>
+#include "BOARD.h"
+#include "Global_Macros.h"
+#include "TowerPlanner.h"
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static uint32_t SquareRoot(uint32_t n) {
+    uint32_t root = 0;
+    for (uint32_t bit = 1UL << 30; bit != 0; bit >>= 2) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return root;
+}
+
+// a beacon falls off with the square of the distance, and reads
+// BEACON_HIGH_THRESH from PLAN_BEACON_REF_CM away
+
+static uint32_t DistanceCm(uint16_t intensity) {
+    if (intensity == 0) intensity = 1;
+    return PLAN_BEACON_REF_CM * SquareRoot((uint32_t) BEACON_HIGH_THRESH * 65536 / intensity) / 256;
+}
+
+static uint8_t NewTower(TowerPlan_t *plan) {
+    if (plan->numTowers >= TOWER_PLAN_MAX_TOWERS) return TOWER_PLAN_NONE;
+    memset(&plan->tower[plan->numTowers], 0, sizeof (PlannedTower_t));
+    return plan->numTowers++;
+}
+
+// the tower seen from the current one before whose beacon read closest to
+// intensity, if it is close enough to be the same one
+
+static uint8_t Recognize(const TowerPlan_t *plan, uint16_t intensity, const uint8_t *claimed) {
+    uint8_t best = TOWER_PLAN_NONE;
+    uint32_t bestOff = UINT32_MAX;
+
+    for (uint8_t i = 0; i < plan->numTowers; i++) {
+        uint16_t then = plan->tower[i].seenFrom[plan->current];
+        if (i == plan->current || claimed[i] || then == 0) continue;
+        uint32_t off = intensity > then ? intensity - then : then - intensity;
+        if (off * 100 <= (uint32_t) then * PLAN_SAME_TOWER_PCT && off < bestOff) {
+            best = i;
+            bestOff = off;
+        }
+    }
+    return best;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+PlanArrival_t TowerPlanner_Arrive(TowerPlan_t *plan, uint32_t nowMs) {
+    uint8_t from = plan->current;
+    PlanArrival_t arrival = PLAN_KNOWN_TOWER;
+
+    if (plan->leaving && plan->targetIntensity != 0 && nowMs < plan->setOffMs + PLAN_CLEAR_TICKS) {
+        return PLAN_LEFT_BEHIND; // still beside it, the peak picked is as it was
+    }
+    if (plan->target != TOWER_PLAN_NONE) {
+        plan->current = plan->target;
+    } else if (plan->leaving || plan->current == TOWER_PLAN_NONE) { // a peak it did not know, or somewhere it did not plan on going
+        plan->current = NewTower(plan);
+        arrival = PLAN_NEW_TOWER;
+        if (plan->current != TOWER_PLAN_NONE && from != TOWER_PLAN_NONE && plan->targetIntensity != 0) {
+            plan->tower[plan->current].seenFrom[from] = plan->targetIntensity;
+            plan->tower[from].seenFrom[plan->current] = plan->targetIntensity;
+        }
+    } // else back at the tower it lost
+    plan->target = TOWER_PLAN_NONE;
+    plan->targetIntensity = 0;
+    plan->leaving = FALSE;
+    return arrival;
+}
+
+void TowerPlanner_Launched(TowerPlan_t *plan) {
+    if (plan->current != TOWER_PLAN_NONE) plan->tower[plan->current].scored = TRUE;
+    plan->target = TOWER_PLAN_NONE;
+    plan->leaving = TRUE;
+}
+
+void TowerPlanner_GiveUp(TowerPlan_t *plan) {
+    plan->target = TOWER_PLAN_NONE;
+    plan->leaving = TRUE;
+}
+
+int8_t TowerPlanner_Choose(TowerPlan_t *plan, const BeaconSweep_t *sweep, uint32_t nowMs) {
+    uint8_t claimed[TOWER_PLAN_MAX_TOWERS] = {0};
+    uint32_t left = nowMs < MATCH_TICKS ? MATCH_TICKS - nowMs : 0;
+    int8_t best = -1;
+
+    plan->target = TOWER_PLAN_NONE;
+    plan->targetIntensity = 0;
+    for (uint8_t p = 0; p < sweep->numPeaks; p++) {
+        const BeaconPeak_t *peak = &sweep->peak[p];
+        uint8_t onward;
+        uint16_t turnMs = BeaconSweep_TurnTo(sweep, p, &onward);
+        uint8_t id = TOWER_PLAN_NONE;
+
+        if (turnMs < PLAN_SELF_TICKS) { // straight ahead, the one it just left
+            continue;
+        }
+        if (plan->current != TOWER_PLAN_NONE) {
+            id = Recognize(plan, peak->intensity, claimed); // any other peak waits until the robot gets there
+            if (id != TOWER_PLAN_NONE) { // one peak to a tower, the strongest
+                claimed[id] = TRUE;
+                plan->tower[id].seenFrom[plan->current] = peak->intensity;
+                plan->tower[plan->current].seenFrom[id] = peak->intensity;
+                if (plan->tower[id].scored) continue;
+            }
+        }
+
+        uint32_t etaMs = turnMs + DistanceCm(peak->intensity) * 1000 / PLAN_APPROACH_CM_PER_S + PLAN_SEARCH_TICKS;
+        if (etaMs <= left && (best < 0 || etaMs < plan->etaMs)) {
+            best = p;
+            plan->target = id;
+            plan->targetIntensity = peak->intensity;
+            plan->setOffMs = nowMs + turnMs;
+            plan->etaMs = etaMs;
+        }
+    }
+    return best;
+}
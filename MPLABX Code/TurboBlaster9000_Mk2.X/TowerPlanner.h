@@ -0,0 +1,101 @@
+/*
+ * TowerPlanner.h
+ * Picks the tower FindNewTower goes to next after a launch, from a list of
+ * every tower found so far, instead of wandering until any beacon is strong.
+ *
+ * The list is kept in the order the robot arrived at the towers. Each one
+ * holds whether a ball was launched at it, which is as close to scored as the
+ * robot can tell, and how strong every other tower's beacon read from beside
+ * it. With no wheel encoders the robot never knows where it is, so that
+ * reading is how a tower is recognized again: two towers read each other's
+ * beacons at the same strength from either end, since they are the same
+ * distance apart.
+ *
+ * After backing out of the hole FindNewTower spins once with a BeaconSweep and
+ * hands the peaks over. The peak straight ahead is the tower it just launched
+ * at. Any peak reading within PLAN_SAME_TOWER_PCT of a tower seen from this
+ * one before is that tower again. Any other peak only goes on the list once
+ * the robot has gone to it and arrived, with the reading it was picked at, so
+ * reflections and beacons glimpsed on one sweep never fill the list up.
+ * Towers launched at are passed over. Each of
+ * the rest is timed: the turn to face it, driving there at
+ * PLAN_APPROACH_CM_PER_S from how far its beacon strength says it is, and
+ * PLAN_SEARCH_TICKS to find the hole. The quickest is picked, if it can still
+ * be scored on before MATCH_TICKS run out.
+ *
+ * Setting off from beside a tower can clip its corner, so a bump sooner than
+ * PLAN_CLEAR_TICKS after turning to the peak picked is that tower again and
+ * no arrival at all. The towers keep the numbers they were put on the list
+ * with for the whole match, and TowerMemory keeps what SearchForHole found on
+ * each of them under the same number.
+ */
+
+#ifndef TOWER_PLANNER_H
+#define	TOWER_PLANNER_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "BeaconSweep.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define TOWER_PLAN_MAX_TOWERS 6 // any more are not remembered
+#define TOWER_PLAN_NONE 0xFF
+
+#define TOWER_PLAN_POWER_ON {.current = TOWER_PLAN_NONE, .target = TOWER_PLAN_NONE}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+// what TowerPlanner_Arrive made of a bump into a tower
+typedef enum {
+    PLAN_LEFT_BEHIND, // the tower it just left, it never got clear of it
+    PLAN_NEW_TOWER, // put on the list as current, or TOWER_PLAN_NONE if the list is full
+    PLAN_KNOWN_TOWER, // current is a tower on the list, or the one it lost
+} PlanArrival_t;
+
+typedef struct {
+    uint8_t scored; // a ball was launched at it
+    uint16_t seenFrom[TOWER_PLAN_MAX_TOWERS]; // its beacon from beside each tower, 0 if never
+} PlannedTower_t;
+
+typedef struct {
+    PlannedTower_t tower[TOWER_PLAN_MAX_TOWERS];
+    uint8_t numTowers;
+    uint8_t current; // the tower the robot is at, or was at last
+    uint8_t target; // the tower it is headed for, TOWER_PLAN_NONE if it does not know
+    uint8_t leaving; // it has launched and is off to another tower
+    uint16_t targetIntensity; // the beacon of the peak picked, from the current tower, 0 if none
+    uint32_t setOffMs; // when it will have turned to face the peak picked
+    uint32_t etaMs; // how long the target was expected to take to score on when it was picked
+} TowerPlan_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// the robot has bumped into a tower nowMs into the match. A peak picked that
+// was no tower on the list is added to it here, and current is the tower
+// SearchForHole is at unless it was the one just left
+PlanArrival_t TowerPlanner_Arrive(TowerPlan_t *plan, uint32_t nowMs);
+
+// a ball was launched at the current tower
+void TowerPlanner_Launched(TowerPlan_t *plan);
+
+// leaving the current tower without launching at it, so it can be picked again
+void TowerPlanner_GiveUp(TowerPlan_t *plan);
+
+/*
+ * Picks the peak of a sweep taken beside the current tower, facing it, to go
+ * to next and makes it the target. Returns the peak's index, or -1 if there is
+ * none worth going to before the match ends at MATCH_TICKS
+ */
+int8_t TowerPlanner_Choose(TowerPlan_t *plan, const BeaconSweep_t *sweep, uint32_t nowMs);
+
+#endif	/* TOWER_PLANNER_H */
@@ -0,0 +1,137 @@
+/*
+ * Trace.c
+ * Binary trace ring buffer, see Trace.h
+ *
+ * Records are only ever added from the main loop and only taken out by
+ * TraceDrain, so the ring has a single producer and a single consumer. Each side
+ * only writes its own index, which keeps it safe without turning interrupts off
+ * even if the drain is later moved into the UART interrupt.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "Trace.h"
+#include "ProfileClock.h"
+#include "RobotContext.h"
+#include "serial.h"
+#include <stdio.h>
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define RING_MASK (TRACE_RING_SIZE - 1)
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+#ifdef TRACE_AS_TEXT
+#define TRACE_FORMAT(id, text) text,
+static const char *FormatText[NUM_TRACE_FORMATS] = {
+    TRACE_FORMAT_LIST
+};
+#undef TRACE_FORMAT
+#endif
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static uint32_t NowUs(TraceContext_t *ctx) {
+    uint32_t us = PROFILE_TICKS_TO_US(ProfileClock_GetTicks() - ctx->lastTicks);
+    ctx->clockUs += us;
+    ctx->lastTicks += us * PROFILE_TICKS_PER_US; // keep the remainder for next time
+    return ctx->clockUs;
+}
+
+static uint8_t Push(TraceContext_t *ctx, uint8_t id, uint8_t nargs, int16_t a, int16_t b, int16_t c, uint32_t timeUs) {
+    uint8_t h = ctx->head;
+    if (((h + 1) & RING_MASK) == ctx->tail) {
+        return FALSE;
+    }
+    TraceRecord_t *r = &ctx->ring[h];
+    r->timeUs = timeUs;
+    r->id = id;
+    r->nargs = nargs;
+    r->arg[0] = a;
+    r->arg[1] = b;
+    r->arg[2] = c;
+    ctx->head = (h + 1) & RING_MASK; // publish only once the record is complete
+    return TRUE;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void Trace_Log(TraceFormat_t id, uint8_t nargs, int16_t a, int16_t b, int16_t c) {
+#ifdef TRACE_AS_TEXT
+    printf(FormatText[id], a, b, c);
+    printf("\r\n");
+#else
+    TraceContext_t *ctx = &ROBOT->trace;
+    uint32_t now = NowUs(ctx);
+
+    if (ctx->droppedSinceReport != 0) { // say how much was lost before logging anything newer
+        if (!Push(ctx, TR_DROPPED, 1, (int16_t) ctx->droppedSinceReport, 0, 0, now)) {
+            if (ctx->droppedSinceReport < 0x7FFF) ctx->droppedSinceReport++;
+            ctx->dropped++;
+            return;
+        }
+        ctx->droppedSinceReport = 0;
+    }
+    if (!Push(ctx, id, nargs, a, b, c, now)) {
+        ctx->droppedSinceReport++;
+        ctx->dropped++;
+    }
+#endif
+}
+
+uint32_t Trace_GetDropped(void) {
+    return ROBOT->trace.dropped;
+}
+
+uint8_t TraceDrain(void) {
+#ifndef TRACE_AS_TEXT
+    TraceContext_t *ctx = &ROBOT->trace;
+    NowUs(ctx); // keeps the clock from missing a wrap of the core timer during quiet periods
+
+    uint8_t t = ctx->tail;
+    if (t == ctx->head || !IsTransmitEmpty()) {
+        return FALSE;
+    }
+
+    const TraceRecord_t *r = &ctx->ring[t];
+    uint8_t frame[TRACE_MAX_FRAME];
+    uint8_t len = 0;
+    uint8_t sum = 0;
+
+    frame[len++] = TRACE_SYNC;
+    frame[len++] = r->id;
+    frame[len++] = r->nargs;
+    frame[len++] = r->timeUs;
+    frame[len++] = r->timeUs >> 8;
+    frame[len++] = r->timeUs >> 16;
+    frame[len++] = r->timeUs >> 24;
+    for (uint8_t i = 0; i < r->nargs && i < TRACE_MAX_ARGS; i++) {
+        frame[len++] = (uint16_t) r->arg[i];
+        frame[len++] = (uint16_t) r->arg[i] >> 8;
+    }
+    for (uint8_t i = 1; i < len; i++) {
+        sum += frame[i];
+    }
+    frame[len++] = sum;
+
+    ctx->tail = (t + 1) & RING_MASK; // the record is copied out, free the slot
+
+    // the transmit buffer was empty, so this never waits on the UART
+    for (uint8_t i = 0; i < len; i++) {
+        PutChar(frame[i]);
+    }
+#endif
+    return FALSE;
+}
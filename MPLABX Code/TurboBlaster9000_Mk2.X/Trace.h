@@ -0,0 +1,98 @@
+/*
+ * Trace.h
+ * Binary trace for the hot paths of the state machines. Instead of a printf that
+ * blocks on the UART inside the run-to-completion handler, a trace call only
+ * copies a format ID, a timestamp and up to three integer args into a RAM ring.
+ * TraceDrain, the last event checker, sends the ring out over the serial port
+ * when the loop has nothing else to do, and the text is put back together on
+ * the host from TraceFormats.h.
+ * The frame layout is in TraceFormats.h.
+ */
+
+#ifndef TRACE_H
+#define	TRACE_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "TraceFormats.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// uncomment to get the old blocking printf text instead of binary frames,
+// handy with a plain serial terminal
+//#define TRACE_AS_TEXT
+
+#define TRACE_RING_SIZE 64 // records, must be a power of 2
+#define TRACE_MAX_FRAME (1 + 1 + 1 + 4 + 2 * TRACE_MAX_ARGS + 1)
+
+#define TRACE0(id) Trace_Log(id, 0, 0, 0, 0)
+#define TRACE1(id, a) Trace_Log(id, 1, a, 0, 0)
+#define TRACE2(id, a, b) Trace_Log(id, 2, a, b, 0)
+#define TRACE3(id, a, b, c) Trace_Log(id, 3, a, b, c)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+#define TRACE_FORMAT(id, text) id,
+
+typedef enum {
+    TRACE_FORMAT_LIST
+    NUM_TRACE_FORMATS
+} TraceFormat_t;
+
+#undef TRACE_FORMAT
+
+#define TRACE_MACHINE(id, file) id,
+
+typedef enum {
+    TRACE_MACHINE_LIST
+    NUM_TRACE_MACHINES
+} TraceMachine_t;
+
+#undef TRACE_MACHINE
+
+typedef struct {
+    uint32_t timeUs;
+    int16_t arg[TRACE_MAX_ARGS];
+    uint8_t id;
+    uint8_t nargs;
+} TraceRecord_t;
+
+typedef struct {
+    TraceRecord_t ring[TRACE_RING_SIZE];
+    volatile uint8_t head; // next free slot, only written by Trace_Log
+    volatile uint8_t tail; // oldest record, only written by TraceDrain
+    uint16_t droppedSinceReport; // drops not yet announced with a TR_DROPPED record
+    uint32_t dropped;
+
+    // the core timer wraps every 107 seconds, so the microsecond clock is kept here
+    // and caught up on every log and every drain, which happen far more often than that
+    uint32_t clockUs;
+    uint32_t lastTicks;
+} TraceContext_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+// puts one record in the ring, use the TRACEn macros instead of calling this.
+// if the ring is full the record is dropped and counted
+void Trace_Log(TraceFormat_t id, uint8_t nargs, int16_t a, int16_t b, int16_t c);
+
+// number of records dropped because the ring was full, since startup
+uint32_t Trace_GetDropped(void);
+
+/*
+ * Event checker that sends the oldest record in the ring whenever the serial
+ * transmit buffer is empty. Put it last in EVENT_CHECK_LIST so it only runs on
+ * passes where no other checker found an event. Always returns FALSE
+ */
+uint8_t TraceDrain(void);
+
+#endif	/* TRACE_H */
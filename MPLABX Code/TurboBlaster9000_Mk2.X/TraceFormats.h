@@ -0,0 +1,76 @@
+/*
+ * TraceFormats.h
+ * Everything the robot and the host decoder have to agree on about the binary
+ * trace, see Trace.h
+ *
+ * Only the ID goes over the wire, the text stays here. Each line is
+ * TRACE_FORMAT(id, text) and the text is a printf format for the integer args
+ * logged with it. The same list builds the TraceFormat_t enum on the robot and
+ * the string table the host decoder uses, so new messages only get added here.
+ * Always add to the end, IDs are the position in the list. Messages nothing
+ * logs any more stay where they are, so older traces still decode.
+ *
+ * host/TraceTables.py reads the TRACE_MACHINE list below to find the StateNames
+ * of every machine, so keep one entry per line.
+ */
+
+#ifndef TRACE_FORMATS_H
+#define	TRACE_FORMATS_H
+
+// each record goes out as one frame, all multi byte fields little endian:
+//   TRACE_SYNC, id, nargs, 4 byte time in us, nargs * 2 byte signed args, checksum
+// where the checksum is the low byte of the sum of every byte after the sync
+#define TRACE_SYNC 0xA5
+#define TRACE_MAX_ARGS 3
+
+#define TRACE_FORMAT_LIST \
+    TRACE_FORMAT(TR_DROPPED, "** %d trace records dropped **") \
+    TRACE_FORMAT(TR_SEARCHING_TOWER, "searching for tower tower") \
+    TRACE_FORMAT(TR_ACQUIRED, "acquired") \
+    TRACE_FORMAT(TR_BUMPED_ACQUIRING, "Bumped Event while acquiring!!") \
+    TRACE_FORMAT(TR_APPROACHING, "approaching") \
+    TRACE_FORMAT(TR_BUMPED_APPROACHING, "Bumped Event while approaching!") \
+    TRACE_FORMAT(TR_NON_TOWER_HIT, "collided with non tower object") \
+    TRACE_FORMAT(TR_RESOLVING, "resolving") \
+    TRACE_FORMAT(TR_RESOLVED, "resolved") \
+    TRACE_FORMAT(TR_FL_RESOLVE, "Entered FL Resolve") \
+    TRACE_FORMAT(TR_FR_RESOLVE, "Entered FR Resolve") \
+    TRACE_FORMAT(TR_BL_RESOLVE, "Entered BL Resolve") \
+    TRACE_FORMAT(TR_BR_RESOLVE, "Entered BR Resolve") \
+    TRACE_FORMAT(TR_ALIGNING_SENSOR, "Aligning Sensor") \
+    TRACE_FORMAT(TR_NEW_PING, "New Ping %d") \
+    TRACE_FORMAT(TR_TRAVERSING, "Traversing") \
+    TRACE_FORMAT(TR_TURNING, "Turning") \
+    TRACE_FORMAT(TR_REACQUIRE, "Driving to Reacquire") \
+    TRACE_FORMAT(TR_DRIVING_FORWARD, "Driving Forward") \
+    TRACE_FORMAT(TR_CENTER_TAPE, "CR: %d, CL: %d") \
+    TRACE_FORMAT(TR_LEFT_SHIFTED, "Left Shifted") \
+    TRACE_FORMAT(TR_RIGHT_SHIFTED, "Right Shifted") \
+    TRACE_FORMAT(TR_CENTERED, "Centered") \
+    TRACE_FORMAT(TR_OFF_COMPLETELY, "Off Completely") \
+    TRACE_FORMAT(TR_BACKING_UP, "backing up") \
+    TRACE_FORMAT(TR_BACK_UP_EXPIRED, "back up time expired") \
+    TRACE_FORMAT(TR_STATE, "machine %d enters state %d") \
+    TRACE_FORMAT(TR_EVENT, "RobotHSM runs event %d, param %d") \
+    TRACE_FORMAT(TR_MOTORS, "motors L %d R %d") \
+    TRACE_FORMAT(TR_FLYWHEEL, "flywheel %d") \
+    TRACE_FORMAT(TR_REC_TAPE_FRONT, "tape FL %d FR %d BL %d") \
+    TRACE_FORMAT(TR_REC_TAPE_BACK, "tape BR %d CL %d CR %d") \
+    TRACE_FORMAT(TR_REC_ANALOG, "side tape %d beacon %d track wire %d") \
+    TRACE_FORMAT(TR_REC_DIGITAL, "bumpers %d beacon %d echo %d") \
+    TRACE_FORMAT(TR_SWEEP_PEAK, "sweep saw %d towers, strongest %d at %d ms") \
+    TRACE_FORMAT(TR_FACE, "tower %d on to face %d, marks %d") \
+    TRACE_FORMAT(TR_HOLE_CONFIDENCE, "hole confidence %d at %d ms along the face") \
+    TRACE_FORMAT(TR_PLAN, "survey saw %d towers, heading for tower %d, %d s to score") \
+    TRACE_FORMAT(TR_ESCAPE, "escaping situation %d: L %d R %d")
+
+// the state machines that log their transitions with TR_STATE, and the file that
+// holds each one's StateNames array so the host can name the states
+#define TRACE_MACHINE_LIST \
+    TRACE_MACHINE(TRACE_ROBOT_HSM, "RobotHSM.c") \
+    TRACE_MACHINE(TRACE_SEARCH_FOR_TOWER, "SearchForTowerSubHSM.c") \
+    TRACE_MACHINE(TRACE_SEARCH_FOR_HOLE, "SearchForHoleSubHSM.c") \
+    TRACE_MACHINE(TRACE_FIND_NEW_TOWER, "FindNewTowerSubHSM.c") \
+    TRACE_MACHINE(TRACE_RESOLVE_OBSTACLE, "ResolveObstacleSubHSM.c")
+
+#endif	/* TRACE_FORMATS_H */
@@ -0,0 +1,710 @@
+/*
+ * ArenaSim.c
+ * Arena and robot model for the host build, see ArenaSim.h
+ *
+ * The robot's dimensions are Prototype 2's (Solidworks/Prototype 2): a square
+ * chassis that fits the 11in box test, wheels on the center line at the sides,
+ * the ping sensor and the side tape sensor on the left, the launcher firing
+ * over the front bumpers. Anything the CAD does not pin down (sensor reach,
+ * A/D levels, motor speed) was picked to match what the thresholds in
+ * Global_Macros.h were tuned against on the real robot, and is all up here.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "BOARD.h"
+#include "AD.h"
+#include "IO_Ports.h"
+#include "pwm.h"
+#include "RC_Servo.h"
+#include "Global_Macros.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DT 0.001 // one tick of the host clock
+#define FEET 0.3048
+
+// chassis, the robot frame has x forward and y to the left
+#define ROBOT_HALF 0.135 // half the side of the square chassis
+#define TRACK 0.23 // between the wheels
+
+// drive, Motor_Control puts 60% to 100% duty on the enable pins. Below about
+// 45% the gearmotors do not turn the wheels at all
+#define TOP_SPEED 0.30 // m/s at 100% duty
+#define STALL_DUTY 450
+#define MOTOR_TAU 0.08 // s, wheel speed lag behind the duty cycle
+// the casters drag sideways when the robot turns, so it turns slower than its
+// wheels alone would. A spin in place at ACQUIRE_SPEED takes the real robot's
+// 5 s TURN_360_TICKS, where the wheels would have it round in 2.95 s
+#define TURN_SCRUB 0.59
+
+// TCRT5000 tape sensors. Black tape and nothing in reach both read high
+#define FLOOR_READING 150
+#define TAPE_READING 900
+#define TAPE_WIDTH 0.05 // 2in electrical tape
+#define WALL_READING 120 // tower wall in reach of a side or front sensor
+#define NOTHING_READING 980
+#define SENSOR_REACH 0.06
+
+// beacon detector, a lobe around straight ahead that falls off with distance
+#define BEACON_AMBIENT 15
+#define BEACON_GAIN 880.0 // reads BEACON_HIGH_THRESH at 2m head on
+#define BEACON_NEAR 0.1
+#define BEACON_TRIP 220 // the detector's own comparator on the digital pin, fixed in hardware
+#define BEACON_LOBE 0.45 // rad either side of straight ahead
+
+// track wire sensor, an inductor tuned to the wire's 25kHz, falls off as 1/r
+#define TW_AMBIENT 5
+#define TW_GAIN 30.0 // reads TW_HIGH_THRESH at about 10cm
+#define TW_NEAR 0.03
+
+// HC-SR04, three rays across its cone, echo held for 38ms when nothing comes back.
+// Flat walls only echo back to it from close to head on
+#define SPEED_OF_SOUND 343.0
+#define PING_MAX_RANGE 4.0
+#define PING_CONE 0.2
+#define PING_MAX_INCIDENCE 0.7
+#define PING_NO_ECHO_MS 38
+
+#define BUMP_REACH 0.002 // how close a bumper has to be to a surface to close
+
+// ball servo and flywheel, see setServoPos and setFlyMotor
+#define SERVO_LOAD_PULSE 1750 // anything shorter is the loading position
+#define FLY_MIN_DUTY 500 // the ball just dribbles out below this
+#define LAUNCH_REACH 0.05 // front bumper to the wall for the ball to make it in
+#define HOLE_HALF_WIDTH 0.04 // launcher center to hole center along the wall
+#define BESIDE_HOLE_REACH 0.2 // side tape sensor to the wall for ArenaSim_BesideHole
+#define LAUNCH_MAX_ANGLE 0.35 // rad off square to the wall
+
+// random fields, room to drive between the towers and around the start pose
+#define TOWER_WALL_GAP 0.35
+#define TOWER_TOWER_GAP 0.7
+#define START_CLEARANCE 0.35
+#define MAX_AD_NOISE 20
+#define MAX_PING_NOISE 0.02
+#define MAX_MISMATCH 0.1
+#define PLACEMENT_TRIES 1000
+
+typedef struct {
+    double x, y;
+} Point_t;
+
+typedef enum {
+    FL_BUMPER, FR_BUMPER, BL_BUMPER, BR_BUMPER, NUM_BUMPERS
+} Bumper_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+// where everything is mounted, in the robot frame
+static const Point_t FloorTapeAt[] = {
+    {0.10, 0.09}, // FL
+    {0.10, -0.09}, // FR
+    {-0.10, 0.09}, // BL
+    {-0.10, -0.09}, // BR
+};
+static const unsigned int FloorTapePin[] = {FL_TAPE_PIN, FR_TAPE_PIN, BL_TAPE_PIN, BR_TAPE_PIN};
+
+static const Point_t CenterLeftAt = {ROBOT_HALF, 0.02}; // looking forward, either side of the launcher
+static const Point_t CenterRightAt = {ROBOT_HALF, -0.02};
+static const Point_t SideTapeAt = {0.05, ROBOT_HALF}; // looking left
+static const Point_t PingAt = {-0.02, ROBOT_HALF}; // looking left
+static const Point_t TrackWireAt = {0.08, ROBOT_HALF - 0.02};
+static const Point_t BeaconAt = {0.05, 0.0}; // looking forward
+
+// each bumper covers half of the front or back edge
+static const Point_t BumperFrom[] = {
+    {ROBOT_HALF, 0.01}, {ROBOT_HALF, -0.01}, {-ROBOT_HALF, 0.01}, {-ROBOT_HALF, -0.01}
+};
+static const Point_t BumperTo[] = {
+    {ROBOT_HALF, ROBOT_HALF}, {ROBOT_HALF, -ROBOT_HALF}, {-ROBOT_HALF, ROBOT_HALF}, {-ROBOT_HALF, -ROBOT_HALF}
+};
+static const unsigned short BumperPin[] = {FL_BUMP_PIN, FR_BUMP_PIN, BL_BUMP_PIN, BR_BUMP_PIN};
+
+static __thread ArenaSim_t *arena; // the one selected with ArenaSim_Select
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+// xorshift32, seeded from the config so a match always plays out the same
+
+static uint32_t NextRandom(void) {
+    uint32_t x = arena->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    arena->rng = x;
+    return x;
+}
+
+// triangular noise between -peak and peak
+
+static double Noise(double peak) {
+    if (peak <= 0) return 0;
+    double a = NextRandom() / 4294967296.0;
+    double b = NextRandom() / 4294967296.0;
+    return (a + b - 1.0) * peak;
+}
+
+static void SetReading(unsigned int pin, double value) {
+    value += Noise(arena->config.adNoise);
+    if (value < 0) value = 0;
+    HostHAL_SetAD(pin, (unsigned int) (value + 0.5));
+}
+
+static Point_t ToWorld(Point_t p) {
+    double c = cos(arena->pose.heading), s = sin(arena->pose.heading);
+    Point_t w = {arena->pose.x + c * p.x - s * p.y, arena->pose.y + s * p.x + c * p.y};
+    return w;
+}
+
+// a point or direction in the frame of a tower, centered with faces along the axes
+
+static Point_t ToTower(const ArenaTower_t *t, Point_t p) {
+    double c = cos(t->angle), s = sin(t->angle);
+    double dx = p.x - t->x, dy = p.y - t->y;
+    Point_t l = {c * dx + s * dy, -s * dx + c * dy};
+    return l;
+}
+
+static Point_t DirToTower(const ArenaTower_t *t, double heading) {
+    Point_t l = {cos(heading - t->angle), sin(heading - t->angle)};
+    return l;
+}
+
+// distance from a point to a tower, 0 when inside
+
+static double TowerDistance(const ArenaTower_t *t, Point_t p) {
+    double h = arena->config.towerSize / 2;
+    Point_t l = ToTower(t, p);
+    double dx = fabs(l.x) - h, dy = fabs(l.y) - h;
+    if (dx < 0) dx = 0;
+    if (dy < 0) dy = 0;
+    return sqrt(dx * dx + dy * dy);
+}
+
+// how far a ray goes before hitting a tower, or -1. face is which face was hit
+// and along is where across it, 0 in the middle where the hole is
+
+static double RayTower(const ArenaTower_t *t, Point_t from, double heading, int *face, double *along) {
+    double h = arena->config.towerSize / 2;
+    Point_t o = ToTower(t, from);
+    Point_t d = DirToTower(t, heading);
+    double tNear = -1e9, tFar = 1e9;
+    int nearAxis = 0;
+    double oc[2] = {o.x, o.y}, dc[2] = {d.x, d.y};
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (fabs(dc[axis]) < 1e-12) {
+            if (oc[axis] < -h || oc[axis] > h) return -1;
+            continue;
+        }
+        double t1 = (-h - oc[axis]) / dc[axis];
+        double t2 = (h - oc[axis]) / dc[axis];
+        if (t1 > t2) {
+            double tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+        if (t1 > tNear) {
+            tNear = t1;
+            nearAxis = axis;
+        }
+        if (t2 < tFar) tFar = t2;
+    }
+    if (tNear > tFar || tNear < 0) return -1;
+
+    double hx = o.x + d.x * tNear, hy = o.y + d.y * tNear;
+    if (nearAxis == 0) {
+        if (face) *face = (hx > 0) ? 0 : 2;
+        if (along) *along = hy;
+    } else {
+        if (face) *face = (hy > 0) ? 1 : 3;
+        if (along) *along = hx;
+    }
+    return tNear;
+}
+
+// how far a ray from inside the arena goes before it hits a wall, and the
+// direction the wall it hits faces
+
+static double RayWalls(Point_t from, double heading, double *normal) {
+    double dx = cos(heading), dy = sin(heading);
+    double best = 1e9, t;
+    if (dx > 1e-12 && (t = (arena->config.width - from.x) / dx) < best) {
+        best = t;
+        *normal = M_PI;
+    }
+    if (dx < -1e-12 && (t = -from.x / dx) < best) {
+        best = t;
+        *normal = 0;
+    }
+    if (dy > 1e-12 && (t = (arena->config.height - from.y) / dy) < best) {
+        best = t;
+        *normal = -M_PI / 2;
+    }
+    if (dy < -1e-12 && (t = -from.y / dy) < best) {
+        best = t;
+        *normal = M_PI / 2;
+    }
+    return best;
+}
+
+// nearest tower along a ray, -1 if none
+
+static int NearestTower(Point_t from, double heading, double *range, int *face, double *along) {
+    int best = -1;
+    *range = 1e9;
+    for (int i = 0; i < arena->config.numTowers; i++) {
+        int f;
+        double a;
+        double r = RayTower(&arena->config.towers[i], from, heading, &f, &a);
+        if (r >= 0 && r < *range) {
+            *range = r;
+            best = i;
+            if (face) *face = f;
+            if (along) *along = a;
+        }
+    }
+    return best;
+}
+
+// the drive. The H bridge enable duty sets the speed, IN1 and IN2 the direction
+
+static double WheelTarget(unsigned short enable, unsigned short in1, unsigned short in2, double gain) {
+    unsigned int duty = HostHAL_GetPWMDuty(enable);
+    unsigned short pins = HostHAL_GetPortOutputs(MOTOR_PORT);
+    if (duty <= STALL_DUTY) return 0;
+
+    double speed = TOP_SPEED * gain * (duty - STALL_DUTY) / (MAX_PWM - STALL_DUTY);
+    if (pins & in1) return speed;
+    if (pins & in2) return -speed;
+    return 0;
+}
+
+static void Drive(void) {
+    double left = WheelTarget(LEFT_EN, LEFT_IN1_PIN, LEFT_IN2_PIN, arena->config.leftGain);
+    double right = WheelTarget(RIGHT_EN, RIGHT_IN1_PIN, RIGHT_IN2_PIN, arena->config.rightGain);
+    double k = DT / (MOTOR_TAU + DT);
+    arena->leftSpeed += (left - arena->leftSpeed) * k;
+    arena->rightSpeed += (right - arena->rightSpeed) * k;
+
+    double v = (arena->leftSpeed + arena->rightSpeed) / 2;
+    double w = (arena->rightSpeed - arena->leftSpeed) / TRACK * TURN_SCRUB;
+    double mid = arena->pose.heading + w * DT / 2;
+    arena->pose.x += v * cos(mid) * DT;
+    arena->pose.y += v * sin(mid) * DT;
+    arena->pose.heading = remainder(arena->pose.heading + w * DT, 2 * M_PI);
+    arena->distance += fabs(v) * DT;
+}
+
+// separating axis test between the chassis and a tower, both squares. Pushes
+// the robot out along the axis it is the least far in on
+
+static uint8_t PushOutOfTower(const ArenaTower_t *t) {
+    double axes[4] = {arena->pose.heading, arena->pose.heading + M_PI / 2, t->angle, t->angle + M_PI / 2};
+    double halves[2] = {ROBOT_HALF, arena->config.towerSize / 2};
+    double angles[2] = {arena->pose.heading, t->angle};
+    double best = 1e9, bestX = 0, bestY = 0;
+    double cx = t->x - arena->pose.x, cy = t->y - arena->pose.y;
+
+    for (int a = 0; a < 4; a++) {
+        double ax = cos(axes[a]), ay = sin(axes[a]);
+        double reach = 0;
+        for (int b = 0; b < 2; b++) { // projected half width of each square on this axis
+            double rel = axes[a] - angles[b];
+            reach += halves[b] * (fabs(cos(rel)) + fabs(sin(rel)));
+        }
+        double gap = fabs(cx * ax + cy * ay);
+        double overlap = reach - gap;
+        if (overlap <= 0) return FALSE;
+        if (overlap < best) {
+            double dir = (cx * ax + cy * ay > 0) ? -1 : 1;
+            best = overlap;
+            bestX = ax * overlap * dir;
+            bestY = ay * overlap * dir;
+        }
+    }
+    arena->pose.x += bestX;
+    arena->pose.y += bestY;
+    return TRUE;
+}
+
+static uint8_t PushOutOfWalls(void) {
+    double minX = 1e9, maxX = -1e9, minY = 1e9, maxY = -1e9;
+    for (int i = 0; i < 4; i++) {
+        Point_t corner = {(i & 1) ? ROBOT_HALF : -ROBOT_HALF, (i & 2) ? ROBOT_HALF : -ROBOT_HALF};
+        Point_t w = ToWorld(corner);
+        minX = fmin(minX, w.x);
+        maxX = fmax(maxX, w.x);
+        minY = fmin(minY, w.y);
+        maxY = fmax(maxY, w.y);
+    }
+
+    uint8_t pushed = FALSE;
+    if (minX < 0) {
+        arena->pose.x -= minX;
+        pushed = TRUE;
+    } else if (maxX > arena->config.width) {
+        arena->pose.x -= maxX - arena->config.width;
+        pushed = TRUE;
+    }
+    if (minY < 0) {
+        arena->pose.y -= minY;
+        pushed = TRUE;
+    } else if (maxY > arena->config.height) {
+        arena->pose.y -= maxY - arena->config.height;
+        pushed = TRUE;
+    }
+    return pushed;
+}
+
+static void Collide(void) {
+    uint8_t pushed = FALSE;
+    for (int pass = 0; pass < 2; pass++) { // a second pass for wedged between a tower and a wall
+        for (int i = 0; i < arena->config.numTowers; i++) {
+            pushed |= PushOutOfTower(&arena->config.towers[i]);
+        }
+        pushed |= PushOutOfWalls();
+    }
+    if (pushed) arena->contactMs++;
+}
+
+static uint8_t Touching(Point_t p) {
+    if (p.x < BUMP_REACH || p.y < BUMP_REACH ||
+            p.x > arena->config.width - BUMP_REACH || p.y > arena->config.height - BUMP_REACH) {
+        return TRUE;
+    }
+    for (int i = 0; i < arena->config.numTowers; i++) {
+        if (TowerDistance(&arena->config.towers[i], p) < BUMP_REACH) return TRUE;
+    }
+    return FALSE;
+}
+
+// the bumpers pull up and read low when pressed
+
+static void Bumpers(void) {
+    for (int b = 0; b < NUM_BUMPERS; b++) {
+        uint8_t pressed = FALSE;
+        for (int s = 0; s <= 4 && !pressed; s++) {
+            Point_t p = {BumperFrom[b].x + (BumperTo[b].x - BumperFrom[b].x) * s / 4,
+                BumperFrom[b].y + (BumperTo[b].y - BumperFrom[b].y) * s / 4};
+            pressed = Touching(ToWorld(p));
+        }
+        HostHAL_SetPortInputs(BUMPER_PORT, BumperPin[b], !pressed);
+    }
+}
+
+// tape runs around the arena just inside the walls
+
+static void FloorTape(void) {
+    for (int i = 0; i < 4; i++) {
+        Point_t p = ToWorld(FloorTapeAt[i]);
+        uint8_t onTape = p.x < TAPE_WIDTH || p.y < TAPE_WIDTH ||
+                p.x > arena->config.width - TAPE_WIDTH || p.y > arena->config.height - TAPE_WIDTH;
+        SetReading(FloorTapePin[i], onTape ? TAPE_READING : FLOOR_READING);
+    }
+}
+
+// the sensors that look at the tower walls, the strip of tape under each hole
+// reads like nothing being there at all
+
+static void WallSensor(unsigned int pin, Point_t at, double facing) {
+    int face;
+    double along, range;
+    Point_t from = ToWorld(at);
+    double heading = arena->pose.heading + facing;
+    int tower = NearestTower(from, heading, &range, &face, &along);
+    double reading = NOTHING_READING;
+
+    if (tower >= 0 && range < SENSOR_REACH && fabs(along) > TAPE_WIDTH / 2) {
+        reading = WALL_READING;
+    }
+    SetReading(pin, reading);
+}
+
+static void Beacon(void) {
+    Point_t from = ToWorld(BeaconAt);
+    double value = BEACON_AMBIENT;
+
+    for (int i = 0; i < arena->config.numTowers; i++) {
+        const ArenaTower_t *t = &arena->config.towers[i];
+        if (!t->beaconOn) continue;
+        double dx = t->x - from.x, dy = t->y - from.y;
+        double bearing = remainder(atan2(dy, dx) - arena->pose.heading, 2 * M_PI);
+        if (fabs(bearing) >= BEACON_LOBE) continue;
+
+        double range;
+        int nearest = NearestTower(from, atan2(dy, dx), &range, NULL, NULL);
+        if (nearest >= 0 && nearest != i) continue; // another tower in the way
+
+        double lobe = cos(bearing / BEACON_LOBE * M_PI / 2);
+        value += BEACON_GAIN * lobe / (dx * dx + dy * dy + BEACON_NEAR * BEACON_NEAR);
+    }
+    if (value > 1023) value = 1023;
+    SetReading(BEACON_A_PIN, value);
+    HostHAL_SetPortInputs(BEACON_PORT, BEACON_D_PIN, value > BEACON_TRIP);
+}
+
+// the wire runs along the bottom of the face with the scoring hole
+
+static void TrackWire(void) {
+    Point_t p = ToWorld(TrackWireAt);
+    double best = 1e9;
+
+    for (int i = 0; i < arena->config.numTowers; i++) {
+        const ArenaTower_t *t = &arena->config.towers[i];
+        double h = arena->config.towerSize / 2;
+        Point_t l = ToTower(t, p);
+        double across, out; // along the face and out from it
+        switch (t->wireFace) {
+            case 0: across = l.y; out = l.x - h; break;
+            case 1: across = l.x; out = l.y - h; break;
+            case 2: across = l.y; out = -l.x - h; break;
+            default: across = l.x; out = -l.y - h; break;
+        }
+        if (across > h) across -= h;
+        else if (across < -h) across += h;
+        else across = 0;
+        best = fmin(best, sqrt(across * across + out * out));
+    }
+    SetReading(TW_PIN, TW_AMBIENT + TW_GAIN / (best + TW_NEAR));
+}
+
+// range a ping ray echoes back from, or PING_MAX_RANGE if it glances off
+
+static double PingRay(Point_t from, double heading) {
+    double normal, range;
+    int face;
+    int tower = NearestTower(from, heading, &range, &face, NULL);
+    double wall = RayWalls(from, heading, &normal);
+
+    if (tower >= 0 && range < wall) {
+        normal = arena->config.towers[tower].angle + face * M_PI / 2;
+    } else {
+        range = wall;
+    }
+    if (fabs(remainder(heading + M_PI - normal, 2 * M_PI)) > PING_MAX_INCIDENCE) return PING_MAX_RANGE;
+    return fmin(range, PING_MAX_RANGE);
+}
+
+// the echo pin goes high the tick after the trigger drops and stays high for
+// the round trip. Whole milliseconds are all the robot can measure, the
+// leftover is carried into the next ping so the average comes out right
+
+static void Ping(void) {
+    uint8_t trigHigh = (HostHAL_GetPortOutputs(PING_PORT) & TRIG_PIN) != 0;
+
+    if (arena->echoMs > 0) {
+        arena->echoMs--;
+    } else if (arena->trigWasHigh && !trigHigh) {
+        Point_t from = ToWorld(PingAt);
+        double range = PING_MAX_RANGE;
+        for (int ray = -1; ray <= 1; ray++) {
+            range = fmin(range, PingRay(from, arena->pose.heading + M_PI / 2 + ray * PING_CONE));
+        }
+
+        if (range >= PING_MAX_RANGE) {
+            arena->echoMs = PING_NO_ECHO_MS;
+        } else {
+            range += Noise(arena->config.pingNoise);
+            double ms = 2 * fmax(range, 0) / SPEED_OF_SOUND * 1000 + arena->echoCarry;
+            arena->echoMs = (int) ms;
+            if (arena->echoMs < 1) arena->echoMs = 1;
+            arena->echoCarry = ms - arena->echoMs;
+        }
+    }
+    arena->trigWasHigh = trigHigh;
+    HostHAL_SetPortInputs(PING_PORT, ECHO_PIN, arena->echoMs > 0);
+}
+
+// a ball goes when the servo swings to the loading position with the
+// flywheel spinning. It scores if the launcher is square on the hole in the
+// face with the track wire and close enough to it
+
+static void Launcher(uint32_t nowMs) {
+    unsigned short pulse = HostHAL_GetRCPulse(RC_PORTX04);
+    uint8_t loading = pulse != 0 && pulse < SERVO_LOAD_PULSE;
+    uint8_t wasLoading = arena->lastServoPulse != 0 && arena->lastServoPulse < SERVO_LOAD_PULSE;
+    arena->lastServoPulse = pulse;
+
+    if (!loading || wasLoading || HostHAL_GetPWMDuty(FLY_PIN) < FLY_MIN_DUTY) return;
+    if (arena->numLaunches >= ARENA_MAX_LAUNCHES) return;
+
+    ArenaLaunch_t *launch = &arena->launches[arena->numLaunches++];
+    Point_t muzzle = {ROBOT_HALF, 0};
+    double range, along;
+    int face;
+    launch->timeMs = nowMs;
+    launch->tower = NearestTower(ToWorld(muzzle), arena->pose.heading, &range, &face, &along);
+    launch->face = -1;
+    launch->scored = FALSE;
+
+    if (launch->tower < 0 || range > LAUNCH_REACH) {
+        launch->tower = -1;
+        return;
+    }
+    const ArenaTower_t *t = &arena->config.towers[launch->tower];
+    double square = remainder(arena->pose.heading - (t->angle + face * M_PI / 2 + M_PI), 2 * M_PI);
+    launch->face = face;
+    launch->scored = face == t->wireFace && fabs(along) < HOLE_HALF_WIDTH && fabs(square) < LAUNCH_MAX_ANGLE;
+}
+
+static void Sense(uint32_t nowMs) {
+    Bumpers();
+    FloorTape();
+    WallSensor(CL_TAPE_PIN, CenterLeftAt, 0);
+    WallSensor(CR_TAPE_PIN, CenterRightAt, 0);
+    WallSensor(S_TAPE_PIN, SideTapeAt, M_PI / 2);
+    Beacon();
+    TrackWire();
+    Ping();
+    Launcher(nowMs);
+}
+
+// splitmix64 for laying out random fields, separate from the noise generator
+
+static double Uniform(uint64_t *state, double low, double high) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return low + (high - low) * (z >> 11) / 9007199254740992.0;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void ArenaSim_Select(ArenaSim_t *sim) {
+    arena = sim;
+}
+
+void ArenaSim_DefaultConfig(ArenaConfig_t *config) {
+    memset(config, 0, sizeof (*config));
+    config->width = 8 * FEET;
+    config->height = 8 * FEET;
+    config->towerSize = 1 * FEET;
+
+    config->numTowers = 3;
+    config->towers[0] = (ArenaTower_t){2.5 * FEET, 5.7 * FEET, 0.0, 2, TRUE};
+    config->towers[1] = (ArenaTower_t){5.7 * FEET, 5.4 * FEET, 0.3, 1, TRUE};
+    config->towers[2] = (ArenaTower_t){4.3 * FEET, 2.1 * FEET, -0.2, 3, TRUE};
+    config->start = (ArenaPose_t){1.1 * FEET, 1.1 * FEET, M_PI / 4};
+
+    config->leftGain = 1.0;
+    config->rightGain = 1.0;
+    config->adNoise = 8;
+    config->pingNoise = 0.01;
+    config->seed = 1;
+}
+
+void ArenaSim_RandomConfig(ArenaConfig_t *config, uint64_t seed) {
+    uint64_t state = seed;
+    ArenaSim_DefaultConfig(config);
+    double edge = config->towerSize / 2 + TOWER_WALL_GAP;
+
+    for (int i = 0; i < config->numTowers; i++) {
+        ArenaTower_t *t = &config->towers[i];
+        for (int tries = 0; tries < PLACEMENT_TRIES; tries++) { // keeps the default spot if nothing fits
+            double x = Uniform(&state, edge, config->width - edge);
+            double y = Uniform(&state, edge, config->height - edge);
+            int clear = TRUE;
+            for (int j = 0; j < i; j++) {
+                if (hypot(x - config->towers[j].x, y - config->towers[j].y) < config->towerSize + TOWER_TOWER_GAP) {
+                    clear = FALSE;
+                }
+            }
+            if (clear) {
+                t->x = x;
+                t->y = y;
+                break;
+            }
+        }
+        t->angle = Uniform(&state, 0, M_PI / 2);
+        t->wireFace = (uint8_t) Uniform(&state, 0, ARENA_NUM_FACES);
+    }
+
+    edge = ROBOT_HALF * M_SQRT2;
+    for (int tries = 0; tries < PLACEMENT_TRIES; tries++) {
+        double x = Uniform(&state, edge, config->width - edge);
+        double y = Uniform(&state, edge, config->height - edge);
+        int clear = TRUE;
+        for (int j = 0; j < config->numTowers; j++) {
+            if (hypot(x - config->towers[j].x, y - config->towers[j].y) < config->towerSize / 2 + edge + START_CLEARANCE) {
+                clear = FALSE;
+            }
+        }
+        if (clear) {
+            config->start.x = x;
+            config->start.y = y;
+            break;
+        }
+    }
+    config->start.heading = Uniform(&state, -M_PI, M_PI);
+
+    config->leftGain = 1 + Uniform(&state, -MAX_MISMATCH, MAX_MISMATCH);
+    config->rightGain = 1 + Uniform(&state, -MAX_MISMATCH, MAX_MISMATCH);
+    config->adNoise = Uniform(&state, 0, MAX_AD_NOISE);
+    config->pingNoise = Uniform(&state, 0, MAX_PING_NOISE);
+    config->seed = (uint32_t) Uniform(&state, 0, 4294967296.0);
+}
+
+void ArenaSim_Init(const ArenaConfig_t *config) {
+    memset(arena, 0, sizeof (*arena));
+    arena->config = *config;
+    arena->pose = config->start;
+    ArenaSim_Reseed(config->seed);
+
+    Sense(0);
+    HostSim_SetTickHook(ArenaSim_Tick);
+}
+
+void ArenaSim_Reseed(uint32_t seed) {
+    arena->rng = seed * 2654435761u ^ 0x9E3779B9u;
+    if (arena->rng == 0) arena->rng = 1;
+}
+
+void ArenaSim_Tick(uint32_t nowMs) {
+    Drive();
+    Collide();
+    Sense(nowMs);
+}
+
+ArenaPose_t ArenaSim_GetPose(void) {
+    return arena->pose;
+}
+
+int ArenaSim_GetNumLaunches(void) {
+    return arena->numLaunches;
+}
+
+const ArenaLaunch_t *ArenaSim_GetLaunch(int i) {
+    if (i < 0 || i >= arena->numLaunches) return NULL;
+    return &arena->launches[i];
+}
+
+double ArenaSim_GetDistance(void) {
+    return arena->distance;
+}
+
+uint32_t ArenaSim_GetContactMs(void) {
+    return arena->contactMs;
+}
+
+uint8_t ArenaSim_BesideHole(void) {
+    int face;
+    double along, range;
+    int tower = NearestTower(ToWorld(SideTapeAt), arena->pose.heading + M_PI / 2, &range, &face, &along);
+
+    return tower >= 0 && range < BESIDE_HOLE_REACH && face == arena->config.towers[tower].wireFace &&
+            fabs(along) < TAPE_WIDTH;
+}
@@ -0,0 +1,138 @@
+/*
+ * ArenaSim.h
+ * A 2D model of the arena and of the robot in it, run behind the simulated
+ * board in host/lib so the robot code can play whole matches on the host.
+ *
+ * Every simulated millisecond (as the HostSim tick hook) the model reads what
+ * the robot is driving, the H bridge duty cycles and direction pins, the
+ * flywheel and the ball servo, moves the robot and pushes it back out of
+ * anything it ran into, then sets every sensor the robot reads through
+ * HostHAL.h: the seven tape sensors, the beacon detector, the track wire
+ * sensor, the ping sensor's echo pin and the four bumpers.
+ *
+ * Everything is deterministic. The only randomness is the sensor noise, which
+ * comes from a generator seeded by the config, so the same config and the
+ * same robot code always play the same match.
+ *
+ * Units are meters, seconds and radians. The arena has its origin in a corner
+ * with x and y along the walls. The robot frame has x forward and y to the
+ * left, headings are counter clockwise from the arena's x axis.
+ */
+
+#ifndef ARENA_SIM_H
+#define	ARENA_SIM_H
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define ARENA_MAX_TOWERS 4
+#define ARENA_MAX_LAUNCHES 16
+#define ARENA_NUM_FACES 4
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    double x, y;
+    double heading;
+} ArenaPose_t;
+
+// a square tower with a beacon on top. Every face has a hole with a strip of
+// tape on the wall below it, the track wire only runs along the face with the
+// hole that scores
+typedef struct {
+    double x, y; // center
+    double angle; // rotation of the square, face 0 looks along +x before rotating
+    uint8_t wireFace; // 0 to 3, counter clockwise from face 0
+    uint8_t beaconOn;
+} ArenaTower_t;
+
+typedef struct {
+    double width, height; // inside of the walls, tape runs just inside them
+    double towerSize; // length of a side
+    int numTowers;
+    ArenaTower_t towers[ARENA_MAX_TOWERS];
+    ArenaPose_t start;
+
+    double leftGain, rightGain; // top speed of each side as a fraction of nominal
+    double adNoise; // peak A/D noise in counts, added to every analog sensor
+    double pingNoise; // peak range noise of the ping sensor in meters
+    uint32_t seed; // for the noise, 0 is allowed
+} ArenaConfig_t;
+
+typedef struct {
+    uint32_t timeMs;
+    int tower; // tower the launcher was pointed at, -1 for none
+    int face;
+    uint8_t scored; // square on the hole in the face with the track wire
+} ArenaLaunch_t;
+
+// one arena and the robot in it
+typedef struct {
+    ArenaConfig_t config;
+    ArenaPose_t pose;
+    double leftSpeed, rightSpeed;
+    uint32_t rng;
+
+    uint8_t trigWasHigh;
+    int echoMs; // left on the echo pulse, 0 when the pin is low
+    double echoCarry; // fraction of a millisecond the last pulses were rounded down by
+
+    unsigned short lastServoPulse;
+    int numLaunches;
+    ArenaLaunch_t launches[ARENA_MAX_LAUNCHES];
+
+    double distance;
+    uint32_t contactMs;
+} ArenaSim_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+// makes the arena the one the rest of these work on for the calling thread,
+// like HostBoard_Select does for the board it sits behind
+void ArenaSim_Select(ArenaSim_t *sim);
+
+// the field as set up in lab: 8ft square, three towers, robot in a corner
+void ArenaSim_DefaultConfig(ArenaConfig_t *config);
+
+// a field like the default one, with the towers, the track wire faces and the
+// robot's start pose moved around, some sensor noise and the two sides of the
+// drive a little mismatched. The same seed always gives the same field
+void ArenaSim_RandomConfig(ArenaConfig_t *config, uint64_t seed);
+
+// puts the robot at the start pose, sets every sensor for it and makes the
+// model the HostSim tick hook. Call after HostSim_Init and InitHardware, the
+// same place the robot would be switched on
+void ArenaSim_Init(const ArenaConfig_t *config);
+
+// starts the sensor noise over from a new seed, the same way ArenaSim_Init
+// seeds it from the config. Everything else is left where it is, so a match
+// restored from a snapshot plays on with different noise from there
+void ArenaSim_Reseed(uint32_t seed);
+
+// moves the world forward one millisecond, the tick hook set by ArenaSim_Init
+void ArenaSim_Tick(uint32_t nowMs);
+
+ArenaPose_t ArenaSim_GetPose(void);
+
+// balls the robot has fed into a spinning flywheel, in order
+int ArenaSim_GetNumLaunches(void);
+const ArenaLaunch_t *ArenaSim_GetLaunch(int i);
+
+// meters driven by the center of the robot and milliseconds spent pushing on
+// a wall or a tower
+double ArenaSim_GetDistance(void);
+uint32_t ArenaSim_GetContactMs(void);
+
+// TRUE if the side tape sensor is looking at the face with the scoring hole,
+// within a tape width of the hole and close enough to follow the wall. What
+// SearchForHole's hole evidence is trying to tell, for host/HoleFit.c
+uint8_t ArenaSim_BesideHole(void);
+
+#endif	/* ARENA_SIM_H */
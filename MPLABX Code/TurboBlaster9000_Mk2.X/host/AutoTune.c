@@ -0,0 +1,431 @@
+/*
+ * AutoTune.c
+ * Tunes the constants Global_Macros.h wraps in TUNABLE against ArenaSim, so the
+ * timing, speed and threshold numbers can be searched for on a build box
+ * instead of by hand on the field.
+ *
+ * The search is sep-CMA-ES (CMA-ES keeping only the diagonal of the covariance,
+ * Ros and Hansen 2008) over every parameter in TunableParams.h, each scaled to
+ * [0, 1] across its range, starting from the values in Global_Macros.h. Every
+ * generation plays all of its candidates on the same batch of randomized
+ * matches, a fresh batch each generation, and ranks them by mean launches per
+ * match. The matches are spread over a thread per core, each thread with a
+ * HostMatch_t of its own and the candidate's parameter set selected.
+ *
+ * When the generations or the time run out, the shipped values and the tuned
+ * ones are both played on a validation batch no generation has seen, and
+ * Global_Macros.h is written back out with the tuned values in. Copy it over
+ * the real one to put the new numbers on the robot.
+ *
+ * usage: AutoTune [-g generations] [-n matches per candidate] [-p population]
+ *                 [-j jobs] [-s seed] [-t match ms] [-T time limit s]
+ *                 [-v validation matches] [-m Global_Macros.h] [-o tuned header]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+#include "TunableParams.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_GENERATIONS 30
+#define DEFAULT_MATCHES 40
+#define DEFAULT_VALIDATION 200
+#define DEFAULT_MATCH_MS 120000
+#define DEFAULT_MACROS "../Global_Macros.h"
+#define MAX_JOBS 256
+#define MAX_POPULATION 256
+#define START_SIGMA 0.2 // first step size, in parameter ranges
+#define VALIDATION_SEEDS (1ULL << 32) // far away from anything a generation plays
+#define NUM_PARAMS NUM_TUNABLE_PARAMS
+
+// one batch of matches, every candidate plays every match
+typedef struct {
+    const TunableParams_t *params; // one per candidate
+    int numCandidates;
+    int numMatches;
+    uint64_t firstSeed;
+    int *launches; // candidate * numMatches + match
+    int *scored;
+    int next; // next match to hand out, taken atomically
+} Batch_t;
+
+// sep-CMA-ES state, positions are in [0, 1] per parameter
+typedef struct {
+    int lambda, mu;
+    double weights[MAX_POPULATION];
+    double mueff, cs, ds, cc, c1, cmu, chiN;
+    double mean[NUM_PARAMS];
+    double sigma;
+    double diagC[NUM_PARAMS];
+    double ps[NUM_PARAMS], pc[NUM_PARAMS];
+    int generation;
+} Cma_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int numJobs = 0;
+static uint32_t matchMs = DEFAULT_MATCH_MS;
+static uint64_t rng;
+
+static HostMatch_t *matches; // one per job
+static Batch_t batch;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// splitmix64, then Box-Muller for the normal samples
+
+static double Uniform(void) {
+    uint64_t z = (rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return ((z >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double Normal(void) {
+    return sqrt(-2 * log(Uniform())) * cos(2 * M_PI * Uniform());
+}
+
+static void ToParams(const double *x, TunableParams_t *params) {
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        const TunableParamInfo_t *info = &TunableParamInfo[i];
+        params->param[i] = info->low + (int) lround(x[i] * (info->high - info->low));
+    }
+}
+
+static void FromParams(const TunableParams_t *params, double *x) {
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        const TunableParamInfo_t *info = &TunableParamInfo[i];
+        x[i] = (double) (params->param[i] - info->low) / (info->high - info->low);
+        x[i] = fmin(fmax(x[i], 0), 1);
+    }
+}
+
+static void *RunWorker(void *arg) {
+    int total = batch.numCandidates * batch.numMatches;
+    int task;
+
+    HostMatch_Select(arg);
+    while ((task = __atomic_fetch_add(&batch.next, 1, __ATOMIC_RELAXED)) < total) {
+        ArenaConfig_t config;
+        int candidate = task / batch.numMatches;
+
+        TunableParams_Select(&batch.params[candidate]);
+        ArenaSim_RandomConfig(&config, batch.firstSeed + task % batch.numMatches);
+        batch.launches[task] = 0;
+        batch.scored[task] = 0;
+        if (HostMatch_Start(&config, NULL) != Success) continue;
+        HostSim_RunFor(matchMs);
+
+        batch.launches[task] = ArenaSim_GetNumLaunches();
+        for (int i = 0; i < batch.launches[task]; i++) {
+            batch.scored[task] += ArenaSim_GetLaunch(i)->scored;
+        }
+    }
+    TunableParams_Select(NULL);
+    return NULL;
+}
+
+// plays every candidate on matches firstSeed on, fills in the mean launches
+// and the share of matches that scored for each
+
+static void PlayBatch(const TunableParams_t *params, int numCandidates, int numMatches, uint64_t firstSeed,
+        double *meanLaunches, double *scoredShare) {
+    pthread_t workers[MAX_JOBS];
+    int jobs = numJobs < numCandidates * numMatches ? numJobs : numCandidates * numMatches;
+
+    batch.params = params;
+    batch.numCandidates = numCandidates;
+    batch.numMatches = numMatches;
+    batch.firstSeed = firstSeed;
+    batch.launches = calloc(numCandidates * numMatches, sizeof (int));
+    batch.scored = calloc(numCandidates * numMatches, sizeof (int));
+    batch.next = 0;
+    if (batch.launches == NULL || batch.scored == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+
+    for (int j = 0; j < jobs; j++) {
+        if (pthread_create(&workers[j], NULL, RunWorker, &matches[j]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (int j = 0; j < jobs; j++) pthread_join(workers[j], NULL);
+
+    for (int c = 0; c < numCandidates; c++) {
+        int launches = 0, scored = 0;
+        for (int k = 0; k < numMatches; k++) {
+            launches += batch.launches[c * numMatches + k];
+            scored += batch.scored[c * numMatches + k] > 0;
+        }
+        meanLaunches[c] = (double) launches / numMatches;
+        if (scoredShare != NULL) scoredShare[c] = (double) scored / numMatches;
+    }
+    free(batch.launches);
+    free(batch.scored);
+}
+
+static void CmaInit(Cma_t *cma, int lambda, const double *start) {
+    double sum = 0, squares = 0;
+
+    memset(cma, 0, sizeof (*cma));
+    cma->lambda = lambda;
+    cma->mu = lambda / 2;
+    for (int i = 0; i < cma->mu; i++) {
+        cma->weights[i] = log(cma->mu + 0.5) - log(i + 1);
+        sum += cma->weights[i];
+    }
+    for (int i = 0; i < cma->mu; i++) {
+        cma->weights[i] /= sum;
+        squares += cma->weights[i] * cma->weights[i];
+    }
+    cma->mueff = 1 / squares;
+
+    cma->cs = (cma->mueff + 2) / (NUM_PARAMS + cma->mueff + 5);
+    cma->ds = 1 + 2 * fmax(0, sqrt((cma->mueff - 1) / (NUM_PARAMS + 1)) - 1) + cma->cs;
+    cma->cc = (4 + cma->mueff / NUM_PARAMS) / (NUM_PARAMS + 4 + 2 * cma->mueff / NUM_PARAMS);
+    // the separable learning rates, (NUM_PARAMS + 2) / 3 times the full ones
+    cma->c1 = 2 / ((NUM_PARAMS + 1.3) * (NUM_PARAMS + 1.3) + cma->mueff) * (NUM_PARAMS + 2) / 3;
+    cma->cmu = fmin(1 - cma->c1, 2 * (cma->mueff - 2 + 1 / cma->mueff) / ((NUM_PARAMS + 2) * (NUM_PARAMS + 2) + cma->mueff) * (NUM_PARAMS + 2) / 3);
+    cma->chiN = sqrt(NUM_PARAMS) * (1 - 1.0 / (4 * NUM_PARAMS) + 1.0 / (21.0 * NUM_PARAMS * NUM_PARAMS));
+
+    memcpy(cma->mean, start, sizeof (cma->mean));
+    cma->sigma = START_SIGMA;
+    for (int i = 0; i < NUM_PARAMS; i++) cma->diagC[i] = 1;
+}
+
+// new candidates around the mean, clipped to the ranges
+
+static void CmaSample(const Cma_t *cma, double x[][NUM_PARAMS]) {
+    for (int k = 0; k < cma->lambda; k++) {
+        for (int i = 0; i < NUM_PARAMS; i++) {
+            x[k][i] = cma->mean[i] + cma->sigma * sqrt(cma->diagC[i]) * Normal();
+            x[k][i] = fmin(fmax(x[k][i], 0), 1);
+        }
+    }
+}
+
+static const double *sortFitness;
+
+static int CompareFitness(const void *a, const void *b) {
+    int i = *(const int *) a, j = *(const int *) b;
+    if (sortFitness[i] != sortFitness[j]) return sortFitness[i] < sortFitness[j] ? 1 : -1;
+    return i - j;
+}
+
+// moves the mean toward the best half, then adapts the step size and the
+// per parameter spread from the path the mean has taken
+
+static void CmaUpdate(Cma_t *cma, double x[][NUM_PARAMS], const double *fitness) {
+    int order[MAX_POPULATION];
+    double oldMean[NUM_PARAMS], yw[NUM_PARAMS], psNorm = 0;
+
+    for (int k = 0; k < cma->lambda; k++) order[k] = k;
+    sortFitness = fitness;
+    qsort(order, cma->lambda, sizeof (order[0]), CompareFitness);
+
+    memcpy(oldMean, cma->mean, sizeof (oldMean));
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        cma->mean[i] = 0;
+        for (int k = 0; k < cma->mu; k++) cma->mean[i] += cma->weights[k] * x[order[k]][i];
+        yw[i] = (cma->mean[i] - oldMean[i]) / cma->sigma;
+    }
+
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        cma->ps[i] = (1 - cma->cs) * cma->ps[i] + sqrt(cma->cs * (2 - cma->cs) * cma->mueff) * yw[i] / sqrt(cma->diagC[i]);
+        psNorm += cma->ps[i] * cma->ps[i];
+    }
+    psNorm = sqrt(psNorm);
+    cma->generation++;
+    int hsig = psNorm / sqrt(1 - pow(1 - cma->cs, 2 * cma->generation)) < (1.4 + 2.0 / (NUM_PARAMS + 1)) * cma->chiN;
+
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        cma->pc[i] = (1 - cma->cc) * cma->pc[i] + hsig * sqrt(cma->cc * (2 - cma->cc) * cma->mueff) * yw[i];
+        double rankMu = 0;
+        for (int k = 0; k < cma->mu; k++) {
+            double y = (x[order[k]][i] - oldMean[i]) / cma->sigma;
+            rankMu += cma->weights[k] * y * y;
+        }
+        cma->diagC[i] = (1 - cma->c1 - cma->cmu) * cma->diagC[i]
+                + cma->c1 * (cma->pc[i] * cma->pc[i] + (1 - hsig) * cma->cc * (2 - cma->cc) * cma->diagC[i])
+                + cma->cmu * rankMu;
+    }
+    cma->sigma *= exp(cma->cs / cma->ds * (psNorm / cma->chiN - 1));
+    cma->sigma = fmin(cma->sigma, 1);
+}
+
+static double Median(const double *values, int n) {
+    double sorted[MAX_POPULATION];
+    memcpy(sorted, values, n * sizeof (double));
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+            double t = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = t;
+        }
+    }
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    int generations = DEFAULT_GENERATIONS;
+    int numMatches = DEFAULT_MATCHES;
+    int numValidation = DEFAULT_VALIDATION;
+    int lambda = 4 + (int) (3 * log(NUM_PARAMS));
+    uint64_t baseSeed = 1;
+    double timeLimit = 0;
+    const char *macrosPath = DEFAULT_MACROS;
+    const char *outPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:n:p:j:s:t:T:v:m:o:")) != -1) {
+        switch (opt) {
+            case 'g':
+                generations = atoi(optarg);
+                break;
+            case 'n':
+                numMatches = atoi(optarg);
+                break;
+            case 'p':
+                lambda = atoi(optarg);
+                break;
+            case 'j':
+                numJobs = atoi(optarg);
+                break;
+            case 's':
+                baseSeed = strtoull(optarg, NULL, 0);
+                break;
+            case 't':
+                matchMs = strtoul(optarg, NULL, 10);
+                break;
+            case 'T':
+                timeLimit = atof(optarg);
+                break;
+            case 'v':
+                numValidation = atoi(optarg);
+                break;
+            case 'm':
+                macrosPath = optarg;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-g generations] [-n matches per candidate] [-p population] [-j jobs] [-s seed]\n"
+                        "       [-t match ms] [-T time limit s] [-v validation matches] [-m Global_Macros.h] [-o tuned header]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (numMatches <= 0 || numValidation <= 0 || lambda < 4 || lambda > MAX_POPULATION) {
+        fprintf(stderr, "need at least one match and a population of 4 to %d\n", MAX_POPULATION);
+        return 1;
+    }
+    if (numJobs <= 0) numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numJobs > MAX_JOBS) numJobs = MAX_JOBS;
+    rng = baseSeed;
+
+    matches = calloc(numJobs, sizeof (HostMatch_t));
+    TunableParams_t *params = calloc(MAX_POPULATION, sizeof (TunableParams_t));
+    double (*x)[NUM_PARAMS] = calloc(MAX_POPULATION, sizeof (*x));
+    if (matches == NULL || params == NULL || x == NULL) {
+        perror("calloc");
+        return 1;
+    }
+
+    // the robot's printfs go to stdout, keep them out of the tuned header
+    fflush(stdout);
+    int headerOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (headerOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+
+    Cma_t cma;
+    double start[NUM_PARAMS];
+    FromParams(&TunableDefaults, start);
+    CmaInit(&cma, lambda, start);
+
+    fprintf(stderr, "%d parameters, %d candidates of %d matches a generation on %d jobs\n", NUM_PARAMS, lambda, numMatches,
+            numJobs);
+    double began = NowSeconds();
+    for (int g = 0; g < generations; g++) {
+        double fitness[MAX_POPULATION];
+
+        CmaSample(&cma, x);
+        for (int k = 0; k < lambda; k++) ToParams(x[k], &params[k]);
+        PlayBatch(params, lambda, numMatches, baseSeed + (uint64_t) g * numMatches, fitness, NULL);
+        CmaUpdate(&cma, x, fitness);
+
+        double best = fitness[0];
+        for (int k = 1; k < lambda; k++) best = fmax(best, fitness[k]);
+        double elapsed = NowSeconds() - began;
+        fprintf(stderr, "generation %d: best %.2f, median %.2f launches per match, step %.3f, %.0f s\n", g + 1, best,
+                Median(fitness, lambda), cma.sigma, elapsed);
+        if (timeLimit > 0 && elapsed >= timeLimit) {
+            fprintf(stderr, "out of time after %d generations\n", g + 1);
+            break;
+        }
+    }
+
+    // shipped against tuned, on matches the search never saw
+    TunableParams_t final[2];
+    double launches[2], scored[2];
+    final[0] = TunableDefaults;
+    ToParams(cma.mean, &final[1]);
+    PlayBatch(final, 2, numValidation, baseSeed + VALIDATION_SEEDS, launches, scored);
+
+    fprintf(stderr, "\nvalidation on %d matches:\n", numValidation);
+    fprintf(stderr, "  shipped  %.2f launches per match, %.1f%% of matches scored\n", launches[0], 100 * scored[0]);
+    fprintf(stderr, "  tuned    %.2f launches per match, %.1f%% of matches scored\n", launches[1], 100 * scored[1]);
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        if (final[1].param[i] != final[0].param[i]) {
+            fprintf(stderr, "  %-24s %6d -> %d\n", TunableParamInfo[i].name, final[0].param[i], final[1].param[i]);
+        }
+    }
+
+    fflush(stdout);
+    if (headerOut >= 0 && devNull >= 0) dup2(headerOut, STDOUT_FILENO);
+
+    char note[256];
+    snprintf(note, sizeof (note), "TUNABLE values from AutoTune -s %llu: %.2f launches per match on %d validation matches, %.2f as shipped",
+            (unsigned long long) baseSeed, launches[1], numValidation, launches[0]);
+    FILE *out = outPath != NULL ? fopen(outPath, "w") : stdout;
+    if (out == NULL) {
+        perror(outPath);
+        return 1;
+    }
+    int written = TunableParams_WriteHeader(macrosPath, out, &final[1], note);
+    if (out != stdout) fclose(out);
+    return written ? 0 : 1;
+}
@@ -0,0 +1,300 @@
+/*
+ * Bench.c
+ * Runs the microbenchmarks in Benchmark.c on the host and compares results
+ * against a baseline, so a change that makes a checker or RobotHSM dispatch
+ * slower gets caught before it costs loop rate on the robot.
+ *
+ * The cases run on a simulated board with nothing on the sensors, timed with
+ * the CPU's time stamp counter where there is one (calibrated against
+ * CLOCK_MONOTONIC) and with clock_gettime anywhere else. The results go to
+ * stdout as JSON, the same format the robot prints with BENCHMARK_TEST. The
+ * suite is run -r times and each case keeps its quickest round, a desktop is
+ * a lot noisier than the PIC32.
+ *
+ * With -b the results are compared case by case with a baseline file instead:
+ * a case whose quickest call got more than -T percent and more than -F ns slower is a
+ * regression and the exit status is 1. -f compares a results file, one captured off the robot for
+ * instance, instead of running anything. Only compare results taken with the
+ * same clock on the same machine.
+ *
+ * usage: Bench [-n reps] [-r rounds] [-g] [-o results] [-b baseline [-T percent] [-F ns] [-f results]]
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostMatch.h"
+#include "Benchmark.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_TOLERANCE 10 // percent
+#define DEFAULT_FLOOR_NS 5 // smaller changes are below what a desktop can tell apart
+#define DEFAULT_ROUNDS 5
+#define MAX_CASES 64
+#define MAX_NAME 64
+#define CALIBRATE_NS 50000000
+
+typedef struct {
+    char name[MAX_NAME];
+    double minNs;
+} BenchEntry_t;
+
+typedef struct {
+    char clock[MAX_NAME];
+    int numEntries;
+    BenchEntry_t entry[MAX_CASES];
+} BenchFile_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static HostMatch_t match;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static uint64_t MonotonicNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint32_t GettimeClock(void) {
+    return (uint32_t) MonotonicNs();
+}
+
+#ifdef HAVE_TSC
+
+static uint32_t TscClock(void) {
+    return (uint32_t) __rdtsc();
+}
+
+// time stamp counter ticks per microsecond, against CLOCK_MONOTONIC
+
+static double CalibrateTsc(void) {
+    uint64_t ns0 = MonotonicNs();
+    uint64_t tsc0 = __rdtsc();
+    while (MonotonicNs() - ns0 < CALIBRATE_NS);
+    uint64_t tsc1 = __rdtsc();
+    uint64_t ns1 = MonotonicNs();
+    return (double) (tsc1 - tsc0) * 1000 / (ns1 - ns0);
+}
+#endif
+
+// runs every case rounds times and keeps the round with the quickest call,
+// which is the one the rest of the machine got in the way of least. The JSON
+// goes to path or stdout
+
+static void RunCases(uint16_t reps, int rounds, int useGettime, const char *path) {
+    BenchmarkClock_t clock = GettimeClock;
+    const char *clockName = "clock_gettime";
+    double ticksPerUs = 1000;
+    BenchmarkResult_t results[MAX_CASES];
+
+#ifdef HAVE_TSC
+    if (!useGettime) {
+        clock = TscClock;
+        clockName = "rdtsc";
+        ticksPerUs = CalibrateTsc();
+    }
+#endif
+
+    // the robot's printfs go to stdout, keep them out of the results
+    fflush(stdout);
+    int resultsOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (resultsOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+
+    HostMatch_Select(&match);
+    if (HostMatch_Start(NULL, NULL) != Success) {
+        fprintf(stderr, "the framework did not start\n");
+        exit(2);
+    }
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < BenchmarkNumCases && i < MAX_CASES; i++) {
+            BenchmarkResult_t r;
+            Benchmark_Run(&BenchmarkCases[i], clock, reps, &r);
+            if (round == 0 || r.min < results[i].min) results[i] = r;
+        }
+    }
+    fflush(stdout);
+    if (resultsOut >= 0 && devNull >= 0) dup2(resultsOut, STDOUT_FILENO);
+
+    if (path != NULL) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            perror(path);
+            exit(2);
+        }
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+    Benchmark_PrintJson(results, clockName, ticksPerUs);
+    fflush(stdout);
+    if (path != NULL && resultsOut >= 0) dup2(resultsOut, STDOUT_FILENO);
+}
+
+// picks the clock and the quickest call of every case out of a results file. Only
+// reads what Benchmark_PrintJson writes, one case per line
+
+static int ReadResults(const char *path, BenchFile_t *file) {
+    FILE *f = fopen(path, "r");
+    char line[512];
+
+    if (f == NULL) {
+        perror(path);
+        return ERROR;
+    }
+    memset(file, 0, sizeof (*file));
+    while (fgets(line, sizeof (line), f) != NULL) {
+        char *clock = strstr(line, "\"clock\": \"");
+        char *name = strstr(line, "\"name\": \"");
+        char *min = strstr(line, "\"min_ns\": ");
+
+        if (clock != NULL) {
+            sscanf(clock + 10, "%63[^\"]", file->clock);
+        } else if (name != NULL && min != NULL && file->numEntries < MAX_CASES) {
+            BenchEntry_t *e = &file->entry[file->numEntries];
+            if (sscanf(name + 9, "%63[^\"]", e->name) == 1 && sscanf(min + 10, "%lf", &e->minNs) == 1) {
+                file->numEntries++;
+            }
+        }
+    }
+    fclose(f);
+    if (file->numEntries == 0) {
+        fprintf(stderr, "%s has no benchmark results in it\n", path);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+static const BenchEntry_t *FindEntry(const BenchFile_t *file, const char *name) {
+    for (int i = 0; i < file->numEntries; i++) {
+        if (strcmp(file->entry[i].name, name) == 0) return &file->entry[i];
+    }
+    return NULL;
+}
+
+// prints the two side by side, returns the number of regressions
+
+static int Compare(const BenchFile_t *base, const BenchFile_t *now, double tolerance, double floorNs) {
+    int regressions = 0;
+
+    if (strcmp(base->clock, now->clock) != 0) {
+        printf("note: baseline timed with %s, these with %s\n", base->clock, now->clock);
+    }
+    printf("%-28s %12s %12s %8s\n", "case", "baseline ns", "now ns", "change");
+    for (int i = 0; i < now->numEntries; i++) {
+        const BenchEntry_t *n = &now->entry[i];
+        const BenchEntry_t *b = FindEntry(base, n->name);
+        if (b == NULL) {
+            printf("%-28s %12s %12.1f %8s\n", n->name, "-", n->minNs, "new");
+            continue;
+        }
+        double change = b->minNs > 0 ? 100 * (n->minNs - b->minNs) / b->minNs : 0;
+        int slower = n->minNs > b->minNs * (1 + tolerance / 100) && n->minNs - b->minNs > floorNs;
+        printf("%-28s %12.1f %12.1f %+7.1f%%%s\n", n->name, b->minNs, n->minNs, change,
+                slower ? "  REGRESSION" : "");
+        regressions += slower;
+    }
+    for (int i = 0; i < base->numEntries; i++) {
+        if (FindEntry(now, base->entry[i].name) == NULL) {
+            printf("%-28s %12.1f %12s %8s\n", base->entry[i].name, base->entry[i].minNs, "-", "gone");
+        }
+    }
+    if (regressions > 0) {
+        printf("%d case%s more than %.0f%% and %.0f ns slower than the baseline\n", regressions,
+                regressions == 1 ? "" : "s", tolerance, floorNs);
+    } else {
+        printf("no case more than %.0f%% and %.0f ns slower than the baseline\n", tolerance, floorNs);
+    }
+    return regressions;
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *outPath = NULL, *basePath = NULL, *resultsPath = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    double floorNs = DEFAULT_FLOOR_NS;
+    int reps = BENCHMARK_REPS;
+    int rounds = DEFAULT_ROUNDS;
+    int useGettime = FALSE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:go:b:T:F:f:")) != -1) {
+        switch (opt) {
+            case 'n':
+                reps = atoi(optarg);
+                break;
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+            case 'g':
+                useGettime = TRUE;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            case 'b':
+                basePath = optarg;
+                break;
+            case 'T':
+                tolerance = atof(optarg);
+                break;
+            case 'F':
+                floorNs = atof(optarg);
+                break;
+            case 'f':
+                resultsPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n reps] [-r rounds] [-g] [-o results] [-b baseline [-T percent] [-F ns] [-f results]]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (reps <= 0 || reps > UINT16_MAX) reps = BENCHMARK_REPS;
+    if (rounds <= 0) rounds = 1;
+
+    if (basePath == NULL) {
+        RunCases(reps, rounds, useGettime, outPath);
+        return 0;
+    }
+
+    BenchFile_t base, now;
+    if (ReadResults(basePath, &base) != SUCCESS) return 2;
+    if (resultsPath == NULL) {
+        char tmpPath[] = "/tmp/benchXXXXXX";
+        int fd = mkstemp(tmpPath);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 2;
+        }
+        close(fd);
+        RunCases(reps, rounds, useGettime, outPath != NULL ? outPath : tmpPath);
+        int read = ReadResults(outPath != NULL ? outPath : tmpPath, &now);
+        unlink(tmpPath);
+        if (read != SUCCESS) return 2;
+    } else if (ReadResults(resultsPath, &now) != SUCCESS) {
+        return 2;
+    }
+    return Compare(&base, &now, tolerance, floorNs) > 0 ? 1 : 0;
+}
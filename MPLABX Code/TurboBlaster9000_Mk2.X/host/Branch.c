@@ -0,0 +1,517 @@
+/*
+ * Branch.c
+ * Plays an arena match up to an interesting moment, freezes it there and plays
+ * the rest of the match out many times over with different sensor noise, to
+ * see how often the robot gets out of that spot and how, without playing the
+ * first part of the match again for every variant.
+ *
+ * The moment is given with -w as machine:state, the first time that machine
+ * enters that state, or machine:state:event, the first time RobotHSM runs that
+ * event while the machine is in that state. Names are as TraceDecode prints
+ * them. The default is the first BUMPED in ApproachTower. -a branches at a time
+ * instead. The match is stopped at the end of the millisecond the moment shows
+ * up in the trace and saved with HostMatch_Save, -o writes the snapshot out and
+ * -i starts from one written before instead of playing up to it.
+ *
+ * Variant 0 keeps the noise generator where the match left it, so it plays on
+ * exactly the way the match did without stopping. When the branch point was
+ * played here the match is also played on straight from it, and variant 0 has
+ * to send the same trace and end in the same place, or the match kept something
+ * outside the snapshot. Every other variant reseeds the noise with
+ * ArenaSim_Reseed(seed + variant).
+ *
+ * usage: Branch [-r random field seed] [-w machine:state[:event] | -a ms] [-n variants]
+ *               [-j jobs] [-s noise seed] [-t match ms] [-i snapshot] [-o snapshot] [-c per variant csv]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Trace.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+#include "TunableParams.h"
+#include "TraceTables.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_VARIANTS 1000
+#define DEFAULT_MATCH_MS 120000
+#define DEFAULT_BRANCH "SearchForTowerSubHSM:ApproachTower:BUMPED"
+#define MAX_JOBS 256
+#define PROGRESS_US 500000
+#define NO_TIME UINT32_MAX
+
+typedef struct {
+    int machine;
+    int state;
+    int event; // -1 to branch on entering the state
+} BranchPoint_t;
+
+typedef struct {
+    uint8_t done;
+    int launches; // after the branch point
+    int scored;
+    uint32_t firstLaunchMs;
+    uint32_t firstScoreMs;
+    ArenaPose_t end;
+} VariantResult_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int numVariants = DEFAULT_VARIANTS;
+static int numJobs = 0;
+static uint32_t noiseSeed = 1;
+static uint32_t matchMs = DEFAULT_MATCH_MS;
+
+static BranchPoint_t branch = {-1, -1, -1};
+static uint32_t branchAtMs = 0; // -a, 0 to use branch
+
+// the trunk, the match played up to the branch point
+static FILE *trunkOut;
+static char *trunkTrace;
+static size_t trunkLen, trunkRead;
+static int trunkState[NUM_TRACE_MACHINES];
+static uint8_t branched;
+
+// shared between every worker
+static HostSnapshot_t snapshot;
+static VariantResult_t *results;
+static int nextVariant;
+static char *variantTrace; // what variant 0 sent, to check against the trunk
+static size_t variantLen;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int FindName(const char *const *names, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (names[i] != NULL && strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static int ParseBranch(const char *text) {
+    char buf[128];
+    char *part[3] = {NULL, NULL, NULL};
+    int numParts = 0;
+
+    snprintf(buf, sizeof (buf), "%s", text);
+    for (char *p = strtok(buf, ":"); p != NULL && numParts < 3; p = strtok(NULL, ":")) {
+        part[numParts++] = p;
+    }
+    if (numParts < 2) return ERROR;
+
+    branch.machine = -1;
+    for (int m = 0; m < TraceNumMachines; m++) {
+        if (strcmp(TraceMachines[m].name, part[0]) == 0) branch.machine = m;
+    }
+    if (branch.machine < 0) {
+        fprintf(stderr, "no machine %s\n", part[0]);
+        return ERROR;
+    }
+    branch.state = FindName(TraceMachines[branch.machine].states, TraceMachines[branch.machine].numStates, part[1]);
+    if (branch.state < 0) {
+        fprintf(stderr, "%s has no state %s\n", part[0], part[1]);
+        return ERROR;
+    }
+    branch.event = -1;
+    if (part[2] != NULL) {
+        branch.event = FindName(TraceEventNames, TraceNumEvents, part[2]);
+        if (branch.event < 0) {
+            fprintf(stderr, "no event %s\n", part[2]);
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+// a sub machine only counts while its parent is in the state that runs it,
+// the same as TraceDecode
+
+static int IsActive(const int *state, int machine) {
+    int parent = TraceMachines[machine].parent;
+    if (parent < 0) return TRUE;
+    return state[parent] == TraceMachines[machine].parentState && IsActive(state, parent);
+}
+
+static int AtBranch(const int *state) {
+    return state[branch.machine] == branch.state && IsActive(state, branch.machine);
+}
+
+// reads the frames the trunk sent since the last call and checks each one
+// against the branch point
+
+static void WatchTrunk(void) {
+    fflush(trunkOut);
+    const uint8_t *trace = (const uint8_t *) trunkTrace;
+
+    while (!branched && trunkRead + 8 <= trunkLen) {
+        size_t i = trunkRead;
+        if (trace[i] != TRACE_SYNC || trace[i + 2] > TRACE_MAX_ARGS) {
+            trunkRead++;
+            continue;
+        }
+        size_t frameLen = 8 + 2 * trace[i + 2];
+        if (i + frameLen > trunkLen) break; // the rest is still on its way
+        uint8_t sum = 0;
+        for (size_t k = i + 1; k < i + frameLen - 1; k++) sum += trace[k];
+        if (sum != trace[i + frameLen - 1]) {
+            trunkRead++;
+            continue;
+        }
+        trunkRead += frameLen;
+
+        if (trace[i + 2] < 2) continue;
+        int a = (int16_t) (trace[i + 7] | trace[i + 8] << 8);
+        int b = (int16_t) (trace[i + 9] | trace[i + 10] << 8);
+        if (trace[i + 1] == TR_STATE && a >= 0 && a < NUM_TRACE_MACHINES) {
+            trunkState[a] = b;
+            if (branch.event < 0 && AtBranch(trunkState)) branched = TRUE;
+        } else if (trace[i + 1] == TR_EVENT && branch.event >= 0) {
+            if (a == branch.event && AtBranch(trunkState)) branched = TRUE;
+        }
+    }
+}
+
+static void TrunkTick(uint32_t nowMs) {
+    ArenaSim_Tick(nowMs);
+    if (branchAtMs > 0) {
+        branched = nowMs >= branchAtMs;
+    } else {
+        WatchTrunk();
+    }
+    if (branched) HostSim_Stop();
+}
+
+// plays the trunk up to the branch point and saves it. FALSE if the match
+// ended first
+
+static int PlayTrunk(HostMatch_t *match, const ArenaConfig_t *config) {
+    for (int m = 0; m < NUM_TRACE_MACHINES; m++) trunkState[m] = -1;
+    trunkOut = open_memstream(&trunkTrace, &trunkLen);
+
+    HostMatch_Select(match);
+    if (HostMatch_Start(config, trunkOut) != Success) {
+        fprintf(stderr, "the framework did not start\n");
+        exit(1);
+    }
+    HostSim_SetTickHook(TrunkTick);
+    HostSim_RunFor(matchMs);
+    if (!branched) return FALSE;
+
+    HostMatch_Save(match, &snapshot);
+    return TRUE;
+}
+
+static void Summarize(VariantResult_t *result, uint32_t fromMs) {
+    result->firstLaunchMs = NO_TIME;
+    result->firstScoreMs = NO_TIME;
+    for (int i = 0; i < ArenaSim_GetNumLaunches(); i++) {
+        const ArenaLaunch_t *launch = ArenaSim_GetLaunch(i);
+        if (launch->timeMs < fromMs) continue;
+        if (result->launches == 0) result->firstLaunchMs = launch->timeMs;
+        result->launches++;
+        if (launch->scored) {
+            if (result->scored == 0) result->firstScoreMs = launch->timeMs;
+            result->scored++;
+        }
+    }
+    result->end = ArenaSim_GetPose();
+}
+
+static void PlayVariant(HostMatch_t *match, int variant, VariantResult_t *result) {
+    FILE *serialOut = NULL;
+
+    HostMatch_Restore(match, &snapshot);
+    HostMatch_Select(match);
+    if (variant == 0) serialOut = open_memstream(&variantTrace, &variantLen);
+    HostHAL_SetSerialOutput(serialOut);
+    HostSim_SetTickHook(ArenaSim_Tick);
+    if (variant > 0) ArenaSim_Reseed(noiseSeed + variant);
+
+    uint32_t fromMs = HostSim_GetTime();
+    if (fromMs < matchMs) HostSim_RunFor(matchMs - fromMs);
+    Summarize(result, fromMs);
+    if (serialOut != NULL) fclose(serialOut);
+    __atomic_store_n(&result->done, TRUE, __ATOMIC_RELEASE);
+}
+
+static void *RunWorker(void *arg) {
+    HostMatch_t *match = calloc(1, sizeof (HostMatch_t));
+    int next;
+
+    if (match == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    TunableParams_Select(&snapshot.params);
+    while ((next = __atomic_fetch_add(&nextVariant, 1, __ATOMIC_RELAXED)) < numVariants) {
+        PlayVariant(match, next, &results[next]);
+    }
+    free(match);
+    return NULL;
+}
+
+static int VariantsDone(void) {
+    int done = 0;
+    for (int i = 0; i < numVariants; i++) {
+        done += __atomic_load_n(&results[i].done, __ATOMIC_ACQUIRE);
+    }
+    return done;
+}
+
+// plays the trunk on from the branch point without stopping, TRUE if
+// variant 0 did the same
+
+static int CheckVariantZero(HostMatch_t *trunk) {
+    char *tail = NULL;
+    size_t tailLen = 0;
+    FILE *tailOut = open_memstream(&tail, &tailLen);
+    VariantResult_t straight = {0};
+
+    HostMatch_Select(trunk);
+    HostHAL_SetSerialOutput(tailOut);
+    HostSim_SetTickHook(ArenaSim_Tick);
+    uint32_t fromMs = HostSim_GetTime();
+    HostSim_RunFor(matchMs - fromMs);
+    Summarize(&straight, fromMs);
+    fclose(tailOut);
+
+    const VariantResult_t *zero = &results[0];
+    int same = tailLen == variantLen && memcmp(tail, variantTrace, tailLen) == 0
+            && straight.launches == zero->launches && straight.scored == zero->scored
+            && memcmp(&straight.end, &zero->end, sizeof (straight.end)) == 0;
+    free(tail);
+    return same;
+}
+
+static int CompareTimes(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Wilson score interval, stays sensible at 0% and 100%
+
+static void Wilson(int hits, int n, double *low, double *high) {
+    double z = 1.96;
+    if (n == 0) {
+        *low = *high = 0;
+        return;
+    }
+    double p = (double) hits / n;
+    double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+    double half = z * sqrt(p * (1 - p) / n + z * z / (4.0 * n * n)) / (1 + z * z / n);
+    *low = center - half;
+    *high = center + half;
+}
+
+static void PrintReport(double wallSeconds, uint32_t fromMs) {
+    int launched = 0, scored = 0, numFirst = 0;
+    double launchSum = 0;
+    uint32_t *first = calloc(numVariants, sizeof (uint32_t));
+
+    for (int i = 0; i < numVariants; i++) {
+        const VariantResult_t *r = &results[i];
+        launchSum += r->launches;
+        if (r->launches > 0) launched++;
+        if (r->scored > 0) {
+            scored++;
+            first[numFirst++] = r->firstScoreMs - fromMs;
+        }
+    }
+
+    printf("%d variants of the last %.1f s in %.1f s on %d jobs: %.1f variants/s\n", numVariants,
+            (matchMs - fromMs) / 1000.0, wallSeconds, numJobs, numVariants / wallSeconds);
+    double low, high;
+    Wilson(scored, numVariants, &low, &high);
+    printf("scored                 %d of %d, %.1f%% (95%% %.1f%% to %.1f%%)\n", scored, numVariants,
+            100.0 * scored / numVariants, 100 * low, 100 * high);
+    Wilson(launched, numVariants, &low, &high);
+    printf("launched               %d of %d, %.1f%% (95%% %.1f%% to %.1f%%)\n", launched, numVariants,
+            100.0 * launched / numVariants, 100 * low, 100 * high);
+    printf("launches per variant   mean %.2f\n", launchSum / numVariants);
+    if (numFirst > 0) {
+        qsort(first, numFirst, sizeof (first[0]), CompareTimes);
+        printf("branch to first score  median %.1f s, 10%% %.1f s, 90%% %.1f s\n", first[numFirst / 2] / 1000.0,
+                first[numFirst / 10] / 1000.0, first[numFirst * 9 / 10] / 1000.0);
+    }
+    free(first);
+}
+
+static void WriteCsv(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "variant,noise_seed,launches,scored,first_launch_ms,first_score_ms,end_x,end_y,end_heading\n");
+    for (int i = 0; i < numVariants; i++) {
+        const VariantResult_t *r = &results[i];
+        fprintf(f, "%d,", i);
+        if (i > 0) fprintf(f, "%lu", (unsigned long) (noiseSeed + i));
+        fprintf(f, ",%d,%d,", r->launches, r->scored);
+        if (r->firstLaunchMs != NO_TIME) fprintf(f, "%lu", (unsigned long) r->firstLaunchMs);
+        fprintf(f, ",");
+        if (r->firstScoreMs != NO_TIME) fprintf(f, "%lu", (unsigned long) r->firstScoreMs);
+        fprintf(f, ",%.4f,%.4f,%.4f\n", r->end.x, r->end.y, r->end.heading);
+    }
+    fclose(f);
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *branchText = DEFAULT_BRANCH;
+    const char *inPath = NULL, *outPath = NULL, *csvPath = NULL;
+    uint64_t fieldSeed = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:w:a:n:j:s:t:i:o:c:")) != -1) {
+        switch (opt) {
+            case 'r':
+                fieldSeed = strtoull(optarg, NULL, 0);
+                break;
+            case 'w':
+                branchText = optarg;
+                break;
+            case 'a':
+                branchAtMs = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                numVariants = atoi(optarg);
+                break;
+            case 'j':
+                numJobs = atoi(optarg);
+                break;
+            case 's':
+                noiseSeed = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                matchMs = strtoul(optarg, NULL, 10);
+                break;
+            case 'i':
+                inPath = optarg;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            case 'c':
+                csvPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-r random field seed] [-w machine:state[:event] | -a ms] [-n variants]\n"
+                        "        [-j jobs] [-s noise seed] [-t match ms] [-i snapshot] [-o snapshot] [-c per variant csv]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (numVariants <= 0) return 0;
+    if (numJobs <= 0) numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numJobs > MAX_JOBS) numJobs = MAX_JOBS;
+    if (numJobs > numVariants) numJobs = numVariants;
+    if (branchAtMs == 0 && ParseBranch(branchText) != SUCCESS) return 1;
+
+    // the robot's printfs go to stdout, keep them out of the report
+    fflush(stdout);
+    int reportOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (reportOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+
+    HostMatch_t *trunk = NULL;
+    if (inPath != NULL) {
+        if (HostMatch_ReadSnapshot(&snapshot, inPath) != SUCCESS) {
+            fprintf(stderr, "%s is not a snapshot from this build\n", inPath);
+            return 1;
+        }
+    } else {
+        ArenaConfig_t config;
+        if (fieldSeed != 0) {
+            ArenaSim_RandomConfig(&config, fieldSeed);
+        } else {
+            ArenaSim_DefaultConfig(&config);
+        }
+        trunk = calloc(1, sizeof (HostMatch_t));
+        if (trunk == NULL) {
+            perror("calloc");
+            return 1;
+        }
+        if (!PlayTrunk(trunk, &config)) {
+            fprintf(stderr, "the match never got to %s\n", branchAtMs > 0 ? "the branch time" : branchText);
+            return 1;
+        }
+    }
+    uint32_t fromMs = snapshot.match.board.sim.nowMs;
+    fprintf(stderr, "branching at %.3f s\n", fromMs / 1000.0);
+    if (outPath != NULL && HostMatch_WriteSnapshot(&snapshot, outPath) != SUCCESS) {
+        perror(outPath);
+        return 1;
+    }
+
+    results = calloc(numVariants, sizeof (VariantResult_t));
+    if (results == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    pthread_t workers[MAX_JOBS];
+    double start = NowSeconds();
+    for (int j = 0; j < numJobs; j++) {
+        if (pthread_create(&workers[j], NULL, RunWorker, NULL) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    int done;
+    do {
+        done = VariantsDone();
+        double elapsed = NowSeconds() - start;
+        fprintf(stderr, "\r%d/%d variants, %.1f variants/s ", done, numVariants, elapsed > 0 ? done / elapsed : 0.0);
+        if (done < numVariants) usleep(PROGRESS_US);
+    } while (done < numVariants);
+    fprintf(stderr, "\n");
+    for (int j = 0; j < numJobs; j++) pthread_join(workers[j], NULL);
+    double wallSeconds = NowSeconds() - start;
+    int same = trunk != NULL && CheckVariantZero(trunk);
+
+    fflush(stdout);
+    if (reportOut >= 0 && devNull >= 0) dup2(reportOut, STDOUT_FILENO);
+
+    printf("branched at %.3f s", fromMs / 1000.0);
+    if (inPath != NULL) {
+        printf(", from %s\n", inPath);
+    } else {
+        printf(", %s\n", branchAtMs > 0 ? "at the given time" : branchText);
+    }
+    PrintReport(wallSeconds, fromMs);
+    if (trunk != NULL) {
+        printf("variant 0 against the match played straight through: %s\n",
+                same ? "identical" : "DIFFERENT, something is kept outside the snapshot");
+    }
+    if (csvPath != NULL) WriteCsv(csvPath);
+    return 0;
+}
@@ -0,0 +1,638 @@
+/*
+ * EscapeFit.c
+ * Fits the escape table ResolveObstacle goes by, see ObstacleEscape.h, so each
+ * escape is the one that actually gets the robot clear the soonest instead of
+ * one of four guesses.
+ *
+ * A situation is got into the way the robot gets into them: the simulated
+ * robot is put somewhere clear in a randomized arena and driven forward, back
+ * or spinning, at powers like the ones the state machines use, until a corner
+ * is blocked. Half of them stop at the first corner on tape, as the robot does
+ * with BOTT_TAPE_ACTIVE, and half at the first bumper, as it does without.
+ * Every STOPPED_EVERY'th one has the motors stopped before it is escaped from.
+ *
+ * Every escape out of CANDIDATE_POWERS and CANDIDATE_MS is then tried on each
+ * situation, from the same copy of the arena. An escape costs the ms it takes,
+ * plus RETRIGGER_MS each time it blocks a corner that was clear, since that
+ * would have ResolveObstacle pick another one, STUCK_MS if a corner is still
+ * blocked at the end and FOLLOW_HIT_MS if AcquireTower spinning in place
+ * afterwards runs into something within FOLLOW_MS. A situation counts for its
+ * mirror image too, left for right, so the two sides get the same answer and
+ * twice the samples. Each key of the table, the first corner blocked and the
+ * motion, gets the escape with the lowest average cost over the situations
+ * that go by it. One seen fewer than MIN_SAMPLES times is written
+ * ESCAPE_UNFITTED and keeps the escape the four resolve states would have
+ * taken. How many situations had more than one corner blocked is reported, as
+ * that is what the key leaves out.
+ *
+ * Every HOLDOUT_EVERY'th situation is kept out of the fit to check it on.
+ * ResolveObstacle itself picks again whenever another corner is blocked, so
+ * the check plays that out: the four resolve states this replaced, the table
+ * ObstacleEscape.c has now and the fitted one, from every held out situation
+ * until the escape is over. ObstacleEscape.c is then written out with the
+ * fitted table in.
+ *
+ * usage: EscapeFit [-n situations] [-j jobs] [-s seed] [-c ObstacleEscape.c]
+ *                  [-o fitted source]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "IO_Ports.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+#include "TunableParams.h"
+#include "RobotContext.h"
+#include "Global_Macros.h"
+#include "Motor_Control.h"
+#include "ProjectEventChecker.h"
+#include "ObstacleEscape.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_SITUATIONS 600
+#define DEFAULT_SOURCE "../ObstacleEscape.c"
+#define MAX_JOBS 256
+#define HOLDOUT_EVERY 5
+#define STOPPED_EVERY 5
+#define MIN_SAMPLES 3
+
+// getting into a situation
+#define TRIP_MS 6000 // longest to drive looking for something to run into
+#define PLACEMENT_TRIES 200
+#define ARENA_MARGIN 0.2 // robot center to the walls where it is put down, m
+#define SPIN_NEAR 0.14 // and for a spin, between these from one of them, where
+#define SPIN_FAR 0.19 // a corner of the chassis sweeps over the tape or the wall
+#define MIN_POWER 65 // the motors hardly turn much below this
+#define MAX_STEER 10
+
+// the escapes tried, every pair of powers held for each time
+#define NUM_POWERS 5
+#define CANDIDATE_POWERS {-100, -75, 0, 75, 100}
+#define NUM_TIMES 8
+#define CANDIDATE_MS {150, 250, 400, 600, 800, 1000, 1300, 1600}
+#define NUM_VECTORS (NUM_POWERS * NUM_POWERS)
+#define NUM_CANDIDATES (NUM_VECTORS * NUM_TIMES)
+
+// what an escape costs on top of its own ms
+#define RETRIGGER_MS 1000
+#define STUCK_MS 3000
+#define FOLLOW_HIT_MS 2000
+#define FOLLOW_MS 1000
+
+#define MAX_ESCAPE_MS 5000 // the check calls an escape that goes on longer stuck
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+
+typedef struct {
+    ArenaSim_t arena; // the moment the corner was blocked
+    int8_t left, right; // the motors then
+    uint8_t tapeState; // and the tape checker's state
+    uint8_t situation;
+    uint8_t bumped, taped; // corners with a bumper pressed and on tape
+} Situation_t;
+
+typedef struct {
+    double cost[ESCAPE_NUM_KEYS][NUM_CANDIDATES];
+    int count[ESCAPE_NUM_KEYS];
+} Costs_t;
+
+typedef struct {
+    int escapes;
+    double ms; // until the last escape picked was over
+    int retriggers;
+    int stuck; // a corner still blocked at the end
+    int followHits;
+} Check_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int numSituations = DEFAULT_SITUATIONS;
+static int numJobs = 0;
+static uint64_t baseSeed = 1;
+
+static Situation_t *situations;
+static uint8_t *found; // TRUE where situations[] got one
+static Costs_t costs;
+static pthread_mutex_t costsLock = PTHREAD_MUTEX_INITIALIZER;
+static int nextSituation; // taken atomically
+
+static const int Powers[NUM_POWERS] = CANDIDATE_POWERS;
+static const int TimesMs[NUM_TIMES] = CANDIDATE_MS;
+static const char *const CornerNames[ESCAPE_NUM_CORNERS] = {"FL", "FR", "BL", "BR"};
+static const char *const MotionNames[ESCAPE_NUM_MOTIONS] = {"stopped", "forward", "backward", "spin left", "spin right"};
+
+// the worker's arena, and its clock for ArenaSim_Tick
+static __thread HostMatch_t *match;
+static __thread uint32_t nowMs;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static uint32_t NextRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 33;
+}
+
+static double Uniform(uint64_t *state, double low, double high) {
+    return low + (high - low) * (NextRandom(state) / 2147483648.0);
+}
+
+// the arena a ms on, and the tape checker with it so its debounced state is
+// what ObstacleEscape_Sense would see on the robot
+
+static void Tick(void) {
+    ArenaSim_Tick(nowMs++);
+    CheckTapeSensors();
+}
+
+// the corners blocked by a bumper and by the floor tape, the same readings
+// ObstacleEscape_Sense goes by
+
+static void ReadCorners(uint8_t *bumped, uint8_t *taped) {
+    uint16_t pressed = ~IO_PortsReadPort(BUMPER_PORT);
+
+    *bumped = ESCAPE_CORNERS(ObstacleEscape_Situation(pressed, 0xFF, 0, 0));
+    *taped = ESCAPE_CORNERS(ObstacleEscape_Situation(0, ROBOT->checkers.tapeState, 0, 0));
+}
+
+static uint8_t Corners(void) {
+    uint8_t bumped, taped;
+    ReadCorners(&bumped, &taped);
+    return bumped | taped;
+}
+
+// left for right
+
+static uint8_t MirrorSituation(uint8_t situation) {
+    static const uint8_t MirrorMotion[ESCAPE_NUM_MOTIONS] = {
+        ESCAPE_STOPPED, ESCAPE_FORWARD, ESCAPE_BACKWARD, ESCAPE_SPIN_RIGHT, ESCAPE_SPIN_LEFT
+    };
+    uint8_t corners = ESCAPE_CORNERS(situation);
+    uint8_t mirrored = (corners & 0x5) << 1 | (corners & 0xA) >> 1;
+    return mirrored | MirrorMotion[ESCAPE_MOTION(situation)] << ESCAPE_NUM_CORNERS;
+}
+
+static int MirrorCandidate(int candidate) {
+    int vector = candidate / NUM_TIMES;
+    int left = vector / NUM_POWERS, right = vector % NUM_POWERS;
+    return (right * NUM_POWERS + left) * NUM_TIMES + candidate % NUM_TIMES;
+}
+
+static ObstacleEscape_t CandidateEscape(int candidate) {
+    int vector = candidate / NUM_TIMES;
+    ObstacleEscape_t escape = {
+        .left = Powers[vector / NUM_POWERS],
+        .right = Powers[vector % NUM_POWERS],
+        .time = TimesMs[candidate % NUM_TIMES] / ESCAPE_TIME_UNIT,
+    };
+    return escape;
+}
+
+// puts the robot down somewhere clear, facing anywhere. Spinning only runs
+// into something close by, so for a spin it goes near a wall
+
+static uint8_t PlaceRobot(uint64_t *rng, uint8_t spin) {
+    const ArenaConfig_t *config = &match->arena.config;
+
+    for (int i = 0; i < PLACEMENT_TRIES; i++) {
+        ArenaPose_t pose = {
+            .x = Uniform(rng, ARENA_MARGIN, config->width - ARENA_MARGIN),
+            .y = Uniform(rng, ARENA_MARGIN, config->height - ARENA_MARGIN),
+            .heading = Uniform(rng, -M_PI, M_PI),
+        };
+        if (spin) {
+            double reach = Uniform(rng, SPIN_NEAR, SPIN_FAR);
+            switch (NextRandom(rng) % 4) {
+                case 0: pose.x = reach;
+                    break;
+                case 1: pose.x = config->width - reach;
+                    break;
+                case 2: pose.y = reach;
+                    break;
+                default: pose.y = config->height - reach;
+                    break;
+            }
+        }
+        match->arena.pose = pose;
+        match->arena.leftSpeed = match->arena.rightSpeed = 0;
+        SetMotors(0, 0);
+        Tick();
+        if (match->arena.pose.x == pose.x && match->arena.pose.y == pose.y && Corners() == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+// drives the robot into something, TRUE once a corner is blocked
+
+static uint8_t GetInto(int n, uint64_t *rng, Situation_t *s) {
+    int motion = n % 4; // forward, back, spin left, spin right
+    uint8_t onTape = (n / 4) % 2;
+    int power = MIN_POWER + NextRandom(rng) % (101 - MIN_POWER);
+    int left, right;
+
+    if (!PlaceRobot(rng, motion >= 2)) return FALSE;
+    if (motion < 2) { // steering a little, the way ApproachTower does
+        int steer = (int) (NextRandom(rng) % (2 * MAX_STEER + 1)) - MAX_STEER;
+        left = power + steer / 2;
+        right = power - steer / 2;
+        if (left > 100) left = 100;
+        if (right > 100) right = 100;
+        if (motion == 1) {
+            left = -left;
+            right = -right;
+        }
+    } else {
+        left = motion == 2 ? -power : power;
+        right = -left;
+    }
+    SetMotors(left, right);
+
+    for (int t = 0; t < TRIP_MS; t++) {
+        uint8_t bumped, taped;
+        Tick();
+        ReadCorners(&bumped, &taped);
+        if (onTape ? (bumped | taped) == 0 : bumped == 0) continue;
+
+        if (n % STOPPED_EVERY == STOPPED_EVERY - 1) {
+            SetMotors(0, 0);
+            match->arena.leftSpeed = match->arena.rightSpeed = 0;
+        }
+        s->arena = match->arena;
+        s->left = getLeftPow();
+        s->right = getRightPow();
+        s->tapeState = ROBOT->checkers.tapeState;
+        s->situation = ObstacleEscape_Sense(0);
+        s->bumped = bumped;
+        s->taped = taped;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void Restore(const Situation_t *s) {
+    match->arena = s->arena;
+    ROBOT->checkers.tapeState = s->tapeState;
+    SetMotors(s->left, s->right);
+}
+
+// AcquireTower spinning in place after the escape, TRUE if it blocks a corner
+// that was clear when it started
+
+static uint8_t FollowHits(void) {
+    uint8_t start = Corners();
+
+    SetMotors(ACQUIRE_SPEED, -ACQUIRE_SPEED);
+    for (int t = 0; t < FOLLOW_MS; t++) {
+        Tick();
+        if (Corners() & ~start) return TRUE;
+    }
+    return FALSE;
+}
+
+// every candidate from one situation, each held for the longest of the times
+// with the cost worked out as each shorter one goes by
+
+static void TryCandidates(const Situation_t *s, double cost[NUM_CANDIDATES]) {
+    for (int v = 0; v < NUM_VECTORS; v++) {
+        ObstacleEscape_t escape = CandidateEscape(v * NUM_TIMES);
+        uint8_t blocked = ESCAPE_CORNERS(s->situation);
+        int retriggers = 0, k = 0;
+
+        Restore(s);
+        SetMotors(escape.left, escape.right);
+        for (int t = 1; k < NUM_TIMES; t++) {
+            Tick();
+            uint8_t corners = Corners();
+            if (corners & ~blocked) retriggers++;
+            blocked = corners;
+            if (t < TimesMs[k]) continue;
+
+            ArenaSim_t at = match->arena;
+            uint8_t tapeState = ROBOT->checkers.tapeState;
+            double c = t + RETRIGGER_MS * retriggers;
+            if (corners) c += STUCK_MS;
+            if (FollowHits()) c += FOLLOW_HIT_MS;
+            cost[v * NUM_TIMES + k] = c;
+            match->arena = at;
+            ROBOT->checkers.tapeState = tapeState;
+            SetMotors(escape.left, escape.right);
+            k++;
+        }
+    }
+}
+
+static void *RunWorker(void *arg) {
+    int n;
+    double *mine = malloc(NUM_CANDIDATES * sizeof (double));
+
+    match = arg;
+    HostMatch_Select(match);
+    if (mine == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    while ((n = __atomic_fetch_add(&nextSituation, 1, __ATOMIC_RELAXED)) < numSituations) {
+        ArenaConfig_t config;
+        uint64_t rng = baseSeed * 0x9E3779B97F4A7C15ull + n;
+
+        ArenaSim_RandomConfig(&config, baseSeed + n);
+        if (HostMatch_Start(&config, NULL) != Success) continue;
+        nowMs = 0;
+        if (!GetInto(n, &rng, &situations[n])) continue;
+        found[n] = TRUE;
+        if (n % HOLDOUT_EVERY == 0) continue;
+
+        TryCandidates(&situations[n], mine);
+        uint8_t s = ObstacleEscape_Key(situations[n].situation);
+        uint8_t m = ObstacleEscape_Key(MirrorSituation(situations[n].situation));
+        pthread_mutex_lock(&costsLock);
+        for (int c = 0; c < NUM_CANDIDATES; c++) {
+            costs.cost[s][c] += mine[c];
+            costs.cost[m][MirrorCandidate(c)] += mine[c];
+        }
+        costs.count[s]++;
+        costs.count[m]++;
+        pthread_mutex_unlock(&costsLock);
+    }
+    free(mine);
+    return NULL;
+}
+
+static void Collect(void) {
+    pthread_t workers[MAX_JOBS];
+    HostMatch_t *matches = calloc(numJobs, sizeof (HostMatch_t));
+
+    situations = calloc(numSituations, sizeof (Situation_t));
+    found = calloc(numSituations, 1);
+    if (matches == NULL || situations == NULL || found == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    for (int j = 0; j < numJobs; j++) {
+        if (pthread_create(&workers[j], NULL, RunWorker, &matches[j]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (int j = 0; j < numJobs; j++) pthread_join(workers[j], NULL);
+    free(matches);
+}
+
+// a situation that goes by the key, the key's corner and motion
+
+static uint8_t KeySituation(uint8_t key) {
+    return ESCAPE_KEY_CORNERS(key) | ESCAPE_KEY_MOTION(key) << ESCAPE_NUM_CORNERS;
+}
+
+// the four resolve states as a table: the first corner blocked in the order
+// FL, FR, BL, BR, whatever the robot was doing
+
+static void OldTable(ObstacleEscape_t table[ESCAPE_NUM_KEYS]) {
+    for (int k = 0; k < ESCAPE_NUM_KEYS; k++) table[k] = ObstacleEscape_Resolve(ESCAPE_KEY_CORNERS(k));
+}
+
+// a table as ObstacleEscape_Plan goes by it, with the four states' escape
+// where nothing was fitted
+
+static void Resolved(const ObstacleEscape_t table[ESCAPE_NUM_KEYS], ObstacleEscape_t resolved[ESCAPE_NUM_KEYS]) {
+    for (int k = 0; k < ESCAPE_NUM_KEYS; k++) {
+        resolved[k] = table[k].time != 0 ? table[k] : ObstacleEscape_Resolve(ESCAPE_KEY_CORNERS(k));
+    }
+}
+
+// nothing blocked any more: take back a little of what the robot was doing,
+// or nothing at all if it was stopped
+
+static ObstacleEscape_t UndoMotion(uint8_t motion) {
+    switch (motion) {
+        case ESCAPE_FORWARD: return (ObstacleEscape_t){-75, -75, 30};
+        case ESCAPE_BACKWARD: return (ObstacleEscape_t){75, 75, 30};
+        case ESCAPE_SPIN_LEFT: return (ObstacleEscape_t){75, -75, 30};
+        case ESCAPE_SPIN_RIGHT: return (ObstacleEscape_t){-75, 75, 30};
+    }
+    return (ObstacleEscape_t){0, 0, 1};
+}
+
+static void Fit(ObstacleEscape_t table[ESCAPE_NUM_KEYS], int *numFitted) {
+    static const ObstacleEscape_t Unfitted = ESCAPE_UNFITTED;
+
+    *numFitted = 0;
+    for (int k = 0; k < ESCAPE_NUM_KEYS; k++) {
+        if (ESCAPE_KEY_CORNERS(k) == 0) {
+            table[k] = UndoMotion(ESCAPE_KEY_MOTION(k));
+            continue;
+        }
+        table[k] = Unfitted;
+        if (ObstacleEscape_Key(KeySituation(k)) != k || costs.count[k] < MIN_SAMPLES) continue;
+        int best = 0;
+        for (int c = 1; c < NUM_CANDIDATES; c++) {
+            if (costs.cost[k][c] < costs.cost[k][best]) best = c;
+        }
+        table[k] = CandidateEscape(best);
+        (*numFitted)++;
+    }
+}
+
+// ResolveObstacle getting out of a situation, picking a new escape whenever
+// it would: the four states on every new bumper and every tape change with a
+// corner on tape, ObstacleEscape on every corner blocked that was clear
+
+static void PlayOut(const Situation_t *s, const ObstacleEscape_t table[ESCAPE_NUM_KEYS], uint8_t oldRule, Check_t *check) {
+    uint8_t situation = s->situation;
+    uint8_t blocked = ESCAPE_CORNERS(situation), bumped = s->bumped, taped = s->taped;
+    const ObstacleEscape_t *escape = &table[ObstacleEscape_Key(situation)];
+    int end = escape->time * ESCAPE_TIME_UNIT;
+    int t = 0;
+
+    Restore(s);
+    SetMotors(escape->left, escape->right);
+    while (t < end && t < MAX_ESCAPE_MS) {
+        uint8_t nowBumped, nowTaped, retrigger;
+        Tick();
+        t++;
+        ReadCorners(&nowBumped, &nowTaped);
+        if (oldRule) {
+            retrigger = (nowBumped & ~bumped) || (nowTaped != taped && nowTaped != 0);
+        } else {
+            retrigger = ((nowBumped | nowTaped) & ~blocked) != 0;
+        }
+        bumped = nowBumped;
+        taped = nowTaped;
+        blocked = nowBumped | nowTaped;
+        if (retrigger) {
+            check->retriggers++;
+            escape = &table[ObstacleEscape_Key(ObstacleEscape_Sense(0))];
+            SetMotors(escape->left, escape->right);
+            end = t + escape->time * ESCAPE_TIME_UNIT;
+        }
+    }
+    check->escapes++;
+    check->ms += t;
+    if (Corners()) check->stuck++;
+    if (FollowHits()) check->followHits++;
+}
+
+static void Report(const char *name, const ObstacleEscape_t table[ESCAPE_NUM_KEYS], uint8_t oldRule) {
+    Check_t check = {0};
+
+    for (int n = 0; n < numSituations; n += HOLDOUT_EVERY) {
+        if (found[n]) PlayOut(&situations[n], table, oldRule, &check);
+    }
+    if (check.escapes == 0) return;
+    fprintf(stderr, "  %-12s %6.0f ms, %.2f retriggers, %4.1f%% still blocked, %4.1f%% ran into something after\n",
+            name, check.ms / check.escapes, (double) check.retriggers / check.escapes,
+            100.0 * check.stuck / check.escapes, 100.0 * check.followHits / check.escapes);
+}
+
+static void WriteRow(FILE *out, uint8_t key, const ObstacleEscape_t *escape) {
+    const char *corner = "clear";
+    char entry[32] = "ESCAPE_UNFITTED";
+
+    for (int i = 0; i < ESCAPE_NUM_CORNERS; i++) {
+        if (ESCAPE_KEY_CORNERS(key) & (1 << i)) corner = CornerNames[i];
+    }
+    if (escape->time != 0) snprintf(entry, sizeof (entry), "{%d, %d, %d}", escape->left, escape->right, escape->time);
+    fprintf(out, "    %s, // %s, %s%s\n", entry, corner, MotionNames[ESCAPE_KEY_MOTION(key)],
+            ObstacleEscape_Key(KeySituation(key)) != key ? ", goes by stopped" : "");
+}
+
+// ObstacleEscape.c with everything between the table markers replaced
+
+static int WriteSource(const char *path, FILE *out, const ObstacleEscape_t table[ESCAPE_NUM_KEYS], const char *note) {
+    FILE *in = fopen(path, "r");
+    char line[512];
+    uint8_t inTable = FALSE, wrote = FALSE;
+
+    if (in == NULL) {
+        perror(path);
+        return FALSE;
+    }
+    while (fgets(line, sizeof (line), in) != NULL) {
+        if (strstr(line, "ESCAPE TABLE END") != NULL) inTable = FALSE;
+        if (inTable) continue;
+        fputs(line, out);
+        if (strstr(line, "ESCAPE TABLE BEGIN") != NULL) {
+            fprintf(out, "    // %s\n", note);
+            for (int k = 0; k < ESCAPE_NUM_KEYS; k++) WriteRow(out, k, &table[k]);
+            inTable = TRUE;
+            wrote = TRUE;
+        }
+    }
+    fclose(in);
+    if (!wrote) fprintf(stderr, "%s has no ESCAPE TABLE BEGIN line\n", path);
+    return wrote;
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *sourcePath = DEFAULT_SOURCE;
+    const char *outPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:s:c:o:")) != -1) {
+        switch (opt) {
+            case 'n':
+                numSituations = atoi(optarg);
+                break;
+            case 'j':
+                numJobs = atoi(optarg);
+                break;
+            case 's':
+                baseSeed = strtoull(optarg, NULL, 0);
+                break;
+            case 'c':
+                sourcePath = optarg;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n situations] [-j jobs] [-s seed] [-c ObstacleEscape.c]\n"
+                        "       [-o fitted source]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (numJobs <= 0) numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numJobs > MAX_JOBS) numJobs = MAX_JOBS;
+
+    // the robot's printfs go to stdout, keep them out of the fitted source
+    fflush(stdout);
+    int sourceOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (sourceOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+
+    fprintf(stderr, "trying %d escapes from %d situations on %d jobs\n", NUM_CANDIDATES, numSituations, numJobs);
+    Collect();
+
+    int numFound = 0, numCorners = 0, seen = 0;
+    for (int n = 0; n < numSituations; n++) {
+        uint8_t corners = ESCAPE_CORNERS(situations[n].situation);
+        numFound += found[n];
+        numCorners += found[n] && (corners & (corners - 1)) != 0;
+    }
+    for (int k = 0; k < ESCAPE_NUM_KEYS; k++) seen += costs.count[k] > 0;
+    fprintf(stderr, "%d situations got into, %d of them with more than one corner blocked, %d different keys counting mirror images\n",
+            numFound, numCorners, seen);
+    if (numFound == 0) return 1;
+
+    ObstacleEscape_t old[ESCAPE_NUM_KEYS], shipped[ESCAPE_NUM_KEYS];
+    ObstacleEscape_t fitted[ESCAPE_NUM_KEYS], fittedResolved[ESCAPE_NUM_KEYS];
+    int numFitted;
+    OldTable(old);
+    for (int k = 0; k < ESCAPE_NUM_KEYS; k++) shipped[k] = ObstacleEscape_Plan(KeySituation(k));
+    Fit(fitted, &numFitted);
+    Resolved(fitted, fittedResolved);
+    fprintf(stderr, "%d keys fitted from at least %d samples\n", numFitted, MIN_SAMPLES);
+
+    // the check drives the same match structs the workers did, one at a time
+    HostMatch_t *checkMatch = calloc(1, sizeof (HostMatch_t));
+    if (checkMatch == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    ArenaConfig_t config;
+    ArenaSim_RandomConfig(&config, baseSeed);
+    match = checkMatch;
+    HostMatch_Select(match);
+    HostMatch_Start(&config, NULL);
+    fprintf(stderr, "\nheld out situations, every %dth, played out:\n", HOLDOUT_EVERY);
+    Report("four states", old, TRUE);
+    Report("shipped", shipped, FALSE);
+    Report("fitted", fittedResolved, FALSE);
+
+    fflush(stdout);
+    if (sourceOut >= 0 && devNull >= 0) dup2(sourceOut, STDOUT_FILENO);
+
+    char note[256];
+    snprintf(note, sizeof (note), "EscapeFit -s %llu on %d situations, %d of the keys fitted",
+            (unsigned long long) baseSeed, numSituations, numFitted);
+    FILE *out = outPath != NULL ? fopen(outPath, "w") : stdout;
+    if (out == NULL) {
+        perror(outPath);
+        return 1;
+    }
+    int written = WriteSource(sourcePath, out, fitted, note);
+    if (out != stdout) fclose(out);
+    return written ? 0 : 1;
+}
@@ -0,0 +1,842 @@
+/*
+ * Fuzz.c
+ * Coverage guided fuzzer for RobotHSM, looking for the ways a match gets thrown
+ * away without anything crashing: a machine going round the same few states
+ * for the rest of the match (PrecisionAlign and PrecisionBack, AlignSensor and
+ * AlignDrive, AcquireTower rearming TURN_TIMER), an event every level passes
+ * up and nobody handles, and out of bounds accesses and other undefined
+ * behaviour in the robot code.
+ *
+ * An input is a list of sensor changes with a wait before each one: a tape
+ * sensor, the beacon or the track wire reading, the bumpers held down, or how
+ * long the ping sensor's echo lasts. The robot code runs unchanged on a board
+ * with no arena and sees the changes through its own event checkers, so the
+ * events RobotHSM gets are ones the sensors could really have produced. Each
+ * input runs in a child process, built with AddressSanitizer and
+ * UndefinedBehaviorSanitizer, until its last change plus the stuck budget.
+ *
+ * Coverage is the set of (states, event, states) transitions RobotHSM made,
+ * with states the state of every machine that was running. An input that makes
+ * one nobody has made before joins the corpus and gets mutated further.
+ *
+ * Findings:
+ *   stuck      RobotHSM stayed in the same state for -t ms (20 s by default),
+ *              named by the sub states it went through over that time
+ *   unhandled  RobotHSM passed an event back up to the framework, named by
+ *              the state of the lowest running machine when it arrived
+ *   sanitizer  a runtime error from the sanitizers, named by where it happened
+ *   crash      the child died some other way
+ * Each one found is cut down to as few changes and as little waiting as still
+ * reproduce it and written to the findings directory as a reproducer, in the
+ * same words Scenario.c uses for sensors:
+ *   wait <ms>
+ *   ad <FL_TAPE|FR_TAPE|BL_TAPE|BR_TAPE|CL_TAPE|CR_TAPE|S_TAPE|BEACON|TW> <value>
+ *   bumpers [FL] [FR] [BL] [BR]
+ *   ping <echo ms>
+ * and -r plays one back, printing every state change along the way.
+ *
+ * usage: Fuzz [-n execs] [-s seed] [-t stuck ms] [-o findings dir] [-r reproducer]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Global_Macros.h"
+#include "Trace.h"
+#include "RobotHSM.h"
+#include "RobotContext.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostMatch.h"
+#include "TraceTables.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_EXECS 2000
+#define DEFAULT_STUCK_MS 20000
+#define DEFAULT_DIR "findings"
+#define MAX_STEPS 64
+#define MAX_INPUT_MS 60000
+#define MAX_CORPUS 512
+#define MAP_SIZE 4096 // transition coverage bitmap
+#define MAX_STATES 32
+#define MAX_KEY 160
+#define MAX_RESULT_FINDINGS 32
+#define MAX_FINDINGS 128
+#define MAX_REPORT 65536
+#define NO_ECHO_MS 38 // what an HC-SR04 holds the echo for when nothing comes back
+#define SEED_INPUTS 8
+#define PROGRESS_EXECS 250
+
+typedef enum {
+    SENSOR_FL_TAPE, SENSOR_FR_TAPE, SENSOR_BL_TAPE, SENSOR_BR_TAPE, SENSOR_CL_TAPE, SENSOR_CR_TAPE,
+    SENSOR_S_TAPE, SENSOR_BEACON, SENSOR_TW, SENSOR_BUMPERS, SENSOR_PING, NUM_SENSORS
+} Sensor_t;
+
+static const char *SensorNames[NUM_SENSORS] = {
+    "FL_TAPE", "FR_TAPE", "BL_TAPE", "BR_TAPE", "CL_TAPE", "CR_TAPE", "S_TAPE", "BEACON", "TW",
+};
+
+static const unsigned int SensorPins[SENSOR_BUMPERS] = {
+    FL_TAPE_PIN, FR_TAPE_PIN, BL_TAPE_PIN, BR_TAPE_PIN, CL_TAPE_PIN, CR_TAPE_PIN, S_TAPE_PIN, BEACON_A_PIN, TW_PIN,
+};
+
+// bit n of a SENSOR_BUMPERS value is BumperNames[n] held down
+static const char *BumperNames[] = {"FL", "FR", "BL", "BR"};
+static const unsigned short BumperPins[] = {FL_BUMP_PIN, FR_BUMP_PIN, BL_BUMP_PIN, BR_BUMP_PIN};
+#define NUM_BUMPERS 4
+
+typedef struct {
+    uint16_t waitMs; // before the change
+    uint8_t sensor;
+    uint16_t value;
+} FuzzStep_t;
+
+typedef struct {
+    int numSteps;
+    FuzzStep_t step[MAX_STEPS];
+} FuzzInput_t;
+
+typedef enum {
+    FINDING_STUCK, FINDING_UNHANDLED, FINDING_SANITIZER, FINDING_CRASH, NUM_FINDING_KINDS
+} FindingKind_t;
+
+static const char *KindNames[NUM_FINDING_KINDS] = {"stuck", "unhandled", "sanitizer", "crash"};
+
+typedef struct {
+    uint8_t kind;
+    char key[MAX_KEY];
+} FindingKey_t;
+
+// what a child sends back, in memory shared with the parent
+typedef struct {
+    uint8_t map[MAP_SIZE];
+    uint32_t endMs;
+    int numFindings;
+    FindingKey_t finding[MAX_RESULT_FINDINGS];
+} FuzzResult_t;
+
+typedef struct {
+    FindingKey_t key;
+    FuzzInput_t input; // the shortest one seen so far
+} Finding_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static HostMatch_t match;
+static uint32_t stuckMs = DEFAULT_STUCK_MS;
+static FILE *report;
+static uint32_t rng;
+
+// the run in progress
+static const FuzzInput_t *input;
+static int nextStep;
+static uint32_t nextStepMs;
+static uint8_t verbose; // print every change, for -r
+static const FindingKey_t *target; // stop as soon as this turns up, while minimizing
+static FuzzResult_t *result;
+static int states[NUM_TRACE_MACHINES]; // -1 for a machine that is not running
+static uint32_t lastVisitMs[NUM_TRACE_MACHINES][MAX_STATES];
+static uint32_t topChangeMs;
+static uint8_t trigWasHigh;
+static uint16_t echoMs, echoLeftMs;
+
+// the whole run
+static Finding_t findings[MAX_FINDINGS];
+static int numFindings;
+static FuzzInput_t corpus[MAX_CORPUS];
+static int corpusSize;
+static uint8_t coverage[MAP_SIZE];
+static int reportFd = -1; // what the child's sanitizers say
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static uint32_t Random(void) { // xorshift32
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint32_t RandomBelow(uint32_t n) {
+    return Random() % n;
+}
+
+static int MachineState(int m) {
+    RobotHSMContext_t *hsm = &ROBOT->hsm;
+
+    switch (m) {
+        case TRACE_ROBOT_HSM:
+            return hsm->CurrentState;
+        case TRACE_SEARCH_FOR_TOWER:
+            return hsm->searchForTower.CurrentState;
+        case TRACE_SEARCH_FOR_HOLE:
+            return hsm->searchForHole.CurrentState;
+        case TRACE_FIND_NEW_TOWER:
+            return hsm->findNewTower.CurrentState;
+        case TRACE_RESOLVE_OBSTACLE:
+            return hsm->searchForTower.resolveObstacle.CurrentState;
+    }
+    return -1;
+}
+
+// which machines are running and in what state. TRACE_MACHINE_LIST has every
+// parent ahead of its children
+
+static void ReadStates(int *s) {
+    for (int m = 0; m < TraceNumMachines; m++) {
+        int parent = TraceMachines[m].parent;
+        if (parent < 0 || s[parent] == TraceMachines[m].parentState) {
+            s[m] = MachineState(m);
+        } else {
+            s[m] = -1;
+        }
+    }
+}
+
+static const char *StateName(int m, int s) {
+    if (s >= 0 && s < TraceMachines[m].numStates) return TraceMachines[m].states[s];
+    return "?";
+}
+
+static int LowestMachine(const int *s) {
+    int lowest = TRACE_ROBOT_HSM;
+    for (int m = 0; m < TraceNumMachines; m++) {
+        if (s[m] >= 0) lowest = m;
+    }
+    return lowest;
+}
+
+static uint8_t AlreadyFound(const FuzzResult_t *r, uint8_t kind, const char *key) {
+    for (int i = 0; i < r->numFindings; i++) {
+        if (r->finding[i].kind == kind && strcmp(r->finding[i].key, key) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+static void AddFinding(FuzzResult_t *r, uint8_t kind, const char *key) {
+    if (AlreadyFound(r, kind, key) || r->numFindings == MAX_RESULT_FINDINGS) return;
+    r->finding[r->numFindings].kind = kind;
+    snprintf(r->finding[r->numFindings].key, MAX_KEY, "%s", key);
+    r->numFindings++;
+    if (verbose) fprintf(report, "%6lu  %s: %s\n", (unsigned long) HostSim_GetTime(), KindNames[kind], key);
+    if (target != NULL && target->kind == kind && strcmp(target->key, key) == 0) HostSim_Stop();
+}
+
+static void MarkVisited(void) {
+    uint32_t now = HostSim_GetTime();
+    for (int m = 0; m < TraceNumMachines; m++) {
+        if (states[m] >= 0 && states[m] < MAX_STATES) lastVisitMs[m][states[m]] = now;
+    }
+}
+
+// every state that was running in the last stuckMs, as one key
+
+static void CheckStuck(void) {
+    uint32_t now = HostSim_GetTime();
+    char key[MAX_KEY];
+    int len;
+
+    if (now - topChangeMs < stuckMs) return;
+    len = snprintf(key, sizeof (key), "in %s for %lu ms through", StateName(TRACE_ROBOT_HSM, states[TRACE_ROBOT_HSM]),
+            (unsigned long) stuckMs);
+    for (int m = 1; m < TraceNumMachines; m++) {
+        for (int s = 0; s < MAX_STATES && s < TraceMachines[m].numStates; s++) {
+            if (lastVisitMs[m][s] != UINT32_MAX && now - lastVisitMs[m][s] < stuckMs && len < sizeof (key)) {
+                len += snprintf(key + len, sizeof (key) - len, " %s", TraceMachines[m].states[s]);
+            }
+        }
+    }
+    AddFinding(result, FINDING_STUCK, key);
+    HostSim_Stop();
+}
+
+static void ApplyStep(const FuzzStep_t *step) {
+    if (step->sensor < SENSOR_BUMPERS) {
+        HostHAL_SetAD(SensorPins[step->sensor], step->value);
+    } else if (step->sensor == SENSOR_BUMPERS) {
+        for (int b = 0; b < NUM_BUMPERS; b++) { // pulled up, a pressed bumper reads low
+            HostHAL_SetPortInputs(BUMPER_PORT, BumperPins[b], (step->value & (1 << b)) == 0);
+        }
+    } else {
+        echoMs = step->value;
+    }
+}
+
+static void WriteStep(FILE *f, const FuzzStep_t *step) {
+    if (step->sensor < SENSOR_BUMPERS) {
+        fprintf(f, "ad %s %u\n", SensorNames[step->sensor], step->value);
+    } else if (step->sensor == SENSOR_BUMPERS) {
+        fprintf(f, "bumpers");
+        for (int b = 0; b < NUM_BUMPERS; b++) {
+            if (step->value & (1 << b)) fprintf(f, " %s", BumperNames[b]);
+        }
+        fprintf(f, "\n");
+    } else {
+        fprintf(f, "ping %u\n", step->value);
+    }
+}
+
+// the changes that are due, the ping sensor's echo, and the stuck check
+
+static void FuzzTick(uint32_t nowMs) {
+    while (nextStep < input->numSteps && nowMs >= nextStepMs) {
+        if (verbose) {
+            fprintf(report, "%6lu  ", (unsigned long) nowMs);
+            WriteStep(report, &input->step[nextStep]);
+        }
+        ApplyStep(&input->step[nextStep]);
+        if (++nextStep < input->numSteps) nextStepMs += input->step[nextStep].waitMs;
+    }
+
+    // the echo goes high the tick after the trigger drops, like ArenaSim's
+    uint8_t trigHigh = (HostHAL_GetPortOutputs(PING_PORT) & TRIG_PIN) != 0;
+    if (echoLeftMs > 0) {
+        echoLeftMs--;
+    } else if (trigWasHigh && !trigHigh) {
+        echoLeftMs = echoMs;
+    }
+    trigWasHigh = trigHigh;
+    HostHAL_SetPortInputs(PING_PORT, ECHO_PIN, echoLeftMs > 0);
+
+    MarkVisited();
+    CheckStuck();
+}
+
+static uint32_t InputMs(const FuzzInput_t *in) {
+    uint32_t ms = 0;
+    for (int i = 0; i < in->numSteps; i++) ms += in->step[i].waitMs;
+    return ms;
+}
+
+// plays one input on the match, in whatever process calls it
+
+static void Execute(const FuzzInput_t *in, FuzzResult_t *r) {
+    memset(r, 0, sizeof (*r));
+    input = in;
+    result = r;
+    nextStep = 0;
+    nextStepMs = in->numSteps > 0 ? in->step[0].waitMs : 0;
+    topChangeMs = 0;
+    trigWasHigh = FALSE;
+    echoMs = NO_ECHO_MS;
+    echoLeftMs = 0;
+    memset(lastVisitMs, 0xFF, sizeof (lastVisitMs));
+
+    HostMatch_Select(&match);
+    if (HostMatch_Start(NULL, NULL) != Success) {
+        AddFinding(r, FINDING_CRASH, "the framework did not start");
+        return;
+    }
+    ReadStates(states);
+    MarkVisited();
+    HostSim_SetTickHook(FuzzTick);
+    HostSim_RunFor(InputMs(in) + stuckMs + 1);
+    r->endMs = HostSim_GetTime();
+}
+
+// the first line of every runtime error the sanitizers printed
+
+static void ReadSanitizerReport(FuzzResult_t *r) {
+    static char text[MAX_REPORT];
+    ssize_t len = pread(reportFd, text, sizeof (text) - 1, 0);
+
+    if (len <= 0) return;
+    text[len] = '\0';
+    for (char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        char *error = strstr(line, "runtime error: ");
+        char *summary = strstr(line, "SUMMARY: ");
+        char key[MAX_KEY];
+        if (error != NULL) {
+            char *file = strrchr(line, '/'); // the file and line without the directory or column
+            file = (file != NULL && file < error) ? file + 1 : line;
+            char *column = strchr(file, ':');
+            column = column != NULL ? strchr(column + 1, ':') : NULL;
+            snprintf(key, sizeof (key), "%.*s %s", column != NULL ? (int) (column - file) : 0, file, error + 15);
+            AddFinding(r, FINDING_SANITIZER, key);
+        } else if (summary != NULL) {
+            snprintf(key, sizeof (key), "%s", summary + 9);
+            AddFinding(r, FINDING_SANITIZER, key);
+        }
+    }
+}
+
+// plays one input in a child, so a crash or a sanitizer abort only loses that one
+
+static void Run(const FuzzInput_t *in, FuzzResult_t *r) {
+    int status;
+
+    fflush(report);
+    ftruncate(reportFd, 0); // the child's stderr shares the offset, so back to the start too
+    lseek(reportFd, 0, SEEK_SET);
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        exit(2);
+    }
+    if (child == 0) {
+        dup2(reportFd, STDERR_FILENO);
+        Execute(in, r);
+        fflush(stderr);
+        _exit(0);
+    }
+    waitpid(child, &status, 0);
+    ReadSanitizerReport(r);
+    if (WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0)) {
+        char key[MAX_KEY];
+        if (WIFSIGNALED(status)) {
+            snprintf(key, sizeof (key), "killed by signal %d", WTERMSIG(status));
+        } else {
+            snprintf(key, sizeof (key), "exited with %d", WEXITSTATUS(status));
+        }
+        // a sanitizer that aborts has already said why
+        int reported = FALSE;
+        for (int i = 0; i < r->numFindings; i++) reported |= r->finding[i].kind == FINDING_SANITIZER;
+        if (!reported) AddFinding(r, FINDING_CRASH, key);
+    }
+}
+
+/*******************************************************************************
+ * ROBOTHSM WRAPPER                                                            *
+ ******************************************************************************/
+
+// the framework's calls to RunRobotHSM land here instead, see -Wl,--wrap in the
+// Makefile, so what every event did to the states can be seen from outside
+ES_Event __real_RunRobotHSM(ES_Event ThisEvent);
+
+ES_Event __wrap_RunRobotHSM(ES_Event ThisEvent) {
+    int before[NUM_TRACE_MACHINES];
+
+    ReadStates(before);
+    ES_Event returned = __real_RunRobotHSM(ThisEvent);
+    if (result == NULL) return returned; // not fuzzing yet, ES_Initialize
+    ReadStates(states);
+
+    uint32_t hash = 2166136261u; // FNV-1a over the states before, the event and the states after
+    for (int m = 0; m < TraceNumMachines; m++) hash = (hash ^ (uint8_t) before[m]) * 16777619u;
+    hash = (hash ^ ThisEvent.EventType) * 16777619u;
+    for (int m = 0; m < TraceNumMachines; m++) hash = (hash ^ (uint8_t) states[m]) * 16777619u;
+    result->map[hash % MAP_SIZE] = 1;
+
+    if (states[TRACE_ROBOT_HSM] != before[TRACE_ROBOT_HSM]) topChangeMs = HostSim_GetTime();
+    if (verbose && memcmp(before, states, sizeof (states)) != 0) {
+        for (int m = 0; m < TraceNumMachines; m++) {
+            if (states[m] >= 0 && states[m] != before[m]) {
+                fprintf(report, "%6lu  %s -> %s\n", (unsigned long) HostSim_GetTime(), TraceMachines[m].name,
+                        StateName(m, states[m]));
+            }
+        }
+    }
+    MarkVisited();
+
+    if (returned.EventType != ES_NO_EVENT && returned.EventType != ES_TIMERACTIVE
+            && returned.EventType != ES_TIMERSTOPPED) {
+        char key[MAX_KEY];
+        int lowest = LowestMachine(before);
+        const char *name = returned.EventType < TraceNumEvents ? TraceEventNames[returned.EventType] : "?";
+        if (returned.EventType == ES_TIMEOUT) {
+            snprintf(key, sizeof (key), "%s %s passes up ES_TIMEOUT for timer %u", TraceMachines[lowest].name,
+                    StateName(lowest, before[lowest]), returned.EventParam);
+        } else {
+            snprintf(key, sizeof (key), "%s %s passes up %s", TraceMachines[lowest].name,
+                    StateName(lowest, before[lowest]), name);
+        }
+        AddFinding(result, FINDING_UNHANDLED, key);
+    }
+    return returned;
+}
+
+/*******************************************************************************
+ * INPUTS                                                                      *
+ ******************************************************************************/
+
+// a reading the sensor could give, mostly either side of its thresholds and
+// now and then right on them
+
+static uint16_t RandomValue(uint8_t sensor) {
+    uint32_t pick = RandomBelow(10);
+
+    switch (sensor) {
+        case SENSOR_BEACON:
+            if (pick < 4) return RandomBelow(BEACON_LOW_THRESH);
+            if (pick < 8) return BEACON_HIGH_THRESH + 1 + RandomBelow(1023 - BEACON_HIGH_THRESH);
+            return BEACON_LOW_THRESH - 10 + RandomBelow(BEACON_HIGH_THRESH - BEACON_LOW_THRESH + 20);
+        case SENSOR_TW:
+            if (pick < 4) return RandomBelow(TW_LOW_THRESH);
+            if (pick < 8) return TW_HIGH_THRESH + 1 + RandomBelow(1023 - TW_HIGH_THRESH);
+            return RandomBelow(1024);
+        case SENSOR_BUMPERS:
+            if (pick < 4) return 0;
+            if (pick < 8) return 1 << RandomBelow(NUM_BUMPERS);
+            return RandomBelow(1 << NUM_BUMPERS);
+        case SENSOR_PING:
+            if (pick < 6) return 1 + RandomBelow(PING_MAX + 5);
+            return 1 + RandomBelow(NO_ECHO_MS);
+        default: // tape, light under 700 and dark over 750
+            if (pick < 4) return RandomBelow(LIGHT_THRESHOLD);
+            if (pick < 8) return DARK_THRESHOLD + 1 + RandomBelow(1023 - DARK_THRESHOLD);
+            return LIGHT_THRESHOLD - 20 + RandomBelow(DARK_THRESHOLD - LIGHT_THRESHOLD + 40);
+    }
+}
+
+static uint16_t RandomWait(void) {
+    switch (RandomBelow(4)) {
+        case 0:
+            return 0;
+        case 1:
+            return RandomBelow(3000);
+        default:
+            return RandomBelow(400);
+    }
+}
+
+static FuzzStep_t RandomStep(void) {
+    FuzzStep_t step;
+    step.waitMs = RandomWait();
+    step.sensor = RandomBelow(NUM_SENSORS);
+    step.value = RandomValue(step.sensor);
+    return step;
+}
+
+static void InsertStep(FuzzInput_t *in, int at, FuzzStep_t step) {
+    if (in->numSteps == MAX_STEPS) return;
+    memmove(&in->step[at + 1], &in->step[at], (in->numSteps - at) * sizeof (FuzzStep_t));
+    in->step[at] = step;
+    in->numSteps++;
+}
+
+static void DeleteSteps(FuzzInput_t *in, int at, int count) {
+    memmove(&in->step[at], &in->step[at + count], (in->numSteps - at - count) * sizeof (FuzzStep_t));
+    in->numSteps -= count;
+}
+
+static void Mutate(FuzzInput_t *in) {
+    int mutations = 1 + RandomBelow(4);
+
+    for (int i = 0; i < mutations; i++) {
+        int at = in->numSteps > 0 ? RandomBelow(in->numSteps) : 0;
+        FuzzStep_t *step = &in->step[at];
+
+        switch (in->numSteps == 0 ? 0 : RandomBelow(7)) {
+            case 0: // a new change
+                InsertStep(in, in->numSteps > 0 ? RandomBelow(in->numSteps + 1) : 0, RandomStep());
+                break;
+            case 1: // another reading
+                step->value = RandomValue(step->sensor);
+                break;
+            case 2: // another sensor
+                *step = RandomStep();
+                break;
+            case 3: // another wait
+                step->waitMs = RandomBelow(2) ? RandomWait() : step->waitMs / 2;
+                break;
+            case 4:
+                if (in->numSteps > 1) DeleteSteps(in, at, 1);
+                break;
+            case 5: // the same few changes over again, which is how cycles get started
+            {
+                int count = 1 + RandomBelow(in->numSteps - at < 4 ? in->numSteps - at : 4);
+                for (int k = 0; k < count && in->numSteps < MAX_STEPS; k++) {
+                    InsertStep(in, at + count + k, in->step[at + k]);
+                }
+                break;
+            }
+            case 6: // the end of another input in the corpus
+            {
+                const FuzzInput_t *other = &corpus[RandomBelow(corpusSize)];
+                if (other->numSteps == 0) break;
+                int from = RandomBelow(other->numSteps);
+                in->numSteps = at;
+                for (int k = from; k < other->numSteps && in->numSteps < MAX_STEPS; k++) {
+                    in->step[in->numSteps++] = other->step[k];
+                }
+                break;
+            }
+        }
+    }
+    // keep it inside a match
+    while (in->numSteps > 1 && InputMs(in) > MAX_INPUT_MS) in->numSteps--;
+}
+
+// TRUE if the run made a transition no run before it made
+
+static uint8_t MergeCoverage(const FuzzResult_t *r) {
+    uint8_t found = FALSE;
+    for (int i = 0; i < MAP_SIZE; i++) {
+        if (r->map[i] && !coverage[i]) {
+            coverage[i] = 1;
+            found = TRUE;
+        }
+    }
+    return found;
+}
+
+static int CountCoverage(void) {
+    int count = 0;
+    for (int i = 0; i < MAP_SIZE; i++) count += coverage[i];
+    return count;
+}
+
+// shorter to play back, then fewer changes
+
+static uint8_t Simpler(const FuzzInput_t *a, const FuzzInput_t *b) {
+    uint32_t aMs = InputMs(a), bMs = InputMs(b);
+    return aMs < bMs || (aMs == bMs && a->numSteps < b->numSteps);
+}
+
+static void RecordFindings(const FuzzResult_t *r, const FuzzInput_t *in) {
+    for (int i = 0; i < r->numFindings; i++) {
+        int f;
+        for (f = 0; f < numFindings; f++) {
+            if (findings[f].key.kind == r->finding[i].kind && strcmp(findings[f].key.key, r->finding[i].key) == 0) break;
+        }
+        if (f == numFindings) {
+            if (numFindings == MAX_FINDINGS) continue;
+            numFindings++;
+            findings[f].key = r->finding[i];
+            findings[f].input = *in;
+            fprintf(report, "new %s: %s\n", KindNames[r->finding[i].kind], r->finding[i].key);
+        } else if (Simpler(in, &findings[f].input)) {
+            findings[f].input = *in;
+        }
+    }
+}
+
+static uint8_t Reproduces(const FuzzInput_t *in, const FindingKey_t *key, FuzzResult_t *r) {
+    target = key;
+    Run(in, r);
+    target = NULL;
+    for (int i = 0; i < r->numFindings; i++) {
+        if (r->finding[i].kind == key->kind && strcmp(r->finding[i].key, key->key) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+// drops changes a chunk at a time while the finding still turns up, halving the
+// chunk when none can go, then cuts the waits down the same way
+
+static void Minimize(Finding_t *f, FuzzResult_t *r) {
+    FuzzInput_t trial;
+
+    for (int chunk = (f->input.numSteps + 1) / 2; chunk >= 1;) {
+        uint8_t dropped = FALSE;
+        for (int at = 0; at + chunk <= f->input.numSteps;) {
+            trial = f->input;
+            DeleteSteps(&trial, at, chunk);
+            if (Reproduces(&trial, &f->key, r)) {
+                f->input = trial;
+                dropped = TRUE;
+            } else {
+                at += chunk;
+            }
+        }
+        if (!dropped) chunk /= 2;
+    }
+    for (int i = 0; i < f->input.numSteps; i++) {
+        while (f->input.step[i].waitMs > 0) {
+            trial = f->input;
+            trial.step[i].waitMs = trial.step[i].waitMs > 1 ? trial.step[i].waitMs / 2 : 0;
+            if (!Reproduces(&trial, &f->key, r)) break;
+            f->input = trial;
+        }
+    }
+}
+
+static void WriteReproducer(const char *path, const Finding_t *f) {
+    FILE *out = fopen(path, "w");
+
+    if (out == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(out, "# %s: %s\n# replay with Fuzz -t %lu -r %s\n", KindNames[f->key.kind], f->key.key,
+            (unsigned long) stuckMs, path);
+    for (int i = 0; i < f->input.numSteps; i++) {
+        if (f->input.step[i].waitMs > 0) fprintf(out, "wait %u\n", f->input.step[i].waitMs);
+        WriteStep(out, &f->input.step[i]);
+    }
+    fclose(out);
+}
+
+static int ReadReproducer(const char *path, FuzzInput_t *in) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    uint32_t wait = 0;
+
+    if (f == NULL) {
+        perror(path);
+        return ERROR;
+    }
+    in->numSteps = 0;
+    while (fgets(line, sizeof (line), f) != NULL && in->numSteps < MAX_STEPS) {
+        char *hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+        char *cmd = strtok(line, " \t\r\n");
+        char *arg = strtok(NULL, " \t\r\n");
+        FuzzStep_t step = {wait > UINT16_MAX ? UINT16_MAX : wait, NUM_SENSORS, 0};
+
+        if (cmd == NULL) continue;
+        if (strcmp(cmd, "wait") == 0 && arg != NULL) {
+            wait += strtoul(arg, NULL, 0);
+            continue;
+        } else if (strcmp(cmd, "ad") == 0 && arg != NULL) {
+            for (int s = 0; s < SENSOR_BUMPERS; s++) {
+                if (strcmp(SensorNames[s], arg) == 0) step.sensor = s;
+            }
+            char *value = strtok(NULL, " \t\r\n");
+            if (value != NULL) step.value = strtoul(value, NULL, 0);
+        } else if (strcmp(cmd, "bumpers") == 0) {
+            step.sensor = SENSOR_BUMPERS;
+            for (; arg != NULL; arg = strtok(NULL, " \t\r\n")) {
+                for (int b = 0; b < NUM_BUMPERS; b++) {
+                    if (strcmp(BumperNames[b], arg) == 0) step.value |= 1 << b;
+                }
+            }
+        } else if (strcmp(cmd, "ping") == 0 && arg != NULL) {
+            step.sensor = SENSOR_PING;
+            step.value = strtoul(arg, NULL, 0);
+        }
+        if (step.sensor == NUM_SENSORS) {
+            fprintf(stderr, "%s: cannot read \"%s\"\n", path, cmd);
+            fclose(f);
+            return ERROR;
+        }
+        in->step[in->numSteps++] = step;
+        wait = 0;
+    }
+    fclose(f);
+    return SUCCESS;
+}
+
+/*******************************************************************************
+ * SANITIZER OPTIONS                                                           *
+ ******************************************************************************/
+
+// a child that ends leaves the match behind on purpose, and one report per place
+// is plenty
+
+const char *__asan_default_options(void) {
+    return "detect_leaks=0";
+}
+
+const char *__ubsan_default_options(void) {
+    return "print_stacktrace=0";
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *dir = DEFAULT_DIR, *replayPath = NULL;
+    int execs = DEFAULT_EXECS;
+    uint32_t seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:t:o:r:")) != -1) {
+        switch (opt) {
+            case 'n':
+                execs = atoi(optarg);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                stuckMs = strtoul(optarg, NULL, 0);
+                break;
+            case 'o':
+                dir = optarg;
+                break;
+            case 'r':
+                replayPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n execs] [-s seed] [-t stuck ms] [-o findings dir] [-r reproducer]\n", argv[0]);
+                return 2;
+        }
+    }
+    rng = seed != 0 ? seed : 1;
+
+    // the robot's printfs go to stdout, keep them out of the report
+    fflush(stdout);
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    int devNull = open("/dev/null", O_WRONLY);
+    if (report == NULL || devNull < 0) {
+        perror("stdout");
+        return 2;
+    }
+    dup2(devNull, STDOUT_FILENO);
+    setvbuf(report, NULL, _IOLBF, 0);
+
+    if (replayPath != NULL) { // in this process, so the sanitizers print straight to stderr
+        static FuzzResult_t replayResult;
+        static FuzzInput_t replayInput;
+        if (ReadReproducer(replayPath, &replayInput) != SUCCESS) return 2;
+        verbose = TRUE;
+        Execute(&replayInput, &replayResult);
+        fprintf(report, "%6lu  end, %d finding%s\n", (unsigned long) replayResult.endMs, replayResult.numFindings,
+                replayResult.numFindings == 1 ? "" : "s");
+        return replayResult.numFindings > 0 ? 1 : 0;
+    }
+
+    char reportPath[] = "/tmp/fuzzXXXXXX";
+    reportFd = mkstemp(reportPath);
+    FuzzResult_t *r = mmap(NULL, sizeof (FuzzResult_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (reportFd < 0 || r == MAP_FAILED) {
+        perror("fuzz setup");
+        return 2;
+    }
+    unlink(reportPath);
+
+    for (int i = 0; i < execs; i++) {
+        FuzzInput_t in;
+        if (i < SEED_INPUTS || corpusSize == 0) {
+            in.numSteps = 0;
+            for (int k = 1 + RandomBelow(16); k > 0; k--) InsertStep(&in, in.numSteps, RandomStep());
+        } else {
+            in = corpus[RandomBelow(corpusSize)];
+            Mutate(&in);
+        }
+        Run(&in, r);
+        if (MergeCoverage(r)) {
+            corpus[corpusSize < MAX_CORPUS ? corpusSize++ : RandomBelow(MAX_CORPUS)] = in;
+        }
+        RecordFindings(r, &in);
+        if ((i + 1) % PROGRESS_EXECS == 0) {
+            fprintf(report, "%d runs, %d transitions, %d in the corpus, %d findings\n", i + 1, CountCoverage(),
+                    corpusSize, numFindings);
+        }
+    }
+
+    if (numFindings > 0 && mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror(dir);
+        return 2;
+    }
+    int count[NUM_FINDING_KINDS] = {0};
+    for (int f = 0; f < numFindings; f++) {
+        char path[512];
+        Minimize(&findings[f], r);
+        snprintf(path, sizeof (path), "%s/%s-%d.txt", dir, KindNames[findings[f].key.kind], ++count[findings[f].key.kind]);
+        WriteReproducer(path, &findings[f]);
+        fprintf(report, "%-9s %s\n          %d changes over %lu ms, %s\n", KindNames[findings[f].key.kind],
+                findings[f].key.key, findings[f].input.numSteps, (unsigned long) InputMs(&findings[f].input), path);
+    }
+    fprintf(report, "%d runs, %d transitions covered, %d findings\n", execs, CountCoverage(), numFindings);
+    return numFindings > 0 ? 1 : 0;
+}
@@ -0,0 +1,466 @@
+/*
+ * HoleFit.c
+ * Fits the weights and the threshold SearchForHole's hole evidence uses, see
+ * HoleEvidence.h, so they come from how the sensors actually read beside the
+ * hole and along the rest of the tower instead of from a guess.
+ *
+ * It plays randomized ArenaSim matches with HOLE_THRESHOLD out of reach, so the
+ * robot never stops for the hole and drives every face end to end, and after
+ * every ping Traverse adds it takes a sample: the three window means the robot
+ * just worked out, and whether ArenaSim_BesideHole says the robot really was
+ * beside the hole. A run on the robot has nothing to say where the hole was,
+ * so samples from one are read from a csv file with -f instead, the same
+ * columns -w writes, labelled by hand.
+ *
+ * The fit is a logistic regression over the means, each class weighted to
+ * count as much as the other since the robot spends so little of a face beside
+ * the hole, by Newton's method. Every HOLDOUT_EVERY'th match is held out of
+ * the fit to check it on. The weights are scaled so the largest is HOLE_WEIGHT_MAX
+ * and rounded, and the threshold is then picked on the rounded weights as the
+ * one that does best on the fitted matches, counting precision and recall the
+ * same. Global_Macros.h is written out with the four of them in, as AutoTune
+ * does.
+ *
+ * usage: HoleFit [-n matches] [-j jobs] [-s seed] [-t match ms] [-f samples csv]
+ *                [-w samples csv] [-m Global_Macros.h] [-o fitted header]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+#include "TunableParams.h"
+#include "RobotContext.h"
+#include "HoleEvidence.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_MATCHES 100
+#define DEFAULT_MATCH_MS 120000
+#define DEFAULT_MACROS "../Global_Macros.h"
+#define MAX_JOBS 256
+#define HOLDOUT_EVERY 5
+#define HOLE_WEIGHT_MAX 16 // the top of the HOLE_W_ ranges in TunableParams.h
+#define FIT_STEPS 25
+#define FIT_RIDGE 1e-4
+#define NUM_SCORES HOLE_NUM_SCORES
+#define NUM_PARAMS (NUM_SCORES + 1) // and the bias
+
+typedef struct {
+    int match;
+    int ping; // of the match, in the order they were taken
+    uint16_t mean[NUM_SCORES];
+    uint8_t beside;
+} Sample_t;
+
+typedef struct {
+    Sample_t *sample;
+    int count, size;
+} SampleList_t;
+
+typedef struct {
+    int weight[NUM_SCORES];
+    int32_t threshold;
+} HoleWeights_t;
+
+typedef struct {
+    int truePositives, falsePositives, falseNegatives, trueNegatives;
+} Tally_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int numMatches = DEFAULT_MATCHES;
+static int numJobs = 0;
+static uint64_t baseSeed = 1;
+static uint32_t matchMs = DEFAULT_MATCH_MS;
+
+static TunableParams_t sampling; // as shipped but never sure enough of the hole
+static SampleList_t samples;
+static pthread_mutex_t samplesLock = PTHREAD_MUTEX_INITIALIZER;
+static int nextMatch; // taken atomically
+
+// the worker's match
+static __thread SampleList_t matchSamples;
+static __thread int matchNumber;
+static __thread uint16_t lastNumPings;
+
+static const char *const ScoreNames[NUM_SCORES] = {"track wire", "side tape", "ping"};
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static void Append(SampleList_t *list, const Sample_t *sample) {
+    if (list->count == list->size) {
+        list->size = list->size ? 2 * list->size : 1024;
+        list->sample = realloc(list->sample, list->size * sizeof (Sample_t));
+        if (list->sample == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    list->sample[list->count++] = *sample;
+}
+
+// every ms of a match: the arena, then a sample for each ping Traverse added
+
+static void SampleTick(uint32_t nowMs) {
+    const HoleEvidence_t *hole = &ROBOT->hsm.searchForHole.hole;
+
+    ArenaSim_Tick(nowMs);
+    if (hole->numPings == lastNumPings) return;
+    lastNumPings = hole->numPings;
+    if (hole->numPings < HOLE_EVIDENCE_WINDOW) return;
+
+    Sample_t sample = {.match = matchNumber, .ping = matchSamples.count, .beside = ArenaSim_BesideHole()};
+    memcpy(sample.mean, hole->mean, sizeof (sample.mean));
+    Append(&matchSamples, &sample);
+}
+
+static void *RunWorker(void *arg) {
+    int match;
+
+    HostMatch_Select(arg);
+    TunableParams_Select(&sampling);
+    while ((match = __atomic_fetch_add(&nextMatch, 1, __ATOMIC_RELAXED)) < numMatches) {
+        ArenaConfig_t config;
+
+        ArenaSim_RandomConfig(&config, baseSeed + match);
+        matchSamples.count = 0;
+        matchNumber = match;
+        lastNumPings = 0;
+        if (HostMatch_Start(&config, NULL) != Success) continue;
+        HostSim_SetTickHook(SampleTick);
+        HostSim_RunFor(matchMs);
+
+        pthread_mutex_lock(&samplesLock);
+        for (int i = 0; i < matchSamples.count; i++) Append(&samples, &matchSamples.sample[i]);
+        pthread_mutex_unlock(&samplesLock);
+    }
+    free(matchSamples.sample);
+    TunableParams_Select(NULL);
+    return NULL;
+}
+
+// the workers finish in any order, put the samples back in match order so the
+// same seed always fits the same weights
+
+static int CompareMatch(const void *a, const void *b) {
+    const Sample_t *x = a, *y = b;
+    if (x->match != y->match) return x->match - y->match;
+    return x->ping - y->ping;
+}
+
+static void PlayMatches(void) {
+    pthread_t workers[MAX_JOBS];
+    HostMatch_t *matches = calloc(numJobs, sizeof (HostMatch_t));
+
+    if (matches == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    sampling = TunableDefaults;
+    sampling.param[TP_HOLE_THRESHOLD] = INT32_MAX;
+
+    for (int j = 0; j < numJobs; j++) {
+        if (pthread_create(&workers[j], NULL, RunWorker, &matches[j]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (int j = 0; j < numJobs; j++) pthread_join(workers[j], NULL);
+    free(matches);
+    qsort(samples.sample, samples.count, sizeof (Sample_t), CompareMatch);
+}
+
+static int ReadSamples(const char *path) {
+    FILE *in = fopen(path, "r");
+    char line[256];
+
+    if (in == NULL) {
+        perror(path);
+        return FALSE;
+    }
+    while (fgets(line, sizeof (line), in) != NULL) {
+        Sample_t sample;
+        unsigned int mean[NUM_SCORES], beside;
+        if (sscanf(line, "%d,%u,%u,%u,%u", &sample.match, &mean[0], &mean[1], &mean[2], &beside) != 5) {
+            continue; // the header
+        }
+        for (int s = 0; s < NUM_SCORES; s++) sample.mean[s] = mean[s];
+        sample.ping = samples.count;
+        sample.beside = beside != 0;
+        Append(&samples, &sample);
+    }
+    fclose(in);
+    return TRUE;
+}
+
+static int WriteSamples(const char *path) {
+    FILE *out = fopen(path, "w");
+
+    if (out == NULL) {
+        perror(path);
+        return FALSE;
+    }
+    fprintf(out, "match,track_wire,side_tape,ping,beside\n");
+    for (int i = 0; i < samples.count; i++) {
+        const Sample_t *s = &samples.sample[i];
+        fprintf(out, "%d,%u,%u,%u,%u\n", s->match, s->mean[0], s->mean[1], s->mean[2], s->beside);
+    }
+    return fclose(out) == 0;
+}
+
+static int IsHeldOut(const Sample_t *sample) {
+    return sample->match % HOLDOUT_EVERY == HOLDOUT_EVERY - 1;
+}
+
+// class weighted logistic regression on the fitted matches by Newton's method,
+// w[NUM_SCORES] is the bias. The means are scaled to 0 to 1 and a touch of
+// ridge keeps the step finite when the classes separate
+
+static void FitLogistic(double w[NUM_PARAMS]) {
+    int count[2] = {0, 0};
+
+    for (int i = 0; i < samples.count; i++) {
+        if (!IsHeldOut(&samples.sample[i])) count[samples.sample[i].beside]++;
+    }
+    double classWeight[2] = {
+        count[0] ? 0.5 / count[0] : 0,
+        count[1] ? 0.5 / count[1] : 0,
+    };
+
+    memset(w, 0, NUM_PARAMS * sizeof (double));
+    for (int step = 0; step < FIT_STEPS; step++) {
+        double gradient[NUM_PARAMS] = {0};
+        double hessian[NUM_PARAMS][NUM_PARAMS + 1] = {{0}}; // with the gradient alongside to solve
+
+        for (int i = 0; i < samples.count; i++) {
+            const Sample_t *s = &samples.sample[i];
+            if (IsHeldOut(s)) continue;
+            double x[NUM_PARAMS], z = 0;
+            for (int k = 0; k < NUM_SCORES; k++) x[k] = s->mean[k] / (double) HOLE_SCORE_MAX;
+            x[NUM_SCORES] = 1;
+            for (int k = 0; k < NUM_PARAMS; k++) z += w[k] * x[k];
+            double p = 1 / (1 + exp(-z));
+            double curve = p * (1 - p) * classWeight[s->beside];
+            for (int k = 0; k < NUM_PARAMS; k++) {
+                gradient[k] += (p - s->beside) * classWeight[s->beside] * x[k];
+                for (int l = 0; l < NUM_PARAMS; l++) hessian[k][l] += curve * x[k] * x[l];
+            }
+        }
+        for (int k = 0; k < NUM_PARAMS; k++) {
+            gradient[k] += FIT_RIDGE * w[k];
+            hessian[k][k] += FIT_RIDGE;
+            hessian[k][NUM_PARAMS] = gradient[k];
+        }
+
+        // Gauss-Jordan, the hessian is positive definite so no pivoting
+        for (int k = 0; k < NUM_PARAMS; k++) {
+            for (int r = 0; r < NUM_PARAMS; r++) {
+                if (r == k) continue;
+                double f = hessian[r][k] / hessian[k][k];
+                for (int c = k; c <= NUM_PARAMS; c++) hessian[r][c] -= f * hessian[k][c];
+            }
+        }
+        for (int k = 0; k < NUM_PARAMS; k++) w[k] -= hessian[k][NUM_PARAMS] / hessian[k][k];
+    }
+}
+
+static int32_t Confidence(const HoleWeights_t *weights, const Sample_t *sample) {
+    int32_t confidence = 0;
+    for (int k = 0; k < NUM_SCORES; k++) confidence += weights->weight[k] * sample->mean[k];
+    return confidence;
+}
+
+static Tally_t Score(const HoleWeights_t *weights, int heldOut) {
+    Tally_t tally = {0};
+
+    for (int i = 0; i < samples.count; i++) {
+        const Sample_t *s = &samples.sample[i];
+        if (IsHeldOut(s) != heldOut) continue;
+        int fired = Confidence(weights, s) >= weights->threshold;
+        if (fired && s->beside) tally.truePositives++;
+        else if (fired) tally.falsePositives++;
+        else if (s->beside) tally.falseNegatives++;
+        else tally.trueNegatives++;
+    }
+    return tally;
+}
+
+static double Precision(const Tally_t *t) {
+    int fired = t->truePositives + t->falsePositives;
+    return fired ? (double) t->truePositives / fired : 0;
+}
+
+static double Recall(const Tally_t *t) {
+    int beside = t->truePositives + t->falseNegatives;
+    return beside ? (double) t->truePositives / beside : 0;
+}
+
+static double F1(const Tally_t *t) {
+    double p = Precision(t), r = Recall(t);
+    return p + r > 0 ? 2 * p * r / (p + r) : 0;
+}
+
+// every confidence a fitted sample reached is a threshold worth trying
+
+static void PickThreshold(HoleWeights_t *weights) {
+    HoleWeights_t trial = *weights;
+    double best = -1;
+
+    for (int i = 0; i < samples.count; i++) {
+        if (IsHeldOut(&samples.sample[i]) || !samples.sample[i].beside) continue;
+        trial.threshold = Confidence(weights, &samples.sample[i]);
+        Tally_t tally = Score(&trial, FALSE);
+        double f1 = F1(&tally);
+        if (f1 > best || (f1 == best && trial.threshold > weights->threshold)) {
+            best = f1;
+            weights->threshold = trial.threshold;
+        }
+    }
+}
+
+static void Report(const char *name, const HoleWeights_t *weights) {
+    Tally_t tally = Score(weights, TRUE);
+    fprintf(stderr, "  %-8s weights %2d %2d %2d, threshold %5d: precision %.1f%%, recall %.1f%%, %d false alarms\n",
+            name, weights->weight[0], weights->weight[1], weights->weight[2], weights->threshold,
+            100 * Precision(&tally), 100 * Recall(&tally), tally.falsePositives);
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *readPath = NULL;
+    const char *writePath = NULL;
+    const char *macrosPath = DEFAULT_MACROS;
+    const char *outPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:s:t:f:w:m:o:")) != -1) {
+        switch (opt) {
+            case 'n':
+                numMatches = atoi(optarg);
+                break;
+            case 'j':
+                numJobs = atoi(optarg);
+                break;
+            case 's':
+                baseSeed = strtoull(optarg, NULL, 0);
+                break;
+            case 't':
+                matchMs = strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                readPath = optarg;
+                break;
+            case 'w':
+                writePath = optarg;
+                break;
+            case 'm':
+                macrosPath = optarg;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n matches] [-j jobs] [-s seed] [-t match ms] [-f samples csv]\n"
+                        "       [-w samples csv] [-m Global_Macros.h] [-o fitted header]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (numJobs <= 0) numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numJobs > MAX_JOBS) numJobs = MAX_JOBS;
+
+    // the robot's printfs go to stdout, keep them out of the fitted header
+    fflush(stdout);
+    int headerOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (headerOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+
+    if (readPath != NULL) {
+        if (!ReadSamples(readPath)) return 1;
+    } else {
+        fprintf(stderr, "sampling %d matches on %d jobs\n", numMatches, numJobs);
+        PlayMatches();
+    }
+    if (writePath != NULL && !WriteSamples(writePath)) return 1;
+
+    int beside = 0;
+    for (int i = 0; i < samples.count; i++) beside += samples.sample[i].beside;
+    fprintf(stderr, "%d samples, %d beside the hole\n", samples.count, beside);
+    if (beside == 0 || beside == samples.count) {
+        fprintf(stderr, "need samples both beside the hole and away from it to fit\n");
+        return 1;
+    }
+
+    double w[NUM_PARAMS];
+    FitLogistic(w);
+    double largest = 0;
+    for (int k = 0; k < NUM_SCORES; k++) largest = fmax(largest, w[k]);
+    if (largest <= 0) {
+        fprintf(stderr, "no sensor reads higher beside the hole, nothing to fit\n");
+        return 1;
+    }
+    fprintf(stderr, "logistic fit:");
+    for (int k = 0; k < NUM_SCORES; k++) fprintf(stderr, " %s %.2f,", ScoreNames[k], w[k]);
+    fprintf(stderr, " bias %.2f\n", w[NUM_SCORES]);
+
+    // a sensor that reads lower beside the hole gets no say rather than a
+    // negative one, the TUNABLE ranges start at 0
+    HoleWeights_t shipped, fitted;
+    for (int k = 0; k < NUM_SCORES; k++) {
+        fitted.weight[k] = (int) lround(fmax(w[k], 0) * HOLE_WEIGHT_MAX / largest);
+    }
+    fitted.threshold = 0;
+    PickThreshold(&fitted);
+    shipped.weight[HOLE_TRACK_WIRE] = TunableDefaults.param[TP_HOLE_W_TRACK_WIRE];
+    shipped.weight[HOLE_SIDE_TAPE_SCORE] = TunableDefaults.param[TP_HOLE_W_SIDE_TAPE];
+    shipped.weight[HOLE_PING] = TunableDefaults.param[TP_HOLE_W_PING];
+    shipped.threshold = TunableDefaults.param[TP_HOLE_THRESHOLD];
+
+    fprintf(stderr, "\nheld out samples, every %dth match:\n", HOLDOUT_EVERY);
+    Report("shipped", &shipped);
+    Report("fitted", &fitted);
+
+    fflush(stdout);
+    if (headerOut >= 0 && devNull >= 0) dup2(headerOut, STDOUT_FILENO);
+
+    TunableParams_t params = TunableDefaults;
+    params.param[TP_HOLE_W_TRACK_WIRE] = fitted.weight[HOLE_TRACK_WIRE];
+    params.param[TP_HOLE_W_SIDE_TAPE] = fitted.weight[HOLE_SIDE_TAPE_SCORE];
+    params.param[TP_HOLE_W_PING] = fitted.weight[HOLE_PING];
+    params.param[TP_HOLE_THRESHOLD] = fitted.threshold;
+
+    char note[256];
+    if (readPath != NULL) {
+        snprintf(note, sizeof (note), "HOLE_ weights from HoleFit -f %s, %d samples", readPath, samples.count);
+    } else {
+        snprintf(note, sizeof (note), "HOLE_ weights from HoleFit -s %llu on %d matches, %d samples",
+                (unsigned long long) baseSeed, numMatches, samples.count);
+    }
+    FILE *out = outPath != NULL ? fopen(outPath, "w") : stdout;
+    if (out == NULL) {
+        perror(outPath);
+        return 1;
+    }
+    int written = TunableParams_WriteHeader(macrosPath, out, &params, note);
+    if (out != stdout) fclose(out);
+    return written ? 0 : 1;
+}
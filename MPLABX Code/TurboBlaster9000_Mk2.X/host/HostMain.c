@@ -0,0 +1,127 @@
+/*
+ * HostMain.c
+ * Runs the robot code on the host, against the simulated board in host/lib.
+ *
+ * Starts the robot the same way Project_ES_Main.c does and then lets the
+ * virtual clock run for a whole match. Without -a nothing drives the sensors
+ * and the arena is empty: no tape, no beacon, no echo and nothing to bump
+ * into. With -a the robot plays in the field modeled by ArenaSim.c.
+ *
+ * usage: TurboHost [-a] [-t match ms] [-s serial capture file] [-p pose log]
+ * the serial capture holds the binary trace, feed it to TraceDecode
+ * the pose log is a CSV of where the robot was every POSE_LOG_MS
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Motor_Control.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+
+#define DEFAULT_MATCH_MS 120000 // two minutes
+#define POSE_LOG_MS 50
+
+static FILE *poseLog = NULL;
+static HostMatch_t match;
+
+// the arena's tick hook, plus a line in the pose log now and then
+
+static void ArenaTick(uint32_t nowMs) {
+    ArenaSim_Tick(nowMs);
+    if (nowMs % POSE_LOG_MS == 0) {
+        ArenaPose_t pose = ArenaSim_GetPose();
+        fprintf(poseLog, "%lu,%.4f,%.4f,%.4f,%d,%d\n", (unsigned long) nowMs, pose.x, pose.y, pose.heading,
+                getLeftPow(), getRightPow());
+    }
+}
+
+static void PrintMatch(void) {
+    ArenaPose_t pose = ArenaSim_GetPose();
+    int scored = 0;
+
+    for (int i = 0; i < ArenaSim_GetNumLaunches(); i++) {
+        const ArenaLaunch_t *launch = ArenaSim_GetLaunch(i);
+        printf("launch %d at %.1f s: ", i + 1, launch->timeMs / 1000.0);
+        if (launch->tower < 0) {
+            printf("no tower in front\r\n");
+        } else {
+            printf("tower %d face %d, %s\r\n", launch->tower, launch->face, launch->scored ? "scored" : "missed");
+        }
+        scored += launch->scored;
+    }
+    printf("%d launches, %d scored, drove %.1f m, pushing on something for %.1f s, ended at (%.2f, %.2f) facing %.0f deg\r\n",
+            ArenaSim_GetNumLaunches(), scored, ArenaSim_GetDistance(), ArenaSim_GetContactMs() / 1000.0,
+            pose.x, pose.y, pose.heading * 180 / M_PI);
+}
+
+int main(int argc, char **argv) {
+    uint32_t matchMs = DEFAULT_MATCH_MS;
+    FILE *serialOut = NULL;
+    uint8_t useArena = FALSE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "at:s:p:")) != -1) {
+        switch (opt) {
+            case 'a':
+                useArena = TRUE;
+                break;
+            case 't':
+                matchMs = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                serialOut = fopen(optarg, "wb");
+                if (serialOut == NULL) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case 'p':
+                poseLog = fopen(optarg, "w");
+                if (poseLog == NULL) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-a] [-t match ms] [-s serial capture file] [-p pose log]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    ArenaConfig_t config;
+    ArenaSim_DefaultConfig(&config);
+
+    HostMatch_Select(&match);
+    ES_Return_t ErrorType = HostMatch_Start(useArena ? &config : NULL, serialOut);
+    if (ErrorType != Success) {
+        printf("ES_Initialize failed: %d\r\n", ErrorType);
+        return 1;
+    }
+
+    if (useArena && poseLog != NULL) {
+        fprintf(poseLog, "ms,x,y,heading,left,right\n");
+        HostSim_SetTickHook(ArenaTick);
+    }
+
+    clock_t start = clock();
+    HostSim_RunFor(matchMs);
+    double wall = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("simulated %.1f s in %.3f s of CPU (%.0fx real time), %lu ms never went idle\r\n",
+            HostSim_GetTime() / 1000.0, wall, wall > 0 ? HostSim_GetTime() / 1000.0 / wall : 0.0,
+            (unsigned long) HostSim_GetBusyMs());
+
+    if (useArena) PrintMatch();
+
+    if (serialOut != NULL) fclose(serialOut);
+    if (poseLog != NULL) fclose(poseLog);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * HostMatch.c
+ * Robot power up on the host, see HostMatch.h
+ */
+
+#include <stdio.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "timers.h"
+#include "AD.h"
+#include "IO_Ports.h"
+#include "Global_Macros.h"
+#include "Motor_Control.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostBoard.h"
+#include "RobotContext.h"
+#include "TunableParams.h"
+#include "HostMatch.h"
+
+void HostMatch_Select(HostMatch_t *match) {
+    HostBoard_Select(&match->board);
+    RobotContext_Select(&match->robot);
+    ArenaSim_Select(&match->arena);
+}
+
+void HostMatch_InitHardware(void) {
+    ES_Timer_Init();
+    TIMERS_Init();
+
+    InitMotors();
+
+    AD_Init();
+    AD_AddPins(FL_TAPE_PIN | FR_TAPE_PIN | BL_TAPE_PIN | BR_TAPE_PIN | CL_TAPE_PIN | CR_TAPE_PIN | S_TAPE_PIN);
+    AD_AddPins(BEACON_A_PIN);
+    IO_PortsSetPortInputs(BEACON_PORT, BEACON_D_PIN);
+    AD_AddPins(TW_PIN);
+    IO_PortsSetPortInputs(BUMPER_PORT, FL_BUMP_PIN | FR_BUMP_PIN | BL_BUMP_PIN | BR_BUMP_PIN);
+
+    IO_PortsSetPortOutputs(PING_PORT, TRIG_PIN);
+    IO_PortsClearPortBits(PING_PORT, TRIG_PIN);
+    IO_PortsSetPortInputs(PING_PORT, ECHO_PIN);
+}
+
+ES_Return_t HostMatch_Start(const ArenaConfig_t *arena, FILE *serialOut) {
+    RobotContext_Reset(ROBOT);
+    HostSim_Init();
+    HostHAL_SetSerialOutput(serialOut);
+    BOARD_Init();
+    HostMatch_InitHardware();
+
+    if (arena != NULL) {
+        ArenaSim_Init(arena);
+    } else { // the bumpers pull up and read low when pressed
+        HostHAL_SetPortInputs(BUMPER_PORT, FL_BUMP_PIN | FR_BUMP_PIN | BL_BUMP_PIN | BR_BUMP_PIN, TRUE);
+    }
+
+    return ES_Initialize();
+}
+
+void HostMatch_Save(const HostMatch_t *match, HostSnapshot_t *snapshot) {
+    snapshot->magic = HOST_SNAPSHOT_MAGIC;
+    snapshot->size = sizeof (HostSnapshot_t);
+    snapshot->params = *CurrentParams;
+    snapshot->match = *match;
+
+    // neither means anything outside this run
+    snapshot->match.board.serial.output = NULL;
+    snapshot->match.board.sim.tickHook = NULL;
+}
+
+void HostMatch_Restore(HostMatch_t *match, const HostSnapshot_t *snapshot) {
+    FILE *output = match->board.serial.output;
+    HostTickHook_t tickHook = match->board.sim.tickHook;
+
+    *match = snapshot->match;
+    match->board.serial.output = output;
+    match->board.sim.tickHook = tickHook;
+}
+
+int HostMatch_WriteSnapshot(const HostSnapshot_t *snapshot, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return ERROR;
+    size_t written = fwrite(snapshot, sizeof (*snapshot), 1, f);
+    if (fclose(f) != 0 || written != 1) return ERROR;
+    return SUCCESS;
+}
+
+int HostMatch_ReadSnapshot(HostSnapshot_t *snapshot, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return ERROR;
+    size_t read = fread(snapshot, sizeof (*snapshot), 1, f);
+    fclose(f);
+    if (read != 1 || snapshot->magic != HOST_SNAPSHOT_MAGIC || snapshot->size != sizeof (HostSnapshot_t)) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*
+ * HostMatch.h
+ * Powers the robot up on the simulated board, the way Project_ES_Main.c does on
+ * the real one. Shared by everything in host/ that plays a match.
+ *
+ * A HostMatch_t is everything one match needs, so a program can play as many
+ * at once as it has threads. Each thread selects the match it is playing
+ * before calling anything else, the robot code, the library stand-ins and the
+ * arena all work on whatever the calling thread selected.
+ *
+ * Since nothing the match remembers lives anywhere else, a HostMatch_t copied
+ * between two HostSim_RunFor calls is the whole match at that millisecond:
+ * the clock, the queues and timers, every machine and checker, the arena and
+ * the state of its noise. HostMatch_Save and HostMatch_Restore take and put
+ * back such a copy, so a match can be stopped anywhere, branched into as many
+ * variants as wanted and each one resumed from there, see Branch.c. Resumed,
+ * a match plays on exactly as it would have without stopping.
+ */
+
+#ifndef HOST_MATCH_H
+#define	HOST_MATCH_H
+
+#include <stdio.h>
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ArenaSim.h"
+#include "HostBoard.h"
+#include "RobotContext.h"
+#include "TunableParams.h"
+
+typedef struct {
+    HostBoard_t board;
+    RobotContext_t robot;
+    ArenaSim_t arena;
+} HostMatch_t;
+
+#define HOST_SNAPSHOT_MAGIC 0x54423950u
+
+// a match frozen between two HostSim_RunFor calls. It is a plain copy of the
+// structs, so a snapshot written to a file only reads back into the same
+// build of the same code
+typedef struct {
+    uint32_t magic;
+    uint32_t size; // sizeof (HostSnapshot_t) of the build that took it
+    TunableParams_t params; // the constants the match was playing with
+    HostMatch_t match; // without the serial output and the tick hook
+} HostSnapshot_t;
+
+// makes the match the one the calling thread plays
+void HostMatch_Select(HostMatch_t *match);
+
+// same as initHardware in Project_ES_Main.c, keep the two in step
+void HostMatch_InitHardware(void);
+
+// puts the clock, the board and the robot back to power on, sets up the hardware, puts
+// the robot in the arena (NULL for an empty one, nothing on any sensor) and
+// starts the framework. Everything the robot sends out the serial port goes
+// to serialOut, NULL to throw it away. Run the match with HostSim_RunFor
+ES_Return_t HostMatch_Start(const ArenaConfig_t *arena, FILE *serialOut);
+
+// copies the match, and the tunable constants the calling thread has
+// selected, into the snapshot
+void HostMatch_Save(const HostMatch_t *match, HostSnapshot_t *snapshot);
+
+// puts the match back the way it was when the snapshot was taken, except for
+// where its serial output goes and its tick hook, which are left as they
+// were. Select the match and set the hook (ArenaSim_Tick for a match in the
+// arena) before running it, and select the snapshot's params to play with the
+// same constants
+void HostMatch_Restore(HostMatch_t *match, const HostSnapshot_t *snapshot);
+
+// snapshot to and from a file, SUCCESS or ERROR. Reading checks the file came
+// from this build
+int HostMatch_WriteSnapshot(const HostSnapshot_t *snapshot, const char *path);
+int HostMatch_ReadSnapshot(HostSnapshot_t *snapshot, const char *path);
+
+#endif	/* HOST_MATCH_H */
@@ -0,0 +1,350 @@
+/*
+ * Localize.c
+ * Checks the particle filter in Localizer.h against where the simulated robot
+ * really is, and times it.
+ *
+ * It plays randomized ArenaSim matches with the robot code driving as usual
+ * and runs a filter of its own alongside, on the map of that match's field,
+ * fed every millisecond exactly what LocalizerTick would be: the motor powers,
+ * the tape checker's bits, the bumper port and the beacon checker's state. Every SAMPLE_MS the filter's
+ * pose is compared with ArenaSim_GetPose. So is the pose from the motor powers
+ * alone, run forward from the true start with the same wheel speeds and no
+ * filter, which is what going by timers amounts to.
+ *
+ * The filter starts around the true start pose the way the robot starts
+ * around LOC_LAB_START, or anywhere on the map facing any way with -g.
+ * Each update is timed with the thread's CPU clock, which is the host's
+ * speed and not the PIC32's, but says how the cost splits between the moves
+ * and the measurements and how it grows.
+ *
+ * usage: Localize [-n matches] [-j jobs] [-s seed] [-t match ms] [-g]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "IO_Ports.h"
+#include "Global_Macros.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+#include "RobotContext.h"
+#include "Localizer.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_MATCHES 50
+#define DEFAULT_MATCH_MS 120000
+#define MAX_JOBS 256
+#define SAMPLE_MS 250
+#define SPAN_MS 15000 // the errors are also broken down over the match in spans this long
+#define MM 1000.0
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+
+typedef struct {
+    uint32_t timeMs;
+    float filterMm, filterDeg; // how far off the filter was
+    float motionMm, motionDeg; // and the motor powers alone
+    float spreadMm; // what the filter thought it was off by
+} Sample_t;
+
+typedef struct {
+    Sample_t *sample;
+    int count, size;
+} SampleList_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int numMatches = DEFAULT_MATCHES;
+static int numJobs = 0;
+static uint64_t baseSeed = 1;
+static uint32_t matchMs = DEFAULT_MATCH_MS;
+static int anywhere = FALSE;
+
+static SampleList_t samples;
+static double updateNs, worstUpdateNs;
+static long numUpdates;
+static pthread_mutex_t samplesLock = PTHREAD_MUTEX_INITIALIZER;
+static int nextMatch; // taken atomically
+
+// the worker's match
+static __thread LocalizerContext_t loc;
+static __thread ArenaPose_t motion;
+static __thread SampleList_t matchSamples;
+static __thread double matchUpdateNs, matchWorstNs;
+static __thread long matchUpdates;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static void Append(SampleList_t *list, const Sample_t *sample) {
+    if (list->count == list->size) {
+        list->size = list->size ? 2 * list->size : 4096;
+        list->sample = realloc(list->sample, list->size * sizeof (Sample_t));
+        if (list->sample == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    list->sample[list->count++] = *sample;
+}
+
+static double ThreadNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void MapFromConfig(const ArenaConfig_t *config, LocMap_t *map) {
+    memset(map, 0, sizeof (*map));
+    map->width = lround(config->width * MM);
+    map->height = lround(config->height * MM);
+    map->tape = 50; // ArenaSim's TAPE_WIDTH
+    map->towerHalf = lround(config->towerSize * MM / 2);
+    map->numTowers = config->numTowers;
+    for (int i = 0; i < config->numTowers && i < LOC_MAX_TOWERS; i++) {
+        map->tower[i].x = lround(config->towers[i].x * MM);
+        map->tower[i].y = lround(config->towers[i].y * MM);
+        map->tower[i].angle = (uint16_t) lround(remainder(config->towers[i].angle, 2 * M_PI) * 65536 / (2 * M_PI));
+    }
+}
+
+// the pose the motor powers alone give, with the filter's wheel speeds
+
+static double WheelSpeed(int pow) {
+    if (pow == 0) return 0;
+    double speed = (LOC_WHEEL_MIN_MM_S + abs(pow) * (LOC_WHEEL_MAX_MM_S - LOC_WHEEL_MIN_MM_S) / 100.0) / MM;
+    return pow > 0 ? speed : -speed;
+}
+
+static void MoveByPowers(void) {
+    double left = WheelSpeed(ROBOT->motors.leftPow), right = WheelSpeed(ROBOT->motors.rightPow);
+    double v = (left + right) / 2, w = (right - left) / (LOC_TRACK_MM / MM);
+    double mid = motion.heading + w * 0.0005;
+    motion.x += v * cos(mid) * 0.001;
+    motion.y += v * sin(mid) * 0.001;
+    motion.heading += w * 0.001;
+}
+
+static double DegreesOff(double heading, double truth) {
+    return fabs(remainder(heading - truth, 2 * M_PI)) * 180 / M_PI;
+}
+
+// every ms of a match: the arena, the filter fed what LocalizerTick would see,
+// and a sample every SAMPLE_MS
+
+static void LocalizeTick(uint32_t nowMs) {
+    ArenaSim_Tick(nowMs);
+    MoveByPowers();
+
+    double start = ThreadNs();
+    if (Localizer_Update(&loc, nowMs, ROBOT->motors.leftPow, ROBOT->motors.rightPow,
+            ROBOT->checkers.tapeState, IO_PortsReadPort(BUMPER_PORT), ROBOT->checkers.beaconEvent == BEACON_FOUND)) {
+        double ns = ThreadNs() - start;
+        matchUpdateNs += ns;
+        if (ns > matchWorstNs) matchWorstNs = ns;
+        matchUpdates++;
+    }
+    if (nowMs % SAMPLE_MS != 0) return;
+
+    ArenaPose_t truth = ArenaSim_GetPose();
+    LocPose_t pose;
+    Localizer_GetPose(&loc, &pose);
+    Sample_t sample = {
+        .timeMs = nowMs,
+        .filterMm = hypot(pose.x / MM - truth.x, pose.y / MM - truth.y) * MM,
+        .filterDeg = DegreesOff(pose.heading * M_PI / 180, truth.heading),
+        .motionMm = hypot(motion.x - truth.x, motion.y - truth.y) * MM,
+        .motionDeg = DegreesOff(motion.heading, truth.heading),
+        .spreadMm = pose.spread,
+    };
+    Append(&matchSamples, &sample);
+}
+
+static void *RunWorker(void *arg) {
+    int match;
+
+    HostMatch_Select(arg);
+    while ((match = __atomic_fetch_add(&nextMatch, 1, __ATOMIC_RELAXED)) < numMatches) {
+        ArenaConfig_t config;
+        LocMap_t map;
+        LocPose_t start;
+
+        ArenaSim_RandomConfig(&config, baseSeed + match);
+        MapFromConfig(&config, &map);
+        start.x = lround(config.start.x * MM);
+        start.y = lround(config.start.y * MM);
+        start.heading = lround(config.start.heading * 180 / M_PI);
+        start.spread = 50;
+        matchSamples.count = 0;
+        matchUpdateNs = matchWorstNs = 0;
+        matchUpdates = 0;
+        motion = config.start;
+        if (HostMatch_Start(&config, NULL) != Success) continue;
+        Localizer_Start(&loc, &map, anywhere ? NULL : &start, baseSeed + match, HostSim_GetTime());
+        HostSim_SetTickHook(LocalizeTick);
+        HostSim_RunFor(matchMs);
+
+        pthread_mutex_lock(&samplesLock);
+        for (int i = 0; i < matchSamples.count; i++) Append(&samples, &matchSamples.sample[i]);
+        updateNs += matchUpdateNs;
+        numUpdates += matchUpdates;
+        if (matchWorstNs > worstUpdateNs) worstUpdateNs = matchWorstNs;
+        pthread_mutex_unlock(&samplesLock);
+    }
+    free(matchSamples.sample);
+    return NULL;
+}
+
+static void PlayMatches(void) {
+    pthread_t workers[MAX_JOBS];
+    HostMatch_t *matches = calloc(numJobs, sizeof (HostMatch_t));
+
+    if (matches == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    for (int j = 0; j < numJobs; j++) {
+        if (pthread_create(&workers[j], NULL, RunWorker, &matches[j]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (int j = 0; j < numJobs; j++) pthread_join(workers[j], NULL);
+    free(matches);
+}
+
+static int CompareFloats(const void *a, const void *b) {
+    float x = *(const float *) a, y = *(const float *) b;
+    return (x > y) - (x < y);
+}
+
+// one column of the samples taken from fromMs up to toMs, sorted, for its
+// median and 90th percentile. Returns the median
+
+static float Percentiles(size_t offset, uint32_t fromMs, uint32_t toMs, double *mean, float *ninety) {
+    float *column = malloc(samples.count * sizeof (float));
+    float median = 0;
+    double sum = 0;
+    int n = 0;
+
+    if (column == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    for (int i = 0; i < samples.count; i++) {
+        if (samples.sample[i].timeMs < fromMs || samples.sample[i].timeMs >= toMs) continue;
+        column[n] = *(const float *) ((const char *) &samples.sample[i] + offset);
+        sum += column[n++];
+    }
+    *mean = 0;
+    *ninety = 0;
+    if (n > 0) {
+        qsort(column, n, sizeof (float), CompareFloats);
+        median = column[n / 2];
+        *mean = sum / n;
+        *ninety = column[n * 9 / 10];
+    }
+    free(column);
+    return median;
+}
+
+static void PrintErrors(const char *what, const char *units, size_t offset) {
+    double mean;
+    float ninety, median = Percentiles(offset, 0, UINT32_MAX, &mean, &ninety);
+
+    printf("  %-22s mean %6.1f %s, median %6.1f %s, 90%% %6.1f %s\n", what, mean, units, median, units, ninety, units);
+}
+
+static void PrintOverTime(void) {
+    double mean;
+    float ninety;
+
+    printf("median position error over the match\n      s   filter  motor powers\n");
+    for (uint32_t from = 0; from < matchMs; from += SPAN_MS) {
+        printf("  %3u-%-3u %5.0f mm", from / 1000, (from + SPAN_MS) / 1000,
+                Percentiles(offsetof(Sample_t, filterMm), from, from + SPAN_MS, &mean, &ninety));
+        printf(" %8.0f mm\n", Percentiles(offsetof(Sample_t, motionMm), from, from + SPAN_MS, &mean, &ninety));
+    }
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:s:t:g")) != -1) {
+        switch (opt) {
+            case 'n':
+                numMatches = atoi(optarg);
+                break;
+            case 'j':
+                numJobs = atoi(optarg);
+                break;
+            case 's':
+                baseSeed = strtoull(optarg, NULL, 0);
+                break;
+            case 't':
+                matchMs = strtoul(optarg, NULL, 10);
+                break;
+            case 'g':
+                anywhere = TRUE;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n matches] [-j jobs] [-s seed] [-t match ms] [-g]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (numJobs <= 0) numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numJobs > MAX_JOBS) numJobs = MAX_JOBS;
+
+    // keep the robot's printfs out of the report
+    fflush(stdout);
+    int reportOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (reportOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+    PlayMatches();
+    fflush(stdout);
+    if (reportOut >= 0 && devNull >= 0) dup2(reportOut, STDOUT_FILENO);
+
+    if (samples.count == 0) {
+        fprintf(stderr, "no matches played\n");
+        return 1;
+    }
+    int covered = 0;
+    for (int i = 0; i < samples.count; i++) {
+        covered += samples.sample[i].filterMm <= 2 * samples.sample[i].spreadMm;
+    }
+    printf("%d matches of %.0f s, %d particles in %d bytes, started %s\n", numMatches, matchMs / 1000.0,
+            LOC_NUM_PARTICLES, (int) sizeof (LocalizerContext_t), anywhere ? "anywhere" : "around the true start");
+    PrintErrors("filter position", "mm ", offsetof(Sample_t, filterMm));
+    PrintErrors("motor powers position", "mm ", offsetof(Sample_t, motionMm));
+    PrintErrors("filter heading", "deg", offsetof(Sample_t, filterDeg));
+    PrintErrors("motor powers heading", "deg", offsetof(Sample_t, motionDeg));
+    PrintErrors("filter spread", "mm ", offsetof(Sample_t, spreadMm));
+    printf("  within twice the spread %.0f%% of the time\n", 100.0 * covered / samples.count);
+    PrintOverTime();
+    printf("%.1f updates per s, %.1f us each on this host, %.1f us at worst\n",
+            numUpdates / (numMatches * matchMs / 1000.0), updateNs / numUpdates / 1000, worstUpdateNs / 1000);
+    return 0;
+}
@@ -0,0 +1,529 @@
+/*
+ * MonteCarlo.c
+ * Plays thousands of randomized matches of the robot code against ArenaSim and
+ * sums them up, so a strategy change can be judged on a success rate with an
+ * error bar instead of on one run on the field.
+ *
+ * Match i is played on ArenaSim_RandomConfig(seed + i): towers, track wire
+ * faces, start pose, sensor noise and motor mismatch all change from match to
+ * match, and the same seed always plays the same set of matches no matter how
+ * many jobs share them out.
+ *
+ * Each job is a thread with a HostMatch_t of its own, a board, a robot and an
+ * arena, that it plays its matches on one after the other. Matches are dealt
+ * out to the workers in equal blocks and a worker that runs out steals from the
+ * far end of another one's block, so a handful of long matches do not leave
+ * cores idle at the end. Everything shares one process, so a match that
+ * crashes takes the whole run down with it, rerun it with TurboHost to see why.
+ *
+ * Reported: how often the robot scored, when it first launched, launches per
+ * match, time spent in each state of SearchForTowerSubHSM,
+ * SearchForHoleSubHSM and ResolveObstacleSubHSM, rebuilt from the TR_STATE
+ * records in each match's trace, and the MatchClock phases against their time
+ * budgets, read out of the robot at the end of the match.
+ *
+ * usage: MonteCarlo [-n matches] [-j jobs] [-s seed] [-t match ms] [-c per match csv]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Trace.h"
+#include "HostSim.h"
+#include "ArenaSim.h"
+#include "HostMatch.h"
+#include "TraceTables.h"
+#include "MatchClock.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_MATCHES 1000
+#define DEFAULT_MATCH_MS 120000
+#define MAX_JOBS 256
+#define MAX_STATES 16
+#define PROGRESS_US 500000
+#define NO_TIME UINT32_MAX
+
+// the machines the state times are reported for
+static const TraceMachine_t Watched[] = {TRACE_SEARCH_FOR_TOWER, TRACE_SEARCH_FOR_HOLE, TRACE_RESOLVE_OBSTACLE};
+#define NUM_WATCHED (sizeof (Watched) / sizeof (Watched[0]))
+
+static const char *PhaseNames[NUM_MATCH_PHASES] = {"none", "acquire", "approach", "hole_search", "launch", "relocate"};
+
+typedef struct {
+    uint8_t done;
+    uint8_t failed; // the framework did not start, nothing else is filled in
+    int launches;
+    int scored;
+    uint32_t firstLaunchMs;
+    uint32_t firstScoreMs;
+    uint32_t busyMs;
+    uint32_t dwellMs[NUM_WATCHED][MAX_STATES];
+    MatchPhaseStats_t phase[NUM_MATCH_PHASES];
+} MatchResult_t;
+
+// one worker's block of matches, [head, tail) still to play. The owner takes
+// from the tail and thieves from the head
+typedef struct {
+    char lock;
+    int head, tail;
+    int played, stolen;
+} WorkQueue_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int numMatches = DEFAULT_MATCHES;
+static int numJobs = 0;
+static uint64_t baseSeed = 1;
+static uint32_t matchMs = DEFAULT_MATCH_MS;
+
+// shared between every worker
+static WorkQueue_t *queues;
+static MatchResult_t *results;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Lock(WorkQueue_t *q) {
+    while (__atomic_test_and_set(&q->lock, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static void Unlock(WorkQueue_t *q) {
+    __atomic_clear(&q->lock, __ATOMIC_RELEASE);
+}
+
+// next match for a worker, its own newest first, then the oldest of somebody
+// else's. -1 once every queue is empty
+
+static int TakeMatch(int self, uint32_t *victimSeed) {
+    WorkQueue_t *q = &queues[self];
+    int match = -1;
+
+    Lock(q);
+    if (q->head < q->tail) match = --q->tail;
+    Unlock(q);
+    if (match >= 0) return match;
+
+    // start at a different victim every time so the thieves spread out
+    *victimSeed = *victimSeed * 1103515245u + 12345u;
+    int first = (*victimSeed >> 8) % numJobs;
+    for (int k = 0; k < numJobs && match < 0; k++) {
+        int victim = (first + k) % numJobs;
+        if (victim == self) continue;
+        WorkQueue_t *v = &queues[victim];
+        Lock(v);
+        if (v->head < v->tail) match = v->head++;
+        Unlock(v);
+    }
+    if (match >= 0) queues[self].stolen++;
+    return match;
+}
+
+// time in each state of the watched machines, from the TR_STATE frames the
+// robot sent out. A sub machine only counts while its parent is in the state
+// that runs it, the same as TraceDecode
+
+static int IsActive(const int *state, int machine) {
+    int parent = TraceMachines[machine].parent;
+    if (parent < 0) return TRUE;
+    return state[parent] == TraceMachines[machine].parentState && IsActive(state, parent);
+}
+
+static void AddDwell(const int *state, uint32_t fromUs, uint32_t toUs, uint64_t dwellUs[][MAX_STATES]) {
+    for (int w = 0; w < NUM_WATCHED; w++) {
+        int m = Watched[w];
+        if (state[m] >= 0 && state[m] < MAX_STATES && IsActive(state, m)) {
+            dwellUs[w][state[m]] += toUs - fromUs;
+        }
+    }
+}
+
+static void TallyStates(const uint8_t *trace, size_t len, uint32_t endUs, MatchResult_t *result) {
+    int state[NUM_TRACE_MACHINES];
+    uint64_t dwellUs[NUM_WATCHED][MAX_STATES] = {{0}};
+    uint32_t lastUs = 0;
+
+    for (int m = 0; m < NUM_TRACE_MACHINES; m++) state[m] = -1;
+
+    size_t i = 0;
+    while (i + 8 <= len) {
+        if (trace[i] != TRACE_SYNC || trace[i + 2] > TRACE_MAX_ARGS) {
+            i++;
+            continue;
+        }
+        size_t frameLen = 8 + 2 * trace[i + 2];
+        if (i + frameLen > len) break;
+        uint8_t sum = 0;
+        for (size_t k = i + 1; k < i + frameLen - 1; k++) sum += trace[k];
+        if (sum != trace[i + frameLen - 1]) {
+            i++;
+            continue;
+        }
+
+        if (trace[i + 1] == TR_STATE && trace[i + 2] >= 2) {
+            uint32_t timeUs = trace[i + 3] | trace[i + 4] << 8 | trace[i + 5] << 16 | (uint32_t) trace[i + 6] << 24;
+            int machine = (int16_t) (trace[i + 7] | trace[i + 8] << 8);
+            int newState = (int16_t) (trace[i + 9] | trace[i + 10] << 8);
+            if (machine >= 0 && machine < NUM_TRACE_MACHINES) {
+                AddDwell(state, lastUs, timeUs, dwellUs);
+                lastUs = timeUs;
+                state[machine] = newState;
+            }
+        }
+        i += frameLen;
+    }
+    AddDwell(state, lastUs, endUs, dwellUs);
+
+    for (int w = 0; w < NUM_WATCHED; w++) {
+        for (int s = 0; s < MAX_STATES; s++) {
+            result->dwellMs[w][s] = dwellUs[w][s] / 1000;
+        }
+    }
+}
+
+// plays on whatever match the worker has selected, HostMatch_Start puts it
+// back to power on first
+
+static void PlayMatch(int match, MatchResult_t *result) {
+    ArenaConfig_t config;
+    char *trace = NULL;
+    size_t traceLen = 0;
+    FILE *serialOut = open_memstream(&trace, &traceLen);
+
+    ArenaSim_RandomConfig(&config, baseSeed + match);
+    if (HostMatch_Start(&config, serialOut) != Success) {
+        fclose(serialOut);
+        free(trace);
+        result->failed = TRUE;
+        __atomic_store_n(&result->done, TRUE, __ATOMIC_RELEASE);
+        return;
+    }
+    HostSim_RunFor(matchMs);
+    fflush(serialOut);
+
+    result->launches = ArenaSim_GetNumLaunches();
+    result->firstLaunchMs = NO_TIME;
+    result->firstScoreMs = NO_TIME;
+    for (int i = 0; i < result->launches; i++) {
+        const ArenaLaunch_t *launch = ArenaSim_GetLaunch(i);
+        if (i == 0) result->firstLaunchMs = launch->timeMs;
+        if (launch->scored) {
+            if (result->scored == 0) result->firstScoreMs = launch->timeMs;
+            result->scored++;
+        }
+    }
+    result->busyMs = HostSim_GetBusyMs();
+    for (int p = 0; p < NUM_MATCH_PHASES; p++) MatchClock_GetStats(p, &result->phase[p]);
+    TallyStates((uint8_t *) trace, traceLen, HostSim_GetTime() * 1000, result);
+    fclose(serialOut);
+    free(trace);
+    __atomic_store_n(&result->done, TRUE, __ATOMIC_RELEASE);
+}
+
+static void *RunWorker(void *arg) {
+    int self = (int) (intptr_t) arg;
+    uint32_t victimSeed = self + 1;
+    HostMatch_t *match = malloc(sizeof (HostMatch_t));
+    int next;
+
+    if (match == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    HostMatch_Select(match);
+    while ((next = TakeMatch(self, &victimSeed)) >= 0) {
+        PlayMatch(next, &results[next]);
+        queues[self].played++;
+    }
+    free(match);
+    return NULL;
+}
+
+static int MatchesDone(void) {
+    int done = 0;
+    for (int i = 0; i < numMatches; i++) {
+        done += __atomic_load_n(&results[i].done, __ATOMIC_ACQUIRE);
+    }
+    return done;
+}
+
+static int CompareTimes(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Wilson score interval, stays sensible at 0% and 100%
+
+static void Wilson(int hits, int n, double *low, double *high) {
+    double z = 1.96;
+    if (n == 0) {
+        *low = *high = 0;
+        return;
+    }
+    double p = (double) hits / n;
+    double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+    double half = z * sqrt(p * (1 - p) / n + z * z / (4.0 * n * n)) / (1 + z * z / n);
+    *low = center - half;
+    *high = center + half;
+}
+
+static void PrintTimes(const char *what, uint32_t *times, int n) {
+    if (n == 0) {
+        printf("%-22s never\n", what);
+        return;
+    }
+    double sum = 0;
+    for (int i = 0; i < n; i++) sum += times[i];
+    qsort(times, n, sizeof (times[0]), CompareTimes);
+    printf("%-22s mean %.1f s, median %.1f s, 10%% %.1f s, 90%% %.1f s (%d matches)\n", what,
+            sum / n / 1000, times[n / 2] / 1000.0, times[n / 10] / 1000.0, times[n * 9 / 10] / 1000.0, n);
+}
+
+// each MatchClock phase against its budget: time and visits per match, the
+// longest visit in nine matches out of ten, and how many visits ran over. The
+// hole search budget is for a whole visit to a tower, so its longest visit
+// can stay under it while the visits still run over
+
+static void PrintPhases(int played) {
+    uint32_t *longest = calloc(numMatches, sizeof (uint32_t));
+
+    printf("\n  %-12s %8s %12s %8s %11s %12s %11s\n", "phase", "budget s", "s per match", "visits",
+            "s per visit", "longest 90%", "over budget");
+    for (int p = 1; p < NUM_MATCH_PHASES; p++) { // PHASE_NONE has no budget
+        double totalMs = 0, visits = 0, exceeded = 0;
+        int n = 0;
+        for (int i = 0; i < numMatches; i++) {
+            const MatchPhaseStats_t *s = &results[i].phase[p];
+            if (results[i].failed) continue;
+            totalMs += s->totalMs;
+            visits += s->visits;
+            exceeded += s->exceeded;
+            if (s->visits > 0) longest[n++] = s->longestMs;
+        }
+        qsort(longest, n, sizeof (longest[0]), CompareTimes);
+        printf("  %-12s %8.1f %12.2f %8.2f %11.2f %12.1f %10.1f%%\n", PhaseNames[p], MatchClock_Budget(p) / 1000.0,
+                totalMs / played / 1000, visits / played, visits > 0 ? totalMs / visits / 1000 : 0.0,
+                n > 0 ? longest[n * 9 / 10] / 1000.0 : 0.0, visits > 0 ? 100 * exceeded / visits : 0.0);
+    }
+    free(longest);
+}
+
+static void PrintReport(double wallSeconds) {
+    int played = 0, failed = 0, scoredMatches = 0, launchedMatches = 0, busyMatches = 0;
+    double launchSum = 0, launchSquares = 0;
+    uint32_t *firstLaunch = calloc(numMatches, sizeof (uint32_t));
+    uint32_t *firstScore = calloc(numMatches, sizeof (uint32_t));
+    int numFirstLaunch = 0, numFirstScore = 0;
+    double dwellSum[NUM_WATCHED][MAX_STATES] = {{0}};
+
+    for (int i = 0; i < numMatches; i++) {
+        const MatchResult_t *r = &results[i];
+        if (r->failed) {
+            failed++;
+            continue;
+        }
+        played++;
+        launchSum += r->launches;
+        launchSquares += r->launches * r->launches;
+        if (r->launches > 0) {
+            launchedMatches++;
+            firstLaunch[numFirstLaunch++] = r->firstLaunchMs;
+        }
+        if (r->scored > 0) {
+            scoredMatches++;
+            firstScore[numFirstScore++] = r->firstScoreMs;
+        }
+        if (r->busyMs > 0) busyMatches++;
+        for (int w = 0; w < NUM_WATCHED; w++) {
+            for (int s = 0; s < MAX_STATES; s++) dwellSum[w][s] += r->dwellMs[w][s];
+        }
+    }
+
+    int stolen = 0;
+    for (int j = 0; j < numJobs; j++) stolen += queues[j].stolen;
+
+    printf("\n%d matches of %.0f s in %.1f s on %d jobs: %.1f matches/s, %d stolen\n", numMatches,
+            matchMs / 1000.0, wallSeconds, numJobs, numMatches / wallSeconds, stolen);
+    if (failed > 0) {
+        printf("%d matches did not start, left out below:", failed);
+        for (int i = 0, shown = 0; i < numMatches && shown < 10; i++) {
+            if (results[i].failed) {
+                printf(" %d", i);
+                shown++;
+            }
+        }
+        printf("\n");
+    }
+    if (busyMatches > 0) {
+        printf("%d matches had a machine or checker that never settled, see HostSim_GetBusyMs\n", busyMatches);
+    }
+    if (played == 0) {
+        free(firstLaunch);
+        free(firstScore);
+        return;
+    }
+
+    double low, high;
+    Wilson(scoredMatches, played, &low, &high);
+    printf("scored                 %d of %d, %.1f%% (95%% %.1f%% to %.1f%%)\n", scoredMatches, played,
+            100.0 * scoredMatches / played, 100 * low, 100 * high);
+    Wilson(launchedMatches, played, &low, &high);
+    printf("launched               %d of %d, %.1f%% (95%% %.1f%% to %.1f%%)\n", launchedMatches, played,
+            100.0 * launchedMatches / played, 100 * low, 100 * high);
+    double mean = launchSum / played;
+    printf("launches per match     mean %.2f, sd %.2f\n", mean, sqrt(fmax(launchSquares / played - mean * mean, 0)));
+    PrintTimes("time to first launch", firstLaunch, numFirstLaunch);
+    PrintTimes("time to first score", firstScore, numFirstScore);
+
+    for (int w = 0; w < NUM_WATCHED; w++) {
+        const TraceMachineInfo_t *info = &TraceMachines[Watched[w]];
+        printf("\n  %-20s %12s %8s\n", info->name, "s per match", "share");
+        for (int s = 1; s < info->numStates && s < MAX_STATES; s++) { // 0 is the init pseudo state
+            printf("  %-20s %12.2f %7.1f%%\n", info->states[s], dwellSum[w][s] / played / 1000,
+                    100 * dwellSum[w][s] / played / matchMs);
+        }
+    }
+    PrintPhases(played);
+    free(firstLaunch);
+    free(firstScore);
+}
+
+static void WriteCsv(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "match,seed,failed,launches,scored,first_launch_ms,first_score_ms");
+    for (int w = 0; w < NUM_WATCHED; w++) {
+        const TraceMachineInfo_t *info = &TraceMachines[Watched[w]];
+        for (int s = 1; s < info->numStates && s < MAX_STATES; s++) {
+            fprintf(f, ",%s.%s_ms", info->name, info->states[s]);
+        }
+    }
+    for (int p = 1; p < NUM_MATCH_PHASES; p++) {
+        fprintf(f, ",%s_ms,%s_visits,%s_over", PhaseNames[p], PhaseNames[p], PhaseNames[p]);
+    }
+    fprintf(f, "\n");
+
+    for (int i = 0; i < numMatches; i++) {
+        const MatchResult_t *r = &results[i];
+        fprintf(f, "%d,%llu,%d,%d,%d,", i, (unsigned long long) (baseSeed + i), r->failed, r->launches, r->scored);
+        if (r->firstLaunchMs != NO_TIME && r->launches > 0) fprintf(f, "%lu", (unsigned long) r->firstLaunchMs);
+        fprintf(f, ",");
+        if (r->firstScoreMs != NO_TIME && r->scored > 0) fprintf(f, "%lu", (unsigned long) r->firstScoreMs);
+        for (int w = 0; w < NUM_WATCHED; w++) {
+            const TraceMachineInfo_t *info = &TraceMachines[Watched[w]];
+            for (int s = 1; s < info->numStates && s < MAX_STATES; s++) {
+                fprintf(f, ",%lu", (unsigned long) r->dwellMs[w][s]);
+            }
+        }
+        for (int p = 1; p < NUM_MATCH_PHASES; p++) {
+            fprintf(f, ",%lu,%u,%u", (unsigned long) r->phase[p].totalMs, r->phase[p].visits, r->phase[p].exceeded);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *csvPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:s:t:c:")) != -1) {
+        switch (opt) {
+            case 'n':
+                numMatches = atoi(optarg);
+                break;
+            case 'j':
+                numJobs = atoi(optarg);
+                break;
+            case 's':
+                baseSeed = strtoull(optarg, NULL, 0);
+                break;
+            case 't':
+                matchMs = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                csvPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n matches] [-j jobs] [-s seed] [-t match ms] [-c per match csv]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (numMatches <= 0) return 0;
+    if (numJobs <= 0) numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numJobs > MAX_JOBS) numJobs = MAX_JOBS;
+    if (numJobs > numMatches) numJobs = numMatches;
+
+    queues = calloc(numJobs, sizeof (WorkQueue_t));
+    results = calloc(numMatches, sizeof (MatchResult_t));
+    if (queues == NULL || results == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    for (int j = 0; j < numJobs; j++) {
+        queues[j].head = (long) numMatches * j / numJobs;
+        queues[j].tail = (long) numMatches * (j + 1) / numJobs;
+    }
+
+    // the robot's printfs go to stdout, keep them out of the report
+    fflush(stdout);
+    int reportOut = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (reportOut >= 0 && devNull >= 0) dup2(devNull, STDOUT_FILENO);
+
+    pthread_t workers[MAX_JOBS];
+    double start = NowSeconds();
+    for (int j = 0; j < numJobs; j++) {
+        if (pthread_create(&workers[j], NULL, RunWorker, (void *) (intptr_t) j) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    int done;
+    do {
+        done = MatchesDone();
+        double elapsed = NowSeconds() - start;
+        fprintf(stderr, "\r%d/%d matches, %.1f matches/s ", done, numMatches, elapsed > 0 ? done / elapsed : 0.0);
+        if (done < numMatches) usleep(PROGRESS_US);
+    } while (done < numMatches);
+    fprintf(stderr, "\n");
+    for (int j = 0; j < numJobs; j++) pthread_join(workers[j], NULL);
+
+    fflush(stdout);
+    if (reportOut >= 0 && devNull >= 0) dup2(reportOut, STDOUT_FILENO);
+
+    PrintReport(NowSeconds() - start);
+    if (csvPath != NULL) WriteCsv(csvPath);
+    return 0;
+}
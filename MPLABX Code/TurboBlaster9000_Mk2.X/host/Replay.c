@@ -0,0 +1,358 @@
+/*
+ * Replay.c
+ * Plays a run recorded on the robot back through the robot code on the host,
+ * so whatever went wrong on the field can be reproduced and stepped through.
+ *
+ * The capture is the robot's serial output with USE_SENSOR_RECORDER on, see
+ * SensorRecorder.h. Every TR_REC_ record in it is put back on the simulated
+ * board's pins at the time it was read, lined up so the robot's first state
+ * transition happens at the same point in the run as it did on the field.
+ * Nothing else drives the sensors. Afterwards the state transitions, motor
+ * commands and flywheel commands the replay produced are compared, in order,
+ * with the ones in the capture, and the first place they part ways is shown.
+ *
+ * The host clock ticks in milliseconds, so a reading is applied on the first
+ * tick at or after the time it was recorded. Everything in the robot code
+ * times itself in milliseconds too, so that is all the timing a replay needs.
+ * The analog pins were only sampled every SENSOR_RECORD_MS though, and the
+ * robot may have seen a change up to that much sooner than the recording
+ * shows it, so outputs are allowed to come that much late by default.
+ *
+ * A capture holds one run per robot reset, -r picks which (from 1). Exits 0 when
+ * the replay matched the capture, 1 when it did not or the capture is unusable.
+ *
+ * usage: Replay [-r run] [-t tolerance ms] [-n lines] [-s replay capture] <capture>
+ * the replay capture is the replay's own serial output, feed it to TraceDecode
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Global_Macros.h"
+#include "Trace.h"
+#include "SensorRecorder.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostMatch.h"
+#include "TraceTables.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_TOLERANCE_MS SENSOR_RECORD_MS
+#define DEFAULT_LINES 10
+#define FRAME_HEADER 7 // sync, id, nargs and the 4 byte time
+#define TAIL_MS 100 // keeps running a little past the last record
+
+typedef struct {
+    uint32_t timeUs;
+    uint8_t id;
+    int16_t arg[TRACE_MAX_ARGS];
+} Record_t;
+
+typedef struct {
+    Record_t *record;
+    int count;
+    int capacity;
+} RecordList_t;
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static const SensorRecorderGroup_t Groups[NUM_RECORDED_GROUPS] = SENSOR_RECORDER_GROUPS;
+
+static HostMatch_t match;
+
+// the recorded readings still to be put on the pins
+static RecordList_t inputs;
+static int nextInput;
+static uint32_t offsetUs; // capture time of the robot's first transition
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static void Add(RecordList_t *list, const Record_t *r) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 1024;
+        list->record = realloc(list->record, list->capacity * sizeof (Record_t));
+        if (list->record == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    list->record[list->count++] = *r;
+}
+
+static uint8_t IsInput(uint8_t id) {
+    return id == TR_REC_TAPE_FRONT || id == TR_REC_TAPE_BACK || id == TR_REC_ANALOG || id == TR_REC_DIGITAL;
+}
+
+static uint8_t IsOutput(uint8_t id) {
+    return id == TR_STATE || id == TR_MOTORS || id == TR_FLYWHEEL;
+}
+
+// sorts the frames of one run of a capture into inputs and outputs, runs are
+// told apart by the clock going backwards. Returns the number of records
+// dropped on the robot in that run
+
+static int ReadRun(const uint8_t *data, size_t len, int wanted, RecordList_t *in, RecordList_t *out) {
+    int run = 1, dropped = 0, started = FALSE;
+    uint32_t lastUs = 0;
+    size_t i = 0;
+
+    while (i + FRAME_HEADER + 1 <= len) {
+        if (data[i] != TRACE_SYNC || data[i + 1] >= NUM_TRACE_FORMATS || data[i + 2] > TRACE_MAX_ARGS) {
+            i++;
+            continue;
+        }
+        size_t frameLen = FRAME_HEADER + 2 * data[i + 2] + 1;
+        if (i + frameLen > len) break;
+        uint8_t sum = 0;
+        for (size_t k = i + 1; k < i + frameLen - 1; k++) sum += data[k];
+        if (sum != data[i + frameLen - 1]) {
+            i++;
+            continue;
+        }
+
+        Record_t r = {0};
+        r.id = data[i + 1];
+        r.timeUs = data[i + 3] | data[i + 4] << 8 | data[i + 5] << 16 | (uint32_t) data[i + 6] << 24;
+        for (int a = 0; a < data[i + 2]; a++) {
+            r.arg[a] = (int16_t) (data[i + FRAME_HEADER + 2 * a] | data[i + FRAME_HEADER + 2 * a + 1] << 8);
+        }
+        i += frameLen;
+
+        if (started && r.timeUs < lastUs) run++;
+        started = TRUE;
+        lastUs = r.timeUs;
+        if (run != wanted) continue;
+
+        if (r.id == TR_DROPPED) dropped += r.arg[0];
+        if (IsInput(r.id)) Add(in, &r);
+        if (IsOutput(r.id)) Add(out, &r);
+    }
+    return dropped;
+}
+
+static uint8_t *ReadFile(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+    size_t size = 0, capacity = 0, n;
+
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    do {
+        if (size == capacity) {
+            capacity = capacity ? 2 * capacity : 65536;
+            data = realloc(data, capacity);
+            if (data == NULL) {
+                perror("realloc");
+                exit(1);
+            }
+        }
+        n = fread(data + size, 1, capacity - size, f);
+        size += n;
+    } while (n > 0);
+    fclose(f);
+    *len = size;
+    return data;
+}
+
+static void ApplyInput(const Record_t *r) {
+    if (r->id == TR_REC_DIGITAL) {
+        HostHAL_SetPortInputs(BUMPER_PORT, RECORDED_BUMPER_PINS & ~r->arg[0], FALSE);
+        HostHAL_SetPortInputs(BUMPER_PORT, RECORDED_BUMPER_PINS & r->arg[0], TRUE);
+        HostHAL_SetPortInputs(BEACON_PORT, BEACON_D_PIN, r->arg[1] != 0);
+        HostHAL_SetPortInputs(PING_PORT, ECHO_PIN, r->arg[2] != 0);
+        return;
+    }
+    for (int g = 0; g < NUM_RECORDED_GROUPS; g++) {
+        if (Groups[g].id == r->id) {
+            for (int p = 0; p < 3; p++) HostHAL_SetAD(Groups[g].pin[p], (uint16_t) r->arg[p]);
+        }
+    }
+}
+
+// puts every reading that is due on the pins, as the HostSim tick hook
+
+static void ReplayTick(uint32_t nowMs) {
+    while (nextInput < inputs.count
+            && (int64_t) inputs.record[nextInput].timeUs - offsetUs <= (int64_t) nowMs * 1000) {
+        ApplyInput(&inputs.record[nextInput++]);
+    }
+}
+
+static uint8_t SameOutput(const Record_t *a, const Record_t *b) {
+    int nargs = a->id == TR_FLYWHEEL ? 1 : 2;
+    if (a->id != b->id) return FALSE;
+    for (int i = 0; i < nargs; i++) {
+        if (a->arg[i] != b->arg[i]) return FALSE;
+    }
+    return TRUE;
+}
+
+static const char *Describe(const Record_t *r) {
+    static char text[96];
+    int machine = r->arg[0], state = r->arg[1];
+
+    switch (r->id) {
+        case TR_STATE:
+            if (machine >= 0 && machine < TraceNumMachines && state >= 0 && state < TraceMachines[machine].numStates) {
+                snprintf(text, sizeof (text), "%s enters %s", TraceMachines[machine].name,
+                        TraceMachines[machine].states[state]);
+            } else {
+                snprintf(text, sizeof (text), "machine %d enters state %d", machine, state);
+            }
+            break;
+        case TR_MOTORS:
+            snprintf(text, sizeof (text), "motors L %d R %d", r->arg[0], r->arg[1]);
+            break;
+        default:
+            snprintf(text, sizeof (text), "flywheel %d", r->arg[0]);
+            break;
+    }
+    return text;
+}
+
+static void PrintSide(const char *side, const RecordList_t *list, int from, int lines, uint32_t shiftUs) {
+    printf("  %s:\n", side);
+    for (int i = from; i < list->count && i < from + lines; i++) {
+        printf("    %9.3f s  %s\n", ((int64_t) list->record[i].timeUs - shiftUs) / 1e6, Describe(&list->record[i]));
+    }
+    if (from >= list->count) printf("    (nothing more)\n");
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    int wantedRun = 1;
+    double toleranceMs = DEFAULT_TOLERANCE_MS;
+    int lines = DEFAULT_LINES;
+    FILE *replayCapture = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:t:n:s:")) != -1) {
+        switch (opt) {
+            case 'r':
+                wantedRun = atoi(optarg);
+                break;
+            case 't':
+                toleranceMs = atof(optarg);
+                break;
+            case 'n':
+                lines = atoi(optarg);
+                break;
+            case 's':
+                replayCapture = fopen(optarg, "wb");
+                if (replayCapture == NULL) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-r run] [-t tolerance ms] [-n lines] [-s replay capture] <capture>\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-r run] [-t tolerance ms] [-n lines] [-s replay capture] <capture>\n", argv[0]);
+        return 1;
+    }
+
+    size_t len;
+    uint8_t *capture = ReadFile(argv[optind], &len);
+    if (capture == NULL) return 1;
+
+    RecordList_t recorded = {0};
+    int dropped = ReadRun(capture, len, wantedRun, &inputs, &recorded);
+    free(capture);
+    if (inputs.count == 0) {
+        fprintf(stderr, "run %d has no sensor records, was USE_SENSOR_RECORDER on?\n", wantedRun);
+        return 1;
+    }
+    int first = 0;
+    while (first < recorded.count && recorded.record[first].id != TR_STATE) first++;
+    if (first == recorded.count) {
+        fprintf(stderr, "run %d has no state transitions to line the replay up with\n", wantedRun);
+        return 1;
+    }
+    if (dropped > 0) {
+        printf("the robot dropped %d trace records in this run, the replay is missing whatever was in them\n", dropped);
+    }
+
+    // the recorded outputs from the first transition on, that is where the replay starts too
+    offsetUs = recorded.record[first].timeUs;
+    uint32_t endUs = inputs.record[inputs.count - 1].timeUs;
+    if (recorded.record[recorded.count - 1].timeUs > endUs) endUs = recorded.record[recorded.count - 1].timeUs;
+    uint32_t runMs = (endUs - offsetUs) / 1000 + TAIL_MS;
+
+    char *trace = NULL;
+    size_t traceLen = 0;
+    FILE *serialOut = open_memstream(&trace, &traceLen);
+
+    HostMatch_Select(&match);
+    ES_Return_t ErrorType = HostMatch_Start(NULL, serialOut);
+    if (ErrorType != Success) {
+        printf("ES_Initialize failed: %d\r\n", ErrorType);
+        return 1;
+    }
+    nextInput = 0;
+    ReplayTick(0); // everything read before the first transition
+    HostSim_SetTickHook(ReplayTick);
+
+    clock_t start = clock();
+    HostSim_RunFor(runMs);
+    double wall = (double) (clock() - start) / CLOCKS_PER_SEC;
+    fflush(serialOut);
+    if (replayCapture != NULL) {
+        fwrite(trace, 1, traceLen, replayCapture);
+        fclose(replayCapture);
+    }
+
+    RecordList_t ignored = {0}, replayed = {0};
+    ReadRun((uint8_t *) trace, traceLen, 1, &ignored, &replayed);
+
+    // in order, for as far as the two agree
+    int n = recorded.count - first < replayed.count ? recorded.count - first : replayed.count;
+    int same = 0, late = 0;
+    double worstMs = 0;
+    while (same < n && SameOutput(&recorded.record[first + same], &replayed.record[same])) {
+        double dt = fabs(((int64_t) replayed.record[same].timeUs
+                - ((int64_t) recorded.record[first + same].timeUs - offsetUs)) / 1000.0);
+        if (dt > toleranceMs) late++;
+        if (dt > worstMs) worstMs = dt;
+        same++;
+    }
+
+    printf("replayed %.1f s of run %d in %.3f s of CPU (%.0fx real time), %d sensor records\n", runMs / 1000.0,
+            wantedRun, wall, wall > 0 ? runMs / 1000.0 / wall : 0.0, inputs.count);
+    printf("%d of %d recorded outputs replayed the same, %d more than %.1f ms off (worst %.1f ms), %d replayed in all\n",
+            same, recorded.count - first, late, toleranceMs, worstMs, replayed.count);
+
+    uint8_t matched = same == recorded.count - first && same == replayed.count && late == 0;
+    if (same < recorded.count - first || same < replayed.count) {
+        double atUs = same < replayed.count ? replayed.record[same].timeUs
+                : (int64_t) recorded.record[first + same].timeUs - offsetUs;
+        printf("first difference at %.3f s:\n", atUs / 1e6);
+        PrintSide("recorded", &recorded, first + same, lines, offsetUs);
+        PrintSide("replayed", &replayed, same, lines, 0);
+    }
+
+    fclose(serialOut);
+    free(trace);
+    return matched ? 0 : 1;
+}
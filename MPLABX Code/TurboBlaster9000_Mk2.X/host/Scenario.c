@@ -0,0 +1,625 @@
+/*
+ * Scenario.c
+ * Golden trace checks for the sub HSMs. Each scenario drives one of
+ * SearchForTower, SearchForHole, ResolveObstacle or FindNewTower on its own,
+ * with a scripted list of events and sensor readings, writes down everything
+ * the machine did (state changes, motor, flywheel and ball servo commands, the
+ * timers it armed and stopped, its trace messages and the events it passed back
+ * up) and compares that with the golden trace stored next to the script. A change to
+ * a machine that was only meant to make it faster has to leave every golden
+ * trace as it was.
+ *
+ * A scenario is scenarios/<name>.scn, its golden trace scenarios/<name>.golden.
+ * Script lines, # starts a comment:
+ *   ad <pin> <value>          what AD_ReadADPin returns for FL_TAPE, FR_TAPE,
+ *                             BL_TAPE, BR_TAPE, CL_TAPE, CR_TAPE, S_TAPE, BEACON
+ *                             or TW, the tape checker's debounced state
+ *                             following it
+ *   bumpers [FL] [FR] [BL] [BR]   the bumpers held down, none if left empty
+ *   start <machine>           resets the machine and runs its Init, machines
+ *                             named as in TraceFormats.h without SubHSM.c
+ *   event <event> [param]     hands the machine an event, the param can be a
+ *                             number or names like FL_TAPE_BIT|FR_TAPE_BIT
+ *   queue <event> [param]     posts an event to RobotHSM, where it waits behind
+ *                             the next event the script hands the machine, the
+ *                             way a timeout that expired waits in the queue
+ *   wait <ms>                 lets the clock run, timeouts, the events the
+ *                             machine posts to RobotHSM and the BUDGET_EXCEEDED
+ *                             MatchClockCheck posts go to the machine
+ *   tunable <name> <value>    sets one of the TUNABLE constants for the rest of
+ *                             the scenario
+ *   plan arrive|launched|giveup   tells the TowerPlanner FindNewTower picks from
+ *                             what RobotHSM would: bumped into a tower,
+ *                             launched at it, or gave up on it. An arrival
+ *                             arrives in TowerMemory too, as RobotHSM does
+ *
+ * Events reach the machine the way RobotHSM would hand them down, stale
+ * timeouts dropped, and everything the machine posts to RobotHSM is handed
+ * to it too before the next script line. Starting SearchForHole is the bump
+ * into the tower: the planner and TowerMemory hear of the arrival and the
+ * match clock's visit to the tower starts, as RobotHSM would have it.
+ *
+ * usage: Scenario [-u] [-d dir] [scenario ...]
+ * with no scenarios named every .scn in the directory (scenarios by default)
+ * is run. -u writes the golden traces from what the machines did instead of
+ * checking them. The exit status is 1 if any scenario differs from its golden
+ * trace.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BOARD.h"
+#include "RC_Servo.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Global_Macros.h"
+#include "Trace.h"
+#include "StateTimers.h"
+#include "SearchForTowerSubHSM.h"
+#include "SearchForHoleSubHSM.h"
+#include "FindNewTowerSubHSM.h"
+#include "ResolveObstacleSubHSM.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#include "HostMatch.h"
+#include "RobotContext.h"
+#include "TunableParams.h"
+#include "TraceTables.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_DIR "scenarios"
+#define MAX_LINE 256
+#define MAX_PATH 512
+#define MAX_SCENARIOS 256
+#define MAX_DIFF_LINES 8
+
+#define TRACE_FORMAT(id, text) text,
+static const char *FormatText[NUM_TRACE_FORMATS] = {
+    TRACE_FORMAT_LIST
+};
+#undef TRACE_FORMAT
+
+typedef struct {
+    const char *name;
+    unsigned int value;
+} Named_t;
+
+#define NO_MACHINE -1
+#define SERVO_RC_PIN RC_PORTX04 // what setServoPos in Motor_Control.c drives
+#define MAX_ARGS 8
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static const Named_t ADPins[] = {
+    {"FL_TAPE", FL_TAPE_PIN}, {"FR_TAPE", FR_TAPE_PIN}, {"BL_TAPE", BL_TAPE_PIN}, {"BR_TAPE", BR_TAPE_PIN},
+    {"CL_TAPE", CL_TAPE_PIN}, {"CR_TAPE", CR_TAPE_PIN}, {"S_TAPE", S_TAPE_PIN}, {"BEACON", BEACON_A_PIN},
+    {"TW", TW_PIN},
+};
+
+static const Named_t Bumpers[] = {
+    {"FL", FL_BUMP_PIN}, {"FR", FR_BUMP_PIN}, {"BL", BL_BUMP_PIN}, {"BR", BR_BUMP_PIN},
+};
+
+// what an event param can be written as
+static const Named_t ParamNames[] = {
+    {"PING_HIGH_TIMER", PING_HIGH_TIMER}, {"PING_WAIT_TIMER", PING_WAIT_TIMER}, {"SAMPLE_TIMER", SAMPLE_TIMER},
+    {"TURN_TIMER", TURN_TIMER}, {"OBSTACLE_TIMER", OBSTACLE_TIMER}, {"LAUNCH_TIMER", LAUNCH_TIMER},
+    {"RESET_TIMER", RESET_TIMER},
+    {"FL_TAPE_BIT", FL_TAPE_BIT}, {"FR_TAPE_BIT", FR_TAPE_BIT}, {"BL_TAPE_BIT", BL_TAPE_BIT},
+    {"BR_TAPE_BIT", BR_TAPE_BIT}, {"CL_TAPE_BIT", CL_TAPE_BIT}, {"CR_TAPE_BIT", CR_TAPE_BIT},
+    {"S_TAPE_BIT", S_TAPE_BIT},
+    {"FL_BUMP_BIT", FL_BUMP_BIT}, {"FR_BUMP_BIT", FR_BUMP_BIT}, {"BL_BUMP_BIT", BL_BUMP_BIT},
+    {"BR_BUMP_BIT", BR_BUMP_BIT},
+};
+
+#define NUM_NAMED(table) (sizeof (table) / sizeof (table[0]))
+
+static HostMatch_t match;
+static int machine = NO_MACHINE; // the TraceMachine_t being driven
+static FILE *out; // what the machine did
+static FILE *report;
+static unsigned short servoPulse; // the ball servo is the one output nothing traces
+static TunableParams_t params; // the defaults, as the script's tunable lines leave them
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static int FindNamed(const Named_t *table, int count, const char *name, unsigned int *value) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(table[i].name, name) == 0) {
+            *value = table[i].value;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static const char *TimerName(int timer) {
+    static char unknown[16];
+    for (int i = 0; i < NUM_NAMED(ParamNames); i++) {
+        if (strstr(ParamNames[i].name, "_TIMER") != NULL && ParamNames[i].value == timer) return ParamNames[i].name;
+    }
+    snprintf(unknown, sizeof (unknown), "%d", timer);
+    return unknown;
+}
+
+static const char *EventName(int type) {
+    static char unknown[16];
+    if (type >= 0 && type < TraceNumEvents) return TraceEventNames[type];
+    snprintf(unknown, sizeof (unknown), "event%d", type);
+    return unknown;
+}
+
+static void Log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void Log(const char *format, ...) {
+    va_list args;
+    fprintf(out, "%6lu  ", (unsigned long) HostSim_GetTime());
+    va_start(args, format);
+    vfprintf(out, format, args);
+    va_end(args);
+    fputc('\n', out);
+}
+
+// names the bits of a TAPE_CHANGE or BUMPED param, anything else is a number
+
+static void LogEvent(const char *what, ES_Event e) {
+    const char *bits = e.EventType == TAPE_CHANGE ? "_TAPE_BIT" : e.EventType == BUMPED ? "_BUMP_BIT" : NULL;
+    char param[MAX_LINE] = "";
+
+    if (e.EventType == ES_TIMEOUT) {
+        Log("%s ES_TIMEOUT %s", what, TimerName(e.EventParam));
+        return;
+    }
+    if (bits != NULL) {
+        for (int i = 0; i < NUM_NAMED(ParamNames); i++) {
+            if (strstr(ParamNames[i].name, bits) != NULL && (e.EventParam & ParamNames[i].value)) {
+                if (param[0] != '\0') strcat(param, "|");
+                strcat(param, ParamNames[i].name);
+            }
+        }
+    }
+    if (param[0] == '\0') snprintf(param, sizeof (param), "%u", e.EventParam);
+    Log("%s %s %s", what, EventName(e.EventType), param);
+}
+
+// everything the machine traced since the last call
+
+static void FlushTrace(void) {
+    TraceContext_t *trace = &ROBOT->trace;
+
+    while (trace->tail != trace->head) {
+        const TraceRecord_t *r = &trace->ring[trace->tail];
+        if (r->id == TR_STATE && r->arg[0] >= 0 && r->arg[0] < TraceNumMachines) {
+            const TraceMachineInfo_t *info = &TraceMachines[r->arg[0]];
+            if (r->arg[1] >= 0 && r->arg[1] < info->numStates) {
+                Log("%s -> %s", info->name, info->states[r->arg[1]]);
+            } else {
+                Log("%s -> state%d", info->name, r->arg[1]);
+            }
+        } else if (r->id < NUM_TRACE_FORMATS) {
+            char text[MAX_LINE];
+            snprintf(text, sizeof (text), FormatText[r->id], r->arg[0], r->arg[1], r->arg[2]);
+            Log("%s", text);
+        }
+        trace->tail = (trace->tail + 1) % TRACE_RING_SIZE;
+    }
+}
+
+// what the machine did since the last call
+
+static void FlushOutputs(void) {
+    FlushTrace();
+    if (HostHAL_GetRCPulse(SERVO_RC_PIN) != servoPulse) {
+        servoPulse = HostHAL_GetRCPulse(SERVO_RC_PIN);
+        Log("servo %u us", servoPulse);
+    }
+}
+
+static ES_Event RunMachine(ES_Event e) {
+    SearchForTowerContext_t *tower = &ROBOT->hsm.searchForTower;
+
+    switch (machine) {
+        case TRACE_SEARCH_FOR_TOWER:
+            return RunSearchForTowerSubHSM(tower, e);
+        case TRACE_SEARCH_FOR_HOLE:
+            return RunSearchForHoleSubHSM(&ROBOT->hsm.searchForHole, e);
+        case TRACE_FIND_NEW_TOWER:
+            return RunFindNewTowerSubHSM(&ROBOT->hsm.findNewTower, e);
+        case TRACE_RESOLVE_OBSTACLE:
+            return RunResolveObstacleSubHSM(&tower->resolveObstacle, e);
+    }
+    return e;
+}
+
+// the bump into a tower, the way RobotHSM tells the planner and TowerMemory
+
+static PlanArrival_t ArriveAtTower(void) {
+    TowerPlan_t *plan = &ROBOT->hsm.findNewTower.plan;
+    PlanArrival_t arrival = TowerPlanner_Arrive(plan, MatchClock_ElapsedMs());
+
+    if (arrival != PLAN_LEFT_BEHIND) {
+        TowerMemory_Arrive(&ROBOT->hsm.searchForHole.towers, plan->current, arrival == PLAN_NEW_TOWER);
+    }
+    return arrival;
+}
+
+static void InitMachine(void) {
+    SearchForTowerContext_t *tower = &ROBOT->hsm.searchForTower;
+
+    switch (machine) {
+        case TRACE_SEARCH_FOR_TOWER:
+            InitSearchForTowerSubHSM(tower);
+            break;
+        case TRACE_SEARCH_FOR_HOLE:
+            ArriveAtTower();
+            MatchClock_StartTower();
+            InitSearchForHoleSubHSM(&ROBOT->hsm.searchForHole);
+            break;
+        case TRACE_FIND_NEW_TOWER:
+            InitFindNewTowerSubHSM(&ROBOT->hsm.findNewTower);
+            break;
+        case TRACE_RESOLVE_OBSTACLE:
+            InitResolveObstacleSubHSM(&tower->resolveObstacle);
+            break;
+    }
+}
+
+// one event into the machine, the way RobotHSM hands it down
+
+static void Dispatch(ES_Event e, uint8_t scripted) {
+    if (e.EventType == ES_TIMERACTIVE) {
+        Log("timer %s armed for %lu ms", TimerName(e.EventParam),
+                (unsigned long) CurrentBoard->esTimers.timeLeft[e.EventParam]);
+    } else if (e.EventType == ES_TIMERSTOPPED) {
+        Log("timer %s stopped", TimerName(e.EventParam));
+    } else if (StateTimer_IsStale(&e)) {
+        LogEvent("stale", e);
+        return;
+    } else {
+        LogEvent(scripted ? "event" : "posted", e);
+    }
+
+    ES_Event returned = RunMachine(e);
+    FlushOutputs();
+    if (returned.EventType != ES_NO_EVENT && returned.EventType != ES_TIMERACTIVE
+            && returned.EventType != ES_TIMERSTOPPED) {
+        LogEvent("returns", returned);
+    }
+}
+
+// hands the machine everything waiting in RobotHSM's queue, and throws away
+// what was posted to anything else
+
+static void DrainQueues(void) {
+    uint8_t robot = ROBOT->hsm.MyPriority;
+
+    for (int i = 0; i < NUM_SERVICES; i++) {
+        if (i == robot) continue;
+        CurrentBoard->framework.queues[i].head = 0;
+        CurrentBoard->framework.queues[i].count = 0;
+        CurrentBoard->framework.ready &= ~(1 << i);
+    }
+    // head is always 0 here, so the events never wrap round the queue, which
+    // is sized by ES_Configure.h rather than HOST_MAX_QUEUE_SIZE
+    HostQueue_t *q = &CurrentBoard->framework.queues[robot];
+    while (q->count > 0) {
+        ES_Event waiting[HOST_MAX_QUEUE_SIZE];
+        uint8_t count = q->count;
+        memcpy(waiting, q->event, count * sizeof (waiting[0]));
+        q->head = 0;
+        q->count = 0;
+        for (uint8_t i = 0; i < count; i++) Dispatch(waiting[i], FALSE);
+    }
+    CurrentBoard->framework.ready = 0;
+}
+
+static void Start(void) {
+    params = TunableDefaults;
+    TunableParams_Select(&params);
+    HostMatch_Select(&match);
+    HostMatch_Start(NULL, NULL);
+    CurrentBoard->framework.ready = 0;
+    for (int i = 0; i < NUM_SERVICES; i++) {
+        CurrentBoard->framework.queues[i].head = 0;
+        CurrentBoard->framework.queues[i].count = 0;
+    }
+    machine = NO_MACHINE;
+    servoPulse = HostHAL_GetRCPulse(SERVO_RC_PIN);
+    CheckTapeSensors();
+}
+
+static unsigned int ParseParam(char *text, int line, const char *path) {
+    unsigned int value = 0;
+
+    for (char *part = strtok(text, "|"); part != NULL; part = strtok(NULL, "|")) {
+        unsigned int v;
+        char *end;
+        if (FindNamed(ParamNames, NUM_NAMED(ParamNames), part, &v)) {
+            value |= v;
+        } else {
+            v = strtoul(part, &end, 0);
+            if (*end != '\0') {
+                fprintf(report, "%s:%d: no param %s\n", path, line, part);
+                exit(2);
+            }
+            value |= v;
+        }
+    }
+    return value;
+}
+
+static void Fail(const char *path, int line, const char *what) {
+    fprintf(report, "%s:%d: %s\n", path, line, what);
+    exit(2);
+}
+
+// runs the script, everything the machine did goes to out
+
+static void RunScript(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[MAX_LINE];
+    int lineNum = 0;
+
+    if (f == NULL) {
+        fprintf(report, "cannot open %s\n", path);
+        exit(2);
+    }
+    Start();
+    while (fgets(line, sizeof (line), f) != NULL) {
+        lineNum++;
+        char *hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+        char *arg[MAX_ARGS];
+        int numArgs = 0;
+        for (char *word = strtok(line, " \t\r\n"); word != NULL && numArgs < MAX_ARGS; word = strtok(NULL, " \t\r\n")) {
+            arg[numArgs++] = word;
+        }
+        if (numArgs == 0) continue;
+        char *cmd = arg[0];
+        char *arg1 = numArgs > 1 ? arg[1] : NULL;
+        char *arg2 = numArgs > 2 ? arg[2] : NULL;
+
+        if (strcmp(cmd, "ad") == 0) {
+            unsigned int pin;
+            if (arg1 == NULL || arg2 == NULL || !FindNamed(ADPins, NUM_NAMED(ADPins), arg1, &pin)) {
+                Fail(path, lineNum, "usage: ad <pin> <value>");
+            }
+            HostHAL_SetAD(pin, strtoul(arg2, NULL, 0));
+            // only to keep the state ObstacleEscape reads, TAPE_CHANGE is
+            // scripted and without BOTT_TAPE_ACTIVE the checker posts nothing
+            CheckTapeSensors();
+            Log("set %s to %s", arg1, arg2);
+        } else if (strcmp(cmd, "bumpers") == 0) {
+            unsigned short held = 0;
+            char names[MAX_LINE] = "";
+            for (int i = 1; i < numArgs; i++) {
+                unsigned int pin;
+                if (!FindNamed(Bumpers, NUM_NAMED(Bumpers), arg[i], &pin)) Fail(path, lineNum, "bumpers are FL FR BL BR");
+                held |= pin;
+                strcat(names, " ");
+                strcat(names, arg[i]);
+            }
+            // pulled up, a pressed bumper reads low
+            HostHAL_SetPortInputs(BUMPER_PORT, FL_BUMP_PIN | FR_BUMP_PIN | BL_BUMP_PIN | BR_BUMP_PIN, TRUE);
+            if (held) HostHAL_SetPortInputs(BUMPER_PORT, held, FALSE);
+            Log("bumpers held:%s", held ? names : " none");
+        } else if (strcmp(cmd, "start") == 0) {
+            machine = NO_MACHINE;
+            for (int m = 0; m < TraceNumMachines && arg1 != NULL; m++) {
+                char name[MAX_LINE];
+                snprintf(name, sizeof (name), "%sSubHSM", arg1);
+                if (strcmp(TraceMachines[m].name, name) == 0 && m != TRACE_ROBOT_HSM) machine = m;
+            }
+            if (machine == NO_MACHINE) Fail(path, lineNum, "start SearchForTower, SearchForHole, ResolveObstacle or FindNewTower");
+            Log("start %s", TraceMachines[machine].name);
+            InitMachine();
+            FlushOutputs();
+            DrainQueues();
+        } else if (strcmp(cmd, "event") == 0 || strcmp(cmd, "queue") == 0) {
+            ES_Event e = {ES_NO_EVENT, 0};
+            int type;
+            if (machine == NO_MACHINE) Fail(path, lineNum, "event before start");
+            for (type = 0; arg1 != NULL && type < TraceNumEvents; type++) {
+                if (strcmp(TraceEventNames[type], arg1) == 0) break;
+            }
+            if (arg1 == NULL || type == TraceNumEvents) Fail(path, lineNum, "no such event");
+            e.EventType = type;
+            if (arg2 != NULL) e.EventParam = ParseParam(arg2, lineNum, path);
+            if (strcmp(cmd, "queue") == 0) {
+                LogEvent("queued", e);
+                PostRobotHSM(e);
+                continue;
+            }
+            Dispatch(e, TRUE);
+            DrainQueues();
+        } else if (strcmp(cmd, "wait") == 0) {
+            if (machine == NO_MACHINE) Fail(path, lineNum, "wait before start");
+            if (arg1 == NULL) Fail(path, lineNum, "usage: wait <ms>");
+            for (unsigned long ms = strtoul(arg1, NULL, 0); ms > 0; ms--) {
+                HostSim_Tick(FALSE);
+                MatchClockCheck();
+                DrainQueues();
+            }
+        } else if (strcmp(cmd, "tunable") == 0) {
+            int p;
+            for (p = 0; arg1 != NULL && p < NUM_TUNABLE_PARAMS; p++) {
+                if (strcmp(TunableParamInfo[p].name, arg1) == 0) break;
+            }
+            if (arg1 == NULL || arg2 == NULL || p == NUM_TUNABLE_PARAMS) Fail(path, lineNum, "usage: tunable <name> <value>");
+            params.param[p] = strtol(arg2, NULL, 0);
+            Log("set %s to %s", arg1, arg2);
+        } else if (strcmp(cmd, "plan") == 0) {
+            TowerPlan_t *plan = &ROBOT->hsm.findNewTower.plan;
+            const char *outcome = "";
+            if (arg1 != NULL && strcmp(arg1, "arrive") == 0) {
+                PlanArrival_t arrival = ArriveAtTower();
+                outcome = arrival == PLAN_LEFT_BEHIND ? " the one it just left" : arrival == PLAN_NEW_TOWER ? " new" : " known";
+            } else if (arg1 != NULL && strcmp(arg1, "launched") == 0) {
+                TowerPlanner_Launched(plan);
+            } else if (arg1 != NULL && strcmp(arg1, "giveup") == 0) {
+                TowerPlanner_GiveUp(plan);
+            } else {
+                Fail(path, lineNum, "usage: plan arrive|launched|giveup");
+            }
+            Log("plan %s%s, at tower %d of %d", arg1, outcome, plan->current == TOWER_PLAN_NONE ? -1 : plan->current, plan->numTowers);
+        } else {
+            Fail(path, lineNum, "unknown command");
+        }
+    }
+    fclose(f);
+}
+
+static char *ReadFile(const char *path, size_t *len) {
+    FILE *f = fopen(path, "r");
+    char *text = NULL;
+    size_t size = 0;
+
+    *len = 0;
+    if (f == NULL) return NULL;
+    FILE *mem = open_memstream(&text, &size);
+    int c;
+    while ((c = fgetc(f)) != EOF) fputc(c, mem);
+    fclose(mem);
+    fclose(f);
+    *len = size;
+    return text;
+}
+
+// prints where the two first part ways
+
+static void ShowDiff(const char *golden, const char *got) {
+    int lineNum = 1, shown = 0;
+
+    while (*golden || *got) {
+        size_t a = strcspn(golden, "\n"), b = strcspn(got, "\n");
+        if (a != b || strncmp(golden, got, a) != 0) {
+            if (shown == 0) fprintf(report, "    first difference at line %d\n", lineNum);
+            fprintf(report, "    - %.*s\n    + %.*s\n", (int) a, golden, (int) b, got);
+            if (++shown == MAX_DIFF_LINES) return;
+        }
+        golden += a + (golden[a] == '\n');
+        got += b + (got[b] == '\n');
+        lineNum++;
+    }
+}
+
+// SUCCESS if the scenario still does what its golden trace says
+
+static int Check(const char *scriptPath, uint8_t update) {
+    char goldenPath[MAX_PATH];
+    char *got = NULL;
+    size_t gotLen = 0;
+
+    snprintf(goldenPath, sizeof (goldenPath), "%.*s.golden", (int) (strlen(scriptPath) - 4), scriptPath);
+    out = open_memstream(&got, &gotLen);
+    RunScript(scriptPath);
+    fclose(out);
+
+    int result = SUCCESS;
+    if (update) {
+        FILE *f = fopen(goldenPath, "w");
+        if (f == NULL || fwrite(got, 1, gotLen, f) != gotLen || fclose(f) != 0) {
+            fprintf(report, "cannot write %s\n", goldenPath);
+            exit(2);
+        }
+        fprintf(report, "wrote %s\n", goldenPath);
+    } else {
+        size_t goldenLen;
+        char *golden = ReadFile(goldenPath, &goldenLen);
+        if (golden == NULL) {
+            fprintf(report, "FAIL %s: no %s, run with -u to make it\n", scriptPath, goldenPath);
+            result = ERROR;
+        } else if (goldenLen != gotLen || memcmp(golden, got, gotLen) != 0) {
+            fprintf(report, "FAIL %s\n", scriptPath);
+            ShowDiff(golden, got);
+            result = ERROR;
+        } else {
+            fprintf(report, "ok   %s\n", scriptPath);
+        }
+        free(golden);
+    }
+    free(got);
+    return result;
+}
+
+static int CompareNames(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    const char *dir = DEFAULT_DIR;
+    uint8_t update = FALSE;
+    char *scripts[MAX_SCENARIOS];
+    int numScripts = 0, failed = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ud:")) != -1) {
+        switch (opt) {
+            case 'u':
+                update = TRUE;
+                break;
+            case 'd':
+                dir = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-u] [-d dir] [scenario ...]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    for (int i = optind; i < argc && numScripts < MAX_SCENARIOS; i++) scripts[numScripts++] = strdup(argv[i]);
+    if (numScripts == 0) {
+        DIR *d = opendir(dir);
+        struct dirent *entry;
+        if (d == NULL) {
+            perror(dir);
+            return 2;
+        }
+        while ((entry = readdir(d)) != NULL && numScripts < MAX_SCENARIOS) {
+            size_t len = strlen(entry->d_name);
+            if (len > 4 && strcmp(entry->d_name + len - 4, ".scn") == 0) {
+                char path[MAX_PATH];
+                snprintf(path, sizeof (path), "%s/%s", dir, entry->d_name);
+                scripts[numScripts++] = strdup(path);
+            }
+        }
+        closedir(d);
+        qsort(scripts, numScripts, sizeof (scripts[0]), CompareNames);
+    }
+
+    // the robot's printfs go to stdout, keep them out of the report
+    fflush(stdout);
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    int devNull = open("/dev/null", O_WRONLY);
+    if (report == NULL || devNull < 0) {
+        perror("stdout");
+        return 2;
+    }
+    dup2(devNull, STDOUT_FILENO);
+
+    for (int i = 0; i < numScripts; i++) {
+        if (Check(scripts[i], update) != SUCCESS) failed++;
+        free(scripts[i]);
+    }
+    if (!update) fprintf(report, "%d of %d scenarios match their golden traces\n", numScripts - failed, numScripts);
+    fclose(report);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,549 @@
+/*
+ * TraceDecode.c
+ * Host side decoder for the robot's binary trace, see Trace.h and TraceFormats.h
+ *
+ * Reads the raw serial stream, either live from the UART (or a pty) or from a
+ * capture file, turns the frames back into text and rebuilds which state every
+ * machine was in. Every run of the robot (a reset shows up as the clock going
+ * backwards) is written out as
+ *   <prefix>_run<N>.csv   one row per state dwell, event, motor command and message
+ *   <prefix>_run<N>.json  the same in Chrome trace event format, open it in
+ *                         chrome://tracing or ui.perfetto.dev
+ * and a table of time spent per state is printed at the end of every run.
+ *
+ * usage: TraceDecode [-b baud] <capture file | serial device | -> <output prefix>
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "TraceFormats.h"
+#include "TraceTables.h"
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define DEFAULT_BAUD 115200
+#define MAX_MACHINES 16
+#define MAX_TEXT 256
+#define FRAME_HEADER 7 // sync, id, nargs and the 4 byte time
+#define MAX_FRAME (FRAME_HEADER + 2 * TRACE_MAX_ARGS + 1)
+
+#define TRACE_FORMAT(id, text) id,
+
+typedef enum {
+    TRACE_FORMAT_LIST
+    NUM_TRACE_FORMATS
+} TraceFormat_t;
+
+#undef TRACE_FORMAT
+
+#define TRACE_FORMAT(id, text) text,
+static const char *FormatText[NUM_TRACE_FORMATS] = {
+    TRACE_FORMAT_LIST
+};
+#undef TRACE_FORMAT
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+typedef enum {
+    ROW_STATE,
+    ROW_EVENT,
+    ROW_MOTORS,
+    ROW_FLYWHEEL,
+    ROW_MESSAGE, // a trace message from the robot
+    ROW_TEXT, // a plain printf line that was mixed in with the frames
+} RowKind_t;
+
+static const char *KindNames[] = {"state", "event", "motors", "flywheel", "message", "text"};
+
+typedef struct {
+    uint32_t timeUs;
+    uint32_t durationUs; // only for states
+    uint32_t seq; // arrival order, keeps the sort stable
+    RowKind_t kind;
+    int source; // machine for states
+    int value; // state or event type
+    int arg0;
+    int arg1;
+    char *text;
+} Row_t;
+
+typedef struct {
+    int number;
+    Row_t *rows;
+    size_t count;
+    size_t capacity;
+    uint32_t seq;
+    int started; // a frame has been seen
+    uint32_t lastUs;
+    uint32_t dropped;
+    int openState[MAX_MACHINES]; // state each machine is dwelling in, -1 if not running
+    uint32_t openSince[MAX_MACHINES];
+} Run_t;
+
+static Run_t run;
+static const char *outputPrefix;
+
+static uint8_t frame[MAX_FRAME];
+static int frameLen = 0;
+static char textLine[MAX_TEXT];
+static int textLen = 0;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static void Die(const char *what) {
+    perror(what);
+    exit(1);
+}
+
+static Row_t *AddRow(RowKind_t kind, uint32_t timeUs) {
+    if (run.count == run.capacity) {
+        run.capacity = run.capacity ? run.capacity * 2 : 1024;
+        run.rows = realloc(run.rows, run.capacity * sizeof (Row_t));
+        if (run.rows == NULL) Die("realloc");
+    }
+    Row_t *r = &run.rows[run.count++];
+    memset(r, 0, sizeof (*r));
+    r->kind = kind;
+    r->timeUs = timeUs;
+    r->seq = run.seq++;
+    return r;
+}
+
+static const char *StateName(int machine, int state) {
+    static char unknown[16];
+    if (state >= 0 && state < TraceMachines[machine].numStates) {
+        return TraceMachines[machine].states[state];
+    }
+    snprintf(unknown, sizeof (unknown), "state%d", state);
+    return unknown;
+}
+
+static const char *EventName(int type) {
+    static char unknown[16];
+    if (type >= 0 && type < TraceNumEvents) {
+        return TraceEventNames[type];
+    }
+    snprintf(unknown, sizeof (unknown), "event%d", type);
+    return unknown;
+}
+
+// ends the dwell of a machine, and of every sub machine running under it
+
+static void CloseMachine(int machine, uint32_t nowUs) {
+    if (run.openState[machine] >= 0) {
+        Row_t *r = AddRow(ROW_STATE, run.openSince[machine]);
+        r->durationUs = nowUs - run.openSince[machine];
+        r->source = machine;
+        r->value = run.openState[machine];
+        run.openState[machine] = -1;
+    }
+    for (int m = 0; m < TraceNumMachines; m++) {
+        if (TraceMachines[m].parent == machine) {
+            CloseMachine(m, nowUs);
+        }
+    }
+}
+
+static void EnterState(int machine, int state, uint32_t nowUs) {
+    if (machine < 0 || machine >= TraceNumMachines) return;
+
+    CloseMachine(machine, nowUs);
+
+    // sub machines are initialized (and transition) even while their parent is
+    // somewhere else, that time is not dwell
+    int parent = TraceMachines[machine].parent;
+    if (parent >= 0 && run.openState[parent] != TraceMachines[machine].parentState) return;
+
+    run.openState[machine] = state;
+    run.openSince[machine] = nowUs;
+}
+
+static int CompareRows(const void *a, const void *b) {
+    const Row_t *x = a, *y = b;
+    if (x->timeUs != y->timeUs) return x->timeUs < y->timeUs ? -1 : 1;
+    return x->seq < y->seq ? -1 : 1;
+}
+
+static void WriteCsvText(FILE *f, const char *text) {
+    fputc('"', f);
+    for (; *text; text++) {
+        if (*text == '"') fputc('"', f);
+        fputc(*text, f);
+    }
+    fputc('"', f);
+}
+
+static void WriteJsonText(FILE *f, const char *text) {
+    fputc('"', f);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') {
+            fprintf(f, "\\%c", *text);
+        } else if ((unsigned char) *text < 0x20) {
+            fprintf(f, "\\u%04x", *text);
+        } else {
+            fputc(*text, f);
+        }
+    }
+    fputc('"', f);
+}
+
+// the name column of a row, for messages and text the whole line
+
+static const char *RowName(const Row_t *r) {
+    switch (r->kind) {
+        case ROW_STATE: return StateName(r->source, r->value);
+        case ROW_EVENT: return EventName(r->value);
+        case ROW_MOTORS: return "drive";
+        case ROW_FLYWHEEL: return "flywheel";
+        default: return r->text;
+    }
+}
+
+static const char *RowSource(const Row_t *r) {
+    switch (r->kind) {
+        case ROW_STATE: return TraceMachines[r->source].name;
+        case ROW_EVENT: return "RobotHSM";
+        case ROW_MOTORS:
+        case ROW_FLYWHEEL: return "Motor_Control";
+        case ROW_MESSAGE: return "trace";
+        default: return "uart";
+    }
+}
+
+static void WriteCsv(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) Die(path);
+
+    fprintf(f, "time_us,duration_us,kind,source,name,arg0,arg1\n");
+    for (size_t i = 0; i < run.count; i++) {
+        const Row_t *r = &run.rows[i];
+        fprintf(f, "%lu,%lu,%s,%s,", (unsigned long) r->timeUs, (unsigned long) r->durationUs,
+                KindNames[r->kind], RowSource(r));
+        WriteCsvText(f, RowName(r));
+        fprintf(f, ",%d,%d\n", r->arg0, r->arg1);
+    }
+    fclose(f);
+}
+
+static void WriteJson(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) Die(path);
+
+    int eventLane = TraceNumMachines + 1;
+    int messageLane = TraceNumMachines + 2;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"TurboBlaster run %d\"}}", run.number);
+    for (int m = 0; m < TraceNumMachines; m++) {
+        fprintf(f, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                m + 1, TraceMachines[m].name);
+    }
+    fprintf(f, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"events\"}}", eventLane);
+    fprintf(f, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"messages\"}}", messageLane);
+
+    for (size_t i = 0; i < run.count; i++) {
+        const Row_t *r = &run.rows[i];
+        unsigned long ts = r->timeUs;
+        fprintf(f, ",\n");
+        switch (r->kind) {
+            case ROW_STATE:
+                fprintf(f, "{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lu,\"dur\":%lu,\"cat\":\"state\",\"name\":",
+                        r->source + 1, ts, (unsigned long) r->durationUs);
+                WriteJsonText(f, RowName(r));
+                fprintf(f, "}");
+                break;
+            case ROW_EVENT:
+                fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%lu,\"cat\":\"event\",\"name\":",
+                        eventLane, ts);
+                WriteJsonText(f, RowName(r));
+                fprintf(f, ",\"args\":{\"param\":%d}}", r->arg0);
+                break;
+            case ROW_MOTORS:
+                fprintf(f, "{\"ph\":\"C\",\"pid\":1,\"ts\":%lu,\"name\":\"drive motors\",\"args\":{\"left\":%d,\"right\":%d}}",
+                        ts, r->arg0, r->arg1);
+                break;
+            case ROW_FLYWHEEL:
+                fprintf(f, "{\"ph\":\"C\",\"pid\":1,\"ts\":%lu,\"name\":\"flywheel\",\"args\":{\"power\":%d}}",
+                        ts, r->arg0);
+                break;
+            default:
+                fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%lu,\"cat\":\"%s\",\"name\":",
+                        messageLane, ts, KindNames[r->kind]);
+                WriteJsonText(f, RowName(r));
+                fprintf(f, "}");
+                break;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+}
+
+static void PrintDwellSummary(void) {
+    uint32_t runUs = run.count ? run.lastUs - run.rows[0].timeUs : 0;
+
+    printf("run %d: %.3f s, %lu records dropped on the robot\n", run.number, runUs / 1e6,
+            (unsigned long) run.dropped);
+    printf("  %-24s %-16s %8s %12s %7s\n", "machine", "state", "visits", "total ms", "share");
+    for (int m = 0; m < TraceNumMachines; m++) {
+        for (int s = 0; s < TraceMachines[m].numStates; s++) {
+            uint32_t visits = 0;
+            uint64_t totalUs = 0;
+            for (size_t i = 0; i < run.count; i++) {
+                const Row_t *r = &run.rows[i];
+                if (r->kind == ROW_STATE && r->source == m && r->value == s) {
+                    visits++;
+                    totalUs += r->durationUs;
+                }
+            }
+            if (visits == 0) continue;
+            printf("  %-24s %-16s %8lu %12.1f %6.1f%%\n", TraceMachines[m].name, StateName(m, s),
+                    (unsigned long) visits, totalUs / 1e3, runUs ? 100.0 * totalUs / runUs : 0.0);
+        }
+    }
+}
+
+static void EndRun(void) {
+    for (int m = 0; m < TraceNumMachines; m++) {
+        if (TraceMachines[m].parent < 0) {
+            CloseMachine(m, run.lastUs);
+        }
+    }
+    if (run.count != 0) {
+        char path[1024];
+        qsort(run.rows, run.count, sizeof (Row_t), CompareRows);
+        snprintf(path, sizeof (path), "%s_run%d.csv", outputPrefix, run.number);
+        WriteCsv(path);
+        snprintf(path, sizeof (path), "%s_run%d.json", outputPrefix, run.number);
+        WriteJson(path);
+        PrintDwellSummary();
+    }
+    for (size_t i = 0; i < run.count; i++) {
+        free(run.rows[i].text);
+    }
+    run.count = 0;
+}
+
+static void StartRun(void) {
+    run.number++;
+    run.count = 0;
+    run.seq = 0;
+    run.started = 0;
+    run.lastUs = 0;
+    run.dropped = 0;
+    for (int m = 0; m < MAX_MACHINES; m++) {
+        run.openState[m] = -1;
+    }
+}
+
+static void HandleFrame(uint8_t id, uint8_t nargs, uint32_t timeUs, const int16_t *arg) {
+    if (run.started && timeUs < run.lastUs) { // the clock went backwards, the robot was reset
+        EndRun();
+        StartRun();
+    }
+    run.started = 1;
+    run.lastUs = timeUs;
+
+    Row_t *r;
+    char text[MAX_TEXT];
+    switch (id) {
+        case TR_STATE:
+            EnterState(arg[0], arg[1], timeUs);
+            break;
+        case TR_EVENT:
+            r = AddRow(ROW_EVENT, timeUs);
+            r->value = arg[0];
+            r->arg0 = (uint16_t) arg[1]; // EventParam is unsigned on the robot
+            break;
+        case TR_MOTORS:
+            r = AddRow(ROW_MOTORS, timeUs);
+            r->arg0 = arg[0];
+            r->arg1 = arg[1];
+            break;
+        case TR_FLYWHEEL:
+            r = AddRow(ROW_FLYWHEEL, timeUs);
+            r->arg0 = arg[0];
+            break;
+        case TR_REC_TAPE_FRONT:
+        case TR_REC_TAPE_BACK:
+        case TR_REC_ANALOG:
+        case TR_REC_DIGITAL:
+            break; // raw sensor readings from SensorRecorder, they are for Replay
+        default:
+            if (id == TR_DROPPED) run.dropped += arg[0];
+            snprintf(text, sizeof (text), FormatText[id], arg[0], arg[1], arg[2]);
+            r = AddRow(ROW_MESSAGE, timeUs);
+            r->arg0 = nargs > 0 ? arg[0] : 0;
+            r->arg1 = nargs > 1 ? arg[1] : 0;
+            r->text = strdup(text);
+            break;
+    }
+}
+
+// bytes that are not part of a frame are plain printf output from the robot,
+// collected into lines and stamped with the time of the last frame
+
+static void TextByte(uint8_t b) {
+    if (b == '\n') {
+        if (textLen != 0) {
+            textLine[textLen] = '\0';
+            AddRow(ROW_TEXT, run.lastUs)->text = strdup(textLine);
+            textLen = 0;
+        }
+    } else if (b >= 0x20 && b < 0x7F && textLen < MAX_TEXT - 1) {
+        textLine[textLen++] = b;
+    }
+}
+
+static void FeedByte(uint8_t b) {
+    if (frameLen == 0) {
+        if (b == TRACE_SYNC) {
+            frame[frameLen++] = b;
+        } else {
+            TextByte(b);
+        }
+        return;
+    }
+
+    frame[frameLen++] = b;
+    if (frameLen == 3 && (frame[1] >= NUM_TRACE_FORMATS || frame[2] > TRACE_MAX_ARGS)) {
+        goto resync;
+    }
+    if (frameLen < 3 || frameLen < FRAME_HEADER + 2 * frame[2] + 1) {
+        return;
+    }
+
+    uint8_t sum = 0;
+    for (int i = 1; i < frameLen - 1; i++) {
+        sum += frame[i];
+    }
+    if (sum != frame[frameLen - 1]) {
+        goto resync;
+    }
+
+    int16_t arg[TRACE_MAX_ARGS] = {0};
+    uint32_t timeUs = frame[3] | (frame[4] << 8) | ((uint32_t) frame[5] << 16) | ((uint32_t) frame[6] << 24);
+    for (int i = 0; i < frame[2]; i++) {
+        arg[i] = (int16_t) (frame[FRAME_HEADER + 2 * i] | (frame[FRAME_HEADER + 2 * i + 1] << 8));
+    }
+    frameLen = 0;
+    HandleFrame(frame[1], frame[2], timeUs, arg);
+    return;
+
+resync:
+    { // that sync byte was not the start of a frame, look for one in what followed it
+        uint8_t rest[MAX_FRAME];
+        int restLen = frameLen - 1;
+        memcpy(rest, frame + 1, restLen);
+        frameLen = 0;
+        for (int i = 0; i < restLen; i++) {
+            FeedByte(rest[i]);
+        }
+    }
+}
+
+static speed_t BaudConstant(long baud) {
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default:
+            fprintf(stderr, "TraceDecode: unsupported baud rate %ld\n", baud);
+            exit(1);
+    }
+}
+
+static int OpenInput(const char *path, long baud) {
+    if (strcmp(path, "-") == 0) return STDIN_FILENO;
+
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) Die(path);
+
+    if (isatty(fd)) { // live from the robot, raw 8N1 at the robot's baud rate
+        struct termios tio;
+        if (tcgetattr(fd, &tio) != 0) Die("tcgetattr");
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, BaudConstant(baud));
+        cfsetospeed(&tio, BaudConstant(baud));
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        if (tcsetattr(fd, TCSANOW, &tio) != 0) Die("tcsetattr");
+    }
+    return fd;
+}
+
+static void OnSignal(int sig) {
+    (void) sig;
+    stopRequested = 1;
+}
+
+/*******************************************************************************
+ * MAIN                                                                        *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    long baud = DEFAULT_BAUD;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:")) != -1) {
+        if (opt == 'b') {
+            baud = strtol(optarg, NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [-b baud] <capture file | serial device | -> <output prefix>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        fprintf(stderr, "usage: %s [-b baud] <capture file | serial device | -> <output prefix>\n", argv[0]);
+        return 1;
+    }
+    if (TraceNumMachines > MAX_MACHINES) {
+        fprintf(stderr, "TraceDecode: raise MAX_MACHINES to %d\n", TraceNumMachines);
+        return 1;
+    }
+    outputPrefix = argv[optind + 1];
+    int fd = OpenInput(argv[optind], baud);
+
+    // a live capture ends with ctrl-c, still write out the run in progress
+    struct sigaction sa;
+    memset(&sa, 0, sizeof (sa));
+    sa.sa_handler = OnSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    StartRun();
+    uint8_t buf[4096];
+    while (!stopRequested) {
+        ssize_t n = read(fd, buf, sizeof (buf));
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            Die("read");
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            FeedByte(buf[i]);
+        }
+    }
+    TextByte('\n'); // flush a partial line
+    EndRun();
+    return 0;
+}
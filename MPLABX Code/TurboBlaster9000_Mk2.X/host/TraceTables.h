@@ -0,0 +1,26 @@
+/*
+ * TraceTables.h
+ * Name tables for the host trace decoder. TraceTables.c is generated from the
+ * robot sources by TraceTables.py every build, see host/Makefile.
+ */
+
+#ifndef TRACE_TABLES_H
+#define	TRACE_TABLES_H
+
+typedef struct {
+    const char *name; // the machine's source file without the .c
+    const char *const *states; // its StateNames array
+    int numStates;
+    int parent; // machine that runs this one as a sub machine, -1 for the top
+    int parentState; // state of the parent this machine runs under
+} TraceMachineInfo_t;
+
+// indexed by TraceMachine_t
+extern const TraceMachineInfo_t TraceMachines[];
+extern const int TraceNumMachines;
+
+// indexed by ES_EventTyp_t
+extern const char *const TraceEventNames[];
+extern const int TraceNumEvents;
+
+#endif	/* TRACE_TABLES_H */
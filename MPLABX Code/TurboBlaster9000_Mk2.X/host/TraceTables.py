@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# TraceTables.py
+# Generates the name tables the host trace decoder needs, run by host/Makefile.
+#
+# The StateNames and EventNames arrays are static in the robot code (and written
+# by the Enum_To_String.py pre-build step), so they are pulled straight out of
+# the sources here instead of keeping a second copy that would go stale.
+#
+# usage: TraceTables.py <project dir> <output .c file>
+
+import os
+import re
+import sys
+
+MACHINE_RE = re.compile(r'TRACE_MACHINE\(\s*(\w+)\s*,\s*"([^"]+)"\s*\)')
+
+
+def read(path):
+    with open(path) as f:
+        return f.read()
+
+
+# returns the strings of a "static const char *<name>[] = { ... };" array
+def string_array(source, name, path):
+    match = re.search(r'\*\s*' + name + r'\s*\[\s*\]\s*=\s*\{(.*?)\};', source, re.S)
+    if match is None:
+        sys.exit('TraceTables.py: no %s array in %s' % (name, path))
+    body = re.sub(r'/\*.*?\*/', '', match.group(1), flags=re.S)
+    body = re.sub(r'//[^\n]*', '', body)
+    return re.findall(r'"((?:[^"\\]|\\.)*)"', body)
+
+
+def c_strings(names):
+    return ''.join('\t"%s",\n' % n for n in names)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: TraceTables.py <project dir> <output .c file>')
+    project, output = sys.argv[1], sys.argv[2]
+
+    machines = MACHINE_RE.findall(read(os.path.join(project, 'TraceFormats.h')))
+    if not machines:
+        sys.exit('TraceTables.py: no TRACE_MACHINE entries in TraceFormats.h')
+
+    names = []
+    states = []
+    for ident, filename in machines:
+        path = os.path.join(project, filename)
+        names.append(os.path.splitext(filename)[0])
+        states.append(string_array(read(path), 'StateNames', path))
+
+    # a sub machine runs while its parent is in the state with the same name,
+    # SearchForTowerSubHSM under RobotHSM's SearchForTower and so on
+    parents = []
+    for name in names:
+        short = name[:-len('SubHSM')] if name.endswith('SubHSM') else name
+        parent = (-1, -1)
+        for m, stateList in enumerate(states):
+            if short in stateList:
+                parent = (m, stateList.index(short))
+                break
+        parents.append(parent)
+
+    config = os.path.join(project, 'ES_Configure.h')
+    events = string_array(read(config), 'EventNames', config)
+
+    out = []
+    out.append('/* generated by TraceTables.py from the robot sources, do not edit */\n\n')
+    out.append('#include "TraceTables.h"\n\n')
+    for name, stateList in zip(names, states):
+        out.append('static const char *const %s_States[] = {\n%s};\n\n' % (name, c_strings(stateList)))
+    out.append('const TraceMachineInfo_t TraceMachines[] = {\n')
+    for name, stateList, parent in zip(names, states, parents):
+        out.append('\t{"%s", %s_States, %d, %d, %d},\n' % (name, name, len(stateList), parent[0], parent[1]))
+    out.append('};\n\n')
+    out.append('const int TraceNumMachines = %d;\n\n' % len(names))
+    out.append('const char *const TraceEventNames[] = {\n%s};\n\n' % c_strings(events))
+    out.append('const int TraceNumEvents = %d;\n' % len(events))
+
+    with open(output, 'w') as f:
+        f.write(''.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,67 @@
+/*
+ * TunableParams.c
+ * Run time values for the tunable constants, see TunableParams.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "BOARD.h"
+
+#include "Global_Macros.h"
+#include "TunableParams.h"
+
+#define TUNABLE_INFO(name, low, high) {#name, low, high},
+
+const TunableParamInfo_t TunableParamInfo[NUM_TUNABLE_PARAMS] = {
+    TUNABLE_PARAMS(TUNABLE_INFO)
+};
+
+// with TUNABLE giving back the number it wraps, each name in the list
+// expands to the value written in Global_Macros.h
+#undef TUNABLE
+#define TUNABLE(name, value) (value)
+#define TUNABLE_DEFAULT(name, low, high) name,
+
+const TunableParams_t TunableDefaults = {
+    {TUNABLE_PARAMS(TUNABLE_DEFAULT)}
+};
+
+__thread const TunableParams_t *CurrentParams = &TunableDefaults;
+
+void TunableParams_Select(const TunableParams_t *params) {
+    CurrentParams = params != NULL ? params : &TunableDefaults;
+}
+
+int TunableParams_WriteHeader(const char *macrosPath, FILE *out, const TunableParams_t *params, const char *note) {
+    FILE *in = fopen(macrosPath, "r");
+    char line[512];
+    int lineNumber = 0;
+
+    if (in == NULL) {
+        perror(macrosPath);
+        return FALSE;
+    }
+    while (fgets(line, sizeof (line), in) != NULL) {
+        char *open = strstr(line, "TUNABLE(");
+        char *comma = open != NULL ? strchr(open, ',') : NULL;
+        char *close = comma != NULL ? strchr(comma, ')') : NULL;
+        int i = -1;
+
+        if (strncmp(line, "#define", 7) == 0 && close != NULL) {
+            open += strlen("TUNABLE(");
+            for (i = NUM_TUNABLE_PARAMS - 1; i >= 0; i--) {
+                const char *name = TunableParamInfo[i].name;
+                if ((size_t) (comma - open) == strlen(name) && strncmp(open, name, comma - open) == 0) break;
+            }
+        }
+        if (i >= 0) {
+            fprintf(out, "%.*s, %d%s", (int) (comma - line), line, params->param[i], close);
+        } else {
+            fputs(line, out);
+        }
+        if (++lineNumber == 1) fprintf(out, "// %s\n", note);
+    }
+    fclose(in);
+    return TRUE;
+}
@@ -0,0 +1,137 @@
+/*
+ * TunableParams.h
+ * Run time values for the constants Global_Macros.h wraps in TUNABLE, host
+ * builds only. On the robot TUNABLE(name, value) is just the value.
+ *
+ * Here it reads the value out of the parameter set the calling thread selected
+ * with TunableParams_Select, TunableDefaults (the numbers written in
+ * Global_Macros.h) until it selects one. Select before HostMatch_Start and keep
+ * the set alive and unchanged until the match is over, the robot code reads it
+ * every time it uses one of the constants.
+ *
+ * To make another constant tunable, wrap it in TUNABLE in Global_Macros.h and
+ * add it to TUNABLE_PARAMS with the range AutoTune may move it over.
+ */
+
+#ifndef TUNABLE_PARAMS_H
+#define	TUNABLE_PARAMS_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdio.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+// name, lowest and highest value worth trying. Left out on purpose: the
+// flywheel (FLY_POWER, REV_UP_TIME, LAUNCH_TICKS), which ArenaSim does not
+// model past on and off, and the constants nothing uses any more
+#define TUNABLE_PARAMS(X) \
+    X(TURN_360_TICKS, 3000, 8000) \
+    X(ACQUIRE_SPEED, 40, 100) \
+    X(BEACON_CLOSE_THRESH, 0, 600) \
+    X(BEACON_HIGH_THRESH, 150, 600) \
+    X(BEACON_LOW_THRESH, 100, 550) \
+    X(APR_SPEED, 50, 100) \
+    X(APR_DIFF, 0, 80) \
+    X(APR_GAIN, 0, 128) \
+    X(APR_DITHER, 5, 60) \
+    X(APR_TIMEOUT, 400, 4000) \
+    X(ALIGN_SPEED, 15, 70) \
+    X(PING_IN_RANGE, 3, 10) \
+    X(PING_MAX, 6, 40) \
+    X(ALIGN_TIME, 500, 5000) \
+    X(LOST_TIMEOUT, 1000, 8000) \
+    X(TRAVERSE_SPEED, 20, 80) \
+    X(TRAVERSE_PASS_TICKS, 3000, 15000) \
+    X(TRAVERSE_CORRECTION, 0, 60) \
+    X(TRAVERSE_STANDOFF, 1, 6) \
+    X(TRAVERSE_KP, 0, 40) \
+    X(TRAVERSE_KD, 0, 80) \
+    X(TRAVERSE_SKIP_SPEED, 45, 100) \
+    X(TW_HIGH_THRESH, 80, 600) \
+    X(HOLE_W_TRACK_WIRE, 0, 16) \
+    X(HOLE_W_SIDE_TAPE, 0, 16) \
+    X(HOLE_W_PING, 0, 16) \
+    X(HOLE_THRESHOLD, 500, 4000) \
+    X(PASS_TIME, 2000, 10000) \
+    X(TURN_TIME, 1000, 4000) \
+    X(TURN_SPEED, 50, 100) \
+    X(ALIGN_LAUNCH_TIME, 200, 2000) \
+    X(C_TAPE_THRESH, 150, 850) \
+    X(ALIGN_LAUNCH_FOR_TICKS, 200, 1500) \
+    X(ALIGN_LAUNCH_BAC_TICKS, 200, 1500) \
+    X(ALIGN_LAUNCH_SPEED, 20, 90) \
+    X(ALIGN_SPEED_DIFF, 0, 70) \
+    X(ALIGN_KP, 0, 64) \
+    X(RESOLVE_TIME, 300, 2500) \
+    X(RESOLVE_SPEED, 40, 100) \
+    X(REVERSE_DIFF, 0, 70) \
+    X(FORWARD_DIFF, 0, 60) \
+    X(LIGHT_THRESHOLD, 300, 850) \
+    X(DARK_THRESHOLD, 350, 900) \
+    X(EXIT_SPEED, 30, 100) \
+    X(EXIT_TICKS, 100, 1500) \
+    X(ALIGN_TICKS, 500, 3000) \
+    X(ADJUST_SPEED, 10, 60) \
+    X(ADJUST_TICKS, 50, 800) \
+    X(BACK_TICKS, 800, 4000) \
+    X(PIVOT_TICKS, 800, 4000) \
+    X(BUDGET_ACQUIRE_TICKS, 5000, 60000) \
+    X(BUDGET_APPROACH_TICKS, 5000, 60000) \
+    X(BUDGET_HOLE_SEARCH_TICKS, 10000, 100000) \
+    X(BUDGET_LAUNCH_TICKS, 10000, 60000) \
+    X(BUDGET_RELOCATE_TICKS, 5000, 60000)
+
+#define TUNABLE(name, value) (CurrentParams->param[TP_##name])
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+#define TUNABLE_ENUM(name, low, high) TP_##name,
+
+typedef enum {
+    TUNABLE_PARAMS(TUNABLE_ENUM)
+    NUM_TUNABLE_PARAMS
+} TunableParam_t;
+
+#undef TUNABLE_ENUM
+
+typedef struct {
+    int param[NUM_TUNABLE_PARAMS]; // indexed by TunableParam_t
+} TunableParams_t;
+
+typedef struct {
+    const char *name;
+    int low, high;
+} TunableParamInfo_t;
+
+/*******************************************************************************
+ * PUBLIC VARIABLES                                                            *
+ ******************************************************************************/
+
+extern const TunableParamInfo_t TunableParamInfo[NUM_TUNABLE_PARAMS];
+
+// the values written in Global_Macros.h
+extern const TunableParams_t TunableDefaults;
+
+extern __thread const TunableParams_t *CurrentParams;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+// makes the set the one the robot code reads on the calling thread, NULL
+// goes back to TunableDefaults
+void TunableParams_Select(const TunableParams_t *params);
+
+// writes Global_Macros.h, read from macrosPath, out again with every
+// TUNABLE(name, value) set to the value in params and note as a comment under
+// the first line. FALSE if macrosPath could not be read
+int TunableParams_WriteHeader(const char *macrosPath, FILE *out, const TunableParams_t *params, const char *note);
+
+#endif	/* TUNABLE_PARAMS_H */
@@ -0,0 +1,64 @@
+/*
+ * AD.c
+ * Host stand-in for the ECE118 A/D library, see AD.h and HostHAL.h
+ */
+
+#include "BOARD.h"
+#include "AD.h"
+#include "HostHAL.h"
+#include "HostBoard.h"
+
+#define AD_MAX 1023
+#define BATTERY_DEFAULT 800 // a charged battery, well above BATTERY_DISCONNECT_THRESHOLD
+
+void HostHAL_ResetAD(void) {
+    CurrentBoard->ad.activePins = 0;
+    for (int i = 0; i < AD_NUM_PINS; i++) {
+        CurrentBoard->ad.reading[i] = 0;
+    }
+    CurrentBoard->ad.reading[AD_NUM_PINS - 1] = BATTERY_DEFAULT;
+}
+
+void HostHAL_SetAD(unsigned int pins, unsigned int value) {
+    if (value > AD_MAX) value = AD_MAX;
+    for (int i = 0; i < AD_NUM_PINS; i++) {
+        if (pins & (1 << i)) CurrentBoard->ad.reading[i] = value;
+    }
+}
+
+char AD_Init(void) {
+    CurrentBoard->ad.activePins = BAT_VOLTAGE; // the library always samples the battery
+    return SUCCESS;
+}
+
+char AD_AddPins(unsigned int AddPins) {
+    CurrentBoard->ad.activePins |= AddPins;
+    return SUCCESS;
+}
+
+char AD_RemovePins(unsigned int RemovePins) {
+    CurrentBoard->ad.activePins &= ~RemovePins | BAT_VOLTAGE;
+    return SUCCESS;
+}
+
+unsigned int AD_ActivePins(void) {
+    return CurrentBoard->ad.activePins;
+}
+
+char AD_IsNewDataReady(void) {
+    return TRUE;
+}
+
+unsigned int AD_ReadADPin(unsigned int Pin) {
+    if ((Pin & CurrentBoard->ad.activePins) == 0) {
+        return ERROR;
+    }
+    for (int i = 0; i < AD_NUM_PINS; i++) {
+        if (Pin & (1 << i)) return CurrentBoard->ad.reading[i];
+    }
+    return ERROR;
+}
+
+void AD_End(void) {
+    CurrentBoard->ad.activePins = 0;
+}
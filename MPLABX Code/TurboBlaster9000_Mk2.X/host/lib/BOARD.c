@@ -0,0 +1,20 @@
+/*
+ * BOARD.c
+ * Host stand-in for the ECE118 board library, see BOARD.h
+ */
+
+#include "BOARD.h"
+
+void BOARD_Init(void) {
+}
+
+void BOARD_End(void) {
+}
+
+unsigned int BOARD_GetPBClock(void) {
+    return 20000000;
+}
+
+unsigned int BOARD_GetSysClock(void) {
+    return 80000000;
+}
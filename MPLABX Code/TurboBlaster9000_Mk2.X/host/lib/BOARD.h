@@ -0,0 +1,32 @@
+/*
+ * BOARD.h
+ * Host stand-in for the ECE118 board library header. Same names and types as
+ * the real one so the robot code compiles unchanged, see host/Makefile.
+ */
+
+#ifndef BOARD_H
+#define	BOARD_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define SUCCESS 0
+#define ERROR -1
+
+void BOARD_Init(void);
+
+void BOARD_End(void);
+
+// the robot runs at 80MHz with a 20MHz peripheral bus
+unsigned int BOARD_GetPBClock(void);
+
+unsigned int BOARD_GetSysClock(void);
+
+#endif	/* BOARD_H */
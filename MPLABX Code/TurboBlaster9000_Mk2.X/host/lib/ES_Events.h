@@ -0,0 +1,23 @@
+/*
+ * ES_Events.h
+ * Host stand-in for the ES framework event definitions. The event types
+ * themselves come from the project's ES_Configure.h.
+ */
+
+#ifndef ES_EVENTS_H
+#define	ES_EVENTS_H
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+
+typedef struct ES_Event {
+    ES_EventTyp_t EventType; // what kind of event?
+    uint16_t EventParam; // parameter value for use w/ this event
+} ES_Event;
+
+#define INIT_EVENT (ES_Event){ES_INIT, 0x0000}
+#define ENTRY_EVENT (ES_Event){ES_ENTRY, 0x0000}
+#define EXIT_EVENT (ES_Event){ES_EXIT, 0x0000}
+#define NO_EVENT (ES_Event){ES_NO_EVENT, 0x0000}
+
+#endif	/* ES_EVENTS_H */
@@ -0,0 +1,135 @@
+/*
+ * ES_Framework.c
+ * Host stand-in for the Events and Services framework core, see ES_Framework.h
+ *
+ * Services, queue sizes and event checkers all come from ES_Configure.h.
+ * Like the library, ES_Run hands one event at a time to the highest priority
+ * service that has one waiting, and runs the event checkers once the queues
+ * are empty.
+ */
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+#include "ES_ServiceHeaders.h"
+#include EVENT_CHECK_HEADER
+
+typedef struct {
+    uint8_t(*InitFunc)(uint8_t Priority);
+    ES_Event(*RunFunc)(ES_Event ThisEvent);
+    uint8_t size;
+} ServiceDesc_t;
+
+static const ServiceDesc_t ServDescList[] = {
+    {SERV_0_INIT, SERV_0_RUN, SERV_0_QUEUE_SIZE},
+#if NUM_SERVICES > 1
+    {SERV_1_INIT, SERV_1_RUN, SERV_1_QUEUE_SIZE},
+#endif
+#if NUM_SERVICES > 2
+    {SERV_2_INIT, SERV_2_RUN, SERV_2_QUEUE_SIZE},
+#endif
+#if NUM_SERVICES > 3
+    {SERV_3_INIT, SERV_3_RUN, SERV_3_QUEUE_SIZE},
+#endif
+#if NUM_SERVICES > 4
+    {SERV_4_INIT, SERV_4_RUN, SERV_4_QUEUE_SIZE},
+#endif
+#if NUM_SERVICES > 5
+    {SERV_5_INIT, SERV_5_RUN, SERV_5_QUEUE_SIZE},
+#endif
+#if NUM_SERVICES > 6
+    {SERV_6_INIT, SERV_6_RUN, SERV_6_QUEUE_SIZE},
+#endif
+#if NUM_SERVICES > 7
+    {SERV_7_INIT, SERV_7_RUN, SERV_7_QUEUE_SIZE},
+#endif
+};
+
+static uint8_t(*const CheckList[])(void) = {EVENT_CHECK_LIST};
+
+static uint8_t CheckUserEvents(void) {
+    for (unsigned int i = 0; i < sizeof (CheckList) / sizeof (CheckList[0]); i++) {
+        if (CheckList[i]() == TRUE) {
+            return TRUE; // the library stops at the first checker that finds something
+        }
+    }
+    return FALSE;
+}
+
+static uint8_t HighestReady(void) {
+    for (int8_t i = NUM_SERVICES - 1; i > 0; i--) {
+        if (CurrentBoard->framework.ready & (1 << i)) return i;
+    }
+    return 0;
+}
+
+ES_Return_t ES_Initialize(void) {
+    CurrentBoard->framework.ready = 0;
+    for (uint8_t i = 0; i < NUM_SERVICES; i++) {
+        if (ServDescList[i].InitFunc == NULL || ServDescList[i].RunFunc == NULL) {
+            return FailedPointer;
+        }
+        if (ServDescList[i].size > HOST_MAX_QUEUE_SIZE) {
+            return FailedInit;
+        }
+        CurrentBoard->framework.queues[i].head = 0;
+        CurrentBoard->framework.queues[i].count = 0;
+    }
+    for (uint8_t i = 0; i < NUM_SERVICES; i++) {
+        if (ServDescList[i].InitFunc(i) != TRUE) {
+            return FailedInit;
+        }
+    }
+    return Success;
+}
+
+ES_Return_t ES_Run(void) {
+    uint32_t passes = 0;
+
+    while (!HostSim_IsStopped()) {
+        while (CurrentBoard->framework.ready != 0) {
+            uint8_t prio = HighestReady();
+            HostQueue_t *q = &CurrentBoard->framework.queues[prio];
+            ES_Event ThisEvent = q->event[q->head];
+            q->head = (q->head + 1) % ServDescList[prio].size;
+            if (--q->count == 0) {
+                CurrentBoard->framework.ready &= ~(1 << prio);
+            }
+            ServDescList[prio].RunFunc(ThisEvent);
+        }
+
+        uint8_t found = CheckUserEvents();
+        if ((found || CurrentBoard->framework.ready != 0) && ++passes < HOST_MAX_PASSES_PER_MS) {
+            continue;
+        }
+        HostSim_Tick(passes >= HOST_MAX_PASSES_PER_MS);
+        passes = 0;
+    }
+    return Success;
+}
+
+uint8_t ES_PostAll(ES_Event ThisEvent) {
+    uint8_t result = TRUE;
+    for (uint8_t i = 0; i < NUM_SERVICES; i++) {
+        if (ES_PostToService(i, ThisEvent) != TRUE) {
+            result = FALSE;
+        }
+    }
+    return result;
+}
+
+uint8_t ES_PostToService(uint8_t WhichService, ES_Event TheEvent) {
+    if (WhichService >= NUM_SERVICES) {
+        return FALSE;
+    }
+    HostQueue_t *q = &CurrentBoard->framework.queues[WhichService];
+    uint8_t size = ServDescList[WhichService].size;
+    if (q->count >= size) {
+        return FALSE; // full, the event is lost just like on the robot
+    }
+    q->event[(q->head + q->count) % size] = TheEvent;
+    q->count++;
+    CurrentBoard->framework.ready |= (1 << WhichService);
+    return TRUE;
+}
@@ -0,0 +1,43 @@
+/*
+ * ES_Framework.h
+ * Host stand-in for the 2nd generation Events and Services framework. The
+ * services, checkers and timers are wired up from the project's ES_Configure.h
+ * the same way the ECE118 library does it, so the robot code runs unchanged.
+ *
+ * The one difference is ES_Run. On the robot it never returns, here it moves
+ * the virtual clock forward one millisecond every time a pass of the loop finds
+ * nothing to do, and returns once HostSim says the run is over.
+ */
+
+#ifndef ES_FRAMEWORK_H
+#define	ES_FRAMEWORK_H
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Events.h"
+#include "ES_Timers.h"
+
+typedef uint8_t(*pPostFunc)(ES_Event);
+
+typedef enum {
+    Success = 0,
+    FailedPost = 1,
+    FailedRun,
+    FailedPointer,
+    FailedIndex,
+    FailedInit
+} ES_Return_t;
+
+ES_Return_t ES_Initialize(void);
+
+ES_Return_t ES_Run(void);
+
+uint8_t ES_PostAll(ES_Event ThisEvent);
+
+uint8_t ES_PostToService(uint8_t WhichService, ES_Event TheEvent);
+
+// the TattleTale call stack trace is not available off the robot
+#define ES_Tattle()
+#define ES_Tail()
+
+#endif	/* ES_FRAMEWORK_H */
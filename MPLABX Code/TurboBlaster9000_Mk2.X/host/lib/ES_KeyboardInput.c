@@ -0,0 +1,24 @@
+/*
+ * ES_KeyboardInput.c
+ * Host stand-in for the framework's keyboard service. On the robot it lets
+ * events be typed in over the serial port, the host drives the robot from
+ * code instead, so it only has to exist.
+ */
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_KeyboardInput.h"
+#include "HostBoard.h"
+
+uint8_t InitKeyboardInput(uint8_t Priority) {
+    CurrentBoard->framework.keyboardPriority = Priority;
+    return TRUE;
+}
+
+uint8_t PostKeyboardInput(ES_Event ThisEvent) {
+    return ES_PostToService(CurrentBoard->framework.keyboardPriority, ThisEvent);
+}
+
+ES_Event RunKeyboardInput(ES_Event ThisEvent) {
+    return NO_EVENT;
+}
@@ -0,0 +1,18 @@
+/*
+ * ES_KeyboardInput.h
+ * Host stand-in for the framework's keyboard service, service 0 of the robot.
+ */
+
+#ifndef ES_KEYBOARD_INPUT_H
+#define	ES_KEYBOARD_INPUT_H
+
+#include "ES_Configure.h"
+#include "ES_Events.h"
+
+uint8_t InitKeyboardInput(uint8_t Priority);
+
+uint8_t PostKeyboardInput(ES_Event ThisEvent);
+
+ES_Event RunKeyboardInput(ES_Event ThisEvent);
+
+#endif	/* ES_KEYBOARD_INPUT_H */
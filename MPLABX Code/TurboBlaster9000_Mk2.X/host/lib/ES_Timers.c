@@ -0,0 +1,82 @@
+/*
+ * ES_Timers.c
+ * Host stand-in for the ES framework timers, see ES_Timers.h
+ */
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_ServiceHeaders.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+
+static const pPostFunc RespFunction[HOST_NUM_ES_TIMERS] = {
+    TIMER0_RESP_FUNC, TIMER1_RESP_FUNC, TIMER2_RESP_FUNC, TIMER3_RESP_FUNC,
+    TIMER4_RESP_FUNC, TIMER5_RESP_FUNC, TIMER6_RESP_FUNC, TIMER7_RESP_FUNC,
+    TIMER8_RESP_FUNC, TIMER9_RESP_FUNC, TIMER10_RESP_FUNC, TIMER11_RESP_FUNC,
+    TIMER12_RESP_FUNC, TIMER13_RESP_FUNC, TIMER14_RESP_FUNC, TIMER15_RESP_FUNC,
+};
+
+static void Post(uint8_t Num, ES_EventTyp_t type) {
+    ES_Event ThisEvent;
+    ThisEvent.EventType = type;
+    ThisEvent.EventParam = Num;
+    RespFunction[Num](ThisEvent);
+}
+
+void ES_Timer_Init(void) {
+    for (int i = 0; i < HOST_NUM_ES_TIMERS; i++) {
+        CurrentBoard->esTimers.timeLeft[i] = 0;
+    }
+    CurrentBoard->esTimers.activeFlags = 0;
+}
+
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint32_t NewTime) {
+    if (Num >= HOST_NUM_ES_TIMERS || RespFunction[Num] == TIMER_UNUSED || NewTime == 0) {
+        return ES_Timer_ERR;
+    }
+    CurrentBoard->esTimers.timeLeft[Num] = NewTime;
+    CurrentBoard->esTimers.activeFlags |= (1 << Num);
+    Post(Num, ES_TIMERACTIVE);
+    return ES_Timer_OK;
+}
+
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint32_t NewTime) {
+    if (Num >= HOST_NUM_ES_TIMERS || RespFunction[Num] == TIMER_UNUSED || NewTime == 0) {
+        return ES_Timer_ERR;
+    }
+    CurrentBoard->esTimers.timeLeft[Num] = NewTime;
+    return ES_Timer_OK;
+}
+
+ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num) {
+    if (Num >= HOST_NUM_ES_TIMERS || RespFunction[Num] == TIMER_UNUSED || CurrentBoard->esTimers.timeLeft[Num] == 0) {
+        return ES_Timer_ERR;
+    }
+    CurrentBoard->esTimers.activeFlags |= (1 << Num);
+    Post(Num, ES_TIMERACTIVE);
+    return ES_Timer_OK;
+}
+
+ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num) {
+    if (Num >= HOST_NUM_ES_TIMERS || RespFunction[Num] == TIMER_UNUSED) {
+        return ES_Timer_ERR;
+    }
+    if (CurrentBoard->esTimers.activeFlags & (1 << Num)) {
+        CurrentBoard->esTimers.activeFlags &= ~(1 << Num);
+        Post(Num, ES_TIMERSTOPPED);
+    }
+    return ES_Timer_OK;
+}
+
+uint32_t ES_Timer_GetTime(void) {
+    return HostSim_GetTime();
+}
+
+void ES_Timer_Tick(void) {
+    for (uint8_t i = 0; i < HOST_NUM_ES_TIMERS; i++) {
+        if ((CurrentBoard->esTimers.activeFlags & (1 << i)) && --CurrentBoard->esTimers.timeLeft[i] == 0) {
+            CurrentBoard->esTimers.activeFlags &= ~(1 << i);
+            Post(i, ES_TIMEOUT);
+        }
+    }
+}
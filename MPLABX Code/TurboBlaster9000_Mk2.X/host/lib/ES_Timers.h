@@ -0,0 +1,38 @@
+/*
+ * ES_Timers.h
+ * Host stand-in for the ES framework timers. Like the robot's, they count in
+ * milliseconds and post ES_TIMEOUT to the TIMERn_RESP_FUNC from ES_Configure.h,
+ * but the milliseconds come from the virtual clock, see HostSim.h.
+ */
+
+#ifndef ES_TIMERS_H
+#define	ES_TIMERS_H
+
+#include "BOARD.h"
+
+typedef enum {
+    ES_Timer_ERR = -1,
+    ES_Timer_ACTIVE = 1,
+    ES_Timer_OK = 0,
+    ES_Timer_NOT_ACTIVE = 0
+} ES_TimerReturn_t;
+
+void ES_Timer_Init(void);
+
+// sets the time and starts the timer, posts ES_TIMERACTIVE like the library does
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint32_t NewTime);
+
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint32_t NewTime);
+
+ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num);
+
+// stops the timer, posts ES_TIMERSTOPPED if it was running
+ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num);
+
+uint32_t ES_Timer_GetTime(void);
+
+// host only: one millisecond of the virtual clock has gone by, counts every
+// running timer down and posts the timeouts. Called by HostSim
+void ES_Timer_Tick(void);
+
+#endif	/* ES_TIMERS_H */
@@ -0,0 +1,103 @@
+/*
+ * HostBoard.h
+ * Everything one simulated board remembers: the pins behind each library
+ * stand-in, the serial port, the software and framework timers, the service
+ * queues and the virtual clock.
+ *
+ * The stand-ins always work on the board the calling thread selected with
+ * HostBoard_Select, so every robot in a process can have a board of its own
+ * and different threads can run different boards at the same time. Only what
+ * is selected may be touched, a board must not be run by two threads at once.
+ */
+
+#ifndef HOST_BOARD_H
+#define	HOST_BOARD_H
+
+#include <stdio.h>
+#include "BOARD.h"
+#include "AD.h"
+#include "IO_Ports.h"
+#include "pwm.h"
+#include "RC_Servo.h"
+#include "timers.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostSim.h"
+
+#define HOST_MAX_QUEUE_SIZE 16 // biggest SERV_n_QUEUE_SIZE the stand-in accepts
+#define HOST_NUM_ES_TIMERS 16
+#define HOST_RX_BUFFER_SIZE 64
+
+typedef struct {
+    unsigned short outputs; // pins set as outputs
+    unsigned short latch; // what was written to the outputs
+    unsigned short inputs; // simulated level of every pin
+} HostPort_t;
+
+typedef struct {
+    unsigned int length;
+    unsigned int deadline;
+    uint8_t active;
+    uint8_t expired;
+} HostSoftTimer_t;
+
+typedef struct {
+    ES_Event event[HOST_MAX_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+} HostQueue_t;
+
+typedef struct {
+    struct {
+        unsigned int activePins;
+        unsigned int reading[AD_NUM_PINS];
+    } ad;
+
+    HostPort_t ports[IO_NUM_PORTS];
+
+    struct {
+        unsigned short activePins;
+        unsigned int frequency;
+        unsigned int duty[PWM_NUM_PINS];
+    } pwm;
+
+    struct {
+        unsigned short activePins;
+        unsigned short pulse[RC_NUM_PINS];
+    } rc;
+
+    struct {
+        FILE *output;
+        char rxBuffer[HOST_RX_BUFFER_SIZE];
+        uint8_t rxHead;
+        uint8_t rxCount;
+    } serial;
+
+    HostSoftTimer_t timer[TIMERS_NUM_TIMERS];
+
+    struct {
+        uint32_t timeLeft[HOST_NUM_ES_TIMERS];
+        uint16_t activeFlags;
+    } esTimers;
+
+    struct {
+        HostQueue_t queues[NUM_SERVICES];
+        uint8_t ready; // bit n set while service n has events waiting
+        uint8_t keyboardPriority;
+    } framework;
+
+    struct {
+        uint32_t nowMs;
+        uint32_t stopAtMs;
+        uint8_t stopped;
+        uint32_t busyMs;
+        HostTickHook_t tickHook;
+    } sim;
+} HostBoard_t;
+
+extern __thread HostBoard_t *CurrentBoard;
+
+// makes the board the one the library stand-ins work on for the calling thread
+void HostBoard_Select(HostBoard_t *board);
+
+#endif	/* HOST_BOARD_H */
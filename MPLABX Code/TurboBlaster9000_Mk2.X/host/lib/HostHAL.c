@@ -0,0 +1,28 @@
+/*
+ * HostHAL.c
+ * Power on reset of the whole simulated board, see HostHAL.h, and the choice
+ * of board the stand-ins work on, see HostBoard.h
+ */
+
+#include "BOARD.h"
+#include "HostHAL.h"
+#include "timers.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostBoard.h"
+
+__thread HostBoard_t *CurrentBoard = NULL;
+
+void HostBoard_Select(HostBoard_t *board) {
+    CurrentBoard = board;
+}
+
+void HostHAL_Reset(void) {
+    HostHAL_ResetAD();
+    HostHAL_ResetIO();
+    HostHAL_ResetPWM();
+    HostHAL_ResetRC();
+    HostHAL_ResetSerial();
+    TIMERS_Init();
+    ES_Timer_Init();
+}
@@ -0,0 +1,47 @@
+/*
+ * HostHAL.h
+ * The other side of the simulated board library. The robot code talks to AD.h,
+ * IO_Ports.h, pwm.h, RC_Servo.h and serial.h as usual, and whatever is standing
+ * in for the outside world (a test, the arena simulator) uses these calls to set
+ * what the sensors read and to see what the robot is driving.
+ */
+
+#ifndef HOST_HAL_H
+#define	HOST_HAL_H
+
+#include <stdio.h>
+#include "BOARD.h"
+
+// puts every pin back to its power on state: A/D reads 0 except the battery,
+// inputs read low, outputs and duty cycles are 0
+void HostHAL_Reset(void);
+
+// sets what AD_ReadADPin returns for one or more pins, clamped to 10 bits
+void HostHAL_SetAD(unsigned int pins, unsigned int value);
+
+// sets the level the given input pins of a port read
+void HostHAL_SetPortInputs(char port, unsigned short pins, uint8_t high);
+
+// what the robot last wrote to a port, only the pins set as outputs
+unsigned short HostHAL_GetPortOutputs(char port);
+
+// duty cycle of a PWM channel, 0 to MAX_PWM
+unsigned int HostHAL_GetPWMDuty(unsigned short channel);
+
+// pulse time of an RC servo pin in microseconds, 0 if it was never set
+unsigned short HostHAL_GetRCPulse(unsigned short pin);
+
+// where bytes sent with PutChar go, NULL to throw them away (the default)
+void HostHAL_SetSerialOutput(FILE *out);
+
+// queues a byte for the robot to receive with GetChar
+void HostHAL_SendSerialInput(char ch);
+
+// the reset of each library on its own, HostHAL_Reset calls all of them
+void HostHAL_ResetAD(void);
+void HostHAL_ResetIO(void);
+void HostHAL_ResetPWM(void);
+void HostHAL_ResetRC(void);
+void HostHAL_ResetSerial(void);
+
+#endif	/* HOST_HAL_H */
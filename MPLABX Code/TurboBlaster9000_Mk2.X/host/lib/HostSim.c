@@ -0,0 +1,64 @@
+/*
+ * HostSim.c
+ * Virtual clock for the host build, see HostSim.h
+ */
+
+#include "BOARD.h"
+#include "HostSim.h"
+#include "HostHAL.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ProfileClock.h"
+#include "HostBoard.h"
+
+void HostSim_Init(void) {
+    CurrentBoard->sim.nowMs = 0;
+    CurrentBoard->sim.stopAtMs = 0;
+    CurrentBoard->sim.stopped = TRUE;
+    CurrentBoard->sim.busyMs = 0;
+    CurrentBoard->sim.tickHook = NULL;
+    HostHAL_Reset();
+}
+
+void HostSim_SetTickHook(HostTickHook_t hook) {
+    CurrentBoard->sim.tickHook = hook;
+}
+
+uint32_t HostSim_GetTime(void) {
+    return CurrentBoard->sim.nowMs;
+}
+
+void HostSim_RunFor(uint32_t ms) {
+    CurrentBoard->sim.stopAtMs = CurrentBoard->sim.nowMs + ms;
+    CurrentBoard->sim.stopped = FALSE;
+    ES_Run();
+}
+
+void HostSim_Stop(void) {
+    CurrentBoard->sim.stopped = TRUE;
+}
+
+uint8_t HostSim_IsStopped(void) {
+    return CurrentBoard->sim.stopped;
+}
+
+uint32_t HostSim_GetBusyMs(void) {
+    return CurrentBoard->sim.busyMs;
+}
+
+void HostSim_Tick(uint8_t busy) {
+    typeof(CurrentBoard->sim) *sim = &CurrentBoard->sim;
+
+    sim->nowMs++;
+    ProfileClock_AdvanceMicros(1000);
+    if (busy) sim->busyMs++;
+
+    if (sim->tickHook != NULL) {
+        sim->tickHook(sim->nowMs);
+    }
+    ES_Timer_Tick();
+
+    if (sim->nowMs >= sim->stopAtMs) {
+        sim->stopped = TRUE;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * HostSim.h
+ * Virtual clock for the host build. Nothing on the host waits on real time:
+ * ES_Run moves the clock forward one millisecond every time a pass of the loop
+ * has nothing left to do, so a whole match runs as fast as the code can go.
+ *
+ * Every millisecond the tick hook gets a chance to update the simulated world
+ * (sensor readings from HostHAL.h), then the ES timers count down.
+ */
+
+#ifndef HOST_SIM_H
+#define	HOST_SIM_H
+
+#include "BOARD.h"
+
+// passes of ES_Run in a single millisecond before the clock is moved forward
+// anyway. The robot would have kept getting interrupted by its timers too, and
+// it keeps a state machine that posts to itself forever from hanging the run
+#define HOST_MAX_PASSES_PER_MS 1000
+
+typedef void (*HostTickHook_t)(uint32_t nowMs);
+
+// puts the clock back to 0 and the board to its power on state
+void HostSim_Init(void);
+
+// called once every simulated millisecond, before the ES timers are counted down
+void HostSim_SetTickHook(HostTickHook_t hook);
+
+// milliseconds since HostSim_Init
+uint32_t HostSim_GetTime(void);
+
+// runs ES_Run until the given number of milliseconds have gone by, or until
+// HostSim_Stop is called
+void HostSim_RunFor(uint32_t ms);
+
+// makes ES_Run return at the end of the current millisecond
+void HostSim_Stop(void);
+
+uint8_t HostSim_IsStopped(void);
+
+// milliseconds where the loop hit HOST_MAX_PASSES_PER_MS without going idle.
+// anything but 0 means some machine or checker never settles
+uint32_t HostSim_GetBusyMs(void);
+
+// called by ES_Run to move the clock forward one millisecond
+void HostSim_Tick(uint8_t busy);
+
+#endif	/* HOST_SIM_H */
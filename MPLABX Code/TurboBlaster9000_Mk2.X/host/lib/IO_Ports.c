@@ -0,0 +1,73 @@
+/*
+ * IO_Ports.c
+ * Host stand-in for the ECE118 digital I/O library, see IO_Ports.h and HostHAL.h
+ */
+
+#include "BOARD.h"
+#include "IO_Ports.h"
+#include "HostHAL.h"
+#include "HostBoard.h"
+
+void HostHAL_ResetIO(void) {
+    for (int i = 0; i < IO_NUM_PORTS; i++) {
+        CurrentBoard->ports[i].outputs = 0;
+        CurrentBoard->ports[i].latch = 0;
+        CurrentBoard->ports[i].inputs = 0;
+    }
+}
+
+void HostHAL_SetPortInputs(char port, unsigned short pins, uint8_t high) {
+    if (port < 0 || port >= IO_NUM_PORTS) return;
+    if (high) {
+        CurrentBoard->ports[(int) port].inputs |= pins;
+    } else {
+        CurrentBoard->ports[(int) port].inputs &= ~pins;
+    }
+}
+
+unsigned short HostHAL_GetPortOutputs(char port) {
+    if (port < 0 || port >= IO_NUM_PORTS) return 0;
+    return CurrentBoard->ports[(int) port].latch & CurrentBoard->ports[(int) port].outputs;
+}
+
+char IO_PortsSetPortInputs(char port, unsigned short pattern) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    CurrentBoard->ports[(int) port].outputs &= ~pattern;
+    return SUCCESS;
+}
+
+char IO_PortsSetPortOutputs(char port, unsigned short pattern) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    CurrentBoard->ports[(int) port].outputs |= pattern;
+    return SUCCESS;
+}
+
+unsigned short IO_PortsReadPort(char port) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    const HostPort_t *p = &CurrentBoard->ports[(int) port];
+    return (p->latch & p->outputs) | (p->inputs & ~p->outputs);
+}
+
+char IO_PortsWritePort(char port, unsigned short pattern) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    CurrentBoard->ports[(int) port].latch = pattern;
+    return SUCCESS;
+}
+
+char IO_PortsSetPortBits(char port, unsigned short pattern) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    CurrentBoard->ports[(int) port].latch |= pattern;
+    return SUCCESS;
+}
+
+char IO_PortsClearPortBits(char port, unsigned short pattern) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    CurrentBoard->ports[(int) port].latch &= ~pattern;
+    return SUCCESS;
+}
+
+char IO_PortsTogglePortBits(char port, unsigned short pattern) {
+    if (port < 0 || port >= IO_NUM_PORTS) return ERROR;
+    CurrentBoard->ports[(int) port].latch ^= pattern;
+    return SUCCESS;
+}
@@ -0,0 +1,43 @@
+/*
+ * IO_Ports.h
+ * Host stand-in for the ECE118 digital I/O library. Inputs come from the
+ * simulated board and outputs are kept for it to read, see HostHAL.h.
+ */
+
+#ifndef IO_PORTS_H
+#define	IO_PORTS_H
+
+#include "BOARD.h"
+
+enum {
+    PORTV, PORTW, PORTX, PORTY, PORTZ,
+    IO_NUM_PORTS
+};
+
+#define PIN3 (1 << 3)
+#define PIN4 (1 << 4)
+#define PIN5 (1 << 5)
+#define PIN6 (1 << 6)
+#define PIN7 (1 << 7)
+#define PIN8 (1 << 8)
+#define PIN9 (1 << 9)
+#define PIN10 (1 << 10)
+#define PIN11 (1 << 11)
+#define PIN12 (1 << 12)
+
+char IO_PortsSetPortInputs(char port, unsigned short pattern);
+
+char IO_PortsSetPortOutputs(char port, unsigned short pattern);
+
+// outputs read back what was written to them, inputs read the simulated level
+unsigned short IO_PortsReadPort(char port);
+
+char IO_PortsWritePort(char port, unsigned short pattern);
+
+char IO_PortsSetPortBits(char port, unsigned short pattern);
+
+char IO_PortsClearPortBits(char port, unsigned short pattern);
+
+char IO_PortsTogglePortBits(char port, unsigned short pattern);
+
+#endif	/* IO_PORTS_H */
@@ -0,0 +1,64 @@
+/*
+ * RC_Servo.c
+ * Host stand-in for the ECE118 RC servo library, see RC_Servo.h and HostHAL.h
+ */
+
+#include "BOARD.h"
+#include "RC_Servo.h"
+#include "HostHAL.h"
+#include "HostBoard.h"
+
+static int Channel(unsigned short pin) {
+    for (int i = 0; i < RC_NUM_PINS; i++) {
+        if (pin == (1 << i)) return i;
+    }
+    return -1;
+}
+
+void HostHAL_ResetRC(void) {
+    CurrentBoard->rc.activePins = 0;
+    for (int i = 0; i < RC_NUM_PINS; i++) {
+        CurrentBoard->rc.pulse[i] = 0;
+    }
+}
+
+unsigned short HostHAL_GetRCPulse(unsigned short pin) {
+    int i = Channel(pin);
+    return (i < 0 || !(CurrentBoard->rc.activePins & pin)) ? 0 : CurrentBoard->rc.pulse[i];
+}
+
+char RC_Init(void) {
+    return SUCCESS;
+}
+
+char RC_AddPins(unsigned short RCpins) {
+    CurrentBoard->rc.activePins |= RCpins;
+    return SUCCESS;
+}
+
+char RC_RemovePins(unsigned short RCpins) {
+    CurrentBoard->rc.activePins &= ~RCpins;
+    return SUCCESS;
+}
+
+unsigned short RC_ActivePins(void) {
+    return CurrentBoard->rc.activePins;
+}
+
+char RC_SetPulseTime(unsigned short RCpin, unsigned short pulseTime) {
+    int i = Channel(RCpin);
+    if (i < 0 || !(CurrentBoard->rc.activePins & RCpin) || pulseTime < MINPULSE || pulseTime > MAXPULSE) {
+        return ERROR;
+    }
+    CurrentBoard->rc.pulse[i] = pulseTime;
+    return SUCCESS;
+}
+
+unsigned short RC_GetPulseTime(unsigned short RCpin) {
+    return HostHAL_GetRCPulse(RCpin);
+}
+
+char RC_End(void) {
+    HostHAL_ResetRC();
+    return SUCCESS;
+}
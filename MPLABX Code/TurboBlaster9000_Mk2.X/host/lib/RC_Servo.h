@@ -0,0 +1,43 @@
+/*
+ * RC_Servo.h
+ * Host stand-in for the ECE118 RC servo library. Pulse times are only stored,
+ * the simulated board reads them back with HostHAL_GetRCPulse.
+ */
+
+#ifndef RC_SERVO_H
+#define	RC_SERVO_H
+
+#include "BOARD.h"
+
+#define RC_PORTX03 ((uint16_t)(1 << 0))
+#define RC_PORTX04 ((uint16_t)(1 << 1))
+#define RC_PORTY06 ((uint16_t)(1 << 2))
+#define RC_PORTY07 ((uint16_t)(1 << 3))
+#define RC_PORTZ08 ((uint16_t)(1 << 4))
+#define RC_PORTZ09 ((uint16_t)(1 << 5))
+#define RC_PORTW07 ((uint16_t)(1 << 6))
+#define RC_PORTW08 ((uint16_t)(1 << 7))
+#define RC_PORTV03 ((uint16_t)(1 << 8))
+#define RC_PORTV04 ((uint16_t)(1 << 9))
+
+#define RC_NUM_PINS 10
+
+#define MINPULSE 500
+#define MAXPULSE 2500
+
+char RC_Init(void);
+
+char RC_AddPins(unsigned short RCpins);
+
+char RC_RemovePins(unsigned short RCpins);
+
+unsigned short RC_ActivePins(void);
+
+// pulse time in microseconds, MINPULSE to MAXPULSE
+char RC_SetPulseTime(unsigned short RCpin, unsigned short pulseTime);
+
+unsigned short RC_GetPulseTime(unsigned short RCpin);
+
+char RC_End(void);
+
+#endif	/* RC_SERVO_H */
@@ -0,0 +1,7 @@
+/*
+ * Timers.h
+ * Some of the robot code includes the timer library as Timers.h, which only
+ * works on Windows. Host file systems care about case.
+ */
+
+#include "timers.h"
@@ -0,0 +1,70 @@
+/*
+ * pwm.c
+ * Host stand-in for the ECE118 PWM library, see pwm.h and HostHAL.h
+ */
+
+#include "BOARD.h"
+#include "pwm.h"
+#include "HostHAL.h"
+#include "HostBoard.h"
+
+static int Channel(unsigned short pin) {
+    for (int i = 0; i < PWM_NUM_PINS; i++) {
+        if (pin == (1 << i)) return i;
+    }
+    return -1;
+}
+
+void HostHAL_ResetPWM(void) {
+    CurrentBoard->pwm.activePins = 0;
+    CurrentBoard->pwm.frequency = PWM_1KHZ;
+    for (int i = 0; i < PWM_NUM_PINS; i++) {
+        CurrentBoard->pwm.duty[i] = 0;
+    }
+}
+
+unsigned int HostHAL_GetPWMDuty(unsigned short channel) {
+    int i = Channel(channel);
+    return (i < 0 || !(CurrentBoard->pwm.activePins & channel)) ? 0 : CurrentBoard->pwm.duty[i];
+}
+
+char PWM_Init(void) {
+    return SUCCESS;
+}
+
+char PWM_SetFrequency(unsigned int NewFrequency) {
+    CurrentBoard->pwm.frequency = NewFrequency;
+    return SUCCESS;
+}
+
+unsigned int PWM_GetFrequency(void) {
+    return CurrentBoard->pwm.frequency;
+}
+
+char PWM_AddPins(unsigned short AddPins) {
+    CurrentBoard->pwm.activePins |= AddPins;
+    return SUCCESS;
+}
+
+char PWM_RemovePins(unsigned short RemovePins) {
+    CurrentBoard->pwm.activePins &= ~RemovePins;
+    return SUCCESS;
+}
+
+char PWM_SetDutyCycle(unsigned short Channel_, unsigned int Duty) {
+    int i = Channel(Channel_);
+    if (i < 0 || !(CurrentBoard->pwm.activePins & Channel_) || Duty > MAX_PWM) {
+        return ERROR;
+    }
+    CurrentBoard->pwm.duty[i] = Duty;
+    return SUCCESS;
+}
+
+unsigned int PWM_GetDutyCycle(unsigned short Channel_) {
+    return HostHAL_GetPWMDuty(Channel_);
+}
+
+char PWM_End(void) {
+    HostHAL_ResetPWM();
+    return SUCCESS;
+}
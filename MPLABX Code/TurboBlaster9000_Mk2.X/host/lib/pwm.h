@@ -0,0 +1,48 @@
+/*
+ * pwm.h
+ * Host stand-in for the ECE118 PWM library. Duty cycles are only stored, the
+ * simulated board reads them back with HostHAL_GetPWMDuty.
+ */
+
+#ifndef PWM_H
+#define	PWM_H
+
+#include "BOARD.h"
+
+#define PWM_PORTZ06 ((uint16_t)(1 << 0))
+#define PWM_PORTY12 ((uint16_t)(1 << 1))
+#define PWM_PORTY10 ((uint16_t)(1 << 2))
+#define PWM_PORTY04 ((uint16_t)(1 << 3))
+#define PWM_PORTX11 ((uint16_t)(1 << 4))
+
+#define PWM_NUM_PINS 5
+
+#define PWM_1KHZ 1000
+#define PWM_2KHZ 2000
+#define PWM_5KHZ 5000
+#define PWM_10KHZ 10000
+#define PWM_20KHZ 20000
+#define PWM_30KHZ 30000
+#define PWM_40KHZ 40000
+
+#define MIN_PWM 0
+#define MAX_PWM 1000
+
+char PWM_Init(void);
+
+char PWM_SetFrequency(unsigned int NewFrequency);
+
+unsigned int PWM_GetFrequency(void);
+
+char PWM_AddPins(unsigned short AddPins);
+
+char PWM_RemovePins(unsigned short RemovePins);
+
+// duty is 0 to MAX_PWM, in tenths of a percent
+char PWM_SetDutyCycle(unsigned short Channel, unsigned int Duty);
+
+unsigned int PWM_GetDutyCycle(unsigned short Channel);
+
+char PWM_End(void);
+
+#endif	/* PWM_H */
@@ -0,0 +1,52 @@
+/*
+ * serial.c
+ * Host stand-in for the ECE118 serial library, see serial.h and HostHAL.h
+ */
+
+#include "BOARD.h"
+#include "serial.h"
+#include "HostHAL.h"
+#include "HostBoard.h"
+
+void HostHAL_ResetSerial(void) {
+    CurrentBoard->serial.rxHead = 0;
+    CurrentBoard->serial.rxCount = 0;
+}
+
+void HostHAL_SetSerialOutput(FILE *out) {
+    CurrentBoard->serial.output = out;
+}
+
+void HostHAL_SendSerialInput(char ch) {
+    if (CurrentBoard->serial.rxCount < HOST_RX_BUFFER_SIZE) {
+        CurrentBoard->serial.rxBuffer[(CurrentBoard->serial.rxHead + CurrentBoard->serial.rxCount) % HOST_RX_BUFFER_SIZE] = ch;
+        CurrentBoard->serial.rxCount++;
+    }
+}
+
+void SERIAL_Init(void) {
+}
+
+void PutChar(char ch) {
+    if (CurrentBoard->serial.output != NULL) {
+        fputc(ch, CurrentBoard->serial.output);
+    }
+}
+
+char GetChar(void) {
+    if (CurrentBoard->serial.rxCount == 0) {
+        return 0;
+    }
+    char ch = CurrentBoard->serial.rxBuffer[CurrentBoard->serial.rxHead];
+    CurrentBoard->serial.rxHead = (CurrentBoard->serial.rxHead + 1) % HOST_RX_BUFFER_SIZE;
+    CurrentBoard->serial.rxCount--;
+    return ch;
+}
+
+char IsTransmitEmpty(void) {
+    return TRUE; // the host never has to wait on the UART
+}
+
+char IsReceiveEmpty(void) {
+    return CurrentBoard->serial.rxCount == 0;
+}
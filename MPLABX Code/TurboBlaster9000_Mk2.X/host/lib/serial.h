@@ -0,0 +1,23 @@
+/*
+ * serial.h
+ * Host stand-in for the ECE118 serial library. printf goes straight to stdout,
+ * bytes sent with PutChar (the binary trace) go to the file given to
+ * HostHAL_SetSerialOutput.
+ */
+
+#ifndef SERIAL_H
+#define	SERIAL_H
+
+#include "BOARD.h"
+
+void SERIAL_Init(void);
+
+void PutChar(char ch);
+
+char GetChar(void);
+
+char IsTransmitEmpty(void);
+
+char IsReceiveEmpty(void);
+
+#endif	/* SERIAL_H */
@@ -0,0 +1,74 @@
+/*
+ * timers.c
+ * Host stand-in for the ECE118 software timer library, see timers.h
+ */
+
+#include "BOARD.h"
+#include "timers.h"
+#include "HostSim.h"
+#include "HostBoard.h"
+
+// catches up a timer with the virtual clock, the library does this in its interrupt
+
+static void Update(unsigned char Num) {
+    if (CurrentBoard->timer[Num].active && HostSim_GetTime() >= CurrentBoard->timer[Num].deadline) {
+        CurrentBoard->timer[Num].active = FALSE;
+        CurrentBoard->timer[Num].expired = TRUE;
+    }
+}
+
+void TIMERS_Init(void) {
+    for (int i = 0; i < TIMERS_NUM_TIMERS; i++) {
+        CurrentBoard->timer[i].length = 0;
+        CurrentBoard->timer[i].deadline = 0;
+        CurrentBoard->timer[i].active = FALSE;
+        CurrentBoard->timer[i].expired = FALSE;
+    }
+}
+
+char TIMERS_SetTimer(unsigned char Num, unsigned int NewTime) {
+    if (Num >= TIMERS_NUM_TIMERS) return ERROR;
+    CurrentBoard->timer[Num].length = NewTime;
+    return SUCCESS;
+}
+
+char TIMERS_StartTimer(unsigned char Num) {
+    if (Num >= TIMERS_NUM_TIMERS) return ERROR;
+    CurrentBoard->timer[Num].deadline = HostSim_GetTime() + CurrentBoard->timer[Num].length;
+    CurrentBoard->timer[Num].active = TRUE;
+    CurrentBoard->timer[Num].expired = FALSE;
+    return SUCCESS;
+}
+
+char TIMERS_StopTimer(unsigned char Num) {
+    if (Num >= TIMERS_NUM_TIMERS) return ERROR;
+    CurrentBoard->timer[Num].active = FALSE;
+    return SUCCESS;
+}
+
+char TIMERS_InitTimer(unsigned char Num, unsigned int NewTime) {
+    if (TIMERS_SetTimer(Num, NewTime) == ERROR) return ERROR;
+    return TIMERS_StartTimer(Num);
+}
+
+char TIMERS_IsTimerActive(unsigned char Num) {
+    if (Num >= TIMERS_NUM_TIMERS) return ERROR;
+    Update(Num);
+    return CurrentBoard->timer[Num].active;
+}
+
+char TIMERS_IsTimerExpired(unsigned char Num) {
+    if (Num >= TIMERS_NUM_TIMERS) return ERROR;
+    Update(Num);
+    return CurrentBoard->timer[Num].expired;
+}
+
+char TIMERS_ClearTimerExpired(unsigned char Num) {
+    if (Num >= TIMERS_NUM_TIMERS) return ERROR;
+    CurrentBoard->timer[Num].expired = FALSE;
+    return SUCCESS;
+}
+
+unsigned int TIMERS_GetTime(void) {
+    return HostSim_GetTime();
+}
@@ -0,0 +1,33 @@
+/*
+ * timers.h
+ * Host stand-in for the ECE118 software timer library. Time is the virtual
+ * millisecond clock of the simulation, see HostSim.h.
+ */
+
+#ifndef TIMERS_H
+#define	TIMERS_H
+
+#include "BOARD.h"
+
+#define TIMERS_NUM_TIMERS 16
+
+void TIMERS_Init(void);
+
+char TIMERS_SetTimer(unsigned char Num, unsigned int NewTime);
+
+char TIMERS_StartTimer(unsigned char Num);
+
+char TIMERS_StopTimer(unsigned char Num);
+
+char TIMERS_InitTimer(unsigned char Num, unsigned int NewTime);
+
+char TIMERS_IsTimerActive(unsigned char Num);
+
+char TIMERS_IsTimerExpired(unsigned char Num);
+
+char TIMERS_ClearTimerExpired(unsigned char Num);
+
+// milliseconds since the simulation started
+unsigned int TIMERS_GetTime(void);
+
+#endif	/* TIMERS_H */
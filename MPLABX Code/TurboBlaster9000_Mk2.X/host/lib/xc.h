@@ -0,0 +1,10 @@
+/*
+ * xc.h
+ * Host stand-in for the XC32 device header. The robot code only includes it,
+ * nothing in here is needed off the robot.
+ */
+
+#ifndef XC_H
+#define	XC_H
+
+#endif	/* XC_H */